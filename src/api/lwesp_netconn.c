@@ -37,6 +37,9 @@
  *
  *   - Remove debug message
  *   - Remove LWESP_CFG_CONN_MANUAL_TCP_RECEIVE macro which is not supported by Ai-thinker esp8266
+ *   - Account allocations to memory statistics tag
+ *   - Confirm received data when application reads it
+ *   - Confirm received data only to the connection which received it
  */
 #include "lwesp/lwesp_netconn.h"
 #include "lwesp/lwesp_private.h"
@@ -65,6 +68,9 @@ typedef struct lwesp_netconn {
 
     size_t rcv_packets;                         /*!< Number of received packets so far on this connection */
     lwesp_conn_p conn;                          /*!< Pointer to actual connection */
+#if LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__
+    uint8_t conn_val_id;                        /*!< Validation ID of connection, when netconn was attached to it */
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__ */
 
     lwesp_sys_mbox_t mbox_accept;               /*!< List of active connections waiting to be processed */
     lwesp_sys_mbox_t mbox_receive;              /*!< Message queue for receive mbox */
@@ -148,6 +154,9 @@ netconn_evt(lwesp_evt_t* evt) {
                 nc = lwesp_conn_get_arg(conn);  /* Argument should be already set */
                 if (nc != NULL) {
                     nc->conn = conn;            /* Save actual connection */
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+                    nc->conn_val_id = conn->val_id;
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL */
                 } else {
                     close = 1;                  /* Close this connection, invalid netconn */
                 }
@@ -162,6 +171,9 @@ netconn_evt(lwesp_evt_t* evt) {
 
                 if (nc != NULL) {
                     nc->conn = conn;            /* Set connection handle */
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+                    nc->conn_val_id = conn->val_id;
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL */
                     lwesp_conn_set_arg(conn, nc);   /* Set argument for connection */
 
                     /*
@@ -200,7 +212,6 @@ netconn_evt(lwesp_evt_t* evt) {
 
             nc = lwesp_conn_get_arg(conn);      /* Get API from connection */
             pbuf = lwesp_evt_conn_recv_get_buff(evt);   /* Get received buff */
-            lwesp_conn_recved(conn, pbuf);      /* Notify stack about received data */
             lwesp_pbuf_ref(pbuf);               /* Increase reference counter */
             if (nc == NULL || !lwesp_sys_mbox_isvalid(&nc->mbox_receive)
                 || !lwesp_sys_mbox_putnow(&nc->mbox_receive, pbuf)) {
@@ -276,7 +287,7 @@ lwesp_netconn_new(lwesp_netconn_type_t type) {
         lwesp_evt_register(lwesp_evt);          /* Register global event function */
     }
     lwesp_core_unlock();
-    a = lwesp_mem_calloc(1, sizeof(*a));        /* Allocate memory for core object */
+    a = LWESP_MEM_CALLOC_TAG(1, sizeof(*a), LWESP_MEM_TAG_CONN);   /* Allocate memory for core object */
     if (a != NULL) {
         a->type = type;                         /* Save netconn type */
         a->conn_timeout = 0;                    /* Default connection timeout */
@@ -608,7 +619,7 @@ lwesp_netconn_write(lwesp_netconn_p nc, const void* data, size_t btw) {
 
     /* Step 3 */
     if (nc->buff.buff == NULL) {                /* Check if we should allocate a new buffer */
-        nc->buff.buff = lwesp_mem_malloc(sizeof(*nc->buff.buff) * LWESP_CFG_CONN_MAX_DATA_LEN);
+        nc->buff.buff = LWESP_MEM_MALLOC_TAG(sizeof(*nc->buff.buff) * LWESP_CFG_CONN_MAX_DATA_LEN, LWESP_MEM_TAG_CONN);
         nc->buff.len = LWESP_CFG_CONN_MAX_DATA_LEN; /* Save buffer length */
         nc->buff.ptr = 0;                       /* Save buffer pointer */
     }
@@ -720,6 +731,12 @@ lwesp_netconn_receive(lwesp_netconn_p nc, lwesp_pbuf_p* pbuf) {
     if (nc->mbox_receive_entries > 0) {
         --nc->mbox_receive_entries;
     }
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+    /* Connection may be closed and its slot reused, while data waited in receive queue */
+    if ((uint8_t*)(*pbuf) != (uint8_t*)&recv_closed && nc->conn != NULL && nc->conn->val_id == nc->conn_val_id) {
+        lwesp_conn_recved(nc->conn, *pbuf);     /* Notify stack about received data, it left receive queue */
+    }
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL */
     lwesp_core_unlock();
 
     /* Check if connection closed */
@@ -0,0 +1,1548 @@
+/**
+ * \file            lwesp_bench.c
+ * \brief           Benchmark of AT data path
+ */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwESP - Lightweight ESP-AT parser library.
+ */
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include "lwesp/apps/lwesp_bench.h"
+#include "lwesp/lwesp_private.h"
+#include "lwesp/lwesp_input.h"
+#include "lwesp/lwesp_mem.h"
+#include "lwesp/lwesp_timeout.h"
+
+#define BENCH_DURATION_DEFAULT          1000    /*!< Default duration of single measurement in milliseconds */
+#define BENCH_IPD_MAX_PAYLOAD           1460    /*!< Largest +IPD payload of ESP8266 */
+#define BENCH_MEM_SLOTS                 32      /*!< Number of allocations kept alive in memory benchmark */
+#define BENCH_SEND_WINDOW               (4 * LWESP_CFG_CONN_MAX_DATA_LEN)   /*!< Maximal number of written bytes not yet sent */
+#define BENCH_SEND_MAX_SIZE             (3 * LWESP_CFG_CONN_MAX_DATA_LEN)   /*!< Largest send, split to multiple chunks */
+#define BENCH_MBOX_THREADS              8       /*!< Default number of writer threads in message queue benchmark */
+#define BENCH_MBOX_MAX_THREADS          32      /*!< Maximal number of writer threads in message queue benchmark */
+#define BENCH_CLOSED_PORT               1       /*!< Port expected to be closed on TCP server host */
+#define BENCH_TIMEOUT_CNT               2048    /*!< Number of concurrent timeouts in timeout benchmark */
+#define BENCH_TIMEOUT_SPREAD            1000    /*!< Spread of timeout expiry times in milliseconds */
+#define BENCH_TIMEOUT_PERIOD            5       /*!< Period of timeout restarted from its own callback */
+#define BENCH_TIMEOUT_REARMS            20      /*!< Number of expiries of timeout restarted from its own callback */
+#define BENCH_SCAN_BURST_LEN            4096    /*!< Length of response burst in scan benchmark */
+#define BENCH_MEM_TRACE_SLOTS           19      /*!< Number of allocations alive at the same time in recorded trace */
+
+/**
+ * \brief           Writer thread of message queue benchmark
+ */
+typedef struct {
+    lwesp_sys_mbox_t* mbox;                     /*!< Message queue to write to */
+    uint32_t start;                             /*!< Start time of measurement */
+    uint32_t duration;                          /*!< Duration of measurement */
+    uint32_t max_put;                           /*!< Result, maximal time of single put in units of milliseconds */
+} bench_mbox_writer_t;
+
+static const lwesp_bench_cfg_t* bench_cfg;
+static bench_mbox_writer_t bench_writers[BENCH_MBOX_MAX_THREADS];
+static lwesp_sys_mbox_t bench_mbox;             /*!< Message queue of message queue benchmark, never deleted
+                                                    as writers may still be inside put call after last entry */
+static uint8_t bench_data[BENCH_SEND_MAX_SIZE];             /*!< Payload for receive and send */
+static char bench_pkt[BENCH_IPD_MAX_PAYLOAD + 48];          /*!< Scripted +IPD statement with data */
+static uint8_t bench_burst[BENCH_SCAN_BURST_LEN];           /*!< Response burst for scan benchmark */
+
+/* Timeout benchmark state, modified from timeout callback with core locked */
+static lwesp_timeout_t bench_to[BENCH_TIMEOUT_CNT];
+static uint32_t bench_to_expiry[BENCH_TIMEOUT_CNT];     /*!< Expected expiry time of each timeout */
+static size_t bench_to_fired, bench_to_early;
+static uint32_t bench_to_late_max;
+
+/* Connection counters, modified from connection callback with core locked */
+static size_t bench_recv, bench_sent, bench_send_err;
+
+/**
+ * \brief           Format and output single result line
+ *
+ * Line longer than local buffer is formatted to allocated memory.
+ * When memory is not available, error line is reported instead of truncated line
+ * \param[in]       fmt: Format string
+ */
+static void
+bench_output(const char* fmt, ...) {
+    char line[256], *buff = line;
+    va_list va;
+    int len;
+
+    if (bench_cfg == NULL || bench_cfg->output_fn == NULL) {
+        return;
+    }
+    va_start(va, fmt);
+    len = vsnprintf(line, sizeof(line), fmt, va);
+    va_end(va);
+    if (len < 0) {
+        bench_cfg->output_fn("{\"bench\":\"error\",\"error\":\"format\"}");
+        return;
+    }
+    if ((size_t)len >= sizeof(line)) {
+        if ((buff = lwesp_mem_malloc((size_t)len + 1)) == NULL) {
+            snprintf(line, sizeof(line), "{\"bench\":\"error\",\"error\":\"truncated\",\"len\":%d}", len);
+            bench_cfg->output_fn(line);
+            return;
+        }
+        va_start(va, fmt);
+        vsnprintf(buff, (size_t)len + 1, fmt, va);
+        va_end(va);
+    }
+    bench_cfg->output_fn(buff);
+    if (buff != line) {
+        lwesp_mem_free(buff);
+    }
+}
+
+/**
+ * \brief           Get duration of single measurement
+ * \return          Duration in units of milliseconds
+ */
+static uint32_t
+bench_duration(void) {
+    return bench_cfg->duration > 0 ? bench_cfg->duration : BENCH_DURATION_DEFAULT;
+}
+
+/**
+ * \brief           Calculate rate per second
+ * \param[in]       cnt: Number of bytes or operations
+ * \param[in]       ms: Elapsed time in units of milliseconds
+ * \return          Rate per second
+ */
+static unsigned long
+bench_rate(size_t cnt, uint32_t ms) {
+    return (unsigned long)((uint64_t)cnt * 1000 / (ms > 0 ? ms : 1));
+}
+
+/**
+ * \brief           Read connection counter
+ * \param[in]       cnt: Pointer to counter
+ * \return          Counter value
+ */
+static size_t
+bench_counter(const size_t* cnt) {
+    size_t val;
+
+    lwesp_core_lock();
+    val = *cnt;
+    lwesp_core_unlock();
+    return val;
+}
+
+/**
+ * \brief           Wait for connection counter to reach value
+ * \param[in]       cnt: Pointer to counter
+ * \param[in]       val: Value to wait for
+ * \param[in]       timeout: Maximal time without counter change in units of milliseconds
+ * \return          `1` when value was reached, `0` on timeout
+ */
+static uint8_t
+bench_wait_counter(const size_t* cnt, size_t val, uint32_t timeout) {
+    uint32_t start = lwesp_sys_now();
+    size_t last = 0, now;
+
+    while ((now = bench_counter(cnt)) < val) {
+        if (now != last) {
+            last = now;
+            start = lwesp_sys_now();            /* Still in progress */
+        } else if (lwesp_sys_now() - start > timeout) {
+            return 0;
+        }
+        lwesp_delay(1);
+    }
+    return 1;
+}
+
+/**
+ * \brief           Callback function for benchmark connection
+ * \param[in]       evt: Event information with data
+ * \return          \ref lwespOK on success, member of \ref lwespr_t otherwise
+ */
+static lwespr_t
+bench_conn_evt(lwesp_evt_t* evt) {
+    switch (lwesp_evt_get_type(evt)) {
+        case LWESP_EVT_CONN_RECV: {
+            bench_recv += lwesp_pbuf_length(lwesp_evt_conn_recv_get_buff(evt), 1);
+            lwesp_conn_recved(lwesp_evt_conn_recv_get_conn(evt), lwesp_evt_conn_recv_get_buff(evt));
+            break;
+        }
+        case LWESP_EVT_CONN_SEND: {
+            if (lwesp_evt_conn_send_get_result(evt) == lwespOK) {
+                bench_sent += lwesp_evt_conn_send_get_length(evt);
+            } else {
+                ++bench_send_err;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return lwespOK;
+}
+
+/**
+ * \brief           Write data to input module like low-level driver does
+ * \param[in]       data: Data to write
+ * \param[in]       len: Length of data in units of bytes
+ */
+static void
+bench_input(const void* data, size_t len) {
+#if LWESP_CFG_INPUT_USE_PROCESS
+    lwesp_input_process(data, len);
+#else /* LWESP_CFG_INPUT_USE_PROCESS */
+    const uint8_t* d = data;
+    uint8_t* buff;
+    size_t l;
+
+    /* Wait for processing thread instead of dropping data */
+    while (len > 0) {
+        buff = lwesp_input_get_write_block(&l);
+        if (buff == NULL) {
+            lwesp_sys_thread_yield();
+            continue;
+        }
+        l = LWESP_MIN(l, len);
+        LWESP_MEMCPY(buff, d, l);
+        lwesp_input_write_advance(l);
+        d += l;
+        len -= l;
+    }
+#endif /* !LWESP_CFG_INPUT_USE_PROCESS */
+}
+
+#if LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__
+
+/**
+ * \brief           Output receive flow control statistics
+ */
+static void
+bench_output_flow_stats(void) {
+    lwesp_input_flow_stats_t s;
+
+    lwesp_input_get_flow_stats(&s);
+    bench_output("{\"bench\":\"input_flow\",\"stalls\":%lu,\"stalled_bytes\":%lu,\"dropped_bytes\":%lu,"
+                 "\"rts_count\":%lu,\"stall_ms_max\":%lu}",
+                 (unsigned long)s.stalls, (unsigned long)s.stalled_bytes, (unsigned long)s.dropped_bytes,
+                 (unsigned long)s.rts_count, (unsigned long)s.stall_time_max);
+}
+
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__ */
+
+#if LWESP_CFG_STATS || __DOXYGEN__
+
+/**
+ * \brief           Output statistics of gaps between send data chunks
+ * \param[in]       mode: Benchmark mode, `send` or `write`
+ * \param[in]       size: Size of single send or write
+ */
+static void
+bench_output_send_gap(const char* mode, size_t size) {
+    lwesp_stats_send_gap_t g;
+
+    lwesp_stats_get_send_gap(&g);
+    bench_output("{\"bench\":\"send_gap\",\"mode\":\"%s\",\"size\":%u,\"chunks\":%lu,\"chunk_us_avg\":%lu,\"chunk_us_max\":%lu,"
+                 "\"msgs\":%lu,\"msg_us_min\":%lu,\"msg_us_avg\":%lu,\"msg_us_max\":%lu,\"started\":%lu}",
+                 mode, (unsigned)size, (unsigned long)g.chunk.count,
+                 (unsigned long)(g.chunk.count > 0 ? g.chunk.time / g.chunk.count : 0), (unsigned long)g.chunk.time_max,
+                 (unsigned long)g.msg.count, (unsigned long)g.msg.time_min,
+                 (unsigned long)(g.msg.count > 0 ? g.msg.time / g.msg.count : 0), (unsigned long)g.msg.time_max,
+                 (unsigned long)g.started);
+}
+
+#endif /* LWESP_CFG_STATS || __DOXYGEN__ */
+
+#if LWESP_CFG_PBUF_POOL || __DOXYGEN__
+
+/**
+ * \brief           Output packet buffer pool statistics of all classes
+ */
+static void
+bench_output_pool_stats(void) {
+    lwesp_pbuf_pool_stats_t s;
+
+    for (size_t i = 0; i < LWESP_PBUF_POOL_CLASSES; ++i) {
+        lwesp_pbuf_pool_get_stats(i, &s);
+        bench_output("{\"bench\":\"pbuf_pool\",\"class\":%u,\"len\":%lu,\"count\":%lu,\"max_used\":%lu,\"hits\":%lu,\"misses\":%lu}",
+                     (unsigned)i, (unsigned long)s.len, (unsigned long)s.count, (unsigned long)s.max_used,
+                     (unsigned long)s.hits, (unsigned long)s.misses);
+    }
+}
+
+#endif /* LWESP_CFG_PBUF_POOL || __DOXYGEN__ */
+
+/**
+ * \brief           Measure throughput of +IPD statements through input module and parser
+ *
+ * Scripted `+IPD` statements are written in chunks of different sizes,
+ * to connection which is marked active only for the benchmark, device is not used.
+ * When \ref LWESP_CFG_IPD_ZERO_COPY is enabled, every measurement is repeated
+ * with zero-copy turned off, to compare it with copy mode
+ * \param[in]       cfg: Benchmark configuration
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_bench_ipd_ingest(const lwesp_bench_cfg_t* cfg) {
+    static const size_t payloads[] = { 64, 536, BENCH_IPD_MAX_PAYLOAD };
+    static const size_t chunks[] = { 16, 64, 256, 1024 };
+#if LWESP_CFG_IPD_ZERO_COPY
+    static const char* modes[] = { "zero_copy", "copy" };
+#else /* LWESP_CFG_IPD_ZERO_COPY */
+    static const char* modes[] = { "copy" };
+#endif /* !LWESP_CFG_IPD_ZERO_COPY */
+    lwesp_conn_p c = NULL;
+    size_t pkt_len, fed, len;
+    uint32_t start, ms;
+    uint8_t id, ok;
+
+    LWESP_ASSERT("cfg != NULL", cfg != NULL);
+    bench_cfg = cfg;
+
+    /* Use free connection, stack handles +IPD only for active connections */
+    lwesp_core_lock();
+    for (size_t i = LWESP_CFG_MAX_CONNS; i > 0; --i) {
+        if (!esp.m.conns[i - 1].status.f.active) {
+            c = &esp.m.conns[i - 1];
+            id = c->val_id;
+            LWESP_MEMSET(c, 0x00, sizeof(*c));
+            c->num = (uint8_t)(i - 1);
+            c->val_id = ++id;
+            c->type = LWESP_CONN_TYPE_TCP;
+            c->evt_func = bench_conn_evt;
+            c->status.f.client = 1;
+            c->status.f.active = 1;
+            break;
+        }
+    }
+    lwesp_core_unlock();
+    if (c == NULL) {
+        return lwespERRNOFREECONN;
+    }
+
+    for (size_t p = 0; p < LWESP_ARRAYSIZE(payloads); ++p) {
+        len = (size_t)sprintf(bench_pkt, "\r\n+IPD,%u,%u,127.0.0.1,5000:", (unsigned)c->num, (unsigned)payloads[p]);
+        LWESP_MEMSET(&bench_pkt[len], 'a', payloads[p]);
+        pkt_len = len + payloads[p];
+
+        for (size_t i = 0; i < LWESP_ARRAYSIZE(chunks) * LWESP_ARRAYSIZE(modes); ++i) {
+            size_t ch = i / LWESP_ARRAYSIZE(modes), m = i % LWESP_ARRAYSIZE(modes);
+
+            lwesp_core_lock();
+            bench_recv = 0;
+#if LWESP_CFG_IPD_ZERO_COPY
+            esp.buff_refs_off = m > 0;
+#endif /* LWESP_CFG_IPD_ZERO_COPY */
+            lwesp_core_unlock();
+
+            fed = 0;
+            start = lwesp_sys_now();
+            do {
+                for (size_t off = 0; off < pkt_len; off += chunks[ch]) {
+                    bench_input(&bench_pkt[off], LWESP_MIN(chunks[ch], pkt_len - off));
+                }
+                fed += payloads[p];
+            } while (lwesp_sys_now() - start < bench_duration());
+            ok = bench_wait_counter(&bench_recv, fed, 1000);
+            ms = lwesp_sys_now() - start;
+
+            bench_output("{\"bench\":\"ipd_ingest\",\"mode\":\"%s\",\"payload\":%u,\"chunk\":%u,\"bytes\":%lu,\"ms\":%lu,\"bytes_per_s\":%lu,\"lost\":%lu}",
+                         modes[m], (unsigned)payloads[p], (unsigned)chunks[ch], (unsigned long)fed, (unsigned long)ms,
+                         bench_rate(fed, ms), ok ? 0UL : (unsigned long)(fed - bench_counter(&bench_recv)));
+        }
+    }
+
+    lwesp_core_lock();
+    c->status.f.active = 0;
+#if LWESP_CFG_IPD_ZERO_COPY
+    esp.buff_refs_off = 0;
+#endif /* LWESP_CFG_IPD_ZERO_COPY */
+    lwesp_core_unlock();
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+    bench_output_flow_stats();
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL */
+#if LWESP_CFG_PBUF_POOL
+    bench_output_pool_stats();
+#endif /* LWESP_CFG_PBUF_POOL */
+    return lwespOK;
+}
+
+/**
+ * \brief           Received line of recorded AT session
+ */
+typedef struct {
+    lwesp_cmd_t cmd;                            /*!< Command active when line was received */
+    const char* line;                           /*!< Received line without line ending */
+} bench_trace_line_t;
+
+/* Helper macro to define recorded line */
+#define BENCH_TRACE_LINE(cmd, line)         { cmd, line }
+
+/**
+ * \brief           Responses starting with `+` character, recorded on AT port
+ *                  during reset, scan, join, IP queries and TCP echo session with emulated device.
+ *                  Data of `+IPD` statements are not included
+ */
+static const bench_trace_line_t
+bench_trace[] = {
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CWDHCP_GET, "+CWDHCP:3"),
+#if LWESP_CFG_MODE_ACCESS_POINT
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPAP_GET, "+CIPAP:ip:\"192.168.4.1\""),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPAP_GET, "+CIPAP:gateway:\"192.168.4.1\""),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPAP_GET, "+CIPAP:netmask:\"255.255.255.0\""),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPAPMAC_GET, "+CIPAPMAC:\"1a:fe:34:00:00:01\""),
+#endif /* LWESP_CFG_MODE_ACCESS_POINT */
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CWDHCP_GET, "+CWDHCP:3"),
+#if LWESP_CFG_MODE_ACCESS_POINT
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPAP_GET, "+CIPAP:ip:\"192.168.4.1\""),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPAP_GET, "+CIPAP:gateway:\"192.168.4.1\""),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPAP_GET, "+CIPAP:netmask:\"255.255.255.0\""),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPAPMAC_GET, "+CIPAPMAC:\"1a:fe:34:00:00:01\""),
+#endif /* LWESP_CFG_MODE_ACCESS_POINT */
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CWLAP, "+CWLAP:(3,\"lwesp_emul\",-45,\"24:0a:c4:00:00:01\",6)"),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CWLAP, "+CWLAP:(4,\"lwesp_emul_2\",-71,\"24:0a:c4:00:00:02\",11)"),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CWDHCP_GET, "+CWDHCP:3"),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPSTA_GET, "+CIPSTA:ip:\"127.0.0.1\""),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPSTA_GET, "+CIPSTA:gateway:\"127.0.0.1\""),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPSTA_GET, "+CIPSTA:netmask:\"255.0.0.0\""),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPSTAMAC_GET, "+CIPSTAMAC:\"18:fe:34:00:00:01\""),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CWJAP_GET, "+CWJAP:\"lwesp_emul\",\"24:0a:c4:00:00:01\",6,-45"),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CWDHCP_GET, "+CWDHCP:3"),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPSTA_GET, "+CIPSTA:ip:\"127.0.0.1\""),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPSTA_GET, "+CIPSTA:gateway:\"127.0.0.1\""),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPSTA_GET, "+CIPSTA:netmask:\"255.0.0.0\""),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPSTAMAC_GET, "+CIPSTAMAC:\"18:fe:34:00:00:01\""),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CWMODE_GET, "+CWMODE:3"),
+#if LWESP_CFG_MODE_ACCESS_POINT
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPAP_GET, "+CIPAP:ip:\"192.168.4.1\""),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPAP_GET, "+CIPAP:gateway:\"192.168.4.1\""),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPAP_GET, "+CIPAP:netmask:\"255.255.255.0\""),
+    BENCH_TRACE_LINE(LWESP_CMD_WIFI_CIPAPMAC_GET, "+CIPAPMAC:\"1a:fe:34:00:00:01\""),
+#endif /* LWESP_CFG_MODE_ACCESS_POINT */
+    BENCH_TRACE_LINE(LWESP_CMD_TCPIP_CIPSTATUS, "+CIPSTATUS:4,\"TCP\",\"127.0.0.1\",7777,34948,0"),
+    BENCH_TRACE_LINE(LWESP_CMD_IDLE, "+IPD,4,64,127.0.0.1,7777:"),
+    BENCH_TRACE_LINE(LWESP_CMD_IDLE, "+IPD,4,314,127.0.0.1,7777:"),
+    BENCH_TRACE_LINE(LWESP_CMD_IDLE, "+IPD,4,564,127.0.0.1,7777:"),
+    BENCH_TRACE_LINE(LWESP_CMD_IDLE, "+IPD,4,814,127.0.0.1,7777:"),
+    BENCH_TRACE_LINE(LWESP_CMD_IDLE, "+IPD,4,1064,127.0.0.1,7777:"),
+    BENCH_TRACE_LINE(LWESP_CMD_IDLE, "+IPD,4,1314,127.0.0.1,7777:"),
+};
+
+/**
+ * \brief           Classify response with `strncmp` cascade, which was used before handler table
+ * \param[in]       line: Received line, starting with `+` character
+ * \param[in]       cmd: Command active when line was received
+ * \return          Response name, `NULL` if response is not handled
+ */
+static const char*
+bench_parser_cascade(const char* line, lwesp_cmd_t cmd) {
+    if (!strncmp("+IPD", line, 4)) {
+        return "IPD";
+#if LWESP_CFG_MODE_ACCESS_POINT
+    } else if (!strncmp(line, "+STA_CONNECTED", 14)) {
+        return "STA_CONNECTED";
+    } else if (!strncmp(line, "+STA_DISCONNECTED", 17)) {
+        return "STA_DISCONNECTED";
+    } else if (!strncmp(line, "+DIST_STA_IP", 12)) {
+        return "DIST_STA_IP";
+#endif /* LWESP_CFG_MODE_ACCESS_POINT */
+    } else if (cmd != LWESP_CMD_IDLE) {
+#if LWESP_CFG_MODE_STATION
+        if (cmd == LWESP_CMD_WIFI_CIPSTAMAC_GET && !strncmp(line, "+CIPSTAMAC", 10)) {
+            return "CIPSTAMAC";
+        }
+#endif /* LWESP_CFG_MODE_STATION */
+#if LWESP_CFG_MODE_ACCESS_POINT
+        if (cmd == LWESP_CMD_WIFI_CIPAPMAC_GET && !strncmp(line, "+CIPAPMAC", 9)) {
+            return "CIPAPMAC";
+        }
+#endif /* LWESP_CFG_MODE_ACCESS_POINT */
+#if LWESP_CFG_MODE_STATION
+        if (cmd == LWESP_CMD_WIFI_CIPSTA_GET && !strncmp(line, "+CIPSTA", 7)) {
+            return "CIPSTA";
+        }
+#endif /* LWESP_CFG_MODE_STATION */
+#if LWESP_CFG_MODE_ACCESS_POINT
+        if (cmd == LWESP_CMD_WIFI_CIPAP_GET && !strncmp(line, "+CIPAP", 6)) {
+            return "CIPAP";
+        }
+#endif /* LWESP_CFG_MODE_ACCESS_POINT */
+#if LWESP_CFG_MODE_STATION
+        if (cmd == LWESP_CMD_WIFI_CWLAP && !strncmp(line, "+CWLAP", 6)) {
+            return "CWLAP";
+        }
+        if (cmd == LWESP_CMD_WIFI_CWJAP && !strncmp(line, "+CWJAP", 6)) {
+            return "CWJAP";
+        }
+        if (cmd == LWESP_CMD_WIFI_CWJAP_GET && !strncmp(line, "+CWJAP", 6)) {
+            return "CWJAP";
+        }
+#endif /* LWESP_CFG_MODE_STATION */
+#if LWESP_CFG_MODE_ACCESS_POINT
+        if (cmd == LWESP_CMD_WIFI_CWLIF && !strncmp(line, "+CWLIF", 6)) {
+            return "CWLIF";
+        }
+        if (cmd == LWESP_CMD_WIFI_CWSAP_GET && !strncmp(line, "+CWSAP", 6)) {
+            return "CWSAP";
+        }
+#endif /* LWESP_CFG_MODE_ACCESS_POINT */
+#if LWESP_CFG_DNS
+        if (cmd == LWESP_CMD_TCPIP_CIPDOMAIN && !strncmp(line, "+CIPDOMAIN", 10)) {
+            return "CIPDOMAIN";
+        }
+        if (cmd == LWESP_CMD_TCPIP_CIPDNS_GET && !strncmp(line, "+CIPDNS", 7)) {
+            return "CIPDNS";
+        }
+#endif /* LWESP_CFG_DNS */
+#if LWESP_CFG_PING
+        if (cmd == LWESP_CMD_TCPIP_PING && !strncmp(line, "+PING", 5)) {
+            return "PING";
+        }
+#endif /* LWESP_CFG_PING */
+#if LWESP_CFG_HOSTNAME
+        if (cmd == LWESP_CMD_WIFI_CWHOSTNAME_GET && !strncmp(line, "+CWHOSTNAME", 11)) {
+            return "CWHOSTNAME";
+        }
+#endif /* LWESP_CFG_HOSTNAME */
+        if (cmd == LWESP_CMD_WIFI_CWDHCP_GET && !strncmp(line, "+CWDHCP", 7)) {
+            return "CWDHCP";
+        }
+        if (cmd == LWESP_CMD_WIFI_CWMODE_GET && !strncmp(line, "+CWMODE", 7)) {
+            return "CWMODE";
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Measure classification of received lines with handler table and with `strncmp` cascade
+ *
+ * Recorded lines are replayed through both classifiers, which must give the same result for every line.
+ * Lines are only classified, handlers are not called and device is not used
+ * \param[in]       cfg: Benchmark configuration
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_bench_parser(const lwesp_bench_cfg_t* cfg) {
+    static const char* modes[] = { "table", "cascade" };
+    const char* n1, *n2;
+    size_t lines, matched, errors = 0;
+    uint32_t start, ms;
+
+    LWESP_ASSERT("cfg != NULL", cfg != NULL);
+    bench_cfg = cfg;
+
+    /* Both classifiers must find the same handler, table is built on first use */
+    lwesp_core_lock();
+    for (size_t i = 0; i < LWESP_ARRAYSIZE(bench_trace); ++i) {
+        n1 = lwespi_recv_classify(bench_trace[i].line, bench_trace[i].cmd);
+        n2 = bench_parser_cascade(bench_trace[i].line, bench_trace[i].cmd);
+        if ((n1 == NULL) != (n2 == NULL) || (n1 != NULL && strcmp(n1, n2))) {
+            ++errors;
+        }
+    }
+    lwesp_core_unlock();
+
+    for (size_t m = 0; m < LWESP_ARRAYSIZE(modes); ++m) {
+        lines = 0;
+        matched = 0;
+        start = lwesp_sys_now();
+        do {
+            for (size_t i = 0; i < LWESP_ARRAYSIZE(bench_trace); ++i, ++lines) {
+                if (m == 0) {
+                    n1 = lwespi_recv_classify(bench_trace[i].line, bench_trace[i].cmd);
+                } else {
+                    n1 = bench_parser_cascade(bench_trace[i].line, bench_trace[i].cmd);
+                }
+                matched += n1 != NULL;
+            }
+        } while (lwesp_sys_now() - start < bench_duration());
+        ms = lwesp_sys_now() - start;
+        bench_output("{\"bench\":\"parser\",\"mode\":\"%s\",\"lines\":%lu,\"matched\":%lu,\"ms\":%lu,\"lines_per_s\":%lu,\"errors\":%lu}",
+                     modes[m], (unsigned long)lines, (unsigned long)matched, (unsigned long)ms,
+                     bench_rate(lines, ms), (unsigned long)errors);
+    }
+    return errors > 0 ? lwespERR : lwespOK;
+}
+
+/**
+ * \brief           Responses of single command, repeated to build long burst in scan benchmark.
+ *                  Recorded on AT port with emulated and real device
+ */
+static const struct {
+    const char* name;                           /*!< Burst name */
+    const char* resp;                           /*!< Response lines */
+} bench_bursts[] = {
+    { "cwlap", "+CWLAP:(3,\"lwesp_emul\",-45,\"24:0a:c4:00:00:01\",6,-12,0,4,4,7,0)\r\n"
+               "+CWLAP:(4,\"Guest network 5th floor\",-71,\"24:0a:c4:00:00:02\",11,-8,0,4,4,7,1)\r\n"
+               "+CWLAP:(0,\"open\",-88,\"b8:27:eb:12:34:56\",1,20,0,0,0,3,0)\r\n" },
+    { "gmr", "AT version:1.7.4.0(May 11 2020 19:13:04)\r\n"
+             "SDK version:3.0.4(9532ceb)\r\n"
+             "compile time:May 27 2020 10:12:17\r\n"
+             "Bin version(Wroom 02):1.7.4\r\n"
+             "OK\r\n" },
+    { "cipstatus", "STATUS:3\r\n"
+                   "+CIPSTATUS:0,\"TCP\",\"192.168.1.100\",80,50123,0\r\n"
+                   "+CIPSTATUS:1,\"TCP\",\"93.184.216.34\",443,50124,0\r\n"
+                   "+CIPSTATUS:4,\"UDP\",\"255.255.255.255\",5000,5000,0\r\n"
+                   "OK\r\n" },
+};
+
+/**
+ * \brief           Get number of plain characters at the beginning of data, checking byte by byte.
+ *                  Reference for \ref lwespi_scan_plain
+ * \param[in]       d: Data to scan
+ * \param[in]       len: Length of data in units of bytes
+ * \return          Number of characters until first non-plain character
+ */
+static size_t
+bench_scan_bytes(const uint8_t* d, size_t len) {
+    size_t i;
+
+    for (i = 0; i < len; ++i) {
+        if (!((d[i] >= 32 && d[i] <= 126 && d[i] != ':' && d[i] != '>') || d[i] == '\r')) {
+            break;
+        }
+    }
+    return i;
+}
+
+/**
+ * \brief           Compare word scanner against byte by byte check
+ *
+ * Every byte value is placed at every position of two words, with every alignment of data.
+ * Random data with mostly plain characters is checked afterwards
+ *
+ * \return          Number of mismatches
+ */
+static size_t
+bench_scan_check(void) {
+    uint32_t rnd = 0x12345678;
+    size_t errors = 0, off, len;
+
+    for (size_t pos = 0; pos < 2 * sizeof(size_t); ++pos) {
+        for (size_t b = 0; b < 256; ++b) {
+            for (off = 0; off < sizeof(size_t); ++off) {
+                len = 3 * sizeof(size_t);
+                memset(bench_burst, 'A', off + len);
+                bench_burst[off + pos] = (uint8_t)b;
+                if (lwespi_scan_plain(&bench_burst[off], len) != bench_scan_bytes(&bench_burst[off], len)) {
+                    ++errors;
+                }
+            }
+        }
+    }
+    for (size_t i = 0; i < 100000; ++i) {
+        off = i % sizeof(size_t);
+        len = i % 67;
+        for (size_t k = 0; k < off + len; ++k) {
+            rnd = rnd * 1103515245 + 12345;
+            bench_burst[k] = (rnd >> 16) % 64 == 0 ? (uint8_t)(rnd >> 24) : (uint8_t)(' ' + (rnd >> 16) % 95);
+        }
+        if (lwespi_scan_plain(&bench_burst[off], len) != bench_scan_bytes(&bench_burst[off], len)) {
+            ++errors;
+        }
+    }
+    return errors;
+}
+
+/**
+ * \brief           Measure scan of plain characters in long response bursts, word at a time and byte by byte
+ *
+ * Scanners are first compared on all byte values and on random data, then timed on
+ * repeated `AT+CWLAP`, `AT+GMR` and `AT+CIPSTATUS` responses. Device is not used
+ * \param[in]       cfg: Benchmark configuration
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_bench_scan(const lwesp_bench_cfg_t* cfg) {
+    static const char* modes[] = { "word", "byte" };
+    size_t len, rlen, pos, runs, runs_ref, bytes, errors;
+    uint32_t start, ms;
+    lwespr_t res = lwespOK;
+
+    LWESP_ASSERT("cfg != NULL", cfg != NULL);
+    bench_cfg = cfg;
+
+    errors = bench_scan_check();
+    bench_output("{\"bench\":\"scan\",\"mode\":\"check\",\"errors\":%lu}", (unsigned long)errors);
+    if (errors > 0) {
+        res = lwespERR;
+    }
+
+    for (size_t b = 0; b < LWESP_ARRAYSIZE(bench_bursts); ++b) {
+        /* Repeat response to fill burst */
+        rlen = strlen(bench_bursts[b].resp);
+        for (len = 0; len + rlen <= sizeof(bench_burst); len += rlen) {
+            LWESP_MEMCPY(&bench_burst[len], bench_bursts[b].resp, rlen);
+        }
+
+        runs_ref = 0;
+        for (size_t m = 0; m < LWESP_ARRAYSIZE(modes); ++m) {
+            bytes = 0;
+            errors = 0;
+            start = lwesp_sys_now();
+            do {
+                /* Find plain runs and skip special character after each of them, as input processing does */
+                runs = 0;
+                for (pos = 0; pos < len; ++pos, ++runs) {
+                    if (m == 0) {
+                        pos += lwespi_scan_plain(&bench_burst[pos], len - pos);
+                    } else {
+                        pos += bench_scan_bytes(&bench_burst[pos], len - pos);
+                    }
+                }
+                bytes += len;
+            } while (lwesp_sys_now() - start < bench_duration());
+            ms = lwesp_sys_now() - start;
+            if (m == 0) {
+                runs_ref = runs;
+            } else if (runs != runs_ref) {
+                ++errors;
+                res = lwespERR;
+            }
+            bench_output("{\"bench\":\"scan\",\"mode\":\"%s\",\"burst\":\"%s\",\"len\":%lu,\"runs\":%lu,\"bytes\":%lu,\"ms\":%lu,\"bytes_per_s\":%lu,\"errors\":%lu}",
+                         modes[m], bench_bursts[b].name, (unsigned long)len, (unsigned long)runs,
+                         (unsigned long)bytes, (unsigned long)ms, bench_rate(bytes, ms), (unsigned long)errors);
+        }
+    }
+    return res;
+}
+
+/**
+ * \brief           Measure `AT+CIPSEND` round trips with blocking \ref lwesp_conn_send
+ *                  and throughput with \ref lwesp_conn_write
+ * \param[in]       cfg: Benchmark configuration with TCP server
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_bench_conn_send(const lwesp_bench_cfg_t* cfg) {
+    static const size_t sizes[] = { 64, 512, LWESP_CFG_CONN_MAX_DATA_LEN, BENCH_SEND_MAX_SIZE };
+    lwesp_conn_p conn = NULL;
+    size_t cnt, written;
+    uint32_t start, ms;
+    lwespr_t res;
+    uint8_t ok;
+
+    LWESP_ASSERT("cfg != NULL", cfg != NULL);
+    bench_cfg = cfg;
+    if (cfg->host == NULL) {
+        return lwespPARERR;
+    }
+
+    res = lwesp_conn_start(&conn, LWESP_CONN_TYPE_TCP, cfg->host, cfg->port, NULL, bench_conn_evt, 1);
+    if (res != lwespOK) {
+        bench_output("{\"bench\":\"conn_send\",\"error\":%d}", (int)res);
+        return res;
+    }
+    LWESP_MEMSET(bench_data, 'a', sizeof(bench_data));
+
+    /* Blocking send, one command round trip per call */
+    for (size_t i = 0; i < LWESP_ARRAYSIZE(sizes); ++i) {
+#if LWESP_CFG_STATS
+        lwesp_stats_reset();
+#endif /* LWESP_CFG_STATS */
+        cnt = 0;
+        start = lwesp_sys_now();
+        do {
+            if ((res = lwesp_conn_send(conn, bench_data, sizes[i], NULL, 1)) != lwespOK) {
+                break;
+            }
+            ++cnt;
+        } while (lwesp_sys_now() - start < bench_duration());
+        ms = lwesp_sys_now() - start;
+
+        bench_output("{\"bench\":\"conn_send\",\"size\":%u,\"sends\":%lu,\"ms\":%lu,\"sends_per_s\":%lu,\"bytes_per_s\":%lu,\"error\":%d}",
+                     (unsigned)sizes[i], (unsigned long)cnt, (unsigned long)ms, bench_rate(cnt, ms),
+                     bench_rate(cnt * sizes[i], ms), (int)res);
+#if LWESP_CFG_STATS
+        bench_output_send_gap("send", sizes[i]);    /* Chunks of sends longer than maximal data length */
+#endif /* LWESP_CFG_STATS */
+        if (res != lwespOK) {
+            break;
+        }
+    }
+
+    /* Buffered write, sends are queued non-blocking */
+    for (size_t i = 0; res == lwespOK && i < LWESP_ARRAYSIZE(sizes); ++i) {
+        lwesp_core_lock();
+        bench_sent = 0;
+        bench_send_err = 0;
+        lwesp_core_unlock();
+#if LWESP_CFG_STATS
+        lwesp_stats_reset();
+#endif /* LWESP_CFG_STATS */
+
+        written = 0;
+        start = lwesp_sys_now();
+        do {
+            if (written - bench_counter(&bench_sent) > BENCH_SEND_WINDOW) {
+                lwesp_delay(1);                 /* Let producer queue drain */
+                continue;
+            }
+            lwesp_core_lock();                  /* Write may only be called from core context */
+            res = lwesp_conn_write(conn, bench_data, sizes[i], 0, NULL);
+            lwesp_core_unlock();
+            if (res != lwespOK) {
+                break;
+            }
+            written += sizes[i];
+        } while (lwesp_sys_now() - start < bench_duration());
+        lwesp_core_lock();
+        lwesp_conn_write(conn, NULL, 0, 1, NULL);
+        lwesp_core_unlock();
+        ok = bench_wait_counter(&bench_sent, written, 1000);
+        ms = lwesp_sys_now() - start;
+
+        bench_output("{\"bench\":\"conn_write\",\"size\":%u,\"bytes\":%lu,\"ms\":%lu,\"bytes_per_s\":%lu,\"send_errors\":%lu,\"timeout\":%u,\"error\":%d}",
+                     (unsigned)sizes[i], (unsigned long)written, (unsigned long)ms, bench_rate(written, ms),
+                     (unsigned long)bench_counter(&bench_send_err), (unsigned)!ok, (int)res);
+#if LWESP_CFG_STATS
+        bench_output_send_gap("write", sizes[i]);
+#endif /* LWESP_CFG_STATS */
+    }
+
+    lwesp_conn_close(conn, 1);
+    return res;
+}
+
+#if LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__
+
+/**
+ * \brief           Measure throughput of \ref lwesp_conn_send in passthrough mode
+ *
+ * Result includes line rate of AT port, which is upper limit of throughput,
+ * and number of bytes echoed back by server
+ * \param[in]       cfg: Benchmark configuration with TCP server
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_bench_passthrough(const lwesp_bench_cfg_t* cfg) {
+    static const size_t sizes[] = { 64, 512, LWESP_CFG_CONN_MAX_DATA_LEN };
+    lwesp_conn_p conn = NULL;
+    size_t written;
+    uint32_t start, ms, line_rate;
+    lwespr_t res;
+    uint8_t ok;
+
+    LWESP_ASSERT("cfg != NULL", cfg != NULL);
+    bench_cfg = cfg;
+    if (cfg->host == NULL) {
+        return lwespPARERR;
+    }
+
+    start = lwesp_sys_now();
+    res = lwesp_conn_passthrough_start(&conn, LWESP_CONN_TYPE_TCP, cfg->host, cfg->port, NULL, bench_conn_evt, 1);
+    ms = lwesp_sys_now() - start;
+    bench_output("{\"bench\":\"passthrough_start\",\"ms\":%lu,\"error\":%d}", (unsigned long)ms, (int)res);
+    if (res != lwespOK) {
+        return res;
+    }
+    LWESP_MEMSET(bench_data, 'a', sizeof(bench_data));
+
+    lwesp_core_lock();
+    line_rate = esp.ll.uart.baudrate / 10;      /* Start bit, 8 data bits and stop bit */
+    lwesp_core_unlock();
+
+    /* Non-blocking sends, data are written to AT port without handshake */
+    for (size_t i = 0; res == lwespOK && i < LWESP_ARRAYSIZE(sizes); ++i) {
+        lwesp_core_lock();
+        bench_sent = 0;
+        bench_recv = 0;
+        bench_send_err = 0;
+        lwesp_core_unlock();
+
+        written = 0;
+        start = lwesp_sys_now();
+        do {
+            if (written - bench_counter(&bench_sent) > BENCH_SEND_WINDOW) {
+                lwesp_delay(1);                 /* Let producer queue drain */
+                continue;
+            }
+            res = lwesp_conn_send(conn, bench_data, sizes[i], NULL, 0);
+            if (res == lwespERRMEM) {           /* Producer queue is full */
+                res = lwespOK;
+                lwesp_delay(1);
+                continue;
+            } else if (res != lwespOK) {
+                break;
+            }
+            written += sizes[i];
+        } while (lwesp_sys_now() - start < bench_duration());
+        ok = bench_wait_counter(&bench_sent, written, 1000);
+        ms = lwesp_sys_now() - start;
+        bench_wait_counter(&bench_recv, written, 200);  /* Echo server may not be used */
+
+        bench_output("{\"bench\":\"passthrough\",\"size\":%u,\"bytes\":%lu,\"ms\":%lu,\"bytes_per_s\":%lu,"
+                     "\"line_bytes_per_s\":%lu,\"recv_bytes\":%lu,\"send_errors\":%lu,\"timeout\":%u,\"error\":%d}",
+                     (unsigned)sizes[i], (unsigned long)written, (unsigned long)ms, bench_rate(written, ms),
+                     (unsigned long)line_rate, (unsigned long)bench_counter(&bench_recv),
+                     (unsigned long)bench_counter(&bench_send_err), (unsigned)!ok, (int)res);
+    }
+
+    start = lwesp_sys_now();
+    if (lwesp_conn_passthrough_stop(1) != lwespOK && res == lwespOK) {
+        res = lwespERR;
+    }
+    ms = lwesp_sys_now() - start;
+    bench_output("{\"bench\":\"passthrough_stop\",\"ms\":%lu,\"guard_time\":%lu,\"error\":%d}",
+                 (unsigned long)ms, (unsigned long)LWESP_CFG_CONN_PASSTHROUGH_GUARD_TIME, (int)res);
+    return res;
+}
+
+#endif /* LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__ */
+
+#if LWESP_CFG_STATS || __DOXYGEN__
+
+/**
+ * \brief           Output core statistics of single command
+ * \param[in]       mode: Mode of latency benchmark
+ * \param[in]       cmd: Command to output statistics for
+ * \param[out]      stats: Optional pointer to output statistics of command. Set to `NULL` if not used
+ */
+static void
+bench_output_cmd_stats(const char* mode, lwesp_cmd_t cmd, lwesp_stats_cmd_t* stats) {
+    lwesp_stats_cmd_t s[LWESP_CMD_END];
+    lwesp_stats_cmd_t* st = &s[cmd];
+    char hist[LWESP_CFG_STATS_HIST_LEN * 11 + 1];
+    size_t len = 0;
+
+    lwesp_stats_get(s, LWESP_ARRAYSIZE(s));
+    for (size_t i = 0; i < LWESP_CFG_STATS_HIST_LEN; ++i) {
+        len += snprintf(&hist[len], sizeof(hist) - len, "%s%lu", i > 0 ? "," : "", (unsigned long)st->hist[i]);
+    }
+    bench_output("{\"bench\":\"cmd_stats\",\"mode\":\"%s\",\"cmd\":\"%s\",\"count\":%lu,\"errors\":%lu,\"timeouts\":%lu,"
+                 "\"queue_ms\":%lu,\"queue_max_ms\":%lu,\"exec_ms\":%lu,\"exec_max_ms\":%lu,\"hist\":[%s]}",
+                 mode, lwesp_stats_cmd_name(cmd), (unsigned long)st->count,
+                 (unsigned long)st->errors, (unsigned long)st->timeouts, (unsigned long)st->queue_time,
+                 (unsigned long)st->queue_time_max, (unsigned long)st->exec_time, (unsigned long)st->exec_time_max, hist);
+    if (stats != NULL) {
+        *stats = *st;
+    }
+}
+
+#endif /* LWESP_CFG_STATS || __DOXYGEN__ */
+
+#if LWESP_CFG_MEM_STATS || __DOXYGEN__
+
+/**
+ * \brief           Output memory manager statistics
+ * \param[in]       name: Name of memory benchmark
+ */
+static void
+bench_output_mem_stats(const char* name) {
+    lwesp_mem_stats_t s;
+
+    lwesp_mem_get_stats(&s);
+    bench_output("{\"bench\":\"mem_stats\",\"type\":\"%s\",\"total\":%lu,\"free\":%lu,\"min_free\":%lu,"
+                 "\"largest_free\":%lu,\"free_blocks\":%lu,\"failed\":%lu,\"pbuf_bytes_max\":%lu,\"other_bytes_max\":%lu}",
+                 name, (unsigned long)s.total_bytes, (unsigned long)s.free_bytes, (unsigned long)s.min_free_bytes,
+                 (unsigned long)s.largest_free_block, (unsigned long)s.free_blocks, (unsigned long)s.alloc_failed,
+                 (unsigned long)s.tags[LWESP_MEM_TAG_PBUF].bytes_max, (unsigned long)s.tags[LWESP_MEM_TAG_OTHER].bytes_max);
+}
+
+#endif /* LWESP_CFG_MEM_STATS || __DOXYGEN__ */
+
+/**
+ * \brief           Measure time of reset sequences until device is ready
+ * \param[in]       mode: Name of reset mode
+ * \param[in]       snap: Snapshot for warm start, or `NULL` for full reset sequence
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+static lwespr_t
+bench_reset_mode(const char* mode, const void* snap) {
+    uint32_t start, t, d, ms, d_max = 0;
+    size_t cnt = 0;
+    lwespr_t res;
+
+    start = lwesp_sys_now();
+    do {
+        t = lwesp_sys_now();
+#if LWESP_CFG_RESET_WARM
+        res = snap != NULL ? lwesp_reset_warm(snap, NULL, NULL, 1) : lwesp_reset(NULL, NULL, 1);
+#else /* LWESP_CFG_RESET_WARM */
+        res = lwesp_reset(NULL, NULL, 1);
+#endif /* !LWESP_CFG_RESET_WARM */
+        if (res != lwespOK) {
+            return res;
+        }
+        d = lwesp_sys_now() - t;
+        d_max = LWESP_MAX(d_max, d);
+        ++cnt;
+    } while (lwesp_sys_now() - start < bench_duration());
+    ms = lwesp_sys_now() - start;
+    bench_output("{\"bench\":\"reset\",\"mode\":\"%s\",\"resets\":%lu,\"avg_ms\":%lu,\"max_ms\":%lu}",
+                 mode, (unsigned long)cnt, (unsigned long)(ms / cnt), (unsigned long)d_max);
+    LWESP_UNUSED(snap);
+    return lwespOK;
+}
+
+/**
+ * \brief           Measure time until device is ready after reset
+ *
+ * Full reset sequence is always measured,
+ * warm start is measured when \ref LWESP_CFG_RESET_WARM is enabled.
+ * Station is disconnected after reset, connection benchmarks must run before it
+ * \param[in]       cfg: Benchmark configuration
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_bench_reset(const lwesp_bench_cfg_t* cfg) {
+    lwespr_t res;
+
+    LWESP_ASSERT("cfg != NULL", cfg != NULL);
+    bench_cfg = cfg;
+
+    res = bench_reset_mode("cold", NULL);
+#if LWESP_CFG_RESET_WARM
+    if (res == lwespOK) {
+        lwesp_warm_snapshot_t snap;
+
+        lwesp_warm_get_snapshot(&snap);
+        res = bench_reset_mode("warm", &snap);
+    }
+#endif /* LWESP_CFG_RESET_WARM */
+    return res;
+}
+
+/**
+ * \brief           Measure latency of commands through producer and process threads
+ *
+ * Blocking mode waits for every command, queued mode keeps producer queue full.
+ * When TCP server is set, connection to closed port checks that failed command is counted as error
+ * \param[in]       cfg: Benchmark configuration
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_bench_cmd_latency(const lwesp_bench_cfg_t* cfg) {
+    uint32_t start, t, d, ms, d_min = 0xFFFFFFFF, d_max = 0;
+    size_t cnt = 0;
+    lwespr_t res;
+
+    LWESP_ASSERT("cfg != NULL", cfg != NULL);
+    bench_cfg = cfg;
+
+    /* Blocking, full latency of every command */
+#if LWESP_CFG_STATS
+    lwesp_stats_reset();
+#endif /* LWESP_CFG_STATS */
+    start = lwesp_sys_now();
+    do {
+        t = lwesp_sys_now();
+        if ((res = lwesp_get_conns_status(1)) != lwespOK) {
+            break;
+        }
+        d = lwesp_sys_now() - t;
+        d_min = LWESP_MIN(d_min, d);
+        d_max = LWESP_MAX(d_max, d);
+        ++cnt;
+    } while (lwesp_sys_now() - start < bench_duration());
+    ms = lwesp_sys_now() - start;
+    bench_output("{\"bench\":\"cmd_latency\",\"mode\":\"blocking\",\"cmds\":%lu,\"ms\":%lu,\"cmds_per_s\":%lu,\"avg_us\":%lu,\"min_ms\":%lu,\"max_ms\":%lu,\"error\":%d}",
+                 (unsigned long)cnt, (unsigned long)ms, bench_rate(cnt, ms),
+                 (unsigned long)(cnt > 0 ? (uint64_t)ms * 1000 / cnt : 0),
+                 (unsigned long)(cnt > 0 ? d_min : 0), (unsigned long)d_max, (int)res);
+#if LWESP_CFG_STATS
+    bench_output_cmd_stats("blocking", LWESP_CMD_TCPIP_CIPSTATUS, NULL);
+#endif /* LWESP_CFG_STATS */
+    if (res != lwespOK) {
+        return res;
+    }
+
+    /* Queued, commands are waiting in producer queue */
+#if LWESP_CFG_STATS
+    lwesp_stats_reset();
+#endif /* LWESP_CFG_STATS */
+    cnt = 0;
+    start = lwesp_sys_now();
+    do {
+        res = lwesp_get_conns_status(0);
+        if (res == lwespOK) {
+            ++cnt;
+        } else if (res == lwespERRMEM) {
+            lwesp_sys_thread_yield();           /* Queue is full */
+        } else {
+            break;
+        }
+    } while (lwesp_sys_now() - start < bench_duration());
+    if (res == lwespOK || res == lwespERRMEM) {
+        res = lwesp_get_conns_status(1);        /* Queue is processed in order, last command finishes after others */
+        ++cnt;
+    }
+    ms = lwesp_sys_now() - start;
+    bench_output("{\"bench\":\"cmd_latency\",\"mode\":\"queued\",\"cmds\":%lu,\"ms\":%lu,\"cmds_per_s\":%lu,\"avg_us\":%lu,\"error\":%d}",
+                 (unsigned long)cnt, (unsigned long)ms, bench_rate(cnt, ms),
+                 (unsigned long)(cnt > 0 ? (uint64_t)ms * 1000 / cnt : 0), (int)res);
+#if LWESP_CFG_STATS
+    bench_output_cmd_stats("queued", LWESP_CMD_TCPIP_CIPSTATUS, NULL);
+
+    /* Command answered with error must be counted as error */
+    if (res == lwespOK && bench_cfg->host != NULL) {
+        lwesp_stats_cmd_t st;
+
+        lwesp_stats_reset();
+        res = lwesp_conn_start(NULL, LWESP_CONN_TYPE_TCP, bench_cfg->host, BENCH_CLOSED_PORT, NULL, bench_conn_evt, 1);
+        bench_output_cmd_stats("failing", LWESP_CMD_TCPIP_CIPSTART, &st);
+        res = res != lwespOK && st.count == 1 && st.errors == 1 ? lwespOK : lwespERR;
+    }
+#endif /* LWESP_CFG_STATS */
+    return res;
+}
+
+/**
+ * \brief           Measure allocator with random mix of allocations and frees
+ * \param[in]       cfg: Benchmark configuration
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_bench_mem(const lwesp_bench_cfg_t* cfg) {
+    static const char* names[] = { "mem", "pbuf" };
+    void* slots[BENCH_MEM_SLOTS] = { 0 };
+    size_t ops, failed, idx, size;
+    uint32_t seed, start, ms;
+
+    LWESP_ASSERT("cfg != NULL", cfg != NULL);
+    bench_cfg = cfg;
+
+    for (size_t type = 0; type < LWESP_ARRAYSIZE(names); ++type) {
+        ops = 0;
+        failed = 0;
+        seed = 1;                               /* Same sequence on every run */
+        start = lwesp_sys_now();
+        do {
+            for (size_t i = 0; i < 256; ++i, ++ops) {
+                seed = seed * 1103515245UL + 12345UL;
+                idx = (seed >> 16) % BENCH_MEM_SLOTS;
+                size = 16 + (seed >> 4) % BENCH_IPD_MAX_PAYLOAD;
+                if (slots[idx] != NULL) {
+                    if (type == 0) {
+                        lwesp_mem_free_s(&slots[idx]);
+                    } else {
+                        lwesp_pbuf_free(slots[idx]);
+                        slots[idx] = NULL;
+                    }
+                } else {
+                    slots[idx] = type == 0 ? lwesp_mem_malloc(size) : (void*)lwesp_pbuf_new(size);
+                    if (slots[idx] == NULL) {
+                        ++failed;
+                    }
+                }
+            }
+        } while (lwesp_sys_now() - start < bench_duration());
+        ms = lwesp_sys_now() - start;
+#if LWESP_CFG_MEM_STATS
+        bench_output_mem_stats(names[type]);    /* Fragmentation while blocks are still allocated */
+#endif /* LWESP_CFG_MEM_STATS */
+
+        for (size_t i = 0; i < BENCH_MEM_SLOTS; ++i) {
+            if (slots[i] != NULL) {
+                if (type == 0) {
+                    lwesp_mem_free_s(&slots[i]);
+                } else {
+                    lwesp_pbuf_free(slots[i]);
+                    slots[i] = NULL;
+                }
+            }
+        }
+        bench_output("{\"bench\":\"%s\",\"ops\":%lu,\"ms\":%lu,\"ops_per_s\":%lu,\"failed\":%lu}",
+                     names[type], (unsigned long)ops, (unsigned long)ms, bench_rate(ops, ms), (unsigned long)failed);
+    }
+    return lwespOK;
+}
+
+/**
+ * \brief           Single operation of recorded allocation trace
+ */
+typedef struct {
+    uint8_t slot;                               /*!< Slot of allocation, referenced by later free */
+    uint16_t size;                              /*!< Number of bytes to allocate, `0` to free slot */
+} bench_mem_op_t;
+
+/**
+ * \brief           Allocations and frees of the stack, recorded on POSIX port with emulated device
+ *                  and \ref LWESP_CFG_PBUF_POOL disabled, during reset, join, command latency and send benchmarks.
+ *                  Long runs of the same allocation followed by free are shortened to two runs
+ */
+static const bench_mem_op_t
+bench_mem_trace[] = {
+    { 0, 1024 }, { 1, 176 }, { 1, 0 }, { 1, 176 }, { 1, 0 }, { 1, 176 }, { 2, 176 }, { 3, 176 },
+    { 4, 176 }, { 5, 176 }, { 6, 176 }, { 7, 176 }, { 8, 176 }, { 9, 176 }, { 10, 176 }, { 11, 176 },
+    { 12, 176 }, { 13, 176 }, { 14, 176 }, { 15, 176 }, { 16, 176 }, { 17, 176 }, { 18, 176 }, { 18, 0 },
+    { 18, 176 }, { 18, 0 }, { 1, 0 }, { 1, 176 }, { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 },
+    { 2, 0 }, { 2, 176 }, { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 }, { 3, 0 }, { 3, 176 },
+    { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 }, { 4, 0 }, { 4, 176 }, { 18, 176 }, { 18, 0 },
+    { 18, 176 }, { 18, 0 }, { 5, 0 }, { 5, 176 }, { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 },
+    { 6, 0 }, { 6, 176 }, { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 }, { 7, 0 }, { 7, 176 },
+    { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 }, { 8, 0 }, { 8, 176 }, { 18, 176 }, { 18, 0 },
+    { 18, 176 }, { 18, 0 }, { 9, 0 }, { 9, 176 }, { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 },
+    { 10, 0 }, { 10, 176 }, { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 }, { 11, 0 }, { 11, 176 },
+    { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 }, { 12, 0 }, { 12, 176 }, { 18, 176 }, { 18, 0 },
+    { 18, 176 }, { 18, 0 }, { 13, 0 }, { 13, 176 }, { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 },
+    { 14, 0 }, { 14, 176 }, { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 }, { 15, 0 }, { 15, 176 },
+    { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 }, { 16, 0 }, { 16, 176 }, { 18, 176 }, { 18, 0 },
+    { 18, 176 }, { 18, 0 }, { 17, 0 }, { 17, 176 }, { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 },
+    { 1, 0 }, { 1, 176 }, { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 }, { 2, 0 }, { 2, 176 },
+    { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 }, { 3, 0 }, { 3, 176 }, { 18, 176 }, { 18, 0 },
+    { 18, 176 }, { 18, 0 }, { 4, 0 }, { 4, 176 }, { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 },
+    { 5, 0 }, { 5, 176 }, { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 }, { 6, 0 }, { 6, 176 },
+    { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 }, { 7, 0 }, { 7, 176 }, { 18, 176 }, { 18, 0 },
+    { 18, 176 }, { 18, 0 }, { 8, 0 }, { 8, 176 }, { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 },
+    { 9, 0 }, { 9, 176 }, { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 }, { 10, 0 }, { 10, 176 },
+    { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 }, { 11, 0 }, { 11, 176 }, { 18, 176 }, { 18, 0 },
+    { 18, 176 }, { 18, 0 }, { 12, 0 }, { 12, 176 }, { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 },
+    { 13, 0 }, { 13, 176 }, { 18, 176 }, { 18, 0 }, { 18, 176 }, { 18, 0 }, { 14, 0 }, { 14, 176 },
+    { 18, 176 }, { 15, 0 }, { 16, 0 }, { 17, 0 }, { 1, 0 }, { 2, 0 }, { 3, 0 }, { 4, 0 },
+    { 5, 0 }, { 6, 0 }, { 7, 0 }, { 8, 0 }, { 9, 0 }, { 10, 0 }, { 11, 0 }, { 12, 0 },
+    { 13, 0 }, { 14, 0 }, { 18, 0 }, { 1, 176 }, { 1, 0 }, { 1, 176 }, { 1, 0 }, { 1, 176 },
+    { 2, 112 }, { 2, 0 }, { 1, 0 }, { 1, 176 }, { 2, 112 }, { 2, 0 }, { 1, 0 }, { 1, 176 },
+    { 2, 112 }, { 2, 0 }, { 1, 0 }, { 1, 176 }, { 2, 112 }, { 2, 0 }, { 1, 0 }, { 1, 176 },
+    { 2, 112 }, { 2, 0 }, { 1, 0 }, { 1, 176 }, { 2, 112 }, { 2, 0 }, { 1, 0 }, { 1, 176 },
+    { 2, 112 }, { 2, 0 }, { 1, 0 }, { 1, 176 }, { 2, 560 }, { 2, 0 }, { 1, 0 }, { 1, 176 },
+    { 2, 560 }, { 2, 0 }, { 1, 0 }, { 1, 2048 }, { 2, 176 }, { 3, 2048 }, { 4, 176 }, { 5, 2048 },
+    { 6, 176 }, { 7, 2048 }, { 8, 176 }, { 9, 2048 }, { 10, 1508 }, { 11, 176 }, { 12, 2048 }, { 12, 0 },
+    { 10, 0 }, { 10, 636 }, { 10, 0 }, { 1, 0 }, { 2, 0 }, { 1, 1508 }, { 1, 0 }, { 1, 636 },
+    { 1, 0 }, { 3, 0 }, { 4, 0 }, { 1, 1508 }, { 1, 0 }, { 1, 636 }, { 1, 0 }, { 5, 0 },
+    { 6, 0 }, { 1, 1508 }, { 1, 0 }, { 1, 636 }, { 1, 0 }, { 7, 0 }, { 8, 0 }, { 1, 1508 },
+    { 1, 0 }, { 1, 636 }, { 1, 0 }, { 9, 0 }, { 11, 0 }, { 1, 2048 }, { 2, 176 }, { 3, 2048 },
+    { 4, 176 }, { 5, 2048 }, { 6, 176 }, { 7, 2048 }, { 8, 176 }, { 9, 2048 }, { 10, 112 }, { 10, 0 },
+    { 10, 176 }, { 11, 2048 }, { 11, 0 }, { 1, 0 }, { 2, 0 }, { 1, 1508 }, { 1, 0 }, { 1, 636 },
+    { 1, 0 }, { 3, 0 }, { 4, 0 }, { 1, 1508 }, { 1, 0 }, { 1, 636 }, { 1, 0 }, { 5, 0 },
+    { 6, 0 }, { 1, 1508 }, { 1, 0 }, { 1, 636 }, { 1, 0 }, { 7, 0 }, { 8, 0 }, { 1, 1508 },
+    { 1, 0 }, { 1, 636 }, { 1, 0 }, { 9, 0 }, { 10, 0 }, { 1, 2048 }, { 2, 176 }, { 3, 2048 },
+    { 4, 176 }, { 5, 2048 }, { 6, 176 }, { 7, 2048 }, { 8, 176 }, { 9, 2048 }, { 10, 176 }, { 11, 2048 },
+    { 12, 560 }, { 12, 0 }, { 11, 0 }, { 11, 2048 }, { 11, 0 }, { 1, 0 }, { 2, 0 }, { 1, 1508 },
+    { 1, 0 }, { 1, 636 }, { 1, 0 }, { 3, 0 }, { 4, 0 }, { 1, 1508 }, { 1, 0 }, { 1, 636 },
+    { 1, 0 }, { 5, 0 }, { 6, 0 }, { 1, 1508 }, { 1, 0 }, { 1, 636 }, { 1, 0 }, { 7, 0 },
+    { 8, 0 }, { 1, 1508 }, { 1, 0 }, { 1, 636 }, { 1, 0 }, { 9, 0 }, { 10, 0 }, { 1, 176 },
+    { 2, 1508 }, { 2, 0 }, { 1, 0 },
+};
+
+/**
+ * \brief           Replay allocation trace recorded from the stack
+ *
+ * Trace is replayed with the memory manager selected in configuration,
+ * `first_fit` by default or `tlsf` when \ref LWESP_CFG_MEM_TLSF is enabled.
+ * Run it with both configurations to compare the backends
+ *
+ * \param[in]       cfg: Benchmark configuration
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_bench_mem_trace(const lwesp_bench_cfg_t* cfg) {
+#if LWESP_CFG_MEM_CUSTOM
+    const char* backend = "custom";
+#elif LWESP_CFG_MEM_TLSF
+    const char* backend = "tlsf";
+#else /* LWESP_CFG_MEM_TLSF */
+    const char* backend = "first_fit";
+#endif /* !LWESP_CFG_MEM_CUSTOM */
+    void* slots[BENCH_MEM_TRACE_SLOTS] = { 0 };
+    size_t ops = 0, failed = 0, replays = 0;
+    uint32_t start, ms;
+
+    LWESP_ASSERT("cfg != NULL", cfg != NULL);
+    bench_cfg = cfg;
+
+    start = lwesp_sys_now();
+    do {
+        for (size_t i = 0; i < LWESP_ARRAYSIZE(bench_mem_trace); ++i, ++ops) {
+            const bench_mem_op_t* op = &bench_mem_trace[i];
+
+            if (op->size > 0) {
+                if ((slots[op->slot] = lwesp_mem_malloc(op->size)) == NULL) {
+                    ++failed;
+                }
+            } else {
+                lwesp_mem_free_s(&slots[op->slot]);
+            }
+        }
+
+        /* Free allocations still alive at the end of trace */
+        for (size_t i = 0; i < BENCH_MEM_TRACE_SLOTS; ++i) {
+            if (slots[i] != NULL) {
+                lwesp_mem_free_s(&slots[i]);
+                ++ops;
+            }
+        }
+        ++replays;
+    } while (lwesp_sys_now() - start < bench_duration());
+    ms = lwesp_sys_now() - start;
+
+    bench_output("{\"bench\":\"mem_trace\",\"backend\":\"%s\",\"trace_ops\":%lu,\"replays\":%lu,\"ops\":%lu,\"ms\":%lu,\"ops_per_s\":%lu,\"failed\":%lu}",
+                 backend, (unsigned long)LWESP_ARRAYSIZE(bench_mem_trace), (unsigned long)replays,
+                 (unsigned long)ops, (unsigned long)ms, bench_rate(ops, ms), (unsigned long)failed);
+#if LWESP_CFG_MEM_STATS
+    bench_output_mem_stats("mem_trace");        /* All blocks are freed, free memory must be merged back */
+#endif /* LWESP_CFG_MEM_STATS */
+    return failed > 0 ? lwespERRMEM : lwespOK;
+}
+
+/**
+ * \brief           Writer thread of message queue benchmark
+ *
+ * Writes entries until time is up, then `NULL` entry to signal the end
+ * \param[in]       arg: Writer parameters
+ */
+static void
+bench_mbox_writer_thread(void* arg) {
+    bench_mbox_writer_t* w = arg;
+    uint32_t t;
+
+    while (lwesp_sys_now() - w->start < w->duration) {
+        t = lwesp_sys_mbox_put(w->mbox, w);
+        w->max_put = LWESP_MAX(w->max_put, t);
+    }
+    lwesp_sys_mbox_put(w->mbox, NULL);          /* Result is visible to reader after this entry */
+    lwesp_sys_thread_terminate(NULL);
+}
+
+/**
+ * \brief           Measure message queue throughput with one and many writer threads
+ *
+ * Writers contend for producer-sized message queue like application threads calling API functions,
+ * benchmark thread reads like producer thread
+ * \param[in]       cfg: Benchmark configuration
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_bench_mbox(const lwesp_bench_cfg_t* cfg) {
+    size_t threads[2], msgs, done, started;
+    uint32_t start, ms, max_put;
+    void* m;
+
+    LWESP_ASSERT("cfg != NULL", cfg != NULL);
+    bench_cfg = cfg;
+    threads[0] = 1;
+    threads[1] = cfg->threads > 0 ? LWESP_MIN(cfg->threads, BENCH_MBOX_MAX_THREADS) : BENCH_MBOX_THREADS;
+
+    if (!lwesp_sys_mbox_isvalid(&bench_mbox)
+        && !lwesp_sys_mbox_create(&bench_mbox, LWESP_CFG_THREAD_PRODUCER_MBOX_SIZE)) {
+        return lwespERRMEM;
+    }
+
+    for (size_t i = 0; i < LWESP_ARRAYSIZE(threads); ++i) {
+        start = lwesp_sys_now();
+        for (started = 0; started < threads[i]; ++started) {
+            bench_writers[started].mbox = &bench_mbox;
+            bench_writers[started].start = start;
+            bench_writers[started].duration = bench_duration();
+            bench_writers[started].max_put = 0;
+            if (!lwesp_sys_thread_create(NULL, "lwesp_bench", bench_mbox_writer_thread, &bench_writers[started],
+                                         LWESP_SYS_THREAD_SS, LWESP_SYS_THREAD_PRIO)) {
+                break;
+            }
+        }
+
+        msgs = 0;
+        done = 0;
+        while (done < started) {
+            lwesp_sys_mbox_get(&bench_mbox, &m, 0);
+            if (m != NULL) {
+                ++msgs;
+            } else {
+                ++done;
+            }
+        }
+        ms = lwesp_sys_now() - start;
+
+        max_put = 0;
+        for (size_t t = 0; t < started; ++t) {
+            max_put = LWESP_MAX(max_put, bench_writers[t].max_put);
+        }
+        bench_output("{\"bench\":\"mbox\",\"lockfree\":%u,\"threads\":%u,\"msgs\":%lu,\"ms\":%lu,\"msgs_per_s\":%lu,\"max_put_ms\":%lu}",
+                     (unsigned)LWESP_CFG_SYS_MBOX_LOCKFREE, (unsigned)started, (unsigned long)msgs, (unsigned long)ms,
+                     bench_rate(msgs, ms), (unsigned long)max_put);
+        if (started < threads[i]) {
+            return lwespERRMEM;
+        }
+    }
+    return lwespOK;
+}
+
+/**
+ * \brief           Timeout callback of concurrent timeouts benchmark
+ * \param[in]       arg: Pointer to expected expiry time
+ */
+static void
+bench_timeout_fn(void* arg) {
+    int32_t late = (int32_t)(lwesp_sys_now() - *(uint32_t*)arg);
+
+    if (late < 0) {
+        ++bench_to_early;
+    } else {
+        bench_to_late_max = LWESP_MAX(bench_to_late_max, (uint32_t)late);
+    }
+    ++bench_to_fired;
+}
+
+/**
+ * \brief           Timeout callback which restarts its own timeout
+ *
+ * Waits for next millisecond before restart, so that restart
+ * happens with newer time than the one timeouts were processed with
+ * \param[in]       arg: Pointer to expected expiry time
+ */
+static void
+bench_timeout_rearm_fn(void* arg) {
+    uint32_t t = lwesp_sys_now();
+
+    bench_timeout_fn(arg);
+    if (bench_to_fired < BENCH_TIMEOUT_REARMS) {
+        while (lwesp_sys_now() == t) {}
+        *(uint32_t*)arg = lwesp_sys_now() + BENCH_TIMEOUT_PERIOD;
+        lwesp_timeout_start(&bench_to[0], BENCH_TIMEOUT_PERIOD, bench_timeout_rearm_fn, arg);
+    }
+}
+
+/**
+ * \brief           Measure timeout manager with many concurrent timeouts
+ *
+ * Restarts \ref BENCH_TIMEOUT_CNT timeouts with random times, then waits for all of them to expire.
+ * Also checks that timeout restarted from its own callback expires once per period.
+ * Early expiries are reported as errors
+ * \param[in]       cfg: Benchmark configuration
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_bench_timeout(const lwesp_bench_cfg_t* cfg) {
+    size_t ops = 0, fired, early, errors;
+    uint32_t seed = 1, start, ms, wait, late_max;
+
+    LWESP_ASSERT("cfg != NULL", cfg != NULL);
+    bench_cfg = cfg;
+
+    /* Restart all timeouts until time is up, none may expire before end of the loop */
+    lwesp_core_lock();
+    bench_to_fired = 0;
+    bench_to_early = 0;
+    bench_to_late_max = 0;
+    lwesp_core_unlock();
+    start = lwesp_sys_now();
+    do {
+        for (size_t i = 0; i < BENCH_TIMEOUT_CNT; ++i, ++ops) {
+            seed = seed * 1103515245UL + 12345UL;
+            wait = bench_duration() + (seed >> 16) % BENCH_TIMEOUT_SPREAD;
+            lwesp_core_lock();
+            bench_to_expiry[i] = lwesp_sys_now() + wait;
+            lwesp_timeout_start(&bench_to[i], wait, bench_timeout_fn, &bench_to_expiry[i]);
+            lwesp_core_unlock();
+        }
+    } while (lwesp_sys_now() - start < bench_duration());
+    ms = lwesp_sys_now() - start;
+    fired = bench_counter(&bench_to_fired);
+
+    /* Wait for all timeouts to expire */
+    bench_wait_counter(&bench_to_fired, BENCH_TIMEOUT_CNT, 2 * bench_duration() + BENCH_TIMEOUT_SPREAD);
+    for (size_t i = 0; i < BENCH_TIMEOUT_CNT; ++i) {
+        lwesp_timeout_stop(&bench_to[i]);
+    }
+    lwesp_core_lock();
+    errors = fired + bench_to_early + (BENCH_TIMEOUT_CNT - bench_to_fired);
+    late_max = bench_to_late_max;
+    lwesp_core_unlock();
+    bench_output("{\"bench\":\"timeout\",\"timers\":%u,\"starts\":%lu,\"ms\":%lu,\"starts_per_s\":%lu,\"late_max_ms\":%lu,\"errors\":%lu}",
+                 (unsigned)BENCH_TIMEOUT_CNT, (unsigned long)ops, (unsigned long)ms, bench_rate(ops, ms),
+                 (unsigned long)late_max, (unsigned long)errors);
+
+    /* Single timeout restarted from its own callback */
+    lwesp_core_lock();
+    bench_to_fired = 0;
+    bench_to_early = 0;
+    bench_to_late_max = 0;
+    start = lwesp_sys_now();
+    bench_to_expiry[0] = start + BENCH_TIMEOUT_PERIOD;
+    lwesp_timeout_start(&bench_to[0], BENCH_TIMEOUT_PERIOD, bench_timeout_rearm_fn, &bench_to_expiry[0]);
+    lwesp_core_unlock();
+    bench_wait_counter(&bench_to_fired, BENCH_TIMEOUT_REARMS, BENCH_TIMEOUT_SPREAD);
+    ms = lwesp_sys_now() - start;
+    lwesp_delay(2 * BENCH_TIMEOUT_PERIOD);      /* Timeout must not expire once more */
+    lwesp_timeout_stop(&bench_to[0]);
+    lwesp_core_lock();
+    fired = bench_to_fired;
+    early = bench_to_early;
+    late_max = bench_to_late_max;
+    lwesp_core_unlock();
+    errors += early + (fired != BENCH_TIMEOUT_REARMS);
+    bench_output("{\"bench\":\"timeout_rearm\",\"period_ms\":%u,\"fired\":%lu,\"ms\":%lu,\"late_max_ms\":%lu,\"early\":%lu}",
+                 (unsigned)BENCH_TIMEOUT_PERIOD, (unsigned long)fired, (unsigned long)ms,
+                 (unsigned long)late_max, (unsigned long)early);
+    return errors > 0 ? lwespERR : lwespOK;
+}
+
+/**
+ * \brief           Run all benchmarks
+ *
+ * Send benchmark is skipped when TCP server is not set in configuration.
+ * Reset benchmark runs last, as station is disconnected after reset
+ * \param[in]       cfg: Benchmark configuration
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_bench_run(const lwesp_bench_cfg_t* cfg) {
+    lwesp_sw_version_t v = { 0 };
+    lwespr_t res;
+
+    LWESP_ASSERT("cfg != NULL", cfg != NULL);
+    bench_cfg = cfg;
+
+    lwesp_get_current_at_fw_version(&v);
+    bench_output("{\"bench\":\"config\",\"at_version\":\"%u.%u.%u\",\"max_conns\":%u,\"rcv_buff_size\":%u,"
+                 "\"conn_max_recv_buff_size\":%u,\"conn_max_data_len\":%u,\"input_use_process\":%u,\"ipd_zero_copy\":%u,"
+                 "\"cmd_pipeline\":%u,\"conn_send_coalesce\":%u,\"mem_tlsf\":%u,\"pbuf_pool\":%u,"
+                 "\"input_buff_spsc\":%u,\"sys_mbox_lockfree\":%u,\"stats\":%u,\"mem_stats\":%u,\"reset_warm\":%u,"
+                 "\"conn_poll_adaptive\":%u,\"conn_passthrough\":%u,\"input_flow_control\":%u,\"conn_send_pipeline\":%u}",
+                 (unsigned)v.major, (unsigned)v.minor, (unsigned)v.patch, (unsigned)LWESP_CFG_MAX_CONNS,
+                 (unsigned)LWESP_CFG_RCV_BUFF_SIZE, (unsigned)LWESP_CFG_CONN_MAX_RECV_BUFF_SIZE,
+                 (unsigned)LWESP_CFG_CONN_MAX_DATA_LEN, (unsigned)LWESP_CFG_INPUT_USE_PROCESS,
+                 (unsigned)LWESP_CFG_IPD_ZERO_COPY, (unsigned)LWESP_CFG_CMD_PIPELINE,
+                 (unsigned)LWESP_CFG_CONN_SEND_COALESCE, (unsigned)LWESP_CFG_MEM_TLSF, (unsigned)LWESP_CFG_PBUF_POOL,
+                 (unsigned)LWESP_CFG_INPUT_BUFF_SPSC, (unsigned)LWESP_CFG_SYS_MBOX_LOCKFREE, (unsigned)LWESP_CFG_STATS,
+                 (unsigned)LWESP_CFG_MEM_STATS, (unsigned)LWESP_CFG_RESET_WARM, (unsigned)LWESP_CFG_CONN_POLL_ADAPTIVE,
+                 (unsigned)LWESP_CFG_CONN_PASSTHROUGH, (unsigned)LWESP_CFG_INPUT_FLOW_CONTROL,
+                 (unsigned)LWESP_CFG_CONN_SEND_PIPELINE);
+
+    if ((res = lwesp_bench_ipd_ingest(cfg)) != lwespOK
+        || (res = lwesp_bench_parser(cfg)) != lwespOK
+        || (res = lwesp_bench_scan(cfg)) != lwespOK
+        || (res = lwesp_bench_mem(cfg)) != lwespOK
+        || (res = lwesp_bench_mem_trace(cfg)) != lwespOK
+        || (res = lwesp_bench_mbox(cfg)) != lwespOK
+        || (res = lwesp_bench_timeout(cfg)) != lwespOK
+        || (res = lwesp_bench_cmd_latency(cfg)) != lwespOK) {
+        return res;
+    }
+    if (cfg->host != NULL) {
+        res = lwesp_bench_conn_send(cfg);
+#if LWESP_CFG_CONN_PASSTHROUGH
+        if (res == lwespOK) {
+            res = lwesp_bench_passthrough(cfg);
+        }
+#endif /* LWESP_CFG_CONN_PASSTHROUGH */
+    }
+    if (res == lwespOK) {
+        res = lwesp_bench_reset(cfg);           /* Last, reset disconnects station */
+    }
+    return res;
+}
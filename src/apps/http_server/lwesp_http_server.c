@@ -36,6 +36,7 @@
  * Copyright (c) 2021 niedong
  *
  *   - Remove debug message
+ *   - Account allocations to memory statistics tag
  */
 #include <ctype.h>
 #include "lwesp/apps/lwesp_http_server.h"
@@ -581,7 +582,7 @@ read_rlwesp_file(http_state_t* hs) {
                 hs->buff_ptr = 0;               /* Reset read pointer */
                 do {
                     hs->buff_len = len;
-                    hs->buff = (const void*)lwesp_mem_malloc(sizeof(*hs->buff) * hs->buff_len);
+                    hs->buff = (const void*)LWESP_MEM_MALLOC_TAG(sizeof(*hs->buff) * hs->buff_len, LWESP_MEM_TAG_HTTP);
                     if (hs->buff != NULL) {     /* Is memory ready? */
                         /* Read file directly and stop everything */
                         if (!http_fs_data_read_file(hi, &hs->rlwesp_file, (void**)&hs->buff, hs->buff_len, NULL)) {
@@ -881,7 +882,7 @@ http_evt(lwesp_evt_t* evt) {
     switch (lwesp_evt_get_type(evt)) {
         /* A new connection just became active */
         case LWESP_EVT_CONN_ACTIVE: {
-            hs = lwesp_mem_calloc(1, sizeof(*hs));
+            hs = LWESP_MEM_CALLOC_TAG(1, sizeof(*hs), LWESP_MEM_TAG_HTTP);
             if (hs != NULL) {
                 hs->conn = conn;                /* Save connection handle */
                 lwesp_conn_set_arg(conn, hs);   /* Set argument for connection */
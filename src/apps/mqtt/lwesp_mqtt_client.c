@@ -36,6 +36,9 @@
  * Copyright (c) 2021 niedong
  *
  *   - Remove debug message
+ *   - Send wrapped transmit buffer with single command
+ *   - Account allocations to memory statistics tag
+ *   - Measure keep-alive time with system time instead of poll events
  */
 #include "lwesp/apps/lwesp_mqtt_client.h"
 #include "lwesp/lwesp_mem.h"
@@ -49,12 +52,13 @@ typedef struct lwesp_mqtt_client {
     const lwesp_mqtt_client_info_t* info;       /*!< Connection info */
     lwesp_mqtt_state_t conn_state;              /*!< MQTT connection state */
 
-    uint32_t poll_time;                         /*!< Poll time, increased every 500ms */
+    uint32_t keep_alive_time;                   /*!< Time of last keep-alive reset in units of milliseconds */
 
     lwesp_mqtt_evt_t evt;                       /*!< MQTT event callback */
     lwesp_mqtt_evt_fn evt_fn;                   /*!< Event callback function */
 
     lwesp_buff_t tx_buff;                       /*!< Buffer for raw output data to transmit */
+    lwesp_iovec_t tx_iov[2];                    /*!< Segments of output buffer currently being sent */
 
     uint8_t is_sending;                         /*!< Flag if we are sending data currently */
     uint32_t sent_total;                        /*!< Total number of bytes sent so far on connection */
@@ -387,17 +391,24 @@ write_string(lwesp_mqtt_client_p client, const char* str, uint16_t len) {
 static void
 send_data(lwesp_mqtt_client_p client) {
     size_t len;
-    const void* addr;
 
     if (client->is_sending) {                   /* We are currently sending data */
         return;
     }
 
-    len = lwesp_buff_get_linear_block_read_length(&client->tx_buff);/* Get length of linear memory */
+    len = lwesp_buff_get_full(&client->tx_buff);/* Get length of all data in buffer */
     if (len > 0) {                              /* Anything to send? */
         lwespr_t res;
-        addr = lwesp_buff_get_linear_block_read_address(&client->tx_buff);  /* Get address of linear memory */
-        if ((res = lwesp_conn_send(client->conn, addr, len, NULL, 0)) == lwespOK) {
+
+        /*
+         * Data may overflow end of buffer and continue at its beginning.
+         * Send both parts directly from buffer memory with single command
+         */
+        client->tx_iov[0].data = lwesp_buff_get_linear_block_read_address(&client->tx_buff);
+        client->tx_iov[0].len = lwesp_buff_get_linear_block_read_length(&client->tx_buff);
+        client->tx_iov[1].data = client->tx_buff.buff;
+        client->tx_iov[1].len = len - client->tx_iov[0].len;
+        if ((res = lwesp_conn_sendv(client->conn, client->tx_iov, client->tx_iov[1].len > 0 ? 2 : 1, NULL, 0)) == lwespOK) {
             client->written_total += len;       /* Increase number of bytes written to queue */
             client->is_sending = 1;             /* Remember active sending flag */
         }
@@ -797,7 +808,7 @@ mqtt_connected_cb(lwesp_mqtt_client_p client) {
 
     client->parser_state = MQTT_PARSER_STATE_INIT;  /* Reset parser state */
 
-    client->poll_time = 0;                      /* Reset kep alive time */
+    client->keep_alive_time = lwesp_sys_now();  /* Reset keep alive time */
     client->conn_state = LWESP_MQTT_CONNECTING; /* MQTT is connecting to server */
 
     send_data(client);                          /* Flush and send the actual data */
@@ -830,7 +841,7 @@ mqtt_data_sent_cb(lwesp_mqtt_client_p client, size_t sent_len, uint8_t successfu
     client->is_sending = 0;                     /* We are not sending anymore */
     client->sent_total += sent_len;
 
-    client->poll_time = 0;                      /* Reset kep alive time */
+    client->keep_alive_time = lwesp_sys_now();  /* Reset keep alive time */
 
     /*
      * In case transmit was not successful,
@@ -871,14 +882,12 @@ mqtt_data_sent_cb(lwesp_mqtt_client_p client, size_t sent_len, uint8_t successfu
 
 /**
  * \brief           Poll for client connection
- *                  Called every LWESP_CFG_CONN_POLL_INTERVAL ms when MQTT client TCP connection is established
+ *                  Called on poll event when MQTT client TCP connection is established
  * \param[in]       client: MQTT client
  * \return          `1` on success, `0` otherwise
  */
 static uint8_t
 mqtt_poll_cb(lwesp_mqtt_client_p client) {
-    ++client->poll_time;
-
     if (client->conn_state == LWESP_MQTT_CONN_DISCONNECTING) {
         return 0;
     }
@@ -889,14 +898,14 @@ mqtt_poll_cb(lwesp_mqtt_client_p client) {
      * to make sure we are still alive
      */
     if (client->info->keep_alive                /* Keep alive must be enabled */
-        /* Poll time is in units of LWESP_CFG_CONN_POLL_INTERVAL milliseconds,
-           while keep_alive is in units of seconds */
-        && (client->poll_time * LWESP_CFG_CONN_POLL_INTERVAL) >= (uint32_t)(client->info->keep_alive * 1000)) {
+        /* Keep alive is in units of seconds. Poll events may be delayed,
+           do not count them to measure time */
+        && (lwesp_sys_now() - client->keep_alive_time) >= (uint32_t)(client->info->keep_alive * 1000)) {
 
         if (output_check_enough_memory(client, 0)) {/* Check if memory available in output buffer */
             write_fixed_header(client, MQTT_MSG_TYPE_PINGREQ, 0, (lwesp_mqtt_qos_t)0, 0, 0);/* Write PINGREQ command to output buffer */
             send_data(client);                  /* Force send data */
-            client->poll_time = 0;              /* Reset polling time */
+            client->keep_alive_time = lwesp_sys_now();  /* Reset keep alive time */
         } else {
             /* Not enough memory */
         }
@@ -1040,7 +1049,7 @@ lwesp_mqtt_client_t*
 lwesp_mqtt_client_new(size_t tx_buff_len, size_t rx_buff_len) {
     lwesp_mqtt_client_p client;
 
-    client = lwesp_mem_malloc(sizeof(*client));
+    client = LWESP_MEM_MALLOC_TAG(sizeof(*client), LWESP_MEM_TAG_MQTT);
     if (client != NULL) {
         LWESP_MEMSET(client, 0x00, sizeof(*client));
         client->conn_state = LWESP_MQTT_CONN_DISCONNECTED;  /* Set to disconnected mode */
@@ -1050,7 +1059,7 @@ lwesp_mqtt_client_new(size_t tx_buff_len, size_t rx_buff_len) {
         }
         if (client != NULL) {
             client->rx_buff_len = rx_buff_len;
-            client->rx_buff = lwesp_mem_malloc(rx_buff_len);
+            client->rx_buff = LWESP_MEM_MALLOC_TAG(rx_buff_len, LWESP_MEM_TAG_MQTT);
             if (client->rx_buff == NULL) {
                 lwesp_buff_free(&client->tx_buff);
                 lwesp_mem_free_s((void**)&client);
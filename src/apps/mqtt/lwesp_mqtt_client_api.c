@@ -36,6 +36,7 @@
  * Copyright (c) 2021 niedong
  *
  *   - Remove debug message
+ *   - Account allocations to memory statistics tag
  */
 #include "lwesp/apps/lwesp_mqtt_client_api.h"
 #include "lwesp/lwesp_mem.h"
@@ -121,7 +122,7 @@ mqtt_evt(lwesp_mqtt_client_p client, lwesp_mqtt_evt_t* evt) {
                 payload_size = LWESP_MEM_ALIGN(sizeof(*payload) * (payload_len + 1));
 
                 size = buf_size + topic_size + payload_size;
-                buf = lwesp_mem_malloc(size);
+                buf = LWESP_MEM_MALLOC_TAG(size, LWESP_MEM_TAG_MQTT);
                 if (buf != NULL) {
                     LWESP_MEMSET(buf, 0x00, size);
                     buf->topic = (void*)((uint8_t*)buf + buf_size);
@@ -192,7 +193,7 @@ lwesp_mqtt_client_api_new(size_t tx_buff_len, size_t rx_buff_len) {
     size = LWESP_MEM_ALIGN(sizeof(*client));    /* Get size of client itself */
 
     /* Create client APi structure */
-    client = lwesp_mem_calloc(1, size);         /* Allocate client memory */
+    client = LWESP_MEM_CALLOC_TAG(1, size, LWESP_MEM_TAG_MQTT);    /* Allocate client memory */
     if (client != NULL) {
         /* Create MQTT raw client structure */
         client->mc = lwesp_mqtt_client_new(tx_buff_len, rx_buff_len);
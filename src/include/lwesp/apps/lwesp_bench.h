@@ -0,0 +1,101 @@
+/**
+ * \file            lwesp_bench.h
+ * \brief           Benchmark of AT data path
+ */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwESP - Lightweight ESP-AT parser library.
+ */
+#ifndef LWESP_HDR_APP_BENCH_H
+#define LWESP_HDR_APP_BENCH_H
+
+#include "lwesp/apps/lwesp_apps.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \ingroup         LWESP_APPS
+ * \defgroup        LWESP_APP_BENCH Benchmark
+ * \brief           Benchmark of receive, send and command paths of the stack
+ *
+ * Every result is reported as single line with one JSON object,
+ * for example `{"bench":"ipd_ingest","mode":"copy","payload":1460,"chunk":64,"bytes":1051200,"ms":205,"bytes_per_s":5127804}`.
+ * First line of \ref lwesp_bench_run describes build configuration,
+ * to compare results between commits and configurations.
+ *
+ * Stack must be initialized before benchmark is started
+ * and no other application may use it while benchmark is running.
+ * \ref lwesp_bench_ipd_ingest feeds scripted data to input module, \ref lwesp_bench_parser
+ * and \ref lwesp_bench_scan process recorded responses, they do not need a device,
+ * other benchmarks need device or emulated device (`lwesp_ll_emul.c`).
+ * \{
+ */
+
+/**
+ * \brief           Output function for result lines
+ * \param[in]       line: Zero-terminated line with JSON object, without line ending
+ */
+typedef void (*lwesp_bench_output_fn)(const char* line);
+
+/**
+ * \brief           Benchmark configuration
+ */
+typedef struct {
+    lwesp_bench_output_fn output_fn;            /*!< Output function for results */
+    uint32_t duration;                          /*!< Duration of single measurement in units of milliseconds.
+                                                    Set to `0` to use default value */
+    const char* host;                           /*!< Host of TCP server that discards or echoes received data,
+                                                    for send benchmark. Set to `NULL` to skip send benchmark */
+    lwesp_port_t port;                          /*!< Port of TCP server */
+    size_t threads;                             /*!< Number of writer threads in message queue benchmark.
+                                                    Set to `0` to use default value */
+} lwesp_bench_cfg_t;
+
+lwespr_t    lwesp_bench_run(const lwesp_bench_cfg_t* cfg);
+lwespr_t    lwesp_bench_ipd_ingest(const lwesp_bench_cfg_t* cfg);
+lwespr_t    lwesp_bench_parser(const lwesp_bench_cfg_t* cfg);
+lwespr_t    lwesp_bench_scan(const lwesp_bench_cfg_t* cfg);
+lwespr_t    lwesp_bench_conn_send(const lwesp_bench_cfg_t* cfg);
+lwespr_t    lwesp_bench_cmd_latency(const lwesp_bench_cfg_t* cfg);
+lwespr_t    lwesp_bench_mem(const lwesp_bench_cfg_t* cfg);
+lwespr_t    lwesp_bench_mem_trace(const lwesp_bench_cfg_t* cfg);
+lwespr_t    lwesp_bench_mbox(const lwesp_bench_cfg_t* cfg);
+lwespr_t    lwesp_bench_timeout(const lwesp_bench_cfg_t* cfg);
+lwespr_t    lwesp_bench_reset(const lwesp_bench_cfg_t* cfg);
+#if LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__
+lwespr_t    lwesp_bench_passthrough(const lwesp_bench_cfg_t* cfg);
+#endif /* LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__ */
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LWESP_HDR_APP_BENCH_H */
@@ -55,6 +55,10 @@ extern "C" {
 lwespr_t    lwesp_init(lwesp_evt_fn cb_func, const uint32_t blocking);
 lwespr_t    lwesp_reset(const lwesp_api_cmd_evt_fn evt_fn, void* const evt_arg, const uint32_t blocking);
 lwespr_t    lwesp_reset_with_delay(uint32_t delay, const lwesp_api_cmd_evt_fn evt_fn, void* const evt_arg, const uint32_t blocking);
+#if LWESP_CFG_RESET_WARM || __DOXYGEN__
+lwespr_t    lwesp_warm_get_snapshot(lwesp_warm_snapshot_t* snap);
+lwespr_t    lwesp_reset_warm(const lwesp_warm_snapshot_t* snap, const lwesp_api_cmd_evt_fn evt_fn, void* const evt_arg, const uint32_t blocking);
+#endif /* LWESP_CFG_RESET_WARM || __DOXYGEN__ */
 
 lwespr_t    lwesp_restore(const lwesp_api_cmd_evt_fn evt_fn, void* const evt_arg, const uint32_t blocking);
 lwespr_t    lwesp_set_at_baudrate(uint32_t baud, const lwesp_api_cmd_evt_fn evt_fn, void* const evt_arg, const uint32_t blocking);
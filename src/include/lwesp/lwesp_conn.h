@@ -31,6 +31,13 @@
  * Author:          Tilen MAJERLE <tilen@majerle.eu>
  * Version:         v1.0.0
  */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ *   - Add adaptive connection poll statistics
+ *   - Add passthrough mode functions
+ */
 #ifndef LWESP_HDR_CONN_H
 #define LWESP_HDR_CONN_H
 
@@ -52,6 +59,8 @@ lwespr_t    lwesp_conn_startex(lwesp_conn_p* conn, lwesp_conn_start_t* start_str
 
 lwespr_t    lwesp_conn_close(lwesp_conn_p conn, const uint32_t blocking);
 lwespr_t    lwesp_conn_send(lwesp_conn_p conn, const void* data, size_t btw, size_t* const bw, const uint32_t blocking);
+lwespr_t    lwesp_conn_sendv(lwesp_conn_p conn, const lwesp_iovec_t* iov, size_t iovcnt, size_t* const bw, const uint32_t blocking);
+lwespr_t    lwesp_conn_send_pbuf(lwesp_conn_p conn, lwesp_pbuf_p pbuf, size_t* const bw, const uint32_t blocking);
 lwespr_t    lwesp_conn_sendto(lwesp_conn_p conn, const lwesp_ip_t* const ip, lwesp_port_t port, const void* data, size_t btw, size_t* bw, const uint32_t blocking);
 lwespr_t    lwesp_conn_set_arg(lwesp_conn_p conn, void* const arg);
 void*       lwesp_conn_get_arg(lwesp_conn_p conn);
@@ -72,6 +81,44 @@ lwesp_port_t  lwesp_conn_get_remote_port(lwesp_conn_p conn);
 lwesp_port_t  lwesp_conn_get_local_port(lwesp_conn_p conn);
 lwespr_t    lwesp_conn_ssl_set_config(uint8_t link_id, uint8_t auth_mode, uint8_t pki_number, uint8_t ca_number, const lwesp_api_cmd_evt_fn evt_fn, void* const evt_arg, const uint32_t blocking);
 
+#if LWESP_CFG_CONN_SEND_COALESCE || __DOXYGEN__
+
+/**
+ * \brief           Statistics of send command coalescing
+ */
+typedef struct {
+    size_t cmds;                                /*!< Number of `AT+CIPSEND` commands started by producer thread */
+    size_t merged;                              /*!< Number of send messages merged into previous command.
+                                                        This is number of `AT+CIPSEND` handshakes saved */
+} lwesp_conn_send_coalesce_stats_t;
+
+lwespr_t    lwesp_conn_get_send_coalesce_stats(lwesp_conn_send_coalesce_stats_t* stats);
+
+#endif /* LWESP_CFG_CONN_SEND_COALESCE || __DOXYGEN__ */
+
+#if LWESP_CFG_CONN_POLL_ADAPTIVE || __DOXYGEN__
+
+/**
+ * \brief           Statistics of adaptive connection poll
+ */
+typedef struct {
+    size_t polls;                               /*!< Number of poll events sent to connections */
+    size_t skipped;                             /*!< Number of poll events skipped due to data activity or backoff,
+                                                        compared to poll at every \ref LWESP_CFG_CONN_POLL_INTERVAL */
+} lwesp_conn_poll_stats_t;
+
+lwespr_t    lwesp_conn_get_poll_stats(lwesp_conn_poll_stats_t* stats);
+
+#endif /* LWESP_CFG_CONN_POLL_ADAPTIVE || __DOXYGEN__ */
+
+#if LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__
+
+lwespr_t    lwesp_conn_passthrough_start(lwesp_conn_p* conn, lwesp_conn_type_t type, const char* const remote_host, lwesp_port_t remote_port, void* const arg, lwesp_evt_fn conn_evt_fn, const uint32_t blocking);
+lwespr_t    lwesp_conn_passthrough_stop(const uint32_t blocking);
+uint8_t     lwesp_conn_is_passthrough(lwesp_conn_p conn);
+
+#endif /* LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__ */
+
 
 /**
  * \}
@@ -31,6 +31,12 @@
  * Author:          Tilen MAJERLE <tilen@majerle.eu>
  * Version:         v1.0.0
  */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ *   - Add AT port baudrate event
+ */
 #ifndef LWESP_HDR_EVT_H
 #define LWESP_HDR_EVT_H
 
@@ -87,6 +93,23 @@ lwespr_t    lwesp_evt_restore_get_result(lwesp_evt_t* cc);
  * \}
  */
 
+#if LWESP_CFG_AT_PORT_BAUDRATE_AUTO || __DOXYGEN__
+
+/**
+ * \anchor          LWESP_EVT_AT_BAUDRATE
+ * \name            AT port baudrate
+ * \brief           Event helper functions for \ref LWESP_EVT_AT_BAUDRATE event
+ */
+
+uint32_t    lwesp_evt_at_baudrate_get_baudrate(lwesp_evt_t* cc);
+lwespr_t    lwesp_evt_at_baudrate_get_result(lwesp_evt_t* cc);
+
+/**
+ * \}
+ */
+
+#endif /* LWESP_CFG_AT_PORT_BAUDRATE_AUTO || __DOXYGEN__ */
+
 /**
  * \anchor          LWESP_EVT_AP_IP_STA
  * \name            Access point or station IP or MAC
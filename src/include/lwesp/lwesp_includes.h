@@ -39,6 +39,8 @@
  *   - Remove LWESP_CFG_SNTP macro which is not supported by Ai-thinker esp8266
  *   - Rearrange include order
  *   - Add mdns include
+ *   - Add statistics include
+ *   - Add trace include
  */
 #ifndef LWESP_HDR_INCLUDES_H
 #define LWESP_HDR_INCLUDES_H
@@ -77,6 +79,12 @@
 #if LWESP_CFG_MDNS || __DOXYGEN__
 #include "lwesp/lwesp_mdns.h"
 #endif /* LWESP_CFG_MDNS || __DOXYGEN__ */
+#if LWESP_CFG_STATS || __DOXYGEN__
+#include "lwesp/lwesp_stats.h"
+#endif /* LWESP_CFG_STATS || __DOXYGEN__ */
+#if LWESP_CFG_TRACE || __DOXYGEN__
+#include "lwesp/lwesp_trace.h"
+#endif /* LWESP_CFG_TRACE || __DOXYGEN__ */
 #include "lwesp/lwesp_dhcp.h"
 
 #endif /* LWESP_HDR_INCLUDES_H */
@@ -31,6 +31,12 @@
  * Author:          Tilen MAJERLE <tilen@majerle.eu>
  * Version:         v1.0.0
  */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ *   - Add receive flow control statistics
+ */
 #ifndef LWESP_HDR_INPUT_H
 #define LWESP_HDR_INPUT_H
 
@@ -50,6 +56,25 @@ extern "C" {
 
 lwespr_t    lwesp_input(const void* data, size_t len);
 lwespr_t    lwesp_input_process(const void* data, size_t len);
+void*       lwesp_input_get_write_block(size_t* len);
+lwespr_t    lwesp_input_write_advance(size_t len);
+
+#if LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__
+
+/**
+ * \brief           Receive flow control statistics
+ */
+typedef struct {
+    size_t stalls;                              /*!< Number of times processing paused to not drop connection data */
+    size_t stalled_bytes;                       /*!< Number of connection bytes delivered after processing paused for them */
+    size_t dropped_bytes;                       /*!< Number of connection bytes not delivered to application */
+    size_t rts_count;                           /*!< Number of times device was asked to stop sending */
+    uint32_t stall_time_max;                    /*!< Longest pause in units of milliseconds */
+} lwesp_input_flow_stats_t;
+
+lwespr_t    lwesp_input_get_flow_stats(lwesp_input_flow_stats_t* stats);
+
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__ */
 
 /**
  * \}
@@ -31,6 +31,12 @@
  * Author:          Tilen MAJERLE <tilen@majerle.eu>
  * Version:         v1.0.0
  */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ *   - Add memory statistics and allocation tags
+ */
 #ifndef LWESP_HDR_MEM_H
 #define LWESP_HDR_MEM_H
 
@@ -61,6 +67,74 @@ uint8_t lwesp_mem_assignmemory(const lwesp_mem_region_t* regions, size_t size);
 
 #endif /* !LWESP_CFG_MEM_CUSTOM || __DOXYGEN__ */
 
+/**
+ * \brief           Subsystem that allocated memory
+ */
+typedef enum {
+    LWESP_MEM_TAG_OTHER = 0,                    /*!< Allocation without specific tag */
+    LWESP_MEM_TAG_PBUF,                         /*!< Packet buffers */
+    LWESP_MEM_TAG_MSG,                          /*!< Messages of API commands */
+    LWESP_MEM_TAG_CONN,                         /*!< Connection send buffers and netconn objects */
+    LWESP_MEM_TAG_TIMEOUT,                      /*!< Timeouts */
+    LWESP_MEM_TAG_MQTT,                         /*!< MQTT client */
+    LWESP_MEM_TAG_HTTP,                         /*!< HTTP server */
+    LWESP_MEM_TAG_END,                          /*!< Last member, number of tags */
+} lwesp_mem_tag_t;
+
+#if LWESP_CFG_MEM_STATS || __DOXYGEN__
+
+/**
+ * \brief           Memory allocated by single subsystem
+ */
+typedef struct {
+    size_t bytes;                               /*!< Currently allocated bytes, including block metadata */
+    size_t bytes_max;                           /*!< Maximal number of allocated bytes at any time */
+    size_t blocks;                              /*!< Number of currently allocated blocks */
+} lwesp_mem_tag_stats_t;
+
+/**
+ * \brief           Memory manager statistics
+ */
+typedef struct {
+    size_t total_bytes;                         /*!< Size of all assigned regions available for allocations */
+    size_t free_bytes;                          /*!< Currently free bytes */
+    size_t min_free_bytes;                      /*!< Minimal number of free bytes at any time */
+    size_t largest_free_block;                  /*!< Largest memory that can be allocated at once */
+    size_t free_blocks;                         /*!< Number of free blocks, many small blocks mean fragmented memory */
+    uint32_t alloc_count;                       /*!< Number of successful allocations */
+    uint32_t free_count;                        /*!< Number of frees */
+    uint32_t alloc_failed;                      /*!< Number of failed allocations */
+    lwesp_mem_tag_stats_t tags[LWESP_MEM_TAG_END];  /*!< Allocated memory per subsystem */
+} lwesp_mem_stats_t;
+
+void*   lwesp_mem_malloc_tag(size_t size, lwesp_mem_tag_t tag);
+void*   lwesp_mem_calloc_tag(size_t num, size_t size, lwesp_mem_tag_t tag);
+lwespr_t lwesp_mem_get_stats(lwesp_mem_stats_t* stats);
+
+/**
+ * \brief           Allocate memory and account it to subsystem
+ * \param[in]       size: Number of bytes to allocate
+ * \param[in]       tag: Subsystem, member of \ref lwesp_mem_tag_t enumeration
+ * \return          Memory address on success, `NULL` otherwise
+ */
+#define LWESP_MEM_MALLOC_TAG(size, tag)             lwesp_mem_malloc_tag((size), (tag))
+
+/**
+ * \brief           Allocate memory set to zero and account it to subsystem
+ * \param[in]       num: Number of elements to allocate
+ * \param[in]       size: Size of each element
+ * \param[in]       tag: Subsystem, member of \ref lwesp_mem_tag_t enumeration
+ * \return          Memory address on success, `NULL` otherwise
+ */
+#define LWESP_MEM_CALLOC_TAG(num, size, tag)        lwesp_mem_calloc_tag((num), (size), (tag))
+
+#else /* LWESP_CFG_MEM_STATS || __DOXYGEN__ */
+
+#define LWESP_MEM_MALLOC_TAG(size, tag)             lwesp_mem_malloc(size)
+#define LWESP_MEM_CALLOC_TAG(num, size, tag)        lwesp_mem_calloc((num), (size))
+
+#endif /* !(LWESP_CFG_MEM_STATS || __DOXYGEN__) */
+
 void*   lwesp_mem_malloc(size_t size);
 void*   lwesp_mem_realloc(void* ptr, size_t size);
 void*   lwesp_mem_calloc(size_t num, size_t size);
@@ -100,6 +100,32 @@
 #define LWESP_CFG_MEM_CUSTOM                  0
 #endif
 
+/**
+ * \brief           Enables `1` or disables `0` two-level segregated fit allocator
+ *
+ * When enabled, built-in memory manager keeps free blocks in lists by size class
+ * and finds suitable block with bitmaps instead of walking single list of free blocks.
+ * Allocation and free take bounded time regardless of memory fragmentation.
+ *
+ * \note            This parameter has no meaning when \ref LWESP_CFG_MEM_CUSTOM is enabled
+ */
+#ifndef LWESP_CFG_MEM_TLSF
+#define LWESP_CFG_MEM_TLSF                    0
+#endif
+
+/**
+ * \brief           Enables `1` or disables `0` statistics of built-in memory manager
+ *
+ * When enabled, memory manager counts allocations, keeps minimal free memory
+ * and bytes allocated per subsystem tag, see \ref lwesp_mem_get_stats.
+ * Every allocated block keeps its tag, which may increase size of block metadata
+ *
+ * \note            This parameter has no meaning when \ref LWESP_CFG_MEM_CUSTOM is enabled
+ */
+#ifndef LWESP_CFG_MEM_STATS
+#define LWESP_CFG_MEM_STATS                   0
+#endif
+
 /**
  * \brief           Memory alignment for dynamic memory allocations
  *
@@ -157,6 +183,36 @@
 #define LWESP_CFG_MAX_SEND_RETRIES            3
 #endif
 
+/**
+ * \brief           Enables `1` or disables `0` coalescing of queued send commands
+ *
+ * When enabled, producer thread merges send messages, waiting in queue one after another
+ * for the same TCP or SSL connection, into single `AT+CIPSEND` command,
+ * as long as total length does not exceed \ref LWESP_CFG_CONN_MAX_DATA_LEN.
+ * Every message still reports its own number of sent bytes and \ref LWESP_EVT_CONN_SEND event
+ *
+ * \sa              lwesp_conn_get_send_coalesce_stats
+ */
+#ifndef LWESP_CFG_CONN_SEND_COALESCE
+#define LWESP_CFG_CONN_SEND_COALESCE          0
+#endif
+
+/**
+ * \brief           Enables `1` or disables `0` pipelining of send commands
+ *
+ * When enabled, next data chunk is prepared while device is sending current one.
+ * Producer thread takes next send message from queue while current one waits for `SEND OK`
+ * and `AT+CIPSEND` command of next chunk is built after data of current chunk are written.
+ * Processing thread sends it as soon as `SEND OK` is received,
+ * without waiting for producer thread to wake up.
+ *
+ * \note            Sends in passthrough mode are not affected
+ * \sa              lwesp_stats_get_send_gap
+ */
+#ifndef LWESP_CFG_CONN_SEND_PIPELINE
+#define LWESP_CFG_CONN_SEND_PIPELINE          0
+#endif
+
 /**
  * \brief           Maximum single buffer size for network receive data on active connection
  *
@@ -166,6 +222,66 @@
 #define LWESP_CFG_CONN_MAX_RECV_BUFF_SIZE     1460
 #endif
 
+/**
+ * \brief           Enables `1` or disables `0` packet buffer pool
+ *
+ * When enabled, packet buffers are allocated from `3` size classes of fixed-size blocks
+ * in static memory instead of dynamic memory. Smallest class with enough space is used.
+ * When class has no free block or requested length is bigger than largest class,
+ * packet buffer is allocated from dynamic memory.
+ *
+ * When \ref LWESP_CFG_IPD_ZERO_COPY is enabled, additional class with
+ * \ref LWESP_CFG_IPD_ZERO_COPY_MAX_REFS packet buffers without payload memory
+ * is used for data referenced in input buffer, small class is not used for them
+ *
+ * \sa              lwesp_pbuf_pool_get_stats
+ */
+#ifndef LWESP_CFG_PBUF_POOL
+#define LWESP_CFG_PBUF_POOL                   0
+#endif
+
+/**
+ * \brief           Payload length of packet buffers in small pool class
+ */
+#ifndef LWESP_CFG_PBUF_POOL_SMALL_LEN
+#define LWESP_CFG_PBUF_POOL_SMALL_LEN         64
+#endif
+
+/**
+ * \brief           Number of packet buffers in small pool class
+ */
+#ifndef LWESP_CFG_PBUF_POOL_SMALL_CNT
+#define LWESP_CFG_PBUF_POOL_SMALL_CNT         8
+#endif
+
+/**
+ * \brief           Payload length of packet buffers in medium pool class
+ */
+#ifndef LWESP_CFG_PBUF_POOL_MEDIUM_LEN
+#define LWESP_CFG_PBUF_POOL_MEDIUM_LEN        256
+#endif
+
+/**
+ * \brief           Number of packet buffers in medium pool class
+ */
+#ifndef LWESP_CFG_PBUF_POOL_MEDIUM_CNT
+#define LWESP_CFG_PBUF_POOL_MEDIUM_CNT        4
+#endif
+
+/**
+ * \brief           Payload length of packet buffers in large pool class
+ */
+#ifndef LWESP_CFG_PBUF_POOL_LARGE_LEN
+#define LWESP_CFG_PBUF_POOL_LARGE_LEN         LWESP_CFG_CONN_MAX_RECV_BUFF_SIZE
+#endif
+
+/**
+ * \brief           Number of packet buffers in large pool class
+ */
+#ifndef LWESP_CFG_PBUF_POOL_LARGE_CNT
+#define LWESP_CFG_PBUF_POOL_LARGE_CNT         2
+#endif
+
 /**
  * \brief           Default baudrate used for AT port
  *
@@ -175,6 +291,44 @@
 #define LWESP_CFG_AT_PORT_BAUDRATE            115200
 #endif
 
+/**
+ * \brief           Enables `1` or disables `0` negotiation of higher AT port baudrate in reset sequence
+ *
+ * After echo mode is set, stack tries baudrates of \ref LWESP_CFG_AT_PORT_BAUDRATE_LIST in order.
+ * Each one is set with `AT+UART_CUR` command and verified with `AT` command at new baudrate.
+ * When none of them works, stack goes back to \ref LWESP_CFG_AT_PORT_BAUDRATE.
+ * Final baudrate is reported with \ref LWESP_EVT_AT_BAUDRATE event
+ *
+ * When verification fails, device is reset to default baudrate with reset function of low-level driver.
+ * Without reset function, next baudrate is set at baudrate that failed,
+ * which works only when device still receives data correctly
+ *
+ * \note            Low-level driver must support baudrate change in `lwesp_ll_init` function
+ */
+#ifndef LWESP_CFG_AT_PORT_BAUDRATE_AUTO
+#define LWESP_CFG_AT_PORT_BAUDRATE_AUTO       0
+#endif
+
+/**
+ * \brief           Comma separated list of baudrates to try in reset sequence, from highest to lowest
+ *
+ * \note            Used when \ref LWESP_CFG_AT_PORT_BAUDRATE_AUTO is enabled
+ */
+#ifndef LWESP_CFG_AT_PORT_BAUDRATE_LIST
+#define LWESP_CFG_AT_PORT_BAUDRATE_LIST       921600, 460800, 230400
+#endif
+
+/**
+ * \brief           Time in units of milliseconds to wait for response to baudrate change or verification
+ *
+ * When there is no response in this time, link at new baudrate is considered as not working
+ *
+ * \note            Used when \ref LWESP_CFG_AT_PORT_BAUDRATE_AUTO is enabled
+ */
+#ifndef LWESP_CFG_AT_PORT_BAUDRATE_TIMEOUT
+#define LWESP_CFG_AT_PORT_BAUDRATE_TIMEOUT    100
+#endif
+
 /**
  * \brief           Enables `1` or disables `0` ESP acting as station
  *
@@ -246,6 +400,29 @@
 #define LWESP_CFG_RESET_DELAY_DEFAULT         0
 #endif
 
+/**
+ * \brief           Enables `1` or disables `0` warm start with \ref lwesp_reset_warm function
+ *
+ * When only host restarts and device keeps running, warm start verifies device with `AT` command
+ * and uses device information from snapshot, saved with \ref lwesp_warm_get_snapshot before restart.
+ * Only connection status is read from device.
+ * Full reset sequence is executed when snapshot is not valid or device does not respond
+ *
+ * \note            Set \ref LWESP_CFG_RESET_ON_INIT to `0` to call \ref lwesp_reset_warm after \ref lwesp_init
+ */
+#ifndef LWESP_CFG_RESET_WARM
+#define LWESP_CFG_RESET_WARM                  0
+#endif
+
+/**
+ * \brief           Time in units of milliseconds to wait for response to `AT` command in warm start
+ *
+ * \note            Used when \ref LWESP_CFG_RESET_WARM is enabled
+ */
+#ifndef LWESP_CFG_RESET_WARM_TIMEOUT
+#define LWESP_CFG_RESET_WARM_TIMEOUT          100
+#endif
+
 /**
  * \brief           Maximum length of SSID for access point scan
  *
@@ -298,6 +475,45 @@
 #define LWESP_CFG_THREAD_PROCESS_MBOX_SIZE    16
 #endif
 
+/**
+ * \brief           Enables `1` or disables `0` lock-free message queue for all system ports
+ *
+ * When enabled, `lwesp_sys_mbox_*` functions are implemented in `lwesp_sys_mbox_lockfree.c`
+ * with bounded lock-free queue and C11 atomics, instead of in system port.
+ * Any number of threads may write to queue and single thread may read from it at the same time.
+ * System port semaphores are used only when reader waits for entry or writer waits for free entry.
+ *
+ * \note            Requires C11 compiler with `stdatomic.h`.
+ *                  Number of queue entries is rounded up to power of `2`
+ */
+#ifndef LWESP_CFG_SYS_MBOX_LOCKFREE
+#define LWESP_CFG_SYS_MBOX_LOCKFREE           0
+#endif
+
+/**
+ * \brief           Allocate memory for lock-free message queue
+ *
+ * Stack memory manager cannot be used, as message queues
+ * are created before memory is assigned in low-level driver
+ *
+ * \note            This parameter has no meaning when \ref LWESP_CFG_SYS_MBOX_LOCKFREE is disabled
+ * \param[in]       size: Number of bytes to allocate
+ * \return          Memory address on success, `NULL` otherwise
+ */
+#ifndef LWESP_SYS_MBOX_MALLOC
+#define LWESP_SYS_MBOX_MALLOC(size)           malloc(size)
+#endif
+
+/**
+ * \brief           Free memory of lock-free message queue
+ *
+ * \note            This parameter has no meaning when \ref LWESP_CFG_SYS_MBOX_LOCKFREE is disabled
+ * \param[in]       ptr: Memory address from \ref LWESP_SYS_MBOX_MALLOC
+ */
+#ifndef LWESP_SYS_MBOX_FREE
+#define LWESP_SYS_MBOX_FREE(ptr)              free(ptr)
+#endif
+
 /**
  * \brief           Enables `1` or disables `0` direct support for processing input data
  *
@@ -319,6 +535,145 @@
 #define LWESP_CFG_INPUT_USE_PROCESS           0
 #endif
 
+/**
+ * \brief           Enables `1` or disables `0` zero-copy receive of network data
+ *
+ * When enabled, packet buffers reported with \ref LWESP_EVT_CONN_RECV event
+ * point directly to received data in input buffer instead of holding a copy of it.
+ * When data wraps around the end of input buffer, chain of `2` packet buffers is reported.
+ * Input buffer memory is released when user frees the packet buffer.
+ *
+ * \note            This mode can only be used when \ref LWESP_CFG_INPUT_USE_PROCESS is disabled
+ *
+ * \note            Single packet buffer is limited to half of \ref LWESP_CFG_RCV_BUFF_SIZE.
+ *                  When user keeps too much data referenced, stack falls back to copy mode
+ *                  to keep enough input buffer memory for incoming data
+ */
+#ifndef LWESP_CFG_IPD_ZERO_COPY
+#define LWESP_CFG_IPD_ZERO_COPY               0
+#endif
+
+/**
+ * \brief           Maximal number of packet buffers referencing input buffer at the same time
+ *
+ * \note            This parameter has no meaning when \ref LWESP_CFG_IPD_ZERO_COPY is disabled
+ */
+#ifndef LWESP_CFG_IPD_ZERO_COPY_MAX_REFS
+#define LWESP_CFG_IPD_ZERO_COPY_MAX_REFS      8
+#endif
+
+/**
+ * \brief           Enables `1` or disables `0` lock-free single-producer/single-consumer input buffer
+ *
+ * When enabled, read and write pointers of input buffer are C11 atomics
+ * with acquire/release ordering and are wrapped with power-of-two mask.
+ * Low-level driver may call \ref lwesp_input or \ref lwesp_input_write_advance
+ * from single thread or interrupt, concurrently to processing thread, without any lock.
+ * Processing thread is woken up only when it waits for new data,
+ * not on every received chunk.
+ *
+ * \note            This mode can only be used when \ref LWESP_CFG_INPUT_USE_PROCESS is disabled
+ *                  and requires C11 compiler with `stdatomic.h`
+ *
+ * \note            \ref LWESP_CFG_RCV_BUFF_SIZE must be power of `2`.
+ *                  Other buffers (MQTT client) are rounded up to power of `2`
+ */
+#ifndef LWESP_CFG_INPUT_BUFF_SPSC
+#define LWESP_CFG_INPUT_BUFF_SPSC             0
+#endif
+
+/**
+ * \brief           Enables `1` or disables `0` receive-side flow control
+ *
+ * When enabled, received connection data are not dropped when packet buffer
+ * cannot be allocated or when connection exceeds its receive budget.
+ * Processing of input buffer pauses instead and data wait in input buffer,
+ * until memory is available or application confirms data with \ref lwesp_conn_recved.
+ *
+ * When low-level driver sets \ref lwesp_ll_t.rts_fn, device is asked to stop sending
+ * when input buffer is filled above \ref LWESP_CFG_INPUT_FLOW_HIGH_WATER or when processing pauses.
+ * Number of paused and dropped bytes is read with \ref lwesp_input_get_flow_stats
+ *
+ * \note            This mode can only be used when \ref LWESP_CFG_INPUT_USE_PROCESS is disabled
+ *
+ * \note            While processing pauses, responses to commands wait too.
+ *                  Application must confirm received data with \ref lwesp_conn_recved
+ *                  or data are dropped after \ref LWESP_CFG_INPUT_FLOW_STALL_TIMEOUT
+ */
+#ifndef LWESP_CFG_INPUT_FLOW_CONTROL
+#define LWESP_CFG_INPUT_FLOW_CONTROL          0
+#endif
+
+/**
+ * \brief           Number of bytes in input buffer above which device is asked to stop sending
+ *
+ * \note            This parameter has no meaning when \ref LWESP_CFG_INPUT_FLOW_CONTROL is disabled
+ */
+#ifndef LWESP_CFG_INPUT_FLOW_HIGH_WATER
+#define LWESP_CFG_INPUT_FLOW_HIGH_WATER       (LWESP_CFG_RCV_BUFF_SIZE * 3 / 4)
+#endif
+
+/**
+ * \brief           Number of bytes in input buffer below which device may send again
+ *
+ * \note            This parameter has no meaning when \ref LWESP_CFG_INPUT_FLOW_CONTROL is disabled
+ */
+#ifndef LWESP_CFG_INPUT_FLOW_LOW_WATER
+#define LWESP_CFG_INPUT_FLOW_LOW_WATER        (LWESP_CFG_RCV_BUFF_SIZE / 4)
+#endif
+
+/**
+ * \brief           Maximal time processing may pause for single packet buffer in units of milliseconds
+ *
+ * When it elapses, remaining data of the same `+IPD` statement are dropped,
+ * so that stack does not wait for command responses forever
+ *
+ * \note            This parameter has no meaning when \ref LWESP_CFG_INPUT_FLOW_CONTROL is disabled
+ */
+#ifndef LWESP_CFG_INPUT_FLOW_STALL_TIMEOUT
+#define LWESP_CFG_INPUT_FLOW_STALL_TIMEOUT    10000
+#endif
+
+/**
+ * \brief           Maximal number of bytes connection may hold before it confirms them with \ref lwesp_conn_recved
+ *
+ * Set to `0` for unlimited budget, processing then pauses only when packet buffer cannot be allocated
+ *
+ * \note            When set to non-zero value, application must call \ref lwesp_conn_recved
+ *                  for every received packet buffer, otherwise processing stalls for
+ *                  \ref LWESP_CFG_INPUT_FLOW_STALL_TIMEOUT and received data are dropped.
+ *                  Netconn API does it automatically
+ *
+ * \note            This parameter has no meaning when \ref LWESP_CFG_INPUT_FLOW_CONTROL is disabled
+ */
+#ifndef LWESP_CFG_CONN_RECV_BUDGET
+#define LWESP_CFG_CONN_RECV_BUDGET            0
+#endif
+
+/**
+ * \brief           Enables `1` or disables `0` pipelining of query commands
+ *
+ * When enabled, producer thread sends queued query commands without side effects
+ * (such as `AT+CIPSTA?` or `AT+GMR`) back-to-back, without waiting for response
+ * of previous command. Responses are matched to commands in the same order as commands were sent.
+ * Steps of reset and restore sequence after echo and baudrate setup are sent the same way.
+ *
+ * \note            AT firmware must accept new command while previous one is still being processed.
+ *                  Firmware replying with `busy p...` should not use this mode
+ */
+#ifndef LWESP_CFG_CMD_PIPELINE
+#define LWESP_CFG_CMD_PIPELINE                0
+#endif
+
+/**
+ * \brief           Maximal number of query commands sent to device without waiting for response
+ *
+ * \note            This parameter has no meaning when \ref LWESP_CFG_CMD_PIPELINE is disabled
+ */
+#ifndef LWESP_CFG_CMD_PIPELINE_DEPTH
+#define LWESP_CFG_CMD_PIPELINE_DEPTH          4
+#endif
+
 /**
  * \brief           Producer thread hook, called each time thread wakes-up and does the processing.
  *
@@ -457,6 +812,64 @@
 #define LWESP_CFG_MDNS                        0
 #endif
 
+/**
+ * \brief           Enables `1` or disables `0` per-command statistics
+ *
+ * When enabled, producer thread records for every command type number of commands,
+ * errors and timeouts, time spent in producer queue
+ * and time from command start to its end with histogram.
+ * Statistics are read with \ref lwesp_stats_get.
+ * When disabled, no code or memory is used
+ */
+#ifndef LWESP_CFG_STATS
+#define LWESP_CFG_STATS                       0
+#endif
+
+/**
+ * \brief           Number of histogram buckets of command execution time
+ *
+ * Bucket `0` counts commands finished within `1` millisecond,
+ * bucket `i` counts commands finished within `[2^(i-1), 2^i)` milliseconds.
+ * Last bucket counts all longer commands
+ *
+ * \note            This parameter has no meaning when \ref LWESP_CFG_STATS is disabled
+ */
+#ifndef LWESP_CFG_STATS_HIST_LEN
+#define LWESP_CFG_STATS_HIST_LEN              16
+#endif
+
+/**
+ * \brief           Enables `1` or disables `0` binary trace of AT port
+ *
+ * When enabled, data sent to and received from AT port
+ * and start and end of every command are written to trace ring buffer
+ * with timestamp in units of microseconds from \ref lwesp_sys_now_us.
+ * Oldest records are overwritten when buffer is full.
+ * Trace is read with \ref lwesp_trace_dump and decoded on host with `tools/lwesp_trace_decode.py`
+ */
+#ifndef LWESP_CFG_TRACE
+#define LWESP_CFG_TRACE                       0
+#endif
+
+/**
+ * \brief           Size of trace ring buffer in units of bytes
+ *
+ * \note            Value must be power of `2`
+ */
+#ifndef LWESP_CFG_TRACE_BUFF_SIZE
+#define LWESP_CFG_TRACE_BUFF_SIZE             4096
+#endif
+
+/**
+ * \brief           Maximal number of data bytes saved in single trace record
+ *
+ * Longer data sent to or received from AT port are truncated,
+ * record still keeps their full length
+ */
+#ifndef LWESP_CFG_TRACE_MAX_DATA
+#define LWESP_CFG_TRACE_MAX_DATA              32
+#endif
+
 /**
  * \}
  */
@@ -472,6 +885,60 @@
 #define LWESP_CFG_CONN_POLL_INTERVAL          500
 #endif
 
+/**
+ * \brief           Enables `1` or disables `0` adaptive poll of connections
+ *
+ * When enabled, single timeout with period of \ref LWESP_CFG_CONN_POLL_INTERVAL
+ * serves all connections instead of one timeout per connection:
+ *
+ *  - Poll event is skipped on connection with received or sent data since previous tick
+ *  - Interval between poll events on idle connection doubles after each event,
+ *      up to \ref LWESP_CFG_CONN_POLL_INTERVAL_MAX
+ *
+ * \note            Applications must not count poll events to measure time
+ * \sa              lwesp_conn_get_poll_stats
+ */
+#ifndef LWESP_CFG_CONN_POLL_ADAPTIVE
+#define LWESP_CFG_CONN_POLL_ADAPTIVE          0
+#endif
+
+/**
+ * \brief           Maximal interval between poll events of connection in units of milliseconds
+ *
+ * Poll event is sent at least this often, also on connection with constant data traffic.
+ *
+ * \note            This parameter has no meaning when \ref LWESP_CFG_CONN_POLL_ADAPTIVE is disabled
+ */
+#ifndef LWESP_CFG_CONN_POLL_INTERVAL_MAX
+#define LWESP_CFG_CONN_POLL_INTERVAL_MAX      (8 * LWESP_CFG_CONN_POLL_INTERVAL)
+#endif
+
+/**
+ * \brief           Enables `1` or disables `0` transparent (passthrough) mode on single connection
+ *
+ * Device is switched to single connection mode with `AT+CIPMODE=1` and open-ended `AT+CIPSEND`.
+ * Data of \ref lwesp_conn_send are written to AT port without `AT+CIPSEND=n,len` handshake
+ * and received data are reported with \ref LWESP_EVT_CONN_RECV without `+IPD` header.
+ *
+ * While session is active, all other commands fail with \ref lwespERR
+ *
+ * \sa              lwesp_conn_passthrough_start, lwesp_conn_passthrough_stop
+ */
+#ifndef LWESP_CFG_CONN_PASSTHROUGH
+#define LWESP_CFG_CONN_PASSTHROUGH            0
+#endif
+
+/**
+ * \brief           Guard time before and after `+++` exit sequence of passthrough mode in units of milliseconds
+ *
+ * Device recognizes `+++` only when no other data is sent to it during this time
+ *
+ * \note            This parameter has no meaning when \ref LWESP_CFG_CONN_PASSTHROUGH is disabled
+ */
+#ifndef LWESP_CFG_CONN_PASSTHROUGH_GUARD_TIME
+#define LWESP_CFG_CONN_PASSTHROUGH_GUARD_TIME 1000
+#endif
+
 /**
  * \defgroup        LWESP_OPT_STD_LIB Standard library
  * \brief           Standard C library configuration
@@ -552,6 +1019,69 @@ void *  my_memset(void* dst, int b, size_t len);
 #endif /* LWESP_CFG_INPUT_USE_PROCESS */
 #endif /* !LWESP_CFG_OS */
 
+#if LWESP_CFG_SYS_MBOX_LOCKFREE && !LWESP_CFG_OS
+#error "LWESP_CFG_SYS_MBOX_LOCKFREE may only be enabled when OS is used!"
+#endif /* LWESP_CFG_SYS_MBOX_LOCKFREE && !LWESP_CFG_OS */
+
+/* Memory manager config */
+#if LWESP_CFG_MEM_TLSF && LWESP_CFG_MEM_ALIGNMENT < 2
+#error "LWESP_CFG_MEM_TLSF requires LWESP_CFG_MEM_ALIGNMENT to be at least 2!"
+#endif /* LWESP_CFG_MEM_TLSF && LWESP_CFG_MEM_ALIGNMENT < 2 */
+
+/* Packet buffer pool config */
+#if LWESP_CFG_PBUF_POOL
+#if LWESP_CFG_PBUF_POOL_SMALL_LEN > LWESP_CFG_PBUF_POOL_MEDIUM_LEN || LWESP_CFG_PBUF_POOL_MEDIUM_LEN > LWESP_CFG_PBUF_POOL_LARGE_LEN
+#error "Packet buffer pool classes must be ordered by length!"
+#endif
+#if !LWESP_CFG_PBUF_POOL_SMALL_CNT || !LWESP_CFG_PBUF_POOL_MEDIUM_CNT || !LWESP_CFG_PBUF_POOL_LARGE_CNT
+#error "Packet buffer pool classes must have at least one block!"
+#endif
+#endif /* LWESP_CFG_PBUF_POOL */
+
+/* Zero-copy receive config */
+#if LWESP_CFG_IPD_ZERO_COPY && LWESP_CFG_INPUT_USE_PROCESS
+#error "LWESP_CFG_IPD_ZERO_COPY may only be used when LWESP_CFG_INPUT_USE_PROCESS is disabled!"
+#endif /* LWESP_CFG_IPD_ZERO_COPY && LWESP_CFG_INPUT_USE_PROCESS */
+
+/* Lock-free input buffer config */
+#if LWESP_CFG_INPUT_BUFF_SPSC && LWESP_CFG_INPUT_USE_PROCESS
+#error "LWESP_CFG_INPUT_BUFF_SPSC may only be used when LWESP_CFG_INPUT_USE_PROCESS is disabled!"
+#endif /* LWESP_CFG_INPUT_BUFF_SPSC && LWESP_CFG_INPUT_USE_PROCESS */
+#if LWESP_CFG_INPUT_BUFF_SPSC && (LWESP_CFG_RCV_BUFF_SIZE & (LWESP_CFG_RCV_BUFF_SIZE - 1))
+#error "LWESP_CFG_RCV_BUFF_SIZE must be power of 2 when LWESP_CFG_INPUT_BUFF_SPSC is enabled!"
+#endif /* LWESP_CFG_INPUT_BUFF_SPSC && (LWESP_CFG_RCV_BUFF_SIZE & (LWESP_CFG_RCV_BUFF_SIZE - 1)) */
+
+/* Receive flow control config */
+#if LWESP_CFG_INPUT_FLOW_CONTROL && LWESP_CFG_INPUT_USE_PROCESS
+#error "LWESP_CFG_INPUT_FLOW_CONTROL may only be used when LWESP_CFG_INPUT_USE_PROCESS is disabled!"
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL && LWESP_CFG_INPUT_USE_PROCESS */
+#if LWESP_CFG_INPUT_FLOW_CONTROL && LWESP_CFG_INPUT_FLOW_LOW_WATER >= LWESP_CFG_INPUT_FLOW_HIGH_WATER
+#error "LWESP_CFG_INPUT_FLOW_LOW_WATER must be lower than LWESP_CFG_INPUT_FLOW_HIGH_WATER!"
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL && LWESP_CFG_INPUT_FLOW_LOW_WATER >= LWESP_CFG_INPUT_FLOW_HIGH_WATER */
+
+/* Memory config */
+#if LWESP_CFG_MEM_STATS && LWESP_CFG_MEM_CUSTOM
+#error "LWESP_CFG_MEM_STATS cannot be used with LWESP_CFG_MEM_CUSTOM!"
+#endif /* LWESP_CFG_MEM_STATS && LWESP_CFG_MEM_CUSTOM */
+
+/* Statistics config */
+#if LWESP_CFG_STATS && LWESP_CFG_STATS_HIST_LEN < 2
+#error "LWESP_CFG_STATS_HIST_LEN must be at least 2!"
+#endif /* LWESP_CFG_STATS && LWESP_CFG_STATS_HIST_LEN < 2 */
+
+/* Trace config */
+#if LWESP_CFG_TRACE && (LWESP_CFG_TRACE_BUFF_SIZE & (LWESP_CFG_TRACE_BUFF_SIZE - 1))
+#error "LWESP_CFG_TRACE_BUFF_SIZE must be power of 2!"
+#endif /* LWESP_CFG_TRACE && (LWESP_CFG_TRACE_BUFF_SIZE & (LWESP_CFG_TRACE_BUFF_SIZE - 1)) */
+#if LWESP_CFG_TRACE && LWESP_CFG_TRACE_BUFF_SIZE < 4 * (LWESP_CFG_TRACE_MAX_DATA + 12)
+#error "LWESP_CFG_TRACE_BUFF_SIZE must hold at least 4 records with LWESP_CFG_TRACE_MAX_DATA bytes!"
+#endif /* LWESP_CFG_TRACE && LWESP_CFG_TRACE_BUFF_SIZE < 4 * (LWESP_CFG_TRACE_MAX_DATA + 12) */
+
+/* Command pipelining config */
+#if LWESP_CFG_CMD_PIPELINE && LWESP_CFG_CMD_PIPELINE_DEPTH < 2
+#error "LWESP_CFG_CMD_PIPELINE_DEPTH must be at least 2!"
+#endif /* LWESP_CFG_CMD_PIPELINE && LWESP_CFG_CMD_PIPELINE_DEPTH < 2 */
+
 /* WPS config */
 #if LWESP_CFG_WPS && !LWESP_CFG_MODE_STATION
 #error "WPS function may only be used when station mode is enabled!"
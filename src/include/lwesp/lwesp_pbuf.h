@@ -36,6 +36,7 @@
  * Copyright (c) 2021 niedong
  *
  *   - Remove debug message
+ *   - Add packet buffer pool statistics
  */
 #ifndef LWESP_HDR_PBUF_H
 #define LWESP_HDR_PBUF_H
@@ -79,6 +80,37 @@ void*           lwesp_pbuf_get_linear_addr(const lwesp_pbuf_p pbuf, size_t offse
 
 void            lwesp_pbuf_set_ip(lwesp_pbuf_p pbuf, const lwesp_ip_t* ip, lwesp_port_t port);
 
+#if LWESP_CFG_PBUF_POOL || __DOXYGEN__
+
+/**
+ * \brief           Number of size classes in packet buffer pool
+ *
+ * When \ref LWESP_CFG_IPD_ZERO_COPY is enabled, class `0` holds packet buffers
+ * without payload memory, which reference data in input buffer
+ */
+#if LWESP_CFG_IPD_ZERO_COPY
+#define LWESP_PBUF_POOL_CLASSES         4
+#else /* LWESP_CFG_IPD_ZERO_COPY */
+#define LWESP_PBUF_POOL_CLASSES         3
+#endif /* !LWESP_CFG_IPD_ZERO_COPY */
+
+/**
+ * \brief           Statistics of single packet buffer pool class
+ */
+typedef struct {
+    size_t len;                                 /*!< Maximal payload length of packet buffer in class */
+    size_t count;                               /*!< Number of packet buffers in class */
+    size_t used;                                /*!< Number of currently allocated packet buffers */
+    size_t max_used;                            /*!< Maximal number of packet buffers allocated at the same time */
+    size_t hits;                                /*!< Number of allocations served by class */
+    size_t misses;                              /*!< Number of allocations served by dynamic memory
+                                                        because class had no free packet buffer */
+} lwesp_pbuf_pool_stats_t;
+
+lwespr_t        lwesp_pbuf_pool_get_stats(size_t index, lwesp_pbuf_pool_stats_t* stats);
+
+#endif /* LWESP_CFG_PBUF_POOL || __DOXYGEN__ */
+
 /**
  * \}
  */
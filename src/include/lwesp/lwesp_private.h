@@ -47,6 +47,16 @@
  *   - Remove LWESP_PORT2NUM macro
  *   - Remove LWESP_CMD_WIFI_CWRECONNCFG which is not supported by Ai-thinker esp8266
  *   - Remove LWESP_CFG_SNTP macro which is not supported by Ai-thinker esp8266
+ *   - Add wake-up flag of lock-free input buffer
+ *   - Add per-command statistics
+ *   - Add AT port trace
+ *   - Account messages to memory statistics tag
+ *   - Add AT port baudrate negotiation to reset sequence
+ *   - Add warm start to reset sequence
+ *   - Add adaptive connection poll
+ *   - Add passthrough mode commands and state
+ *   - Add receive flow control state
+ *   - Add send pipeline state and send gap statistics
  */
 #ifndef LWESP_HDR_PRIV_H
 #define LWESP_HDR_PRIV_H
@@ -73,6 +83,9 @@ typedef enum {
     LWESP_CMD_RESET,                            /*!< Reset device */
     LWESP_CMD_ATE0,                             /*!< Disable ECHO mode on AT commands */
     LWESP_CMD_ATE1,                             /*!< Enable ECHO mode on AT commands */
+#if LWESP_CFG_AT_PORT_BAUDRATE_AUTO || LWESP_CFG_RESET_WARM || __DOXYGEN__
+    LWESP_CMD_AT,                               /*!< Verify AT port with empty command */
+#endif /* LWESP_CFG_AT_PORT_BAUDRATE_AUTO || LWESP_CFG_RESET_WARM || __DOXYGEN__ */
     LWESP_CMD_GMR,                              /*!< Get AT commands version */
     LWESP_CMD_GSLP,                             /*!< Set ESP to sleep mode */
     LWESP_CMD_RESTORE,                          /*!< Restore ESP internal settings to default values */
@@ -142,12 +155,18 @@ typedef enum {
     LWESP_CMD_TCPIP_CIPSERVER,                  /*!< Enables/Disables server mode */
     LWESP_CMD_TCPIP_CIPSERVERMAXCONN,           /*!< Sets maximal number of connections allowed for server population */
     LWESP_CMD_TCPIP_CIPMODE,                    /*!< Transmission mode, either transparent or normal one */
+#if LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__
+    LWESP_CMD_TCPIP_CIPSEND_PASSTHROUGH,        /*!< Start transparent transmission with open-ended `AT+CIPSEND` */
+    LWESP_CMD_TCPIP_PASSTHROUGH_EXIT,           /*!< Exit transparent transmission with `+++` sequence */
+#endif /* LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__ */
     LWESP_CMD_TCPIP_CIPSTO,                     /*!< Sets connection timeout */
     LWESP_CMD_TCPIP_CIUPDATE,                   /*!< Perform self-update */
     LWESP_CMD_TCPIP_CIPDINFO,                   /*!< Configure what data are received on +IPD statement */
 #if LWESP_CFG_PING || __DOXYGEN__
     LWESP_CMD_TCPIP_PING,                       /*!< Ping domain */
 #endif /* LWESP_CFG_PING || __DOXYGEN__ */
+
+    LWESP_CMD_END,                              /*!< Last member, number of commands */
 } lwesp_cmd_t;
 
 /**
@@ -163,6 +182,9 @@ typedef struct lwesp_conn {
     lwesp_linbuff_t   buff;                     /*!< Linear buffer structure */
 
     size_t            total_recved;             /*!< Total number of bytes received */
+#if LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__
+    size_t            recv_held;                /*!< Number of received bytes not yet confirmed with \ref lwesp_conn_recved */
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__ */
 
     union {
         struct {
@@ -188,6 +210,17 @@ typedef struct lwesp_conn {
 #endif
 } lwesp_conn_t; // On 64-bit platform, sizeof(lwesp_conn_t) is still 64
 
+/**
+ * \ingroup         LWESP_PBUF
+ * \brief           Input buffer region referenced by packet buffer
+ */
+typedef struct {
+    uint8_t* payload;                           /*!< Start address of region in input buffer */
+    size_t pos;                                 /*!< Absolute input stream position of region */
+    size_t len;                                 /*!< Length of region in units of bytes */
+    uint8_t freed;                              /*!< Set to `1` when packet buffer has been freed */
+} lwesp_buff_ref_t;
+
 /**
  * \ingroup         LWESP_PBUF
  * \brief           Packet buffer structure
@@ -200,6 +233,9 @@ typedef struct lwesp_pbuf {
     uint8_t* payload;                           /*!< Pointer to payload memory */
     lwesp_ip_t ip;                              /*!< Remote address for received IPD data */
     lwesp_port_t port;                          /*!< Remote port for received IPD data */
+#if LWESP_CFG_IPD_ZERO_COPY || __DOXYGEN__
+    lwesp_buff_ref_t* buff_ref;                 /*!< Input buffer region when payload is not owned by pbuf */
+#endif /* LWESP_CFG_IPD_ZERO_COPY || __DOXYGEN__ */
 } lwesp_pbuf_t;
 
 /**
@@ -218,6 +254,14 @@ typedef struct {
                                                         When set to `NULL` while `read = 1`,
                                                         reading should ignore incoming data */
     lwesp_pbuf_p        buff;                   /*!< Pointer to data buffer used for receiving data */
+#if LWESP_CFG_IPD_ZERO_COPY || __DOXYGEN__
+    uint8_t             zc;                     /*!< Set to `1` when buffer references input buffer memory */
+#endif /* LWESP_CFG_IPD_ZERO_COPY || __DOXYGEN__ */
+#if LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__
+    uint8_t             buff_pending;           /*!< Set to `1` when packet buffer for next data is not allocated yet */
+    uint8_t             stalled;                /*!< Set to `1` when processing pauses until packet buffer is allocated */
+    uint32_t            stall_time;             /*!< Time when processing paused */
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__ */
 } lwesp_ipd_t;
 
 /**
@@ -234,6 +278,15 @@ typedef struct lwesp_msg {
                                                         Use `0` to for non-blocking call */
     lwespr_t          res;                      /*!< Result of message operation */
     lwespr_t          (*fn)(struct lwesp_msg*); /*!< Processing callback function to process packet */
+#if LWESP_CFG_CMD_PIPELINE || __DOXYGEN__
+    struct lwesp_msg* pipe_next;                /*!< Next command sent to device before this one finished */
+#endif /* LWESP_CFG_CMD_PIPELINE || __DOXYGEN__ */
+#if LWESP_CFG_STATS || __DOXYGEN__
+    uint32_t          stats_time;               /*!< Time when message was put to producer queue,
+                                                        later time when command was started */
+    uint32_t          stats_queue;              /*!< Time message waited in producer queue in units of milliseconds */
+    uint32_t          stats_queued_us;          /*!< Time when message was put to producer queue in units of microseconds */
+#endif /* LWESP_CFG_STATS || __DOXYGEN__ */
 
 #if LWESP_CFG_USE_API_FUNC_EVT
     lwesp_api_cmd_evt_fn evt_fn;                /*!< Command callback API function */
@@ -243,6 +296,19 @@ typedef struct lwesp_msg {
     union {
         struct {
             uint32_t delay;                     /*!< Delay in units of milliseconds before executing first RESET command */
+#if LWESP_CFG_AT_PORT_BAUDRATE_AUTO || __DOXYGEN__
+            uint32_t baudrate;                  /*!< Baudrate currently negotiated on AT port */
+            uint8_t baudrate_idx;               /*!< Index of baudrate in list of baudrates to negotiate */
+#endif /* LWESP_CFG_AT_PORT_BAUDRATE_AUTO || __DOXYGEN__ */
+#if LWESP_CFG_RESET_WARM || __DOXYGEN__
+            const lwesp_warm_snapshot_t* warm;  /*!< Snapshot for warm start, `NULL` for full reset sequence */
+#endif /* LWESP_CFG_RESET_WARM || __DOXYGEN__ */
+#if LWESP_CFG_AT_PORT_BAUDRATE_AUTO || LWESP_CFG_RESET_WARM || __DOXYGEN__
+            uint8_t is_timeout;                 /*!< Set to `1` when command result is forced by timeout */
+#endif /* LWESP_CFG_AT_PORT_BAUDRATE_AUTO || LWESP_CFG_RESET_WARM || __DOXYGEN__ */
+#if LWESP_CFG_CMD_PIPELINE || __DOXYGEN__
+            uint8_t sent_ahead;                 /*!< Number of sub commands sent after current one, waiting for response */
+#endif /* LWESP_CFG_CMD_PIPELINE || __DOXYGEN__ */
         } reset;                                /*!< Reset device */
         struct {
             uint32_t baudrate;                  /*!< Baudrate for AT port */
@@ -343,16 +409,28 @@ typedef struct lwesp_msg {
             lwesp_evt_fn evt_func;              /*!< Callback function to use on connection */
             uint8_t num;                        /*!< Connection number used for start */
             uint8_t success;                    /*!< Status if connection AT+CIPSTART succedded */
+#if LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__
+            uint8_t failed;                     /*!< Set to `1` when passthrough start failed and device is being restored */
+#endif /* LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__ */
         } conn_start;                           /*!< Structure for starting new connection */
         struct {
             lwesp_conn_t* conn;                 /*!< Pointer to connection to close */
             uint8_t val_id;                     /*!< Connection current validation ID when command was sent to queue */
         } conn_close;                           /*!< Close connection */
+#if LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__
+        struct {
+            uint8_t exit_sent;                  /*!< Set to `1` when `+++` sequence was sent */
+        } passthrough_stop;                     /*!< Stop passthrough mode */
+#endif /* LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__ */
         struct {
             lwesp_conn_t* conn;                 /*!< Pointer to connection to send data */
             size_t btw;                         /*!< Number of remaining bytes to write */
             size_t ptr;                         /*!< Current write pointer for data */
             const uint8_t* data;                /*!< Data to send */
+            const lwesp_iovec_t* iov;           /*!< Array of data segments to send. Used instead of `data` when not `NULL` */
+            size_t iovcnt;                      /*!< Number of entries in `iov` array */
+            lwesp_pbuf_p pbuf;                  /*!< Packet buffer chain to send. Used instead of `data` when not `NULL`.
+                                                        Reference is released together with message */
             size_t sent;                        /*!< Number of bytes sent in last packet */
             size_t sent_all;                    /*!< Number of bytes sent all together */
             uint8_t tries;                      /*!< Number of tries used for last packet */
@@ -362,6 +440,13 @@ typedef struct lwesp_msg {
             uint8_t fau;                        /*!< Free after use flag to free memory after data are sent (or not) */
             size_t* bw;                         /*!< Number of bytes written so far */
             uint8_t val_id;                     /*!< Connection current validation ID when command was sent to queue */
+#if LWESP_CFG_CONN_SEND_COALESCE || __DOXYGEN__
+            struct lwesp_msg* next;             /*!< Next send message merged into the same `AT+CIPSEND` command */
+#endif /* LWESP_CFG_CONN_SEND_COALESCE || __DOXYGEN__ */
+#if LWESP_CFG_CONN_SEND_PIPELINE || __DOXYGEN__
+            struct lwesp_msg* stage_next;       /*!< Next send message taken from queue, started when this one finishes */
+            uint8_t stage_started;              /*!< Set to `1` when processing thread started next send message */
+#endif /* LWESP_CFG_CONN_SEND_PIPELINE || __DOXYGEN__ */
         } conn_send;                            /*!< Structure to send data on connection */
 
         /* TCP/IP based commands */
@@ -420,6 +505,21 @@ typedef struct lwesp_msg {
     } msg;                                      /*!< Group of different message contents */
 } lwesp_msg_t;
 
+#if LWESP_CFG_CONN_SEND_PIPELINE || __DOXYGEN__
+
+/**
+ * \brief           `AT+CIPSEND` command of next data chunk, built before current chunk is confirmed
+ */
+typedef struct {
+    const lwesp_msg_t* msg;                     /*!< Send message command was built for, `NULL` when there is none */
+    size_t ptr;                                 /*!< Data offset of chunk in message */
+    size_t len;                                 /*!< Number of bytes sent with command */
+    char cmd[64];                               /*!< Command including line ending */
+    size_t cmd_len;                             /*!< Length of command */
+} lwesp_conn_send_stage_t;
+
+#endif /* LWESP_CFG_CONN_SEND_PIPELINE || __DOXYGEN__ */
+
 /**
  * \brief           IP and MAC structure with netmask and gateway addresses
  */
@@ -469,6 +569,12 @@ typedef struct {
     lwesp_link_conn_t     link_conn;            /*!< Link connection handle */
     lwesp_ipd_t           ipd;                  /*!< Connection incoming data structure */
     lwesp_conn_t          conns[LWESP_CFG_MAX_CONNS];   /*!< Array of all connection structures */
+#if LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__
+    struct {
+        lwesp_conn_t*     conn;                 /*!< Connection of passthrough session, `NULL` when session is not started */
+        uint8_t           active;               /*!< Set to `1` when device is in transparent transmission */
+    } passthrough;                              /*!< Passthrough session */
+#endif /* LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__ */
 
 #if LWESP_CFG_MODE_STATION || __DOXYGEN__
     lwesp_ip_mac_t        sta;                  /*!< Station IP and MAC addressed */
@@ -492,7 +598,23 @@ typedef struct {
 #if !LWESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__
     lwesp_buff_t          buff;                 /*!< Input processing buffer */
 #endif /* !LWESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__ */
+#if LWESP_CFG_INPUT_BUFF_SPSC || __DOXYGEN__
+    atomic_flag           buff_wake;            /*!< Set when processing thread has been woken up
+                                                    and has not yet started to process input buffer */
+#endif /* LWESP_CFG_INPUT_BUFF_SPSC || __DOXYGEN__ */
+#if LWESP_CFG_IPD_ZERO_COPY || __DOXYGEN__
+    lwesp_buff_ref_t      buff_refs[LWESP_CFG_IPD_ZERO_COPY_MAX_REFS];  /*!< Input buffer regions referenced by pbufs */
+    size_t                buff_refs_r;          /*!< Index of oldest referenced region */
+    size_t                buff_refs_cnt;        /*!< Number of referenced regions */
+    size_t                buff_rel_pos;         /*!< Absolute input stream position of buffer read pointer */
+    size_t                buff_proc_pos;        /*!< Absolute input stream position of processed data */
+    uint8_t               buff_refs_off;        /*!< Set to `1` to copy all `+IPD` data, to compare with zero-copy */
+#endif /* LWESP_CFG_IPD_ZERO_COPY || __DOXYGEN__ */
     lwesp_ll_t            ll;                   /*!< Low level functions */
+#if LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__
+    volatile uint8_t      flow_rts;             /*!< Set to `1` when device was asked to stop sending */
+    lwesp_input_flow_stats_t flow_stats;        /*!< Receive flow control statistics */
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__ */
 
     lwesp_msg_t*          msg;                  /*!< Pointer to current user message being executed */
 
@@ -512,6 +634,21 @@ typedef struct {
     uint8_t conn_val_id;                        /*!< Validation ID increased each time device
                                                         connects to wifi network or on reset.
                                                         It is used for connections */
+#if LWESP_CFG_CONN_SEND_COALESCE || __DOXYGEN__
+    lwesp_conn_send_coalesce_stats_t send_coalesce;   /*!< Send coalescing statistics */
+#endif /* LWESP_CFG_CONN_SEND_COALESCE || __DOXYGEN__ */
+#if LWESP_CFG_CONN_SEND_PIPELINE || __DOXYGEN__
+    lwesp_conn_send_stage_t send_stage;         /*!< Command of next data chunk */
+#endif /* LWESP_CFG_CONN_SEND_PIPELINE || __DOXYGEN__ */
+#if LWESP_CFG_CONN_POLL_ADAPTIVE || __DOXYGEN__
+    lwesp_conn_poll_stats_t conn_poll;          /*!< Adaptive connection poll statistics */
+#endif /* LWESP_CFG_CONN_POLL_ADAPTIVE || __DOXYGEN__ */
+#if LWESP_CFG_STATS || __DOXYGEN__
+    lwesp_stats_cmd_t     stats[LWESP_CMD_END]; /*!< Statistics of commands, indexed by command type */
+    lwesp_stats_send_gap_t stats_send_gap;      /*!< Statistics of gaps between send data chunks */
+    uint32_t              stats_send_ok;        /*!< Time of last `SEND OK` in units of microseconds */
+    uint8_t               stats_send_ok_valid;  /*!< Set to `1` until command after last `SEND OK` is sent */
+#endif /* LWESP_CFG_STATS || __DOXYGEN__ */
 } lwesp_t;
 
 /**
@@ -542,7 +679,7 @@ extern lwesp_t esp;
 
 #define LWESP_MSG_VAR_DEFINE(name)                lwesp_msg_t* name
 #define LWESP_MSG_VAR_ALLOC(name, blocking)       do {  \
-        (name) = lwesp_mem_malloc(sizeof(*(name)));     \
+        (name) = LWESP_MEM_MALLOC_TAG(sizeof(*(name)), LWESP_MEM_TAG_MSG);  \
         if ((name) == NULL) {                           \
             return lwespERRMEM;                         \
         }                                               \
@@ -555,6 +692,10 @@ extern lwesp_t esp;
             lwesp_sys_sem_delete(&((name)->sem));       \
             lwesp_sys_sem_invalid(&((name)->sem));      \
         }                                               \
+        if ((name)->cmd_def == LWESP_CMD_TCPIP_CIPSEND  \
+            && (name)->msg.conn_send.pbuf != NULL) {    \
+            lwesp_pbuf_free((name)->msg.conn_send.pbuf);\
+        }                                               \
         lwesp_mem_free_s((void **)&(name));             \
     } while (0)
 #if LWESP_CFG_USE_API_FUNC_EVT
@@ -580,20 +721,47 @@ extern lwesp_t esp;
 #define CRLF                                "\r\n"
 #define CRLF_LEN                            2
 
-lwespr_t    lwespi_process(const void* data, size_t len);
+lwespr_t    lwespi_process(const void* data, size_t len, size_t* processed);
 lwespr_t    lwespi_process_buffer(void);
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+void        lwespi_flow_rts(uint8_t stop);
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL */
+#if LWESP_CFG_IPD_ZERO_COPY
+void        lwespi_buff_ref_release(lwesp_buff_ref_t* ref);
+lwesp_pbuf_p lwespi_pbuf_new_ref(lwesp_buff_ref_t* ref);
+#endif /* LWESP_CFG_IPD_ZERO_COPY */
 lwespr_t    lwespi_initiate_cmd(lwesp_msg_t* msg);
+const char* lwespi_recv_classify(const char* line, lwesp_cmd_t cmd);
+size_t      lwespi_scan_plain(const uint8_t* d, size_t len);
 uint8_t     lwespi_is_valid_conn_ptr(lwesp_conn_p conn);
 lwespr_t    lwespi_send_cb(lwesp_evt_type_t type);
 lwespr_t    lwespi_send_conn_cb(lwesp_conn_t* conn, lwesp_evt_fn cb);
 void        lwespi_conn_init(void);
 void        lwespi_conn_start_timeout(lwesp_conn_p conn);
+#if LWESP_CFG_CONN_POLL_ADAPTIVE
+void        lwespi_conn_activity(lwesp_conn_p conn);
+#endif /* LWESP_CFG_CONN_POLL_ADAPTIVE */
 lwespr_t    lwespi_send_msg_to_producer_mbox(lwesp_msg_t* msg, lwespr_t (*process_fn)(lwesp_msg_t*), uint32_t max_block_time);
 uint32_t    lwespi_get_from_mbox_with_timeout_checks(lwesp_sys_mbox_t* b, void** m, uint32_t timeout);
 
 void        lwespi_reset_everything(uint8_t forced);
 void        lwespi_process_events_for_timeout_or_error(lwesp_msg_t* msg, lwespr_t err);
 
+#if LWESP_CFG_STATS
+void        lwespi_stats_cmd_start(lwesp_msg_t* msg);
+void        lwespi_stats_cmd_end(lwesp_msg_t* msg, lwespr_t res);
+void        lwespi_stats_send_ok(void);
+void        lwespi_stats_send_gap(const lwesp_msg_t* msg);
+#endif /* LWESP_CFG_STATS */
+#if LWESP_CFG_STATS || LWESP_CFG_TRACE
+const char* lwespi_cmd_name(size_t cmd);
+#endif /* LWESP_CFG_STATS || LWESP_CFG_TRACE */
+#if LWESP_CFG_TRACE
+uint8_t     lwespi_trace_init(void);
+void        lwespi_trace(lwesp_trace_type_t type, uint8_t cmd, uint32_t arg, const void* data, size_t len);
+size_t      lwespi_trace_ll_send(const void* data, size_t len);
+#endif /* LWESP_CFG_TRACE */
+
 /**
  * \}
  */
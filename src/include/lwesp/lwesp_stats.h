@@ -0,0 +1,112 @@
+/**
+ * \file            lwesp_stats.h
+ * \brief           Per-command statistics
+ */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwESP - Lightweight ESP-AT parser library.
+ */
+#ifndef LWESP_HDR_STATS_H
+#define LWESP_HDR_STATS_H
+
+#include "lwesp/lwesp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \ingroup         LWESP
+ * \defgroup        LWESP_STATS Statistics
+ * \brief           Per-command counters and latency histograms
+ *
+ * Producer thread records statistics for every command type when command finishes.
+ * Times are measured with \ref lwesp_sys_now in units of milliseconds:
+ *
+ *  - Queue time is time from command being put to producer queue until producer thread takes it
+ *  - Execution time is time from command being started until it finishes, including response from device
+ *
+ * Commands are identified by their index in statistics array, use \ref lwesp_stats_cmd_name to get their name.
+ *
+ * Processing thread records gaps between data chunks of send commands with \ref lwesp_sys_now_us
+ * in units of microseconds. Gap is time from `SEND OK` of one chunk
+ * until `AT+CIPSEND` command of next chunk is written to AT port.
+ * It is recorded only when next chunk was ready to be sent when `SEND OK` was received
+ * and no other command was started in between, see \ref lwesp_stats_get_send_gap.
+ * \{
+ */
+
+/**
+ * \brief           Statistics of single command type
+ */
+typedef struct {
+    uint32_t count;                             /*!< Number of finished commands */
+    uint32_t errors;                            /*!< Number of commands finished with error, excluding timeouts */
+    uint32_t timeouts;                          /*!< Number of commands finished with timeout */
+    uint32_t queue_time;                        /*!< Total time commands waited in producer queue */
+    uint32_t queue_time_max;                    /*!< Maximal time single command waited in producer queue */
+    uint32_t exec_time;                         /*!< Total execution time of commands */
+    uint32_t exec_time_max;                     /*!< Maximal execution time of single command */
+    uint32_t hist[LWESP_CFG_STATS_HIST_LEN];    /*!< Histogram of execution time.
+                                                    Bucket `0` counts times below `1` millisecond,
+                                                    bucket `i` counts times in range `[2^(i-1), 2^i)`
+                                                    and last bucket counts all longer times */
+} lwesp_stats_cmd_t;
+
+/**
+ * \brief           Statistics of gaps of single kind
+ */
+typedef struct {
+    uint32_t count;                             /*!< Number of recorded gaps */
+    uint32_t time;                              /*!< Total time of gaps */
+    uint32_t time_min;                          /*!< Minimal time of single gap */
+    uint32_t time_max;                          /*!< Maximal time of single gap */
+} lwesp_stats_gap_t;
+
+/**
+ * \brief           Statistics of gaps between data chunks of send commands
+ */
+typedef struct {
+    lwesp_stats_gap_t chunk;                    /*!< Gaps between chunks of the same send message */
+    lwesp_stats_gap_t msg;                      /*!< Gaps between last chunk of one send message
+                                                    and first chunk of next send message */
+    uint32_t started;                           /*!< Number of send messages started by processing thread,
+                                                    when \ref LWESP_CFG_CONN_SEND_PIPELINE is enabled */
+} lwesp_stats_send_gap_t;
+
+size_t      lwesp_stats_get(lwesp_stats_cmd_t* cmds, size_t len);
+lwespr_t    lwesp_stats_get_send_gap(lwesp_stats_send_gap_t* gap);
+lwespr_t    lwesp_stats_reset(void);
+const char* lwesp_stats_cmd_name(size_t cmd);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LWESP_HDR_STATS_H */
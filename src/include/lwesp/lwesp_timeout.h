@@ -50,6 +50,9 @@ extern "C" {
 lwespr_t          lwesp_timeout_add(uint32_t time, lwesp_timeout_fn fn, void* arg);
 lwespr_t          lwesp_timeout_remove(lwesp_timeout_fn fn);
 
+lwespr_t          lwesp_timeout_start(lwesp_timeout_t* to, uint32_t time, lwesp_timeout_fn fn, void* arg);
+lwespr_t          lwesp_timeout_stop(lwesp_timeout_t* to);
+
 /**
  * \}
  */
@@ -0,0 +1,99 @@
+/**
+ * \file            lwesp_trace.h
+ * \brief           Binary trace of AT port
+ */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwESP - Lightweight ESP-AT parser library.
+ */
+#ifndef LWESP_HDR_TRACE_H
+#define LWESP_HDR_TRACE_H
+
+#include "lwesp/lwesp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+/**
+ * \ingroup         LWESP
+ * \defgroup        LWESP_TRACE Trace
+ * \brief           Binary trace of AT port with timestamps
+ *
+ * Trace keeps latest records in ring buffer of \ref LWESP_CFG_TRACE_BUFF_SIZE bytes,
+ * without formatting any text at run time.
+ * \ref lwesp_trace_dump outputs trace in binary format, all numbers are little endian:
+ *
+ *  - File header: `"LWTR"`, `uint8_t` version \ref LWESP_TRACE_VERSION and 3 reserved bytes
+ *  - One \ref LWESP_TRACE_TYPE_NAME record for every command type
+ *  - Records from ring buffer, from oldest to newest
+ *
+ * Every record starts with `12` bytes header, followed by `len` data bytes:
+ *
+ *  - `uint32_t` time in units of microseconds
+ *  - `uint8_t` type, member of \ref lwesp_trace_type_t enumeration
+ *  - `uint8_t` command type, active command for data records
+ *  - `uint16_t` number of data bytes
+ *  - `uint32_t` argument, meaning depends on record type
+ *
+ * Use `tools/lwesp_trace_decode.py` to print timeline with command durations
+ * and idle gaps on AT port.
+ * \{
+ */
+
+#define LWESP_TRACE_VERSION             1       /*!< Version of binary trace format */
+
+/**
+ * \brief           Type of trace record
+ */
+typedef enum {
+    LWESP_TRACE_TYPE_TX = 1,                    /*!< Data sent to AT port, argument is full length of data */
+    LWESP_TRACE_TYPE_RX,                        /*!< Data received from AT port, argument is full length of data */
+    LWESP_TRACE_TYPE_CMD_START,                 /*!< Command started, argument identifies command until it ends */
+    LWESP_TRACE_TYPE_CMD_END,                   /*!< Command finished, argument identifies command,
+                                                    single data byte is result as member of \ref lwespr_t */
+    LWESP_TRACE_TYPE_NAME,                      /*!< Name of command type, only in output of \ref lwesp_trace_dump */
+} lwesp_trace_type_t;
+
+/**
+ * \brief           Output function for trace dump
+ * \param[in]       data: Data to output
+ * \param[in]       len: Length of data in units of bytes
+ * \param[in]       arg: User argument
+ */
+typedef void (*lwesp_trace_out_fn)(const void* data, size_t len, void* arg);
+
+lwespr_t    lwesp_trace_dump(lwesp_trace_out_fn out_fn, void* arg);
+lwespr_t    lwesp_trace_clear(void);
+
+/**
+ * \}
+ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LWESP_HDR_TRACE_H */
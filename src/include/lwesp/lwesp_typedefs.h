@@ -38,6 +38,11 @@
  *   - Remove LWESP_CFG_ESP32 macro
  *   - Change lwesp_conn_type_t from enum to int8_t
  *   - Remove lwesp_datetime_t
+ *   - Add lwesp_iovec_t
+ *   - Add lock-free index type of lwesp_buff_t
+ *   - Add AT port baudrate event
+ *   - Add warm start snapshot
+ *   - Add RTS flow control function
  */
 #ifndef LWESP_HDR_DEFS_H
 #define LWESP_HDR_DEFS_H
@@ -46,6 +51,9 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#if LWESP_CFG_INPUT_BUFF_SPSC
+#include <stdatomic.h>
+#endif /* LWESP_CFG_INPUT_BUFF_SPSC */
 
 #ifdef __cplusplus
 extern "C" {
@@ -152,6 +160,39 @@ typedef struct {
     uint8_t patch;                              /*!< Patch version */
 } lwesp_sw_version_t;
 
+#if LWESP_CFG_RESET_WARM || __DOXYGEN__
+
+/**
+ * \ingroup         LWESP_TYPEDEFS
+ * \brief           Device information for warm start, saved by application over host restart
+ * \sa              lwesp_warm_get_snapshot, lwesp_reset_warm
+ */
+typedef struct {
+    uint32_t magic;                             /*!< Snapshot identification, set by stack */
+    uint32_t size;                              /*!< Size of snapshot structure, changes with configuration */
+    uint32_t baudrate;                          /*!< AT port baudrate */
+    lwesp_device_t device;                      /*!< ESP device type */
+    lwesp_sw_version_t version_at;              /*!< Version of AT command software on ESP device */
+    lwesp_sw_version_t version_sdk;             /*!< Version of SDK used to build AT software */
+#if LWESP_CFG_MODE_STATION || __DOXYGEN__
+    lwesp_ip_t sta_ip;                          /*!< Station IP address */
+    lwesp_ip_t sta_gw;                          /*!< Station gateway address */
+    lwesp_ip_t sta_nm;                          /*!< Station netmask address */
+    lwesp_mac_t sta_mac;                        /*!< Station MAC address */
+    uint8_t sta_dhcp;                           /*!< Station DHCP status */
+#endif /* LWESP_CFG_MODE_STATION || __DOXYGEN__ */
+#if LWESP_CFG_MODE_ACCESS_POINT || __DOXYGEN__
+    lwesp_ip_t ap_ip;                           /*!< Access point IP address */
+    lwesp_ip_t ap_gw;                           /*!< Access point gateway address */
+    lwesp_ip_t ap_nm;                           /*!< Access point netmask address */
+    lwesp_mac_t ap_mac;                         /*!< Access point MAC address */
+    uint8_t ap_dhcp;                            /*!< Access point DHCP status */
+#endif /* LWESP_CFG_MODE_ACCESS_POINT || __DOXYGEN__ */
+    uint32_t checksum;                          /*!< Checksum of all previous fields */
+} lwesp_warm_snapshot_t;
+
+#endif /* LWESP_CFG_RESET_WARM || __DOXYGEN__ */
+
 /**
  * \ingroup         LWESP_AP
  * \brief           Access point data structure
@@ -288,6 +329,9 @@ typedef enum lwesp_evt_type_t {
     LWESP_EVT_DEVICE_PRESENT,                   /*!< Notification when device present status changes */
 
     LWESP_EVT_AT_VERSION_NOT_SUPPORTED,         /*!< Library does not support firmware version on ESP device. */
+#if LWESP_CFG_AT_PORT_BAUDRATE_AUTO || __DOXYGEN__
+    LWESP_EVT_AT_BAUDRATE,                      /*!< AT port baudrate negotiated in reset sequence */
+#endif /* LWESP_CFG_AT_PORT_BAUDRATE_AUTO || __DOXYGEN__ */
 
     LWESP_EVT_CONN_RECV,                        /*!< Connection data received */
     LWESP_EVT_CONN_SEND,                        /*!< Connection data send */
@@ -342,6 +386,13 @@ typedef struct lwesp_evt {
         struct {
             lwespr_t res;                       /*!< Restore operation result */
         } restore;                              /*!< Restore sequence finish. Use with \ref LWESP_EVT_RESTORE event */
+#if LWESP_CFG_AT_PORT_BAUDRATE_AUTO || __DOXYGEN__
+        struct {
+            uint32_t baudrate;                  /*!< Baudrate used for AT port */
+            lwespr_t res;                       /*!< \ref lwespOK when baudrate from list is used,
+                                                    \ref lwespERR when stack went back to default baudrate */
+        } at_baudrate;                          /*!< AT port baudrate negotiated. Use with \ref LWESP_EVT_AT_BAUDRATE event */
+#endif /* LWESP_CFG_AT_PORT_BAUDRATE_AUTO || __DOXYGEN__ */
 
         struct {
             lwesp_conn_p conn;                  /*!< Connection where data were received */
@@ -447,6 +498,18 @@ typedef size_t (*lwesp_ll_send_fn)(const void* data, size_t len);
  */
 typedef uint8_t (*lwesp_ll_reset_fn)(uint8_t state);
 
+/**
+ * \ingroup         LWESP_LL
+ * \brief           Function prototype for hardware flow control of data received from ESP device
+ *
+ * Function is called from input functions (may be interrupt context)
+ * when input buffer fills up and from processing thread, it must only set the pin
+ *
+ * \param[in]       stop: When set to `1`, device must stop sending data (RTS pin inactive, usually high),
+ *                      or set to `0` when device may send data again
+ */
+typedef void (*lwesp_ll_rts_fn)(uint8_t stop);
+
 /**
  * \ingroup         LWESP_LL
  * \brief           Low level user specific functions
@@ -454,6 +517,10 @@ typedef uint8_t (*lwesp_ll_reset_fn)(uint8_t state);
 typedef struct {
     lwesp_ll_send_fn send_fn;                   /*!< Callback function to transmit data */
     lwesp_ll_reset_fn reset_fn;                 /*!< Reset callback function */
+#if LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__
+    lwesp_ll_rts_fn rts_fn;                     /*!< Optional RTS callback function. Set to `NULL`
+                                                    when device has no hardware flow control */
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__ */
     struct {
         uint32_t baudrate;                      /*!< UART baudrate value */
     } uart;                                     /*!< UART communication parameters */
@@ -471,12 +538,29 @@ typedef void (*lwesp_timeout_fn)(void* arg);
  * \brief           Timeout structure
  */
 typedef struct lwesp_timeout {
-    struct lwesp_timeout* next;                 /*!< Pointer to next timeout entry */
-    uint32_t time;                              /*!< Time difference from previous entry */
+    struct lwesp_timeout* next;                 /*!< Pointer to next timeout entry in the same slot */
+    struct lwesp_timeout* prev;                 /*!< Pointer to previous timeout entry in the same slot */
+    uint32_t time;                              /*!< Absolute expiry time in units of milliseconds */
     void* arg;                                  /*!< Argument to pass to callback function */
     lwesp_timeout_fn fn;                        /*!< Callback function for timeout */
+    uint8_t level;                              /*!< Timing wheel level of entry */
+    uint8_t slot;                               /*!< Slot index on timing wheel level */
+    uint8_t flags;                              /*!< Timeout flags, used by timeout manager */
 } lwesp_timeout_t;
 
+/**
+ * \ingroup         LWESP_BUFF
+ * \brief           Buffer read and write pointer type
+ *
+ * Atomic when \ref LWESP_CFG_INPUT_BUFF_SPSC is enabled,
+ * so one thread (or interrupt) may write to buffer while other reads from it
+ */
+#if LWESP_CFG_INPUT_BUFF_SPSC || __DOXYGEN__
+typedef atomic_size_t lwesp_buff_idx_t;
+#else
+typedef size_t lwesp_buff_idx_t;
+#endif /* LWESP_CFG_INPUT_BUFF_SPSC || __DOXYGEN__ */
+
 /**
  * \ingroup         LWESP_BUFF
  * \brief           Buffer structure
@@ -486,9 +570,9 @@ typedef struct {
                                                     Buffer is considered initialized when `buff != NULL` */
     size_t size;                                /*!< Size of buffer data. Size of actual buffer is
                                                         `1` byte less than this value */
-    size_t r;                                   /*!< Next read pointer. Buffer is considered empty
+    lwesp_buff_idx_t r;                         /*!< Next read pointer. Buffer is considered empty
                                                         when `r == w` and full when `w == r - 1` */
-    size_t w;                                   /*!< Next write pointer. Buffer is considered empty
+    lwesp_buff_idx_t w;                         /*!< Next write pointer. Buffer is considered empty
                                                         when `r == w` and full when `w == r - 1` */
 } lwesp_buff_t;
 
@@ -502,6 +586,16 @@ typedef struct {
     size_t ptr;                                 /*!< Current buffer pointer */
 } lwesp_linbuff_t;
 
+/**
+ * \ingroup         LWESP_TYPEDEFS
+ * \brief           Data segment for scatter-gather send
+ * \sa              lwesp_conn_sendv
+ */
+typedef struct {
+    const void* data;                           /*!< Pointer to segment data */
+    size_t len;                                 /*!< Length of segment in units of bytes */
+} lwesp_iovec_t;
+
 /**
  * \ingroup         LWESP_TYPEDEFS
  * \brief           Function declaration for API function command event callback function
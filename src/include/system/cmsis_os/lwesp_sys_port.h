@@ -31,6 +31,12 @@
  * Author:          Tilen MAJERLE <tilen@majerle.eu>
  * Version:         v1.0.0
  */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ *   - Skip message queue type when lock-free message queue is used
+ */
 #ifndef LWESP_HDR_SYSTEM_PORT_H
 #define LWESP_HDR_SYSTEM_PORT_H
 
@@ -47,13 +53,17 @@ extern "C" {
 
 typedef osMutexId_t                 lwesp_sys_mutex_t;
 typedef osSemaphoreId_t             lwesp_sys_sem_t;
+#if !LWESP_CFG_SYS_MBOX_LOCKFREE
 typedef osMessageQueueId_t          lwesp_sys_mbox_t;
+#endif /* !LWESP_CFG_SYS_MBOX_LOCKFREE */
 typedef osThreadId_t                lwesp_sys_thread_t;
 typedef osPriority_t                lwesp_sys_thread_prio_t;
 
 #define LWESP_SYS_MUTEX_NULL          ((lwesp_sys_mutex_t)0)
 #define LWESP_SYS_SEM_NULL            ((lwesp_sys_sem_t)0)
+#if !LWESP_CFG_SYS_MBOX_LOCKFREE
 #define LWESP_SYS_MBOX_NULL           ((lwesp_sys_mbox_t)0)
+#endif /* !LWESP_CFG_SYS_MBOX_LOCKFREE */
 #define LWESP_SYS_TIMEOUT             ((uint32_t)osWaitForever)
 #define LWESP_SYS_THREAD_PRIO         (osPriorityNormal)
 #define LWESP_SYS_THREAD_SS           (512)
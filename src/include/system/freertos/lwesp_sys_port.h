@@ -32,6 +32,12 @@
  * Author:          Adrian Carpenter (FreeRTOS port)
  * Version:         v1.0.0
  */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ *   - Skip message queue type when lock-free message queue is used
+ */
 #ifndef LWESP_HDR_SYSTEM_PORT_H
 #define LWESP_HDR_SYSTEM_PORT_H
 
@@ -50,13 +56,17 @@ extern "C" {
 
 typedef SemaphoreHandle_t           lwesp_sys_mutex_t;
 typedef SemaphoreHandle_t           lwesp_sys_sem_t;
+#if !LWESP_CFG_SYS_MBOX_LOCKFREE
 typedef QueueHandle_t               lwesp_sys_mbox_t;
+#endif /* !LWESP_CFG_SYS_MBOX_LOCKFREE */
 typedef TaskHandle_t                lwesp_sys_thread_t;
 typedef UBaseType_t                 lwesp_sys_thread_prio_t;
 
 #define LWESP_SYS_MUTEX_NULL          ((SemaphoreHandle_t)0)
 #define LWESP_SYS_SEM_NULL            ((SemaphoreHandle_t)0)
+#if !LWESP_CFG_SYS_MBOX_LOCKFREE
 #define LWESP_SYS_MBOX_NULL           ((QueueHandle_t)0)
+#endif /* !LWESP_CFG_SYS_MBOX_LOCKFREE */
 #define LWESP_SYS_TIMEOUT             ((TickType_t)portMAX_DELAY)
 #define LWESP_SYS_THREAD_PRIO         (configMAX_PRIORITIES - 1)
 #define LWESP_SYS_THREAD_SS           (1024)
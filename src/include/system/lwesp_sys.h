@@ -31,6 +31,14 @@
  * Author:          Tilen MAJERLE <tilen@majerle.eu>
  * Version:         v1.0.0
  */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ *   - Add message queue type of lock-free implementation
+ *   - Add time in units of microseconds for trace
+ *   - Use time in units of microseconds for send gap statistics
+ */
 #ifndef LWESP_HDR_MAIN_SYS_H
 #define LWESP_HDR_MAIN_SYS_H
 
@@ -55,6 +63,12 @@ typedef void (*lwesp_sys_thread_fn)(void*);
 /* Include system port file from portable folder */
 #include "lwesp_sys_port.h"
 
+#if LWESP_CFG_OS && LWESP_CFG_SYS_MBOX_LOCKFREE && !__DOXYGEN__
+/* Message queue type of lock-free implementation, replaces type from system port */
+typedef struct lwesp_sys_mbox_lf*   lwesp_sys_mbox_t;
+#define LWESP_SYS_MBOX_NULL           ((lwesp_sys_mbox_t)0)
+#endif /* LWESP_CFG_OS && LWESP_CFG_SYS_MBOX_LOCKFREE && !__DOXYGEN__ */
+
 /**
  * \anchor          LWESP_SYS_CORE
  * \name            Main
@@ -62,6 +76,9 @@ typedef void (*lwesp_sys_thread_fn)(void*);
 
 uint8_t     lwesp_sys_init(void);
 uint32_t    lwesp_sys_now(void);
+#if LWESP_CFG_TRACE || LWESP_CFG_STATS || __DOXYGEN__
+uint32_t    lwesp_sys_now_us(void);
+#endif /* LWESP_CFG_TRACE || LWESP_CFG_STATS || __DOXYGEN__ */
 
 uint8_t     lwesp_sys_protect(void);
 uint8_t     lwesp_sys_unprotect(void);
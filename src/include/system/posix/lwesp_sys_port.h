@@ -0,0 +1,68 @@
+/**
+ * \file            lwesp_sys_port.h
+ * \brief           POSIX based system file implementation
+ */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwESP - Lightweight ESP-AT parser library.
+ */
+#ifndef LWESP_HDR_SYSTEM_PORT_H
+#define LWESP_HDR_SYSTEM_PORT_H
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include "lwesp/lwesp_opt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif /* __cplusplus */
+
+#if LWESP_CFG_OS && !__DOXYGEN__
+
+typedef pthread_mutex_t*            lwesp_sys_mutex_t;
+typedef struct lwesp_posix_sem*     lwesp_sys_sem_t;
+#if !LWESP_CFG_SYS_MBOX_LOCKFREE
+typedef struct lwesp_posix_mbox*    lwesp_sys_mbox_t;
+#endif /* !LWESP_CFG_SYS_MBOX_LOCKFREE */
+typedef pthread_t                   lwesp_sys_thread_t;
+typedef int                         lwesp_sys_thread_prio_t;
+
+#if !LWESP_CFG_SYS_MBOX_LOCKFREE
+#define LWESP_SYS_MBOX_NULL           ((lwesp_sys_mbox_t)0)
+#endif /* !LWESP_CFG_SYS_MBOX_LOCKFREE */
+#define LWESP_SYS_SEM_NULL            ((lwesp_sys_sem_t)0)
+#define LWESP_SYS_MUTEX_NULL          ((lwesp_sys_mutex_t)0)
+#define LWESP_SYS_TIMEOUT             ((uint32_t)0xFFFFFFFF)
+#define LWESP_SYS_THREAD_PRIO         (0)
+#define LWESP_SYS_THREAD_SS           (0)
+
+#endif /* LWESP_CFG_OS && !__DOXYGEN__ */
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* LWESP_HDR_SYSTEM_PORT_H */
@@ -31,6 +31,12 @@
  * Author:          Tilen MAJERLE <tilen@majerle.eu>
  * Version:         v1.0.0
  */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ *   - Skip message queue type when lock-free message queue is used
+ */
 #ifndef LWESP_HDR_SYSTEM_PORT_H
 #define LWESP_HDR_SYSTEM_PORT_H
 
@@ -64,12 +70,14 @@ typedef osMutexId_t         lwesp_sys_mutex_t;
  */
 typedef osSemaphoreId_t     lwesp_sys_sem_t;
 
+#if !LWESP_CFG_SYS_MBOX_LOCKFREE || __DOXYGEN__
 /**
  * \brief           System message queue type
  *
  * It is used by middleware as base type of mutex.
  */
 typedef osMessageQueueId_t  lwesp_sys_mbox_t;
+#endif /* !LWESP_CFG_SYS_MBOX_LOCKFREE || __DOXYGEN__ */
 
 /**
  * \brief           System thread ID type
@@ -98,12 +106,14 @@ typedef osPriority          lwesp_sys_thread_prio_t;
  */
 #define LWESP_SYS_SEM_NULL            ((lwesp_sys_sem_t)0)
 
+#if !LWESP_CFG_SYS_MBOX_LOCKFREE || __DOXYGEN__
 /**
  * \brief           Message box invalid value
  *
  * Value assigned to \ref lwesp_sys_mbox_t type when it is not valid.
  */
 #define LWESP_SYS_MBOX_NULL           ((lwesp_sys_mbox_t)0)
+#endif /* !LWESP_CFG_SYS_MBOX_LOCKFREE || __DOXYGEN__ */
 
 /**
  * \brief           OS timeout value
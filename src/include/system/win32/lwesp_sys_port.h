@@ -31,6 +31,12 @@
  * Author:          Tilen MAJERLE <tilen@majerle.eu>
  * Version:         v1.0.0
  */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ *   - Skip message queue type when lock-free message queue is used
+ */
 #ifndef LWESP_HDR_SYSTEM_PORT_H
 #define LWESP_HDR_SYSTEM_PORT_H
 
@@ -47,11 +53,15 @@ extern "C" {
 
 typedef HANDLE                      lwesp_sys_mutex_t;
 typedef HANDLE                      lwesp_sys_sem_t;
+#if !LWESP_CFG_SYS_MBOX_LOCKFREE
 typedef HANDLE                      lwesp_sys_mbox_t;
+#endif /* !LWESP_CFG_SYS_MBOX_LOCKFREE */
 typedef HANDLE                      lwesp_sys_thread_t;
 typedef int                         lwesp_sys_thread_prio_t;
 
+#if !LWESP_CFG_SYS_MBOX_LOCKFREE
 #define LWESP_SYS_MBOX_NULL           ((HANDLE)0)
+#endif /* !LWESP_CFG_SYS_MBOX_LOCKFREE */
 #define LWESP_SYS_SEM_NULL            ((HANDLE)0)
 #define LWESP_SYS_MUTEX_NULL          ((HANDLE)0)
 #define LWESP_SYS_TIMEOUT             (INFINITE)
@@ -38,7 +38,11 @@
  *   - Remove LWESP_CFG_ESP32 macro
  *   - Remove debug message
  *   - Remove LWESP_CFG_CONN_MANUAL_TCP_RECEIVE macro which is not supported by Ai-thinker esp8266
+ *   - Init wake-up flag of lock-free input buffer
+ *   - Init AT port trace
+ *   - Add warm start
  */
+#include <stddef.h>
 #include "lwesp/lwesp_private.h"
 #include "lwesp/lwesp_mem.h"
 #include "lwesp/lwesp_threads.h"
@@ -92,6 +96,11 @@ lwesp_init(lwesp_evt_fn evt_func, const uint32_t blocking) {
     if (!lwesp_sys_init()) {                    /* Init low-level system */
         goto cleanup;
     }
+#if LWESP_CFG_TRACE
+    if (!lwespi_trace_init()) {                 /* Init trace before any data are sent */
+        goto cleanup;
+    }
+#endif /* LWESP_CFG_TRACE */
 
     if (!lwesp_sys_sem_create(&esp.sem_sync, 1)) {  /* Create sync semaphore between threads */
         goto cleanup;
@@ -127,6 +136,9 @@ lwesp_init(lwesp_evt_fn evt_func, const uint32_t blocking) {
 #if !LWESP_CFG_INPUT_USE_PROCESS
     lwesp_buff_init(&esp.buff, LWESP_CFG_RCV_BUFF_SIZE);/* Init buffer for input data */
 #endif /* !LWESP_CFG_INPUT_USE_PROCESS */
+#if LWESP_CFG_INPUT_BUFF_SPSC
+    atomic_flag_clear(&esp.buff_wake);
+#endif /* LWESP_CFG_INPUT_BUFF_SPSC */
 
     esp.status.f.initialized = 1;               /* We are initialized now */
     esp.status.f.dev_present = 1;               /* We assume device is present at this point */
@@ -207,6 +219,103 @@ lwesp_reset_with_delay(uint32_t delay,
     return lwespi_send_msg_to_producer_mbox(&LWESP_MSG_VAR_REF(msg), lwespi_initiate_cmd, 5000);
 }
 
+#if LWESP_CFG_RESET_WARM || __DOXYGEN__
+
+#define LWESP_WARM_MAGIC            0x4D525757  /*!< Identification of warm start snapshot */
+
+/**
+ * \brief           Calculate checksum of warm start snapshot
+ * \param[in]       snap: Snapshot
+ * \return          FNV-1a hash of all fields before checksum
+ */
+static uint32_t
+warm_snapshot_checksum(const lwesp_warm_snapshot_t* snap) {
+    const uint8_t* d = (const void*)snap;
+    uint32_t hash = 0x811C9DC5;
+
+    for (size_t i = 0; i < offsetof(lwesp_warm_snapshot_t, checksum); ++i) {
+        hash = (hash ^ d[i]) * 0x01000193;
+    }
+    return hash;
+}
+
+/**
+ * \brief           Save device information for warm start
+ *
+ * Application keeps snapshot over host restart, for example in memory not cleared on reset,
+ * and passes it to \ref lwesp_reset_warm after restart.
+ * Take snapshot after reset sequence has finished and after IP or MAC addresses changed
+ *
+ * \param[out]      snap: Snapshot to fill
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_warm_get_snapshot(lwesp_warm_snapshot_t* snap) {
+    LWESP_ASSERT("snap != NULL", snap != NULL);
+
+    LWESP_MEMSET(snap, 0x00, sizeof(*snap));    /* Clear padding, it is part of checksum */
+    lwesp_core_lock();
+    snap->magic = LWESP_WARM_MAGIC;
+    snap->size = sizeof(*snap);
+    snap->baudrate = esp.ll.uart.baudrate;
+    snap->device = esp.m.device;
+    snap->version_at = esp.m.version_at;
+    snap->version_sdk = esp.m.version_sdk;
+#if LWESP_CFG_MODE_STATION
+    snap->sta_ip = esp.m.sta.ip;
+    snap->sta_gw = esp.m.sta.gw;
+    snap->sta_nm = esp.m.sta.nm;
+    snap->sta_mac = esp.m.sta.mac;
+    snap->sta_dhcp = esp.m.sta.dhcp;
+#endif /* LWESP_CFG_MODE_STATION */
+#if LWESP_CFG_MODE_ACCESS_POINT
+    snap->ap_ip = esp.m.ap.ip;
+    snap->ap_gw = esp.m.ap.gw;
+    snap->ap_nm = esp.m.ap.nm;
+    snap->ap_mac = esp.m.ap.mac;
+    snap->ap_dhcp = esp.m.ap.dhcp;
+#endif /* LWESP_CFG_MODE_ACCESS_POINT */
+    lwesp_core_unlock();
+    snap->checksum = warm_snapshot_checksum(snap);
+    return lwespOK;
+}
+
+/**
+ * \brief           Start device after host restart, when device may still be running
+ *
+ * Device is verified with `AT` command and only connection status is read,
+ * other device information is taken from snapshot.
+ * When snapshot is `NULL` or not valid, or device does not respond,
+ * full reset sequence is executed as with \ref lwesp_reset
+ *
+ * \param[in]       snap: Snapshot saved with \ref lwesp_warm_get_snapshot before host restart.
+ *                      It must stay valid until command finishes
+ * \param[in]       evt_fn: Callback function called when command has finished. Set to `NULL` when not used
+ * \param[in]       evt_arg: Custom argument for event callback function
+ * \param[in]       blocking: Status whether command should be blocking or not
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_reset_warm(const lwesp_warm_snapshot_t* snap,
+                 const lwesp_api_cmd_evt_fn evt_fn, void* const evt_arg, const uint32_t blocking) {
+    LWESP_MSG_VAR_DEFINE(msg);
+
+    if (snap == NULL || snap->magic != LWESP_WARM_MAGIC || snap->size != sizeof(*snap)
+        || snap->checksum != warm_snapshot_checksum(snap)) {
+        return lwesp_reset(evt_fn, evt_arg, blocking);
+    }
+
+    LWESP_MSG_VAR_ALLOC(msg, blocking);
+    LWESP_MSG_VAR_SET_EVT(msg, evt_fn, evt_arg);
+    LWESP_MSG_VAR_REF(msg).cmd_def = LWESP_CMD_RESET;
+    LWESP_MSG_VAR_REF(msg).cmd = LWESP_CMD_AT;
+    LWESP_MSG_VAR_REF(msg).msg.reset.warm = snap;
+
+    return lwespi_send_msg_to_producer_mbox(&LWESP_MSG_VAR_REF(msg), lwespi_initiate_cmd, 5000);
+}
+
+#endif /* LWESP_CFG_RESET_WARM || __DOXYGEN__ */
+
 /**
  * \brief           Execute restore command and set module to default values
  * \param[in]       evt_fn: Callback function called when command has finished. Set to `NULL` when not used
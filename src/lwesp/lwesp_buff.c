@@ -31,6 +31,12 @@
  * Author:          Tilen MAJERLE <tilen@majerle.eu>
  * Version:         v1.0.0
  */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ *   - Add lock-free single-producer/single-consumer mode
+ */
 #include "lwesp/lwesp_private.h"
 #include "lwesp/lwesp_buff.h"
 #include "lwesp/lwesp_mem.h"
@@ -47,8 +53,28 @@
 #define BUF_MIN(x, y)                   ((x) < (y) ? (x) : (y))
 #define BUF_MAX(x, y)                   ((x) > (y) ? (x) : (y))
 
+/*
+ * Pointer access macros
+ *
+ * In lock-free mode, writer owns write pointer and reader owns read pointer.
+ * Own pointer is loaded relaxed, pointer of other side with acquire
+ * and own pointer is published with release, after data are copied.
+ * Pointers are wrapped with mask as buffer size is power of 2
+ */
+#if LWESP_CFG_INPUT_BUFF_SPSC
+#define BUF_LOAD(p, mo)                 atomic_load_explicit(&(p), memory_order_ ## mo)
+#define BUF_STORE(p, v, mo)             atomic_store_explicit(&(p), (v), memory_order_ ## mo)
+#define BUF_WRAP(b, i)                  ((i) & ((b)->size - 1))
+#else /* LWESP_CFG_INPUT_BUFF_SPSC */
+#define BUF_LOAD(p, mo)                 (p)
+#define BUF_STORE(p, v, mo)             ((p) = (v))
+#define BUF_WRAP(b, i)                  ((i) >= (b)->size ? (i) - (b)->size : (i))
+#endif /* !LWESP_CFG_INPUT_BUFF_SPSC */
+
 /**
  * \brief           Initialize buffer
+ * \note            When \ref LWESP_CFG_INPUT_BUFF_SPSC is enabled,
+ *                  size is rounded up to power of `2`
  * \param[in]       buff: Pointer to buffer structure
  * \param[in]       size: Size of buffer in units of bytes
  * \return          `1` on success, `0` otherwise
@@ -59,6 +85,11 @@ BUF_PREF(buff_init)(BUF_PREF(buff_t)* buff, size_t size) {
         return 0;
     }
     BUF_MEMSET(buff, 0, sizeof(*buff));
+#if LWESP_CFG_INPUT_BUFF_SPSC
+    while (size & (size - 1)) {                 /* Round up to power of 2 for mask */
+        size = (size | (size - 1)) + 1;
+    }
+#endif /* LWESP_CFG_INPUT_BUFF_SPSC */
 
     buff->size = size;                          /* Set default values */
     buff->buff = lwesp_mem_malloc(sizeof(*buff->buff) * size);  /* Allocate memory for buffer */
@@ -92,7 +123,7 @@ BUF_PREF(buff_free)(BUF_PREF(buff_t)* buff) {
  */
 size_t
 BUF_PREF(buff_write)(BUF_PREF(buff_t)* buff, const void* data, size_t btw) {
-    size_t tocopy, free;
+    size_t tocopy, free, w;
     const uint8_t* d = data;
 
     if (!BUF_IS_VALID(buff) || btw == 0) {
@@ -107,20 +138,19 @@ BUF_PREF(buff_write)(BUF_PREF(buff_t)* buff, const void* data, size_t btw) {
     }
 
     /* Step 1: Write data to linear part of buffer */
-    tocopy = BUF_MIN(buff->size - buff->w, btw);
-    BUF_MEMCPY(&buff->buff[buff->w], d, tocopy);
-    buff->w += tocopy;
+    w = BUF_LOAD(buff->w, relaxed);
+    tocopy = BUF_MIN(buff->size - w, btw);
+    BUF_MEMCPY(&buff->buff[w], d, tocopy);
     btw -= tocopy;
 
     /* Step 2: Write data to beginning of buffer (overflow part) */
     if (btw > 0) {
         BUF_MEMCPY(buff->buff, (void*)&d[tocopy], btw);
-        buff->w = btw;
     }
 
-    if (buff->w >= buff->size) {
-        buff->w = 0;
-    }
+    /* Step 3: Publish written data to reader */
+    w += tocopy + btw;
+    BUF_STORE(buff->w, BUF_WRAP(buff, w), release);
     return tocopy + btw;
 }
 
@@ -134,7 +164,7 @@ BUF_PREF(buff_write)(BUF_PREF(buff_t)* buff, const void* data, size_t btw) {
  */
 size_t
 BUF_PREF(buff_read)(BUF_PREF(buff_t)* buff, void* data, size_t btr) {
-    size_t tocopy, full;
+    size_t tocopy, full, r;
     uint8_t* d = data;
 
     if (!BUF_IS_VALID(buff) || btr == 0) {
@@ -149,21 +179,19 @@ BUF_PREF(buff_read)(BUF_PREF(buff_t)* buff, void* data, size_t btr) {
     }
 
     /* Step 1: Read data from linear part of buffer */
-    tocopy = BUF_MIN(buff->size - buff->r, btr);
-    BUF_MEMCPY(d, &buff->buff[buff->r], tocopy);
-    buff->r += tocopy;
+    r = BUF_LOAD(buff->r, relaxed);
+    tocopy = BUF_MIN(buff->size - r, btr);
+    BUF_MEMCPY(d, &buff->buff[r], tocopy);
     btr -= tocopy;
 
     /* Step 2: Read data from beginning of buffer (overflow part) */
     if (btr > 0) {
         BUF_MEMCPY(&d[tocopy], buff->buff, btr);
-        buff->r = btr;
     }
 
-    /* Step 3: Check end of buffer */
-    if (buff->r >= buff->size) {
-        buff->r = 0;
-    }
+    /* Step 3: Release read memory to writer */
+    r += tocopy + btr;
+    BUF_STORE(buff->r, BUF_WRAP(buff, r), release);
     return tocopy + btr;
 }
 
@@ -184,8 +212,6 @@ BUF_PREF(buff_peek)(BUF_PREF(buff_t)* buff, size_t skip_count, void* data, size_
         return 0;
     }
 
-    r = buff->r;
-
     /* Calculate maximum number of bytes available to read */
     full = BUF_PREF(buff_get_full)(buff);
 
@@ -193,11 +219,9 @@ BUF_PREF(buff_peek)(BUF_PREF(buff_t)* buff, size_t skip_count, void* data, size_
     if (skip_count >= full) {
         return 0;
     }
-    r += skip_count;
+    r = BUF_LOAD(buff->r, relaxed) + skip_count;
+    r = BUF_WRAP(buff, r);
     full -= skip_count;
-    if (r >= buff->size) {
-        r -= buff->size;
-    }
 
     /* Check maximum number of bytes available to read after skip */
     btp = BUF_MIN(full, btp);
@@ -231,8 +255,11 @@ BUF_PREF(buff_get_free)(BUF_PREF(buff_t)* buff) {
     }
 
     /* Use temporary values in case they are changed during operations */
-    w = buff->w;
-    r = buff->r;
+    w = BUF_LOAD(buff->w, acquire);
+    r = BUF_LOAD(buff->r, acquire);
+#if LWESP_CFG_INPUT_BUFF_SPSC
+    size = BUF_WRAP(buff, r - w - 1);
+#else /* LWESP_CFG_INPUT_BUFF_SPSC */
     if (w == r) {
         size = buff->size;
     } else if (r > w) {
@@ -240,9 +267,11 @@ BUF_PREF(buff_get_free)(BUF_PREF(buff_t)* buff) {
     } else {
         size = buff->size - (w - r);
     }
+    --size;
+#endif /* !LWESP_CFG_INPUT_BUFF_SPSC */
 
     /* Buffer free size is always 1 less than actual size */
-    return size - 1;
+    return size;
 }
 
 /**
@@ -259,8 +288,11 @@ BUF_PREF(buff_get_full)(BUF_PREF(buff_t)* buff) {
     }
 
     /* Use temporary values in case they are changed during operations */
-    w = buff->w;
-    r = buff->r;
+    w = BUF_LOAD(buff->w, acquire);
+    r = BUF_LOAD(buff->r, acquire);
+#if LWESP_CFG_INPUT_BUFF_SPSC
+    size = BUF_WRAP(buff, w - r);
+#else /* LWESP_CFG_INPUT_BUFF_SPSC */
     if (w == r) {
         size = 0;
     } else if (w > r) {
@@ -268,6 +300,7 @@ BUF_PREF(buff_get_full)(BUF_PREF(buff_t)* buff) {
     } else {
         size = buff->size - (r - w);
     }
+#endif /* !LWESP_CFG_INPUT_BUFF_SPSC */
     return size;
 }
 
@@ -278,8 +311,8 @@ BUF_PREF(buff_get_full)(BUF_PREF(buff_t)* buff) {
 void
 BUF_PREF(buff_reset)(BUF_PREF(buff_t)* buff) {
     if (BUF_IS_VALID(buff)) {
-        buff->w = 0;
-        buff->r = 0;
+        BUF_STORE(buff->w, 0, relaxed);
+        BUF_STORE(buff->r, 0, relaxed);
     }
 }
 
@@ -293,7 +326,7 @@ BUF_PREF(buff_get_linear_block_read_address)(BUF_PREF(buff_t)* buff) {
     if (!BUF_IS_VALID(buff)) {
         return NULL;
     }
-    return &buff->buff[buff->r];
+    return &buff->buff[BUF_LOAD(buff->r, relaxed)];
 }
 
 /**
@@ -310,8 +343,8 @@ BUF_PREF(buff_get_linear_block_read_length)(BUF_PREF(buff_t)* buff) {
     }
 
     /* Use temporary values in case they are changed during operations */
-    w = buff->w;
-    r = buff->r;
+    w = BUF_LOAD(buff->w, acquire);
+    r = BUF_LOAD(buff->r, acquire);
     if (w > r) {
         len = w - r;
     } else if (r > w) {
@@ -332,17 +365,15 @@ BUF_PREF(buff_get_linear_block_read_length)(BUF_PREF(buff_t)* buff) {
  */
 size_t
 BUF_PREF(buff_skip)(BUF_PREF(buff_t)* buff, size_t len) {
-    size_t full;
+    size_t full, r;
 
     if (!BUF_IS_VALID(buff) || len == 0) {
         return 0;
     }
 
     full = BUF_PREF(buff_get_full)(buff);       /* Get buffer used length */
-    buff->r += BUF_MIN(len, full);              /* Advance read pointer */
-    if (buff->r >= buff->size) {                /* Subtract possible overflow */
-        buff->r -= buff->size;
-    }
+    r = BUF_LOAD(buff->r, relaxed) + BUF_MIN(len, full);   /* Advance read pointer */
+    BUF_STORE(buff->r, BUF_WRAP(buff, r), release); /* Release memory to writer */
     return len;
 }
 
@@ -356,7 +387,7 @@ BUF_PREF(buff_get_linear_block_write_address)(BUF_PREF(buff_t)* buff) {
     if (!BUF_IS_VALID(buff)) {
         return NULL;
     }
-    return &buff->buff[buff->w];
+    return &buff->buff[BUF_LOAD(buff->w, relaxed)];
 }
 
 /**
@@ -373,8 +404,8 @@ BUF_PREF(buff_get_linear_block_write_length)(BUF_PREF(buff_t)* buff) {
     }
 
     /* Use temporary values in case they are changed during operations */
-    w = buff->w;
-    r = buff->r;
+    w = BUF_LOAD(buff->w, acquire);
+    r = BUF_LOAD(buff->r, acquire);
     if (w >= r) {
         len = buff->size - w;
         /*
@@ -407,16 +438,14 @@ BUF_PREF(buff_get_linear_block_write_length)(BUF_PREF(buff_t)* buff) {
  */
 size_t
 BUF_PREF(buff_advance)(BUF_PREF(buff_t)* buff, size_t len) {
-    size_t free;
+    size_t free, w;
 
     if (!BUF_IS_VALID(buff) || len == 0) {
         return 0;
     }
 
     free = BUF_PREF(buff_get_free)(buff);       /* Get buffer free length */
-    buff->w += BUF_MIN(len, free);              /* Advance write pointer */
-    if (buff->w >= buff->size) {                /* Subtract possible overflow */
-        buff->w -= buff->size;
-    }
+    w = BUF_LOAD(buff->w, relaxed) + BUF_MIN(len, free);   /* Advance write pointer */
+    BUF_STORE(buff->w, BUF_WRAP(buff, w), release); /* Publish data to reader */
     return len;
 }
@@ -38,6 +38,14 @@
  *   - Remove debug message
  *   - Remove LWESP_CFG_CONN_MANUAL_TCP_RECEIVE macro which is not supported by Ai-thinker esp8266
  *   - Code cleanup
+ *   - Use statically allocated poll timeout per connection
+ *   - Add send command coalescing statistics
+ *   - Add scatter-gather send function
+ *   - Add packet buffer send function
+ *   - Account allocations to memory statistics tag
+ *   - Add adaptive poll with single timeout for all connections
+ *   - Add passthrough mode functions
+ *   - Release receive budget in lwesp_conn_recved
  */
 #include "lwesp/lwesp_private.h"
 #include "lwesp/lwesp_conn.h"
@@ -61,6 +69,95 @@
         }                                                              \
     } while (0)
 
+#if LWESP_CFG_CONN_POLL_ADAPTIVE || __DOXYGEN__
+
+/**
+ * \brief           Adaptive poll state of connection
+ */
+typedef struct {
+    uint32_t time;                              /*!< Time of last poll event */
+    uint32_t interval;                          /*!< Current interval between poll events */
+    uint8_t activity;                           /*!< Set to `1` when data were received or sent since last tick */
+} conn_poll_t;
+
+static lwesp_timeout_t conn_poll_timeout;       /*!< Poll timeout, common for all connections */
+static uint8_t conn_poll_running;               /*!< Set to `1` when poll timeout is started */
+static conn_poll_t conn_polls[LWESP_CFG_MAX_CONNS]; /*!< Poll state, one for each connection */
+
+/**
+ * \brief           Timeout callback for all connections
+ * \param[in]       arg: Timeout callback custom argument
+ */
+static void
+conn_timeout_cb(void* arg) {
+    uint32_t time = lwesp_sys_now();
+    uint8_t active = 0;
+
+    for (size_t i = 0; i < LWESP_CFG_MAX_CONNS; ++i) {
+        lwesp_conn_p conn = &esp.m.conns[i];
+        conn_poll_t* p = &conn_polls[i];
+
+        if (!conn->status.f.active) {           /* Handle only active connections */
+            continue;
+        }
+        active = 1;
+        if (p->activity) {                      /* Connection is busy, application is notified by data events */
+            p->activity = 0;
+            p->interval = LWESP_CFG_CONN_POLL_INTERVAL;
+            if ((time - p->time) < LWESP_CFG_CONN_POLL_INTERVAL_MAX) {
+                ++esp.conn_poll.skipped;
+                continue;
+            }
+        } else if ((time - p->time) < p->interval) {/* Connection is idle, interval not reached yet */
+            ++esp.conn_poll.skipped;
+            continue;
+        } else {
+            p->interval = LWESP_MIN(2 * p->interval, LWESP_CFG_CONN_POLL_INTERVAL_MAX);
+        }
+        p->time = time;
+        ++esp.conn_poll.polls;
+
+        esp.evt.type = LWESP_EVT_CONN_POLL;     /* Poll connection event */
+        esp.evt.evt.conn_poll.conn = conn;      /* Set connection pointer */
+        lwespi_send_conn_cb(conn, NULL);        /* Send connection callback */
+    }
+    conn_poll_running = active;                 /* Stop ticking when all connections are closed */
+    if (conn_poll_running) {
+        lwesp_timeout_start(&conn_poll_timeout, LWESP_CFG_CONN_POLL_INTERVAL, conn_timeout_cb, NULL);
+    }
+    LWESP_UNUSED(arg);
+}
+
+/**
+ * \brief           Start timeout function for connection
+ * \param[in]       conn: Connection handle as user argument
+ */
+void
+lwespi_conn_start_timeout(lwesp_conn_p conn) {
+    conn_poll_t* p = &conn_polls[conn - esp.m.conns];
+
+    p->time = lwesp_sys_now();
+    p->interval = LWESP_CFG_CONN_POLL_INTERVAL;
+    p->activity = 0;
+    if (!conn_poll_running) {                   /* Keep phase of running tick */
+        conn_poll_running = 1;
+        lwesp_timeout_start(&conn_poll_timeout, LWESP_CFG_CONN_POLL_INTERVAL, conn_timeout_cb, NULL);
+    }
+}
+
+/**
+ * \brief           Mark data activity on connection to skip next poll event
+ * \param[in]       conn: Connection handle
+ */
+void
+lwespi_conn_activity(lwesp_conn_p conn) {
+    conn_polls[conn - esp.m.conns].activity = 1;
+}
+
+#else /* LWESP_CFG_CONN_POLL_ADAPTIVE || __DOXYGEN__ */
+
+static lwesp_timeout_t conn_timeouts[LWESP_CFG_MAX_CONNS];  /*!< Poll timeouts, one for each connection */
+
 /**
  * \brief           Timeout callback for connection
  * \param[in]       arg: Timeout callback custom argument
@@ -84,9 +181,11 @@ conn_timeout_cb(void* arg) {
  */
 void
 lwespi_conn_start_timeout(lwesp_conn_p conn) {
-    lwesp_timeout_add(LWESP_CFG_CONN_POLL_INTERVAL, conn_timeout_cb, conn); /* Add connection timeout */
+    lwesp_timeout_start(&conn_timeouts[conn - esp.m.conns], LWESP_CFG_CONN_POLL_INTERVAL, conn_timeout_cb, conn);   /* Start connection timeout */
 }
 
+#endif /* !(LWESP_CFG_CONN_POLL_ADAPTIVE || __DOXYGEN__) */
+
 /**
  * \brief           Get connection validation ID
  * \param[in]       conn: Connection handle
@@ -348,15 +447,118 @@ lwesp_conn_send(lwesp_conn_p conn, const void* data, size_t btw, size_t* const b
     return res;
 }
 
+/**
+ * \brief           Send data from multiple memory segments on already active connection
+ *
+ * Segments are sent in order as one continuous stream,
+ * directly from user memory without copying them to intermediate buffer.
+ * As many segments as fit are sent with single `AT+CIPSEND` command.
+ *
+ * \note            Array of segments and data they point to must stay valid until data are sent.
+ *                  When call is not blocking, wait for \ref LWESP_EVT_CONN_SEND event
+ * \param[in]       conn: Connection handle to send data
+ * \param[in]       iov: Array of data segments to send
+ * \param[in]       iovcnt: Number of entries in `iov` array
+ * \param[out]      bw: Pointer to output variable to save number of sent data when successfully sent
+ * \param[in]       blocking: Status whether command should be blocking or not
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_conn_sendv(lwesp_conn_p conn, const lwesp_iovec_t* iov, size_t iovcnt, size_t* const bw,
+                 const uint32_t blocking) {
+    LWESP_MSG_VAR_DEFINE(msg);
+    size_t i, btw = 0;
+
+    LWESP_ASSERT("conn != NULL", conn != NULL);
+    LWESP_ASSERT("iov != NULL", iov != NULL);
+    LWESP_ASSERT("iovcnt > 0", iovcnt > 0);
+
+    for (i = 0; i < iovcnt; ++i) {
+        LWESP_ASSERT("iov[i].data != NULL || iov[i].len == 0", iov[i].data != NULL || iov[i].len == 0);
+        btw += iov[i].len;
+    }
+    LWESP_ASSERT("btw > 0", btw > 0);
+
+    if (bw != NULL) {
+        *bw = 0;
+    }
+
+    flush_buff(conn);                           /* Flush currently written memory if exists */
+    CONN_CHECK_CLOSED_IN_CLOSING(conn);         /* Check if we can continue */
+
+    LWESP_MSG_VAR_ALLOC(msg, blocking);
+    LWESP_MSG_VAR_REF(msg).cmd_def = LWESP_CMD_TCPIP_CIPSEND;
+
+    LWESP_MSG_VAR_REF(msg).msg.conn_send.conn = conn;
+    LWESP_MSG_VAR_REF(msg).msg.conn_send.iov = iov;
+    LWESP_MSG_VAR_REF(msg).msg.conn_send.iovcnt = iovcnt;
+    LWESP_MSG_VAR_REF(msg).msg.conn_send.btw = btw;
+    LWESP_MSG_VAR_REF(msg).msg.conn_send.bw = bw;
+    LWESP_MSG_VAR_REF(msg).msg.conn_send.val_id = lwespi_conn_get_val_id(conn);
+
+    return lwespi_send_msg_to_producer_mbox(&LWESP_MSG_VAR_REF(msg), lwespi_initiate_cmd, 60000);
+}
+
+/**
+ * \brief           Send packet buffer chain on already active connection
+ *
+ * Data are sent directly from packet buffers without copying them to linear memory.
+ * Function takes its own reference on the chain and releases it when send command finishes,
+ * so caller may free its packet buffer immediately after function returns.
+ *
+ * \note            Packet buffers received on another connection can be forwarded this way
+ * \param[in]       conn: Connection handle to send data
+ * \param[in]       pbuf: Packet buffer chain to send
+ * \param[out]      bw: Pointer to output variable to save number of sent data when successfully sent
+ * \param[in]       blocking: Status whether command should be blocking or not
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_conn_send_pbuf(lwesp_conn_p conn, lwesp_pbuf_p pbuf, size_t* const bw, const uint32_t blocking) {
+    LWESP_MSG_VAR_DEFINE(msg);
+
+    LWESP_ASSERT("conn != NULL", conn != NULL);
+    LWESP_ASSERT("pbuf != NULL", pbuf != NULL);
+    LWESP_ASSERT("pbuf length > 0", lwesp_pbuf_length(pbuf, 1) > 0);
+
+    if (bw != NULL) {
+        *bw = 0;
+    }
+
+    flush_buff(conn);                           /* Flush currently written memory if exists */
+    CONN_CHECK_CLOSED_IN_CLOSING(conn);         /* Check if we can continue */
+
+    LWESP_MSG_VAR_ALLOC(msg, blocking);
+    LWESP_MSG_VAR_REF(msg).cmd_def = LWESP_CMD_TCPIP_CIPSEND;
+
+    lwesp_core_lock();
+    lwesp_pbuf_ref(pbuf);                       /* Keep chain until message is released */
+    lwesp_core_unlock();
+
+    LWESP_MSG_VAR_REF(msg).msg.conn_send.conn = conn;
+    LWESP_MSG_VAR_REF(msg).msg.conn_send.pbuf = pbuf;
+    LWESP_MSG_VAR_REF(msg).msg.conn_send.btw = lwesp_pbuf_length(pbuf, 1);
+    LWESP_MSG_VAR_REF(msg).msg.conn_send.bw = bw;
+    LWESP_MSG_VAR_REF(msg).msg.conn_send.val_id = lwespi_conn_get_val_id(conn);
+
+    return lwespi_send_msg_to_producer_mbox(&LWESP_MSG_VAR_REF(msg), lwespi_initiate_cmd, 60000);
+}
+
 /**
  * \brief           Notify connection about received data which means connection is ready to accept more data
  *
  * Once data reception is confirmed, stack will try to send more data to user.
  *
- * \note            Since this feature is not supported yet by AT commands, function is only prototype
- *                  and should be used in connection callback when data are received
+ * When \ref LWESP_CFG_INPUT_FLOW_CONTROL is enabled, confirmed data no longer count
+ * to receive budget of connection and paused processing continues.
+ * Otherwise function has no effect
  *
- * \note            Function is not thread safe and may only be called from connection event function
+ * \note            When \ref LWESP_CFG_CONN_RECV_BUDGET is set to non-zero value,
+ *                  function must be called for every packet buffer received in \ref LWESP_EVT_CONN_RECV event,
+ *                  otherwise receive processing stalls once budget is used
+ *
+ * \note            Function should be called once application has processed data,
+ *                  from connection event function or from any other thread
  *
  * \param[in]       conn: Connection handle
  * \param[in]       pbuf: Packet buffer received on connection
@@ -364,8 +566,23 @@ lwesp_conn_send(lwesp_conn_p conn, const void* data, size_t btw, size_t* const b
  */
 lwespr_t
 lwesp_conn_recved(lwesp_conn_p conn, lwesp_pbuf_p pbuf) {
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+    size_t len;
+
+    LWESP_ASSERT("conn != NULL", conn != NULL);
+    LWESP_ASSERT("pbuf != NULL", pbuf != NULL);
+
+    len = lwesp_pbuf_length(pbuf, 1);
+    lwesp_core_lock();
+    conn->recv_held -= LWESP_MIN(conn->recv_held, len);
+    if (esp.m.ipd.stalled) {
+        lwesp_sys_mbox_putnow(&esp.mbox_process, NULL); /* Wake up processing thread to continue */
+    }
+    lwesp_core_unlock();
+#else /* LWESP_CFG_INPUT_FLOW_CONTROL */
     LWESP_UNUSED(conn);
     LWESP_UNUSED(pbuf);
+#endif /* !LWESP_CFG_INPUT_FLOW_CONTROL */
     return lwespOK;
 }
 
@@ -591,7 +808,7 @@ lwesp_conn_write(lwesp_conn_p conn, const void* data, size_t btw, uint8_t flush,
     /* Step 2 */
     while (btw >= LWESP_CFG_CONN_MAX_DATA_LEN) {
         uint8_t* buff;
-        buff = lwesp_mem_malloc(sizeof(*buff) * LWESP_CFG_CONN_MAX_DATA_LEN);
+        buff = LWESP_MEM_MALLOC_TAG(sizeof(*buff) * LWESP_CFG_CONN_MAX_DATA_LEN, LWESP_MEM_TAG_CONN);
         if (buff != NULL) {
             LWESP_MEMCPY(buff, d, LWESP_CFG_CONN_MAX_DATA_LEN); /* Copy data to buffer */
             if (conn_send(conn, NULL, 0, buff, LWESP_CFG_CONN_MAX_DATA_LEN, NULL, 1, 0) != lwespOK) {
@@ -608,7 +825,7 @@ lwesp_conn_write(lwesp_conn_p conn, const void* data, size_t btw, uint8_t flush,
 
     /* Step 3 */
     if (conn->buff.buff == NULL) {
-        conn->buff.buff = lwesp_mem_malloc(sizeof(*conn->buff.buff) * LWESP_CFG_CONN_MAX_DATA_LEN);
+        conn->buff.buff = LWESP_MEM_MALLOC_TAG(sizeof(*conn->buff.buff) * LWESP_CFG_CONN_MAX_DATA_LEN, LWESP_MEM_TAG_CONN);
         conn->buff.len = LWESP_CFG_CONN_MAX_DATA_LEN;
         conn->buff.ptr = 0;
     }
@@ -734,3 +951,121 @@ lwesp_conn_ssl_set_config(uint8_t link_id, uint8_t auth_mode, uint8_t pki_number
 
     return lwespi_send_msg_to_producer_mbox(&LWESP_MSG_VAR_REF(msg), lwespi_initiate_cmd, 1000);
 }
+
+#if LWESP_CFG_CONN_SEND_COALESCE || __DOXYGEN__
+
+/**
+ * \brief           Get statistics of send command coalescing
+ * \param[out]      stats: Pointer to output structure to fill with statistics
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_conn_get_send_coalesce_stats(lwesp_conn_send_coalesce_stats_t* stats) {
+    LWESP_ASSERT("stats != NULL", stats != NULL);
+
+    lwesp_core_lock();
+    *stats = esp.send_coalesce;
+    lwesp_core_unlock();
+    return lwespOK;
+}
+
+#endif /* LWESP_CFG_CONN_SEND_COALESCE || __DOXYGEN__ */
+
+#if LWESP_CFG_CONN_POLL_ADAPTIVE || __DOXYGEN__
+
+/**
+ * \brief           Get statistics of adaptive connection poll
+ * \param[out]      stats: Pointer to output structure to fill with statistics
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_conn_get_poll_stats(lwesp_conn_poll_stats_t* stats) {
+    LWESP_ASSERT("stats != NULL", stats != NULL);
+
+    lwesp_core_lock();
+    *stats = esp.conn_poll;
+    lwesp_core_unlock();
+    return lwespOK;
+}
+
+#endif /* LWESP_CFG_CONN_POLL_ADAPTIVE || __DOXYGEN__ */
+
+#if LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__
+
+/**
+ * \brief           Start a new connection in transparent (passthrough) mode
+ *
+ * Device is switched to single connection mode and connection is started with `AT+CIPSTART`.
+ * After `AT+CIPMODE=1` and open-ended `AT+CIPSEND`, data of \ref lwesp_conn_send
+ * are written to device as they are and received data are reported with \ref LWESP_EVT_CONN_RECV event.
+ *
+ * \note            Function fails when any other connection is active.
+ *                  All other commands fail until \ref lwesp_conn_passthrough_stop is called
+ * \param[out]      conn: Pointer to connection handle to set new connection reference in case of successfully connected
+ * \param[in]       type: Connection type. This parameter can be a value of \ref lwesp_conn_type_t enumeration
+ * \param[in]       remote_host: Connection host. In case of IP, write it as string, ex. "192.168.1.1"
+ * \param[in]       remote_port: Connection port
+ * \param[in]       arg: Pointer to user argument passed to connection if successfully connected
+ * \param[in]       conn_evt_fn: Callback function for this connection
+ * \param[in]       blocking: Status whether command should be blocking or not
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_conn_passthrough_start(lwesp_conn_p* conn, lwesp_conn_type_t type, const char* const remote_host, lwesp_port_t remote_port,
+                             void* const arg, lwesp_evt_fn conn_evt_fn, const uint32_t blocking) {
+    LWESP_MSG_VAR_DEFINE(msg);
+
+    LWESP_ASSERT("remote_host != NULL", remote_host != NULL);
+    LWESP_ASSERT("remote_port > 0", remote_port > 0);
+    LWESP_ASSERT("conn_evt_fn != NULL", conn_evt_fn != NULL);
+
+    LWESP_MSG_VAR_ALLOC(msg, blocking);
+    LWESP_MSG_VAR_REF(msg).cmd_def = LWESP_CMD_TCPIP_CIPSEND_PASSTHROUGH;
+    LWESP_MSG_VAR_REF(msg).cmd = LWESP_CMD_TCPIP_CIPMUX;
+    LWESP_MSG_VAR_REF(msg).msg.conn_start.num = LWESP_CFG_MAX_CONNS;/* Set maximal value as invalid number */
+    LWESP_MSG_VAR_REF(msg).msg.conn_start.conn = conn;
+    LWESP_MSG_VAR_REF(msg).msg.conn_start.type = type;
+    LWESP_MSG_VAR_REF(msg).msg.conn_start.remote_host = remote_host;
+    LWESP_MSG_VAR_REF(msg).msg.conn_start.remote_port = remote_port;
+    LWESP_MSG_VAR_REF(msg).msg.conn_start.evt_func = conn_evt_fn;
+    LWESP_MSG_VAR_REF(msg).msg.conn_start.arg = arg;
+
+    return lwespi_send_msg_to_producer_mbox(&LWESP_MSG_VAR_REF(msg), lwespi_initiate_cmd, 60000);
+}
+
+/**
+ * \brief           Exit transparent (passthrough) mode and close its connection
+ *
+ * `+++` sequence is sent after \ref LWESP_CFG_CONN_PASSTHROUGH_GUARD_TIME without data.
+ * Connection is closed and device is switched back to multiple connections mode
+ *
+ * \param[in]       blocking: Status whether command should be blocking or not
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_conn_passthrough_stop(const uint32_t blocking) {
+    LWESP_MSG_VAR_DEFINE(msg);
+
+    LWESP_MSG_VAR_ALLOC(msg, blocking);
+    LWESP_MSG_VAR_REF(msg).cmd_def = LWESP_CMD_TCPIP_PASSTHROUGH_EXIT;
+
+    return lwespi_send_msg_to_producer_mbox(&LWESP_MSG_VAR_REF(msg), lwespi_initiate_cmd,
+                                            2 * LWESP_CFG_CONN_PASSTHROUGH_GUARD_TIME + 10000);
+}
+
+/**
+ * \brief           Check if connection is used by transparent (passthrough) mode
+ * \param[in]       conn: Connection handle
+ * \return          `1` if connection is in passthrough mode, `0` otherwise
+ */
+uint8_t
+lwesp_conn_is_passthrough(lwesp_conn_p conn) {
+    uint8_t res;
+
+    lwesp_core_lock();
+    res = conn != NULL && esp.m.passthrough.active && esp.m.passthrough.conn == conn;
+    lwesp_core_unlock();
+    return res;
+}
+
+#endif /* LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__ */
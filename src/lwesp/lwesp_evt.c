@@ -31,6 +31,12 @@
  * Author:          Tilen MAJERLE <tilen@majerle.eu>
  * Version:         v1.0.0
  */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ *   - Add AT port baudrate event
+ */
 #include "lwesp/lwesp_private.h"
 #include "lwesp/lwesp_evt.h"
 #include "lwesp/lwesp_mem.h"
@@ -142,6 +148,31 @@ lwesp_evt_restore_get_result(lwesp_evt_t* cc) {
     return cc->evt.restore.res;
 }
 
+#if LWESP_CFG_AT_PORT_BAUDRATE_AUTO || __DOXYGEN__
+
+/**
+ * \brief           Get AT port baudrate after reset sequence
+ * \param[in]       cc: Event data
+ * \return          Baudrate in units of bits per second
+ */
+uint32_t
+lwesp_evt_at_baudrate_get_baudrate(lwesp_evt_t* cc) {
+    return cc->evt.at_baudrate.baudrate;
+}
+
+/**
+ * \brief           Get AT port baudrate negotiation status
+ * \param[in]       cc: Event data
+ * \return          \ref lwespOK when baudrate from list is used,
+ *                      \ref lwespERR when stack went back to default baudrate
+ */
+lwespr_t
+lwesp_evt_at_baudrate_get_result(lwesp_evt_t* cc) {
+    return cc->evt.at_baudrate.res;
+}
+
+#endif /* LWESP_CFG_AT_PORT_BAUDRATE_AUTO || __DOXYGEN__ */
+
 #if LWESP_CFG_MODE_ACCESS_POINT || __DOXYGEN__
 
 /**
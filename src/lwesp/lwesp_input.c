@@ -31,6 +31,15 @@
  * Author:          Tilen MAJERLE <tilen@majerle.eu>
  * Version:         v1.0.0
  */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ *   - Add direct write to input buffer
+ *   - Wake up processing thread only when it waits for data
+ *   - Trace received data
+ *   - Ask device to stop sending when input buffer fills up
+ */
 #include "lwesp/lwesp_private.h"
 #include "lwesp/lwesp.h"
 #include "lwesp/lwesp_input.h"
@@ -41,6 +50,43 @@ static uint32_t lwesp_recv_calls;
 
 #if !LWESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__
 
+/**
+ * \brief           Wake up processing thread after new data are written to input buffer
+ *
+ * In lock-free mode, message is sent only when processing thread
+ * has already started to process previous wake-up,
+ * to not flood the message queue on every received chunk
+ */
+static void
+input_wake_process(void) {
+#if LWESP_CFG_INPUT_BUFF_SPSC
+    /*
+     * Pairs with fence in lwespi_process_buffer:
+     * either processing thread sees new write pointer
+     * or this thread sees cleared flag and sends message
+     */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_flag_test_and_set_explicit(&esp.buff_wake, memory_order_relaxed)) {
+        return;
+    }
+#endif /* LWESP_CFG_INPUT_BUFF_SPSC */
+    lwesp_sys_mbox_putnow(&esp.mbox_process, NULL); /* Write empty box, don't care if write fails */
+}
+
+#if LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__
+
+/**
+ * \brief           Ask device to stop sending when input buffer is filled above high-water mark
+ */
+static void
+input_flow_check(void) {
+    if (!esp.flow_rts && lwesp_buff_get_full(&esp.buff) >= LWESP_CFG_INPUT_FLOW_HIGH_WATER) {
+        lwespi_flow_rts(1);
+    }
+}
+
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__ */
+
 /**
  * \brief           Write data to input buffer
  * \note            \ref LWESP_CFG_INPUT_USE_PROCESS must be disabled to use this function
@@ -53,8 +99,59 @@ lwesp_input(const void* data, size_t len) {
     if (!esp.status.f.initialized || esp.buff.buff == NULL) {
         return lwespERR;
     }
+#if LWESP_CFG_TRACE
+    lwespi_trace(LWESP_TRACE_TYPE_RX, LWESP_CMD_IDLE, (uint32_t)len, data, len);
+#endif /* LWESP_CFG_TRACE */
     lwesp_buff_write(&esp.buff, data, len);     /* Write data to buffer */
-    lwesp_sys_mbox_putnow(&esp.mbox_process, NULL); /* Write empty box, don't care if write fails */
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+    input_flow_check();
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL */
+    input_wake_process();
+    lwesp_recv_total_len += len;                /* Update total number of received bytes */
+    ++lwesp_recv_calls;                         /* Update number of calls */
+    return lwespOK;
+}
+
+/**
+ * \brief           Get linear memory of input buffer where received data can be written directly
+ *
+ * Low-level driver may read data from device straight to this memory
+ * and confirm it with \ref lwesp_input_write_advance, to skip intermediate copy
+ *
+ * \note            \ref LWESP_CFG_INPUT_USE_PROCESS must be disabled to use this function
+ * \param[out]      len: Pointer to output variable to save length of memory in units of bytes
+ * \return          Pointer to memory to write to or `NULL` if input buffer is full or not ready
+ */
+void*
+lwesp_input_get_write_block(size_t* len) {
+    *len = 0;
+    if (!esp.status.f.initialized || esp.buff.buff == NULL) {
+        return NULL;
+    }
+    *len = lwesp_buff_get_linear_block_write_length(&esp.buff);
+    return *len > 0 ? lwesp_buff_get_linear_block_write_address(&esp.buff) : NULL;
+}
+
+/**
+ * \brief           Confirm data written to memory from \ref lwesp_input_get_write_block
+ * \note            \ref LWESP_CFG_INPUT_USE_PROCESS must be disabled to use this function
+ * \param[in]       len: Number of bytes written in units of bytes
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_input_write_advance(size_t len) {
+    if (!esp.status.f.initialized || esp.buff.buff == NULL) {
+        return lwespERR;
+    }
+#if LWESP_CFG_TRACE
+    lwespi_trace(LWESP_TRACE_TYPE_RX, LWESP_CMD_IDLE, (uint32_t)len,
+                 lwesp_buff_get_linear_block_write_address(&esp.buff), len);
+#endif /* LWESP_CFG_TRACE */
+    lwesp_buff_advance(&esp.buff, len);         /* Data are already in buffer */
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+    input_flow_check();
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL */
+    input_wake_process();
     lwesp_recv_total_len += len;                /* Update total number of received bytes */
     ++lwesp_recv_calls;                         /* Update number of calls */
     return lwespOK;
@@ -85,13 +182,35 @@ lwesp_input_process(const void* data, size_t len) {
 
     lwesp_recv_total_len += len;                /* Update total number of received bytes */
     ++lwesp_recv_calls;                         /* Update number of calls */
+#if LWESP_CFG_TRACE
+    lwespi_trace(LWESP_TRACE_TYPE_RX, LWESP_CMD_IDLE, (uint32_t)len, data, len);
+#endif /* LWESP_CFG_TRACE */
 
     if (len > 0) {
         lwesp_core_lock();
-        res = lwespi_process(data, len);        /* Process input data */
+        res = lwespi_process(data, len, NULL);  /* Process input data */
         lwesp_core_unlock();
     }
     return res;
 }
 
 #endif /* LWESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__ */
+
+#if LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__
+
+/**
+ * \brief           Get receive flow control statistics
+ * \param[out]      stats: Pointer to output structure to fill with statistics
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_input_get_flow_stats(lwesp_input_flow_stats_t* stats) {
+    LWESP_ASSERT("stats != NULL", stats != NULL);
+
+    lwesp_core_lock();
+    *stats = esp.flow_stats;
+    lwesp_core_unlock();
+    return lwespOK;
+}
+
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__ */
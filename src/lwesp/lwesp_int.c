@@ -52,12 +52,26 @@
  *   - Remove LWESP_CFG_SNTP macro which is not supported by Ai-thinker esp8266
  *   - Restructure lwespi_send_string function
  *   - Add AT_PORT_SEND_COMMAND macro
+ *   - Add zero-copy receive of +IPD data
+ *   - Add word-at-a-time scan of plain characters in command mode
+ *   - Add pipelining of reset and restore sequence
+ *   - Re-arm wake-up of lock-free input buffer
+ *   - Record time when message is put to producer queue
+ *   - Add command names for statistics and trace
+ *   - Trace data sent to AT port
+ *   - Add AT port baudrate negotiation in reset sequence
+ *   - Add warm start to reset sequence
+ *   - Add connection activity for adaptive poll
+ *   - Add passthrough mode
+ *   - Pause processing instead of dropping received data
+ *   - Add send pipeline and send gap statistics
  */
 #include "lwesp/lwesp_private.h"
 #include "lwesp/lwesp.h"
 #include "lwesp/lwesp_int.h"
 #include "lwesp/lwesp_mem.h"
 #include "lwesp/lwesp_parser.h"
+#include "lwesp/lwesp_timeout.h"
 #include "lwesp/lwesp_unicode.h"
 #include "system/lwesp_ll.h"
 
@@ -70,18 +84,43 @@ typedef struct {
     size_t len;                                 /*!< Length of valid characters */
 } lwesp_recv_t;
 
+/* Check if +IPD data is referenced in input buffer instead of copied */
+#if LWESP_CFG_IPD_ZERO_COPY
+#define IPD_IS_ZERO_COPY()                  (esp.m.ipd.zc)
+#else /* LWESP_CFG_IPD_ZERO_COPY */
+#define IPD_IS_ZERO_COPY()                  0
+#endif /* !LWESP_CFG_IPD_ZERO_COPY */
+
 /* Receive character macros */
 #define RECV_ADD(ch)                        do { if (recv_buff.len < (sizeof(recv_buff.data)) - 1) { recv_buff.data[recv_buff.len++] = ch; recv_buff.data[recv_buff.len] = 0; } } while (0)
 #define RECV_RESET()                        do { recv_buff.len = 0; recv_buff.data[0] = 0; } while (0)
 #define RECV_LEN()                          ((size_t)recv_buff.len)
 #define RECV_IDX(index)                     recv_buff.data[index]
+#define RECV_ADD_BLOCK(b, l)                do { size_t l_ = LWESP_MIN((l), sizeof(recv_buff.data) - 1 - recv_buff.len); LWESP_MEMCPY(&recv_buff.data[recv_buff.len], (b), l_); recv_buff.len += l_; recv_buff.data[recv_buff.len] = 0; } while (0)
+
+/* Check if character is valid ASCII without special meaning for command mode processing */
+#define RECV_IS_PLAIN(ch)                   (((ch) >= 32 && (ch) <= 126 && (ch) != ':' && (ch) != '>') || (ch) == '\r')
+
+/* Word-at-a-time helpers, checking all bytes of `size_t` word at the same time */
+#define SCAN_ONES                           ((size_t)~(size_t)0 / 0xFF)
+#define SCAN_HIGHS                          (SCAN_ONES * 0x80)
+#define SCAN_HAS_LESS(w, n)                 (((w) - SCAN_ONES * (n)) & ~(w) & SCAN_HIGHS)
+#define SCAN_HAS_BYTE(w, b)                 SCAN_HAS_LESS((w) ^ (SCAN_ONES * (b)), 1)
+#define SCAN_HAS_SPECIAL(w)                 (((w) & SCAN_HIGHS) || SCAN_HAS_LESS((w), 0x20)       \
+                                                || SCAN_HAS_BYTE((w), ':') || SCAN_HAS_BYTE((w), '>') \
+                                                || SCAN_HAS_BYTE((w), 0x7F))
 
 /* Send data over AT port */
-#define AT_PORT_SEND_STR(str)               esp.ll.send_fn((const void *)(str), (size_t)strlen(str))
-#define AT_PORT_SEND_CONST_STR(str)         esp.ll.send_fn((const void *)(str), (size_t)(sizeof(str) - 1))
-#define AT_PORT_SEND_CHR(str)               esp.ll.send_fn((const void *)(str), (size_t)1)
-#define AT_PORT_SEND_FLUSH()                esp.ll.send_fn(NULL, 0)
-#define AT_PORT_SEND(d, l)                  esp.ll.send_fn((const void *)(d), (size_t)(l))
+#if LWESP_CFG_TRACE
+#define AT_PORT_LL_SEND(d, l)               lwespi_trace_ll_send((d), (l))
+#else /* LWESP_CFG_TRACE */
+#define AT_PORT_LL_SEND(d, l)               esp.ll.send_fn((d), (l))
+#endif /* !LWESP_CFG_TRACE */
+#define AT_PORT_SEND_STR(str)               AT_PORT_LL_SEND((const void *)(str), (size_t)strlen(str))
+#define AT_PORT_SEND_CONST_STR(str)         AT_PORT_LL_SEND((const void *)(str), (size_t)(sizeof(str) - 1))
+#define AT_PORT_SEND_CHR(str)               AT_PORT_LL_SEND((const void *)(str), (size_t)1)
+#define AT_PORT_SEND_FLUSH()                AT_PORT_LL_SEND(NULL, 0)
+#define AT_PORT_SEND(d, l)                  AT_PORT_LL_SEND((const void *)(d), (size_t)(l))
 #define AT_PORT_SEND_WITH_FLUSH(d, l)       do { AT_PORT_SEND((d), (l)); AT_PORT_SEND_FLUSH(); } while (0)
 
 /* Beginning and end of every AT command */
@@ -100,6 +139,16 @@ typedef struct {
 static lwesp_recv_t recv_buff;
 static lwespr_t lwespi_process_sub_cmd(lwesp_msg_t* msg, uint8_t* is_ok, uint8_t* is_error, uint8_t* is_ready);
 
+#if LWESP_CFG_AT_PORT_BAUDRATE_AUTO || __DOXYGEN__
+static const uint32_t at_baudrates[] = { LWESP_CFG_AT_PORT_BAUDRATE_LIST }; /*!< Baudrates to negotiate, from highest to lowest */
+#endif /* LWESP_CFG_AT_PORT_BAUDRATE_AUTO || __DOXYGEN__ */
+#if LWESP_CFG_AT_PORT_BAUDRATE_AUTO || LWESP_CFG_RESET_WARM || __DOXYGEN__
+static lwesp_timeout_t reset_timeout;           /*!< Timeout of command in reset sequence that may get no response */
+#endif /* LWESP_CFG_AT_PORT_BAUDRATE_AUTO || LWESP_CFG_RESET_WARM || __DOXYGEN__ */
+#if LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__
+static lwesp_timeout_t passthrough_timeout;     /*!< Guard time of passthrough exit sequence */
+#endif /* LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__ */
+
 /**
  * \brief           Free connection send data memory
  * \param[in]       m: Send data message type
@@ -114,11 +163,11 @@ static lwespr_t lwespi_process_sub_cmd(lwesp_msg_t* msg, uint8_t* is_ok, uint8_t
     } while (0)
 
 /**
- * \brief           Send connection callback for "data send"
+ * \brief           Send connection callback for "data send" of single message
  * \param[in]       m: Connection send message
  * \param[in]       err: Error of type \ref lwespr_t
  */
-#define CONN_SEND_DATA_SEND_EVT(m, err)  do {                          \
+#define CONN_SEND_DATA_SEND_EVT_ONE(m, err)  do {                      \
         CONN_SEND_DATA_FREE(m);                                        \
         esp.evt.type = LWESP_EVT_CONN_SEND;                            \
         esp.evt.evt.conn_data_send.res = err;                          \
@@ -127,6 +176,23 @@ static lwespr_t lwespi_process_sub_cmd(lwesp_msg_t* msg, uint8_t* is_ok, uint8_t
         lwespi_send_conn_cb((m)->msg.conn_send.conn, NULL);            \
     } while (0)
 
+#if LWESP_CFG_CONN_SEND_COALESCE || __DOXYGEN__
+/**
+ * \brief           Send connection callback for "data send"
+ *                  for message and all messages merged into the same command
+ * \param[in]       m: Connection send message
+ * \param[in]       err: Error of type \ref lwespr_t
+ */
+#define CONN_SEND_DATA_SEND_EVT(m, err)  do {                          \
+        lwesp_msg_t* sm;                                               \
+        for (sm = (m); sm != NULL; sm = sm->msg.conn_send.next) {      \
+            CONN_SEND_DATA_SEND_EVT_ONE(sm, err);                      \
+        }                                                              \
+    } while (0)
+#else
+#define CONN_SEND_DATA_SEND_EVT(m, err)  CONN_SEND_DATA_SEND_EVT_ONE(m, err)
+#endif /* LWESP_CFG_CONN_SEND_COALESCE || __DOXYGEN__ */
+
 /**
  * \brief           Send reset sequence event
  * \param[in]       m: Command message
@@ -472,6 +538,55 @@ lwespi_send_conn_cb(lwesp_conn_t* conn, lwesp_evt_fn evt) {
     return lwesp_conn_close(conn, 0);
 }
 
+/**
+ * \brief           Get number of bytes sent with next `AT+CIPSEND` command of send message
+ * \param[in]       m: Connection send message
+ * \param[in]       btw: Number of remaining bytes of message
+ * \return          Number of bytes, including merged messages
+ */
+static size_t
+lwespi_tcpip_send_cmd_len(const lwesp_msg_t* m, size_t btw) {
+    size_t len = LWESP_MIN(btw, LWESP_CFG_CONN_MAX_DATA_LEN);
+#if LWESP_CFG_CONN_SEND_COALESCE
+    /* Merged messages are sent completely after data of this message */
+    for (m = m->msg.conn_send.next; m != NULL; m = m->msg.conn_send.next) {
+        len += m->msg.conn_send.btw;
+    }
+#else /* LWESP_CFG_CONN_SEND_COALESCE */
+    LWESP_UNUSED(m);
+#endif /* !LWESP_CFG_CONN_SEND_COALESCE */
+    return len;
+}
+
+/**
+ * \brief           Build `AT+CIPSEND` command of send message
+ * \param[in]       m: Connection send message
+ * \param[in]       len: Number of bytes sent with command
+ * \param[out]      cmd: Output buffer for command
+ * \param[in]       size: Size of output buffer, must be at least `64` bytes
+ * \return          Length of command including line ending
+ */
+static size_t
+lwespi_tcpip_build_send_cmd(const lwesp_msg_t* m, size_t len, char* cmd, size_t size) {
+    lwesp_conn_t* c = m->msg.conn_send.conn;
+    const lwesp_ip_t* ip = m->msg.conn_send.remote_ip;
+    char num[2][11], buf[4][4], port[6];
+    int res;
+
+    /* On UDP connections, IP address and port may be included */
+    if (c->type == LWESP_CONN_TYPE_UDP && ip != NULL && m->msg.conn_send.remote_port) {
+        res = snprintf(cmd, size, "AT+CIPSEND=%s,%s,\"" IP_FORMAT "\",%s" CRLF,
+                       lwesp_u32_to_str(c->num, num[0]), lwesp_u32_to_str(len, num[1]),
+                       lwesp_u8_to_str(ip->ip[0], buf[0]), lwesp_u8_to_str(ip->ip[1], buf[1]),
+                       lwesp_u8_to_str(ip->ip[2], buf[2]), lwesp_u8_to_str(ip->ip[3], buf[3]),
+                       lwesp_u16_to_str(m->msg.conn_send.remote_port, port));
+    } else {
+        res = snprintf(cmd, size, "AT+CIPSEND=%s,%s" CRLF,
+                       lwesp_u32_to_str(c->num, num[0]), lwesp_u32_to_str(len, num[1]));
+    }
+    return res > 0 ? (size_t)res : 0;           /* Condition should always be true */
+}
+
 /**
  * \brief           Process and send data from device buffer
  * \return          Member of \ref lwespr_t enumeration
@@ -479,6 +594,9 @@ lwespi_send_conn_cb(lwesp_conn_t* conn, lwesp_evt_fn evt) {
 static lwespr_t
 lwespi_tcpip_process_send_data(void) {
     lwesp_conn_t* c = esp.msg->msg.conn_send.conn;
+    char cmd[64];
+    size_t len;
+
     if (!lwesp_conn_is_active(c) ||             /* Is the connection already closed? */
         esp.msg->msg.conn_send.val_id != c->val_id  /* Did validation ID change after we set parameter? */
        ) {
@@ -487,21 +605,151 @@ lwespi_tcpip_process_send_data(void) {
         return lwespERR;
     }
     esp.msg->msg.conn_send.sent = LWESP_MIN(esp.msg->msg.conn_send.btw, LWESP_CFG_CONN_MAX_DATA_LEN);
+    len = lwespi_tcpip_send_cmd_len(esp.msg, esp.msg->msg.conn_send.btw);
+#if LWESP_CFG_STATS
+    lwespi_stats_send_gap(esp.msg);
+#endif /* LWESP_CFG_STATS */
+
+#if LWESP_CFG_CONN_SEND_PIPELINE
+    /* Command may be built already, while previous chunk was being sent */
+    if (esp.send_stage.msg == esp.msg && esp.send_stage.ptr == esp.msg->msg.conn_send.ptr
+        && esp.send_stage.len == len) {
+        esp.send_stage.msg = NULL;
+        AT_PORT_SEND_WITH_FLUSH(esp.send_stage.cmd, esp.send_stage.cmd_len);
+        return lwespOK;
+    }
+#endif /* LWESP_CFG_CONN_SEND_PIPELINE */
+    AT_PORT_SEND_WITH_FLUSH(cmd, lwespi_tcpip_build_send_cmd(esp.msg, len, cmd, sizeof(cmd)));
+    return lwespOK;
+}
 
-    AT_PORT_SEND_BEGIN_AT();
-    AT_PORT_SEND_CONST_STR("+CIPSEND=");
-    lwespi_send_number(LWESP_U32(c->num), 0, 0);/* Send connection number */
-    lwespi_send_number(LWESP_U32(esp.msg->msg.conn_send.sent), 0, 1);   /* Send length number */
+#if LWESP_CFG_CONN_SEND_PIPELINE || __DOXYGEN__
 
-    /* On UDP connections, IP address and port may be included */
-    if (c->type == LWESP_CONN_TYPE_UDP) {
-        if (esp.msg->msg.conn_send.remote_ip != NULL && esp.msg->msg.conn_send.remote_port) {
-            lwespi_send_ip(esp.msg->msg.conn_send.remote_ip, 1, 1);     /* Send IP address including quotes */
-            lwespi_send_port(esp.msg->msg.conn_send.remote_port, 0, 1); /* Send length number */
+/**
+ * \brief           Build `AT+CIPSEND` command of next data chunk, while device is sending current one
+ *
+ * Next chunk is either remaining data of current send message
+ * or first chunk of next send message, already taken from queue by producer thread
+ */
+static void
+lwespi_tcpip_stage_send_cmd(void) {
+    const lwesp_msg_t* m = esp.msg;
+    size_t ptr, btw;
+
+    ptr = m->msg.conn_send.ptr + m->msg.conn_send.sent;
+    btw = m->msg.conn_send.btw - m->msg.conn_send.sent;
+    if (btw == 0) {                             /* Current message is finished with this chunk */
+        if ((m = m->msg.conn_send.stage_next) == NULL) {
+            esp.send_stage.msg = NULL;
+            return;
+        }
+        ptr = m->msg.conn_send.ptr;
+        btw = m->msg.conn_send.btw;
+    }
+    esp.send_stage.msg = m;
+    esp.send_stage.ptr = ptr;
+    esp.send_stage.len = lwespi_tcpip_send_cmd_len(m, btw);
+    esp.send_stage.cmd_len = lwespi_tcpip_build_send_cmd(m, esp.send_stage.len, esp.send_stage.cmd, sizeof(esp.send_stage.cmd));
+}
+
+/**
+ * \brief           Start next send message when current one finishes
+ *
+ * Message was taken from queue by producer thread while current one was being sent.
+ * It is started in the same step as `SEND OK` is received,
+ * producer thread only finishes current message after it wakes up.
+ *
+ * \param[in]       msg: Finished send message
+ * \param[in]       res: Result of finished message
+ * \return          Started message or `NULL` when there is nothing to start.
+ *                  Producer thread starts next message when it is not started here
+ */
+static lwesp_msg_t*
+lwespi_tcpip_send_start_next(lwesp_msg_t* msg, lwespr_t res) {
+    lwesp_msg_t* next = msg->msg.conn_send.stage_next;
+    lwesp_conn_t* c;
+
+    /* Producer thread reports closed connection when it starts message */
+    if (res != lwespOK || next == NULL || !esp.status.f.dev_present
+        || !lwesp_conn_is_active(c = next->msg.conn_send.conn)
+        || next->msg.conn_send.val_id != c->val_id) {
+        esp.send_stage.msg = NULL;
+        return NULL;
+    }
+    esp.msg = next;
+#if LWESP_CFG_STATS
+    next->stats_time = lwesp_sys_now();         /* Execution starts now */
+    ++esp.stats_send_gap.started;
+#endif /* LWESP_CFG_STATS */
+#if LWESP_CFG_TRACE
+    lwespi_trace(LWESP_TRACE_TYPE_CMD_START, LWESP_U8(next->cmd_def), (uint32_t)(uintptr_t)next, NULL, 0);
+#endif /* LWESP_CFG_TRACE */
+    lwespi_tcpip_process_send_data();           /* Connection is active, it cannot fail */
+    esp.send_stage.msg = NULL;
+    msg->msg.conn_send.stage_started = 1;
+    return next;
+}
+
+#endif /* LWESP_CFG_CONN_SEND_PIPELINE || __DOXYGEN__ */
+
+/**
+ * \brief           Write part of message data to AT port
+ * \param[in]       m: Connection send message
+ * \param[in]       ptr: Offset of first byte to write
+ * \param[in]       len: Number of bytes to write
+ */
+static void
+lwespi_tcpip_send_msg_data(const lwesp_msg_t* m, size_t ptr, size_t len) {
+    const lwesp_iovec_t* iov = m->msg.conn_send.iov;
+    lwesp_pbuf_p p;
+    size_t i, l;
+
+    if (m->msg.conn_send.pbuf != NULL) {        /* Packet buffer chain */
+        for (p = lwesp_pbuf_skip(m->msg.conn_send.pbuf, ptr, &ptr); p != NULL && len > 0; p = p->next) {
+            l = LWESP_MIN(p->len - ptr, len);
+            AT_PORT_SEND(&p->payload[ptr], l);
+            len -= l;
+            ptr = 0;
         }
+        return;
     }
-    AT_PORT_SEND_END_AT();
-    return lwespOK;
+    if (iov == NULL) {                          /* Single linear memory */
+        AT_PORT_SEND(&m->msg.conn_send.data[ptr], len);
+        return;
+    }
+
+    /* Find segment with first byte and stream segments directly from user memory */
+    for (i = 0; i < m->msg.conn_send.iovcnt && len > 0; ++i) {
+        if (ptr >= iov[i].len) {
+            ptr -= iov[i].len;
+            continue;
+        }
+        l = LWESP_MIN(iov[i].len - ptr, len);
+        AT_PORT_SEND((const uint8_t*)iov[i].data + ptr, l);
+        len -= l;
+        ptr = 0;
+    }
+}
+
+/**
+ * \brief           Write data of current send command to AT port after `>` was received
+ */
+static void
+lwespi_tcpip_send_data(void) {
+#if LWESP_CFG_CONN_SEND_COALESCE
+    lwesp_msg_t* m;
+#endif /* LWESP_CFG_CONN_SEND_COALESCE */
+
+    lwespi_tcpip_send_msg_data(esp.msg, esp.msg->msg.conn_send.ptr, esp.msg->msg.conn_send.sent);
+#if LWESP_CFG_CONN_SEND_COALESCE
+    for (m = esp.msg->msg.conn_send.next; m != NULL; m = m->msg.conn_send.next) {
+        lwespi_tcpip_send_msg_data(m, m->msg.conn_send.ptr, m->msg.conn_send.btw);
+    }
+#endif /* LWESP_CFG_CONN_SEND_COALESCE */
+    AT_PORT_SEND_FLUSH();
+#if LWESP_CFG_CONN_SEND_PIPELINE
+    lwespi_tcpip_stage_send_cmd();
+#endif /* LWESP_CFG_CONN_SEND_PIPELINE */
 }
 
 /**
@@ -520,6 +768,22 @@ lwespi_tcpip_process_data_sent(uint8_t sent) {
             *esp.msg->msg.conn_send.bw += esp.msg->msg.conn_send.sent;
         }
         esp.msg->msg.conn_send.tries = 0;
+#if LWESP_CFG_CONN_SEND_COALESCE
+        {
+            lwesp_msg_t* m;
+
+            /* Merged messages were sent completely together with this one */
+            for (m = esp.msg->msg.conn_send.next; m != NULL; m = m->msg.conn_send.next) {
+                m->msg.conn_send.sent = m->msg.conn_send.btw;
+                m->msg.conn_send.sent_all += m->msg.conn_send.btw;
+                if (m->msg.conn_send.bw != NULL) {
+                    *m->msg.conn_send.bw += m->msg.conn_send.btw;
+                }
+                m->msg.conn_send.ptr += m->msg.conn_send.btw;
+                m->msg.conn_send.btw = 0;
+            }
+        }
+#endif /* LWESP_CFG_CONN_SEND_COALESCE */
     } else {                                    /* We were not successful */
         ++esp.msg->msg.conn_send.tries;         /* Increase number of tries */
         if (esp.msg->msg.conn_send.tries == LWESP_CFG_MAX_SEND_RETRIES) {   /* In case we reached max number of retransmissions */
@@ -554,6 +818,590 @@ lwespi_send_conn_error_cb(lwesp_msg_t* msg, lwespr_t error) {
     LWESP_UNUSED(msg);
 }
 
+/**
+ * \brief           Process "+IPD" statement
+ * \param[in]       rcv: Received line
+ */
+static void
+recv_ipd(lwesp_recv_t* rcv) {
+    lwespi_parse_ipd(rcv->data);                /* Parse IPD statement and start receiving network data */
+}
+
+#if LWESP_CFG_MODE_ACCESS_POINT
+
+/**
+ * \brief           Process "+STA_CONNECTED" statement
+ * \param[in]       rcv: Received line
+ */
+static void
+recv_sta_connected(lwesp_recv_t* rcv) {
+    lwespi_parse_ap_conn_disconn_sta(&rcv->data[15], 1);/* Parse string and send to user layer */
+}
+
+/**
+ * \brief           Process "+STA_DISCONNECTED" statement
+ * \param[in]       rcv: Received line
+ */
+static void
+recv_sta_disconnected(lwesp_recv_t* rcv) {
+    lwespi_parse_ap_conn_disconn_sta(&rcv->data[18], 0);/* Parse string and send to user layer */
+}
+
+/**
+ * \brief           Process "+DIST_STA_IP" statement
+ * \param[in]       rcv: Received line
+ */
+static void
+recv_dist_sta_ip(lwesp_recv_t* rcv) {
+    lwespi_parse_ap_ip_sta(&rcv->data[13]);     /* Parse string and send to user layer */
+}
+
+#endif /* LWESP_CFG_MODE_ACCESS_POINT */
+
+/**
+ * \brief           Process "+CIPSTAMAC" and "+CIPAPMAC" responses
+ * \param[in]       rcv: Received line
+ */
+static void
+recv_cip_mac(lwesp_recv_t* rcv) {
+    const char* tmp = NULL;
+    lwesp_mac_t mac;
+
+    if (rcv->data[9] == ':') {
+        tmp = &rcv->data[10];
+    } else if (rcv->data[10] == ':') {
+        tmp = &rcv->data[11];
+    }
+
+    lwespi_parse_mac(&tmp, &mac);               /* Save as current MAC address */
+#if LWESP_CFG_MODE_STATION
+    if (CMD_IS_CUR(LWESP_CMD_WIFI_CIPSTAMAC_GET)) {
+        LWESP_MEMCPY(&esp.m.sta.mac, &mac, 6);  /* Copy to current setup */
+    }
+#endif /* LWESP_CFG_MODE_STATION */
+#if LWESP_CFG_MODE_ACCESS_POINT
+    if (CMD_IS_CUR(LWESP_CMD_WIFI_CIPAPMAC_GET)) {
+        LWESP_MEMCPY(&esp.m.ap.mac, &mac, 6);   /* Copy to current setup */
+    }
+#endif /* LWESP_CFG_MODE_ACCESS_POINT */
+    if (esp.msg->msg.sta_ap_getmac.mac != NULL && CMD_IS_CUR(CMD_GET_DEF())) {
+        LWESP_MEMCPY(esp.msg->msg.sta_ap_getmac.mac, &mac, sizeof(mac));/* Copy to current setup */
+    }
+}
+
+/**
+ * \brief           Process "+CIPSTA" and "+CIPAP" responses
+ * \param[in]       rcv: Received line
+ */
+static void
+recv_cip_ip(lwesp_recv_t* rcv) {
+    const char* tmp = NULL;
+    lwesp_ip_t ip, *a = NULL, *b = NULL;
+    lwesp_ip_mac_t* im = NULL;
+    uint8_t ch = 0;
+
+#if LWESP_CFG_MODE_STATION
+    if (CMD_IS_CUR(LWESP_CMD_WIFI_CIPSTA_GET)) {
+        im = &esp.m.sta;                        /* Get IP and MAC structure first */
+    }
+#endif /* LWESP_CFG_MODE_STATION */
+#if LWESP_CFG_MODE_ACCESS_POINT
+    if (CMD_IS_CUR(LWESP_CMD_WIFI_CIPAP_GET)) {
+        im = &esp.m.ap;                         /* Get IP and MAC structure first */
+    }
+#endif /* LWESP_CFG_MODE_ACCESS_POINT */
+
+    if (im != NULL) {
+        /* We expect "+CIPSTA:" or "+CIPAP:" ... */
+        if (rcv->data[6] == ':') {
+            ch = rcv->data[7];
+        } else if (rcv->data[7] == ':') {
+            ch = rcv->data[8];
+        }
+        switch (ch) {
+            case 'i':
+                tmp = &rcv->data[10];
+                a = &im->ip;
+                b = esp.msg->msg.sta_ap_getip.ip;
+                break;
+            case 'g':
+                tmp = &rcv->data[15];
+                a = &im->gw;
+                b = esp.msg->msg.sta_ap_getip.gw;
+                break;
+            case 'n':
+                tmp = &rcv->data[15];
+                a = &im->nm;
+                b = esp.msg->msg.sta_ap_getip.nm;
+                break;
+            default:
+                tmp = NULL;
+                a = NULL;
+                b = NULL;
+                break;
+        }
+        if (tmp != NULL) {                      /* Do we have temporary string? */
+            if (*tmp == ':') {
+                ++tmp;
+            }
+            lwespi_parse_ip(&tmp, &ip);         /* Parse IP address */
+            LWESP_MEMCPY(a, &ip, sizeof(ip));   /* Copy to current setup */
+            if (b != NULL && CMD_IS_CUR(CMD_GET_DEF())) {   /* Is current command the same as default one? */
+                LWESP_MEMCPY(b, &ip, sizeof(ip));   /* Copy to user variable */
+            }
+        }
+    }
+}
+
+#if LWESP_CFG_MODE_STATION
+
+/**
+ * \brief           Process "+CWLAP" response
+ * \param[in]       rcv: Received line
+ */
+static void
+recv_cwlap(lwesp_recv_t* rcv) {
+    lwespi_parse_cwlap(rcv->data, esp.msg);     /* Parse CWLAP entry */
+}
+
+/**
+ * \brief           Process "+CWJAP" response on join command
+ * \param[in]       rcv: Received line
+ */
+static void
+recv_cwjap(lwesp_recv_t* rcv) {
+    const char* tmp = &rcv->data[7];            /* Go to the number position */
+    esp.msg->msg.sta_join.error_num = (uint8_t)lwespi_parse_number(&tmp);
+}
+
+/**
+ * \brief           Process "+CWJAP" response on query command
+ * \param[in]       rcv: Received line
+ */
+static void
+recv_cwjap_get(lwesp_recv_t* rcv) {
+    lwespi_parse_cwjap(rcv->data, esp.msg);     /* Parse CWJAP */
+}
+
+#endif /* LWESP_CFG_MODE_STATION */
+
+#if LWESP_CFG_MODE_ACCESS_POINT
+
+/**
+ * \brief           Process "+CWLIF" response
+ * \param[in]       rcv: Received line
+ */
+static void
+recv_cwlif(lwesp_recv_t* rcv) {
+    lwespi_parse_cwlif(rcv->data, esp.msg);     /* Parse CWLIF entry */
+}
+
+/**
+ * \brief           Process "+CWSAP" response
+ * \param[in]       rcv: Received line
+ */
+static void
+recv_cwsap(lwesp_recv_t* rcv) {
+    lwespi_parse_cwsap(rcv->data, esp.msg);
+}
+
+#endif /* LWESP_CFG_MODE_ACCESS_POINT */
+
+#if LWESP_CFG_DNS
+
+/**
+ * \brief           Process "+CIPDOMAIN" response
+ * \param[in]       rcv: Received line
+ */
+static void
+recv_cipdomain(lwesp_recv_t* rcv) {
+    lwespi_parse_cipdomain(rcv->data, esp.msg); /* Parse CIPDOMAIN entry */
+}
+
+/**
+ * \brief           Process "+CIPDNS" response
+ * \param[in]       rcv: Received line
+ */
+static void
+recv_cipdns(lwesp_recv_t* rcv) {
+    const char* tmp = &rcv->data[8];            /* Go to the ip position */
+    lwesp_ip_t ip;
+    uint8_t index = (uint8_t)lwespi_parse_number(&tmp);
+
+    esp.msg->msg.dns_getconf.dnsi = index;
+    lwespi_parse_ip(&tmp, &ip);                 /* Parse DNS address */
+    if (esp.msg->msg.dns_getconf.s1 != NULL) {
+        *esp.msg->msg.dns_getconf.s1 = ip;
+    }
+    if (esp.msg->msg.dns_getconf.s2 != NULL && lwespi_parse_ip(&tmp, &ip)) {
+        *esp.msg->msg.dns_getconf.s2 = ip;
+    }
+}
+
+#endif /* LWESP_CFG_DNS */
+
+#if LWESP_CFG_PING
+
+/**
+ * \brief           Process "+PING" response
+ * \param[in]       rcv: Received line
+ */
+static void
+recv_ping(lwesp_recv_t* rcv) {
+    lwespi_parse_ping_time(rcv->data, esp.msg); /* Parse ping time */
+}
+
+#endif /* LWESP_CFG_PING */
+
+#if LWESP_CFG_HOSTNAME
+
+/**
+ * \brief           Process "+CWHOSTNAME" response
+ * \param[in]       rcv: Received line
+ */
+static void
+recv_cwhostname(lwesp_recv_t* rcv) {
+    lwespi_parse_hostname(rcv->data, esp.msg);  /* Parse HOSTNAME entry */
+}
+
+#endif /* LWESP_CFG_HOSTNAME */
+
+/**
+ * \brief           Process "+CWDHCP" response
+ * \param[in]       rcv: Received line
+ */
+static void
+recv_cwdhcp(lwesp_recv_t* rcv) {
+    lwespi_parse_cwdhcp(rcv->data);             /* Parse CWDHCP state */
+}
+
+/**
+ * \brief           Process "+CWMODE" response
+ * \param[in]       rcv: Received line
+ */
+static void
+recv_cwmode(lwesp_recv_t* rcv) {
+    const char* tmp = &rcv->data[8];            /* Go to the number position */
+    *esp.msg->msg.wifi_mode.mode_get = (uint8_t)lwespi_parse_number(&tmp);
+}
+
+/**
+ * \brief           Response handler entry
+ */
+typedef struct {
+    const char* name;                           /*!< Response name between `+` and `:` or `,` characters */
+    lwesp_cmd_t cmd;                            /*!< Command that must be active for handler to be called.
+                                                        Set to \ref LWESP_CMD_IDLE for unsolicited responses */
+    void (*fn)(lwesp_recv_t* rcv);              /*!< Handler function */
+} lwesp_recv_handler_t;
+
+/* Helper macro to define response handler entry */
+#define RECV_HANDLER(name, cmd, fn)         { name, cmd, fn }
+
+/**
+ * \brief           List of handlers for responses starting with `+` character
+ */
+static const lwesp_recv_handler_t
+recv_handlers[] = {
+    RECV_HANDLER("IPD", LWESP_CMD_IDLE, recv_ipd),
+#if LWESP_CFG_MODE_ACCESS_POINT
+    RECV_HANDLER("STA_CONNECTED", LWESP_CMD_IDLE, recv_sta_connected),
+    RECV_HANDLER("STA_DISCONNECTED", LWESP_CMD_IDLE, recv_sta_disconnected),
+    RECV_HANDLER("DIST_STA_IP", LWESP_CMD_IDLE, recv_dist_sta_ip),
+    RECV_HANDLER("CIPAPMAC", LWESP_CMD_WIFI_CIPAPMAC_GET, recv_cip_mac),
+    RECV_HANDLER("CIPAP", LWESP_CMD_WIFI_CIPAP_GET, recv_cip_ip),
+    RECV_HANDLER("CWLIF", LWESP_CMD_WIFI_CWLIF, recv_cwlif),
+    RECV_HANDLER("CWSAP", LWESP_CMD_WIFI_CWSAP_GET, recv_cwsap),
+#endif /* LWESP_CFG_MODE_ACCESS_POINT */
+#if LWESP_CFG_MODE_STATION
+    RECV_HANDLER("CIPSTAMAC", LWESP_CMD_WIFI_CIPSTAMAC_GET, recv_cip_mac),
+    RECV_HANDLER("CIPSTA", LWESP_CMD_WIFI_CIPSTA_GET, recv_cip_ip),
+    RECV_HANDLER("CWLAP", LWESP_CMD_WIFI_CWLAP, recv_cwlap),
+    RECV_HANDLER("CWJAP", LWESP_CMD_WIFI_CWJAP, recv_cwjap),
+    RECV_HANDLER("CWJAP", LWESP_CMD_WIFI_CWJAP_GET, recv_cwjap_get),
+#endif /* LWESP_CFG_MODE_STATION */
+#if LWESP_CFG_DNS
+    RECV_HANDLER("CIPDOMAIN", LWESP_CMD_TCPIP_CIPDOMAIN, recv_cipdomain),
+    RECV_HANDLER("CIPDNS", LWESP_CMD_TCPIP_CIPDNS_GET, recv_cipdns),
+#endif /* LWESP_CFG_DNS */
+#if LWESP_CFG_PING
+    RECV_HANDLER("PING", LWESP_CMD_TCPIP_PING, recv_ping),
+#endif /* LWESP_CFG_PING */
+#if LWESP_CFG_HOSTNAME
+    RECV_HANDLER("CWHOSTNAME", LWESP_CMD_WIFI_CWHOSTNAME_GET, recv_cwhostname),
+#endif /* LWESP_CFG_HOSTNAME */
+    RECV_HANDLER("CWDHCP", LWESP_CMD_WIFI_CWDHCP_GET, recv_cwdhcp),
+    RECV_HANDLER("CWMODE", LWESP_CMD_WIFI_CWMODE_GET, recv_cwmode),
+};
+
+/* Number of slots in hash table, must be power of 2 and bigger than number of handlers */
+#define RECV_HASH_SIZE                      64
+
+/* Compile-time check that hash table keeps at least one empty slot to terminate probing */
+typedef char recv_hash_size_check_t[(LWESP_ARRAYSIZE(recv_handlers) < RECV_HASH_SIZE) ? 1 : -1];
+
+/* Calculate hash of response name */
+#define RECV_HASH_NEXT(h, ch)               ((uint32_t)((h) * 31U + (uint8_t)(ch)))
+
+/* Check if character terminates response name */
+#define RECV_IS_NAME_END(ch)                ((ch) == ':' || (ch) == ',' || (ch) == '\r' || (ch) == '\n' || (ch) == '\0')
+
+/**
+ * \brief           Hash table of response handlers.
+ *                  Each slot holds index of handler increased by `1`, or `0` when empty
+ */
+static uint8_t recv_hash[RECV_HASH_SIZE];
+static uint8_t recv_hash_init;
+
+/**
+ * \brief           Fill hash table with handlers.
+ *                  Collisions are resolved with linear probing
+ */
+static void
+lwespi_recv_hash_init(void) {
+    uint32_t h;
+    size_t i;
+
+    for (i = 0; i < LWESP_ARRAYSIZE(recv_handlers); ++i) {
+        h = 0;
+        for (const char* n = recv_handlers[i].name; *n != '\0'; ++n) {
+            h = RECV_HASH_NEXT(h, *n);
+        }
+        for (h &= RECV_HASH_SIZE - 1; recv_hash[h] != 0; h = (h + 1) & (RECV_HASH_SIZE - 1)) {}
+        recv_hash[h] = (uint8_t)(i + 1);
+    }
+    recv_hash_init = 1;
+}
+
+/**
+ * \brief           Find handler for received response starting with `+` character
+ *
+ * Response name is hashed in single pass and looked up in hash table,
+ * so that classification time does not depend on number of handlers
+ *
+ * \param[in]       line: Received line, starting with `+` character
+ * \param[in]       cmd: Currently active command
+ * \return          Handler on success, `NULL` if response is not handled
+ */
+static const lwesp_recv_handler_t*
+lwespi_recv_find(const char* line, lwesp_cmd_t cmd) {
+    const lwesp_recv_handler_t* hnd;
+    const char* name = &line[1];
+    uint32_t h = 0;
+    size_t len;
+
+    if (!recv_hash_init) {
+        lwespi_recv_hash_init();
+    }
+
+    /* Get length and hash of response name */
+    for (len = 0; !RECV_IS_NAME_END(name[len]); ++len) {
+        h = RECV_HASH_NEXT(h, name[len]);
+    }
+
+    /* Probe until empty slot; equal names may be registered for different commands */
+    for (h &= RECV_HASH_SIZE - 1; recv_hash[h] != 0; h = (h + 1) & (RECV_HASH_SIZE - 1)) {
+        hnd = &recv_handlers[recv_hash[h] - 1];
+        if (!strncmp(hnd->name, name, len) && hnd->name[len] == '\0'
+            && (hnd->cmd == LWESP_CMD_IDLE || hnd->cmd == cmd)) {
+            return hnd;
+        }
+    }
+    return NULL;
+}
+
+/**
+ * \brief           Find and call handler for received response starting with `+` character
+ * \param[in]       rcv: Received line
+ */
+static void
+lwespi_recv_dispatch(lwesp_recv_t* rcv) {
+    const lwesp_recv_handler_t* hnd;
+
+    if ((hnd = lwespi_recv_find(rcv->data, CMD_GET_CUR())) != NULL) {
+        hnd->fn(rcv);
+    }
+}
+
+/**
+ * \brief           Classify received response starting with `+` character, without processing it
+ * \note            Core must be locked on first call, when handler table is built
+ * \param[in]       line: Received line, starting with `+` character
+ * \param[in]       cmd: Command to classify response for
+ * \return          Response name of handler, `NULL` if response is not handled
+ */
+const char*
+lwespi_recv_classify(const char* line, lwesp_cmd_t cmd) {
+    const lwesp_recv_handler_t* hnd = lwespi_recv_find(line, cmd);
+
+    return hnd != NULL ? hnd->name : NULL;
+}
+
+/**
+ * \brief           Get baudrate to set with UART command
+ * \param[in]       msg: Message with UART command
+ * \return          Baudrate for AT port
+ */
+static uint32_t
+lwespi_get_uart_baudrate(lwesp_msg_t* msg) {
+#if LWESP_CFG_AT_PORT_BAUDRATE_AUTO
+    if (msg->cmd_def == LWESP_CMD_RESET || msg->cmd_def == LWESP_CMD_RESTORE) {
+        return msg->msg.reset.baudrate;         /* Baudrate negotiated in reset sequence */
+    }
+#endif /* LWESP_CFG_AT_PORT_BAUDRATE_AUTO */
+    return msg->msg.uart.baudrate;
+}
+
+/**
+ * \brief           Process final result of current command
+ * \param[in]       is_ok: Status whether command result was OK
+ * \param[in]       is_error: Status whether command result was ERROR
+ * \param[in]       is_ready: Status whether command result was ready
+ */
+static void
+lwespi_process_cmd_result(uint8_t is_ok, uint8_t is_error, uint8_t is_ready) {
+    lwespr_t res = lwespOK;
+    if (esp.msg != NULL) {                      /* Do we have active message? */
+        res = lwespi_process_sub_cmd(esp.msg, &is_ok, &is_error, &is_ready);
+        if (res != lwespCONT) {                 /* Shall we continue with next subcommand under this one? */
+            if (is_ok || is_ready) {            /* Check ready or ok status */
+                res = esp.msg->res = lwespOK;
+            } else {                            /* Or error status */
+                res = esp.msg->res = res;       /* Set the error status */
+            }
+        } else {
+            ++esp.msg->i;                       /* Number of continue calls */
+        }
+
+        /*
+         * When the command is finished,
+         * release synchronization semaphore
+         * from user thread and start with next command
+         */
+        if (res != lwespCONT) {                 /* Do we have to continue to wait for command? */
+#if LWESP_CFG_CONN_SEND_PIPELINE
+            lwesp_msg_t* msg = esp.msg;
+#endif /* LWESP_CFG_CONN_SEND_PIPELINE */
+#if LWESP_CFG_CMD_PIPELINE
+            esp.msg = esp.msg->pipe_next;       /* Next responses belong to next pipelined command */
+#endif /* LWESP_CFG_CMD_PIPELINE */
+#if LWESP_CFG_CONN_SEND_PIPELINE
+            if (msg->cmd_def == LWESP_CMD_TCPIP_CIPSEND) {
+                esp.msg = lwespi_tcpip_send_start_next(msg, res);   /* Next responses belong to next send command */
+            }
+#endif /* LWESP_CFG_CONN_SEND_PIPELINE */
+            lwesp_sys_sem_release(&esp.sem_sync);   /* Release semaphore */
+        }
+    }
+}
+
+#if LWESP_CFG_AT_PORT_BAUDRATE_AUTO || LWESP_CFG_RESET_WARM || __DOXYGEN__
+
+/**
+ * \brief           Timeout callback of baudrate change or AT port verification in reset sequence
+ *
+ * Device may not respond when link does not work at new baudrate
+ * or when device is not running in warm start,
+ * command is finished as it would respond with error
+ *
+ * \param[in]       arg: Reset or restore message
+ */
+static void
+lwespi_reset_timeout_fn(void* arg) {
+    if (esp.msg != NULL && esp.msg == arg
+        && (CMD_IS_DEF(LWESP_CMD_RESET) || CMD_IS_DEF(LWESP_CMD_RESTORE))
+        && (CMD_IS_CUR(LWESP_CMD_UART) || CMD_IS_CUR(LWESP_CMD_AT))) {
+        esp.msg->msg.reset.is_timeout = 1;
+        lwespi_process_cmd_result(0, 1, 0);
+    }
+}
+
+#endif /* LWESP_CFG_AT_PORT_BAUDRATE_AUTO || LWESP_CFG_RESET_WARM || __DOXYGEN__ */
+
+#if LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__
+
+/**
+ * \brief           Write data of current send command to AT port in passthrough mode
+ *
+ * Device forwards data to connection without `AT+CIPSEND` handshake and does not confirm it,
+ * command is finished as soon as data are written to AT port
+ *
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+static lwespr_t
+lwespi_passthrough_send_data(void) {
+    lwesp_conn_t* c = esp.msg->msg.conn_send.conn;
+
+    if (c != esp.m.passthrough.conn || !c->status.f.active
+        || esp.msg->msg.conn_send.val_id != c->val_id) {
+        CONN_SEND_DATA_SEND_EVT(esp.msg, lwespCLOSED);
+        return lwespERR;
+    }
+    esp.msg->msg.conn_send.sent = esp.msg->msg.conn_send.btw;   /* There is no packet length limit */
+    lwespi_tcpip_send_data();
+    lwespi_tcpip_process_data_sent(1);
+#if LWESP_CFG_CONN_POLL_ADAPTIVE
+    lwespi_conn_activity(c);
+#endif /* LWESP_CFG_CONN_POLL_ADAPTIVE */
+    CONN_SEND_DATA_SEND_EVT(esp.msg, lwespOK);
+    lwespi_process_cmd_result(1, 0, 0);
+    return lwespOK;
+}
+
+/**
+ * \brief           Timeout callback of passthrough exit sequence
+ *
+ * First timeout sends `+++` after guard time without data,
+ * second one finishes command after guard time, when device is back in command mode
+ *
+ * \param[in]       arg: Passthrough stop message
+ */
+static void
+lwespi_passthrough_exit_fn(void* arg) {
+    if (esp.msg != NULL && esp.msg == arg && CMD_IS_CUR(LWESP_CMD_TCPIP_PASSTHROUGH_EXIT)) {
+        if (!esp.msg->msg.passthrough_stop.exit_sent) {
+            AT_PORT_SEND_WITH_FLUSH("+++", 3);
+            esp.msg->msg.passthrough_stop.exit_sent = 1;
+            lwesp_timeout_start(&passthrough_timeout, LWESP_CFG_CONN_PASSTHROUGH_GUARD_TIME, lwespi_passthrough_exit_fn, arg);
+        } else {
+            esp.m.passthrough.active = 0;
+            lwespi_process_cmd_result(1, 0, 0);
+        }
+    }
+}
+
+/**
+ * \brief           Close connection of passthrough session in memory
+ *
+ * Device does not report closed connection in single connection mode,
+ * it is closed after device is switched back to multiple connections
+ */
+static void
+lwespi_passthrough_close(void) {
+    lwesp_conn_t* conn = esp.m.passthrough.conn;
+
+    if (conn == NULL) {
+        return;
+    }
+    if (conn->status.f.active) {
+        conn->status.f.active = 0;
+        esp.m.active_conns &= ~(1U << conn->num);
+
+        esp.evt.type = LWESP_EVT_CONN_CLOSE;
+        esp.evt.evt.conn_active_close.conn = conn;
+        esp.evt.evt.conn_active_close.client = conn->status.f.client;
+        esp.evt.evt.conn_active_close.forced = 1;
+        esp.evt.evt.conn_active_close.res = lwespOK;
+        lwespi_send_conn_cb(conn, NULL);
+    }
+    if (conn->buff.buff != NULL) {
+        lwesp_mem_free_s((void**)&conn->buff.buff);
+    }
+    esp.m.passthrough.conn = NULL;
+}
+
+#endif /* LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__ */
+
 /**
  * \brief           Process received string from ESP
  * \param[in]       rcv: Pointer to \ref lwesp_recv_t structure with input string
@@ -598,158 +1446,7 @@ lwespi_parse_received(lwesp_recv_t* rcv) {
 
     /* Read and process statements starting with '+' character */
     if (rcv->data[0] == '+') {
-        if (!strncmp("+IPD", rcv->data, 4)) {   /* Check received network data */
-            lwespi_parse_ipd(rcv->data);        /* Parse IPD statement and start receiving network data */
-#if LWESP_CFG_MODE_ACCESS_POINT
-        } else if (!strncmp(rcv->data, "+STA_CONNECTED", 14)) {
-            lwespi_parse_ap_conn_disconn_sta(&rcv->data[15], 1);/* Parse string and send to user layer */
-        } else if (!strncmp(rcv->data, "+STA_DISCONNECTED", 17)) {
-            lwespi_parse_ap_conn_disconn_sta(&rcv->data[18], 0);/* Parse string and send to user layer */
-        } else if (!strncmp(rcv->data, "+DIST_STA_IP", 12)) {
-            lwespi_parse_ap_ip_sta(&rcv->data[13]); /* Parse string and send to user layer */
-#endif /* LWESP_CFG_MODE_ACCESS_POINT */
-        } else if (esp.msg != NULL) {
-            if (0
-#if LWESP_CFG_MODE_STATION
-                || (CMD_IS_CUR(LWESP_CMD_WIFI_CIPSTAMAC_GET) && !strncmp(rcv->data, "+CIPSTAMAC", 10))
-#endif /* LWESP_CFG_MODE_STATION */
-#if LWESP_CFG_MODE_ACCESS_POINT
-                || (CMD_IS_CUR(LWESP_CMD_WIFI_CIPAPMAC_GET) && !strncmp(rcv->data, "+CIPAPMAC", 9))
-#endif /* LWESP_CFG_MODE_ACCESS_POINT */
-               ) {
-                const char* tmp;
-                lwesp_mac_t mac;
-
-                if (rcv->data[9] == ':') {
-                    tmp = &rcv->data[10];
-                } else if (rcv->data[10] == ':') {
-                    tmp = &rcv->data[11];
-                }
-
-                lwespi_parse_mac(&tmp, &mac);   /* Save as current MAC address */
-#if LWESP_CFG_MODE_STATION
-                if (CMD_IS_CUR(LWESP_CMD_WIFI_CIPSTAMAC_GET)) {
-                    LWESP_MEMCPY(&esp.m.sta.mac, &mac, 6);  /* Copy to current setup */
-                }
-#endif /* LWESP_CFG_MODE_STATION */
-#if LWESP_CFG_MODE_ACCESS_POINT
-                if (CMD_IS_CUR(LWESP_CMD_WIFI_CIPAPMAC_GET)) {
-                    LWESP_MEMCPY(&esp.m.ap.mac, &mac, 6);   /* Copy to current setup */
-                }
-#endif /* LWESP_CFG_MODE_ACCESS_POINT */
-                if (esp.msg->msg.sta_ap_getmac.mac != NULL && CMD_IS_CUR(CMD_GET_DEF())) {
-                    LWESP_MEMCPY(esp.msg->msg.sta_ap_getmac.mac, &mac, sizeof(mac));/* Copy to current setup */
-                }
-            } else if (0
-#if LWESP_CFG_MODE_STATION
-                       || (CMD_IS_CUR(LWESP_CMD_WIFI_CIPSTA_GET) && !strncmp(rcv->data, "+CIPSTA", 7))
-#endif /* LWESP_CFG_MODE_STATION */
-#if LWESP_CFG_MODE_ACCESS_POINT
-                       || (CMD_IS_CUR(LWESP_CMD_WIFI_CIPAP_GET) && !strncmp(rcv->data, "+CIPAP", 6))
-#endif /* LWESP_CFG_MODE_ACCESS_POINT */
-                      ) {
-                const char* tmp = NULL;
-                lwesp_ip_t ip, *a = NULL, *b = NULL;
-                lwesp_ip_mac_t* im;
-                uint8_t ch = 0;
-
-#if LWESP_CFG_MODE_STATION
-                if (CMD_IS_CUR(LWESP_CMD_WIFI_CIPSTA_GET)) {
-                    im = &esp.m.sta;            /* Get IP and MAC structure first */
-                }
-#endif /* LWESP_CFG_MODE_STATION */
-#if LWESP_CFG_MODE_ACCESS_POINT
-                if (CMD_IS_CUR(LWESP_CMD_WIFI_CIPAP_GET)) {
-                    im = &esp.m.ap;             /* Get IP and MAC structure first */
-                }
-#endif /* LWESP_CFG_MODE_ACCESS_POINT */
-
-                if (im != NULL) {
-                    /* We expect "+CIPSTA:" or "+CIPAP:" ... */
-                    if (rcv->data[6] == ':') {
-                        ch = rcv->data[7];
-                    } else if (rcv->data[7] == ':') {
-                        ch = rcv->data[8];
-                    }
-                    switch (ch) {
-                        case 'i':
-                            tmp = &rcv->data[10];
-                            a = &im->ip;
-                            b = esp.msg->msg.sta_ap_getip.ip;
-                            break;
-                        case 'g':
-                            tmp = &rcv->data[15];
-                            a = &im->gw;
-                            b = esp.msg->msg.sta_ap_getip.gw;
-                            break;
-                        case 'n':
-                            tmp = &rcv->data[15];
-                            a = &im->nm;
-                            b = esp.msg->msg.sta_ap_getip.nm;
-                            break;
-                        default:
-                            tmp = NULL;
-                            a = NULL;
-                            b = NULL;
-                            break;
-                    }
-                    if (tmp != NULL) {          /* Do we have temporary string? */
-                        if (*tmp == ':') {
-                            ++tmp;
-                        }
-                        lwespi_parse_ip(&tmp, &ip); /* Parse IP address */
-                        LWESP_MEMCPY(a, &ip, sizeof(ip));   /* Copy to current setup */
-                        if (b != NULL && CMD_IS_CUR(CMD_GET_DEF())) {   /* Is current command the same as default one? */
-                            LWESP_MEMCPY(b, &ip, sizeof(ip));   /* Copy to user variable */
-                        }
-                    }
-                }
-#if LWESP_CFG_MODE_STATION
-            } else if (CMD_IS_CUR(LWESP_CMD_WIFI_CWLAP) && !strncmp(rcv->data, "+CWLAP", 6)) {
-                lwespi_parse_cwlap(rcv->data, esp.msg); /* Parse CWLAP entry */
-            } else if (CMD_IS_CUR(LWESP_CMD_WIFI_CWJAP) && !strncmp(rcv->data, "+CWJAP", 6)) {
-                const char* tmp = &rcv->data[7];/* Go to the number position */
-                esp.msg->msg.sta_join.error_num = (uint8_t)lwespi_parse_number(&tmp);
-            } else if (CMD_IS_CUR(LWESP_CMD_WIFI_CWJAP_GET) && !strncmp(rcv->data, "+CWJAP", 6)) {
-                lwespi_parse_cwjap(rcv->data, esp.msg); /* Parse CWJAP */
-#endif /* LWESP_CFG_MODE_STATION */
-#if LWESP_CFG_MODE_ACCESS_POINT
-            } else if (CMD_IS_CUR(LWESP_CMD_WIFI_CWLIF) && !strncmp(rcv->data, "+CWLIF", 6)) {
-                lwespi_parse_cwlif(rcv->data, esp.msg); /* Parse CWLIF entry */
-            } else if (CMD_IS_CUR(LWESP_CMD_WIFI_CWSAP_GET) && !strncmp(rcv->data, "+CWSAP", 6)) {
-                lwespi_parse_cwsap(rcv->data, esp.msg);
-#endif /* LWESP_CFG_MODE_ACCESS_POINT */
-#if LWESP_CFG_DNS
-            } else if (CMD_IS_CUR(LWESP_CMD_TCPIP_CIPDOMAIN) && !strncmp(rcv->data, "+CIPDOMAIN", 10)) {
-                lwespi_parse_cipdomain(rcv->data, esp.msg); /* Parse CIPDOMAIN entry */
-            } else if (CMD_IS_CUR(LWESP_CMD_TCPIP_CIPDNS_GET) && !strncmp(rcv->data, "+CIPDNS", 7)) {
-                const char* tmp = &rcv->data[8];/* Go to the ip position */
-                lwesp_ip_t ip;
-                uint8_t index = (uint8_t)lwespi_parse_number(&tmp);
-                esp.msg->msg.dns_getconf.dnsi = index;
-                lwespi_parse_ip(&tmp, &ip);     /* Parse DNS address */
-                if (esp.msg->msg.dns_getconf.s1 != NULL) {
-                    *esp.msg->msg.dns_getconf.s1 = ip;
-                }
-                if (esp.msg->msg.dns_getconf.s2 != NULL && lwespi_parse_ip(&tmp, &ip)) {
-                    *esp.msg->msg.dns_getconf.s2 = ip;
-                }
-#endif /* LWESP_CFG_DNS */
-#if LWESP_CFG_PING
-            } else if (CMD_IS_CUR(LWESP_CMD_TCPIP_PING) && !strncmp(rcv->data, "+PING", 5)) {
-                lwespi_parse_ping_time(rcv->data, esp.msg); /* Parse ping time */
-#endif /* LWESP_CFG_PING */
-#if LWESP_CFG_HOSTNAME
-            } else if (CMD_IS_CUR(LWESP_CMD_WIFI_CWHOSTNAME_GET) && !strncmp(rcv->data, "+CWHOSTNAME", 11)) {
-                lwespi_parse_hostname(rcv->data, esp.msg);  /* Parse HOSTNAME entry */
-#endif /* LWESP_CFG_HOSTNAME */
-            } else if (CMD_IS_CUR(LWESP_CMD_WIFI_CWDHCP_GET) && !strncmp(rcv->data, "+CWDHCP", 7)) {
-                lwespi_parse_cwdhcp(rcv->data); /* Parse CWDHCP state */
-            } else if (CMD_IS_CUR(LWESP_CMD_WIFI_CWMODE_GET) && !strncmp(rcv->data, "+CWMODE", 7)) {
-                const char* tmp = &rcv->data[8];/* Go to the number position */
-                *esp.msg->msg.wifi_mode.mode_get = (uint8_t)lwespi_parse_number(&tmp);
-            }
-        }
+        lwespi_recv_dispatch(rcv);              /* Find handler by response name and process it */
 #if LWESP_CFG_MODE_STATION
     } else if (strlen(rcv->data) > 4 && !strncmp(rcv->data, "WIFI", 4)) {
         if (!strncmp(&rcv->data[5], "CONNECTED", 9)) {
@@ -812,6 +1509,16 @@ lwespi_parse_received(lwesp_recv_t* rcv) {
         } else if (CMD_IS_CUR(LWESP_CMD_TCPIP_CIPSTATUS)) {
             if (!strncmp(rcv->data, "+CIPSTATUS", 10)) {
                 lwespi_parse_cipstatus(rcv->data + 11); /* Parse CIPSTATUS response */
+#if LWESP_CFG_RESET_WARM && LWESP_CFG_MODE_STATION
+            } else if (!strncmp(rcv->data, "STATUS:", 7)) {
+                if (CMD_IS_DEF(LWESP_CMD_RESET) && esp.msg->msg.reset.warm != NULL) {
+                    const char* tmp = &rcv->data[7];
+                    int32_t status = lwespi_parse_number(&tmp);
+
+                    /* 2: has IP, 3: connection active, 4: connection closed, 5: not connected to access point */
+                    esp.m.sta.is_connected = esp.m.sta.has_ip = LWESP_U8(status >= 2 && status <= 4);
+                }
+#endif /* LWESP_CFG_RESET_WARM && LWESP_CFG_MODE_STATION */
             } else if (is_ok) {
                 for (size_t i = 0; i < LWESP_CFG_MAX_CONNS; ++i) {  /* Set current connection statuses */
                     esp.m.conns[i].status.f.active = !!(esp.m.active_conns & (1 << i));
@@ -898,7 +1605,13 @@ lwespi_parse_received(lwesp_recv_t* rcv) {
             if (esp.msg->msg.conn_send.wait_send_ok_err) {
                 if (!strncmp("SEND OK", rcv->data, 7)) {/* Data were sent successfully */
                     esp.msg->msg.conn_send.wait_send_ok_err = 0;
+#if LWESP_CFG_STATS
+                    lwespi_stats_send_ok();
+#endif /* LWESP_CFG_STATS */
                     is_ok = lwespi_tcpip_process_data_sent(1);  /* Process as data were sent */
+#if LWESP_CFG_CONN_POLL_ADAPTIVE
+                    lwespi_conn_activity(esp.msg->msg.conn_send.conn);
+#endif /* LWESP_CFG_CONN_POLL_ADAPTIVE */
                     if (is_ok && esp.msg->msg.conn_send.conn->status.f.active) {
                         CONN_SEND_DATA_SEND_EVT(esp.msg, lwespOK);
                     }
@@ -912,9 +1625,13 @@ lwespi_parse_received(lwesp_recv_t* rcv) {
             } else if (is_error) {
                 CONN_SEND_DATA_SEND_EVT(esp.msg, lwespERR);
             }
+#if LWESP_CFG_CONN_PASSTHROUGH
+        } else if (CMD_IS_CUR(LWESP_CMD_TCPIP_CIPSEND_PASSTHROUGH)) {
+            is_ok = 0;                          /* Wait for "> " statement after OK */
+#endif /* LWESP_CFG_CONN_PASSTHROUGH */
         } else if (CMD_IS_CUR(LWESP_CMD_UART)) {/* In case of UART command */
             if (is_ok) {                        /* We have valid OK result */
-                esp.ll.uart.baudrate = esp.msg->msg.uart.baudrate;  /* Save user baudrate */
+                esp.ll.uart.baudrate = lwespi_get_uart_baudrate(esp.msg);   /* Save user baudrate */
                 lwesp_ll_init(&esp.ll);         /* Set new baudrate */
             }
         }
@@ -973,92 +1690,497 @@ lwespi_parse_received(lwesp_recv_t* rcv) {
     }
 
     /*
-     * In case of any of these events, simply release semaphore
-     * and proceed with next command
+     * In case of any of these events, simply release semaphore
+     * and proceed with next command
+     */
+    if (is_ok || is_error || is_ready) {
+        lwespi_process_cmd_result(is_ok, is_error, is_ready);
+    }
+}
+
+#if !LWESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__
+
+#if LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__
+
+/**
+ * \brief           Get number of bytes in input buffer not processed yet
+ *
+ * Data already processed but still referenced by packet buffers are not counted,
+ * application may hold them as long as it needs
+ *
+ * \return          Number of bytes waiting for processing
+ */
+static size_t
+lwespi_flow_unprocessed(void) {
+#if LWESP_CFG_IPD_ZERO_COPY
+    return lwesp_buff_get_full(&esp.buff) - (esp.buff_proc_pos - esp.buff_rel_pos);
+#else /* LWESP_CFG_IPD_ZERO_COPY */
+    return lwesp_buff_get_full(&esp.buff);
+#endif /* !LWESP_CFG_IPD_ZERO_COPY */
+}
+
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__ */
+
+/**
+ * \brief           Process data from input buffer
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwespi_process_buffer(void) {
+    void* data;
+    size_t len;
+
+#if LWESP_CFG_INPUT_BUFF_SPSC
+    /*
+     * Re-arm wake-up before buffer is checked,
+     * data written after this point send new message
+     */
+    atomic_flag_clear_explicit(&esp.buff_wake, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+#endif /* LWESP_CFG_INPUT_BUFF_SPSC */
+
+    do {
+#if LWESP_CFG_IPD_ZERO_COPY
+        size_t idx;
+
+        /*
+         * Data between read pointer and processed position
+         * may still be referenced by packet buffers.
+         * Process data after already processed position
+         */
+        len = lwesp_buff_get_full(&esp.buff) - (esp.buff_proc_pos - esp.buff_rel_pos);
+        if (len > 0) {
+            idx = esp.buff.r + (esp.buff_proc_pos - esp.buff_rel_pos);
+            if (idx >= esp.buff.size) {
+                idx -= esp.buff.size;
+            }
+            len = LWESP_MIN(len, esp.buff.size - idx);
+            data = &esp.buff.buff[idx];
+
+            /* Process actual received data, data after pause stay in buffer */
+            lwespi_process(data, len, &len);
+
+            /*
+             * Once data is processed, release the memory
+             * not referenced by any packet buffer
+             */
+            esp.buff_proc_pos += len;
+            lwespi_buff_ref_release(NULL);
+        }
+#else /* LWESP_CFG_IPD_ZERO_COPY */
+        /*
+         * Get length of linear memory in buffer
+         * we can process directly as memory
+         */
+        len = lwesp_buff_get_linear_block_read_length(&esp.buff);
+        if (len > 0) {
+            /*
+             * Get memory address of first element
+             * in linear block of data to process
+             */
+            data = lwesp_buff_get_linear_block_read_address(&esp.buff);
+
+            /* Process actual received data, data after pause stay in buffer */
+            lwespi_process(data, len, &len);
+
+            /*
+             * Once data is processed, simply skip
+             * the buffer memory and start over
+             */
+            lwesp_buff_skip(&esp.buff, len);
+        }
+#endif /* !LWESP_CFG_IPD_ZERO_COPY */
+    } while (len);
+
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+    /* Let device send again once most of received data are processed */
+    if (esp.flow_rts && !esp.m.ipd.stalled && lwespi_flow_unprocessed() <= LWESP_CFG_INPUT_FLOW_LOW_WATER
+        && lwesp_buff_get_full(&esp.buff) < LWESP_CFG_INPUT_FLOW_HIGH_WATER) {
+        lwespi_flow_rts(0);
+    }
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL */
+    return lwespOK;
+}
+#endif /* !LWESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__ */
+
+#if LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__
+
+/**
+ * \brief           Ask device to stop or continue sending data with \ref lwesp_ll_t.rts_fn
+ * \note            Function is called from input functions and from processing thread.
+ *                  Pin is released before flag is cleared, input functions do not set it in between
+ * \param[in]       stop: Set to `1` to stop device, `0` to let it send again
+ */
+void
+lwespi_flow_rts(uint8_t stop) {
+    if (esp.ll.rts_fn == NULL) {
+        return;
+    }
+    if (stop) {
+        if (!esp.flow_rts) {
+            esp.flow_rts = 1;
+            ++esp.flow_stats.rts_count;
+            esp.ll.rts_fn(1);
+        }
+    } else if (esp.flow_rts) {
+        esp.ll.rts_fn(0);
+        esp.flow_rts = 0;
+
+        /* Input function may have filled buffer while flag was still set */
+        if (lwesp_buff_get_full(&esp.buff) >= LWESP_CFG_INPUT_FLOW_HIGH_WATER) {
+            lwespi_flow_rts(1);
+        }
+    }
+}
+
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__ */
+
+#if LWESP_CFG_IPD_ZERO_COPY || __DOXYGEN__
+
+/**
+ * \brief           Release input buffer region after packet buffer has been freed
+ *
+ * Read pointer of input buffer is advanced up to first region still referenced by
+ * packet buffer or up to processed position if no region is referenced anymore
+ *
+ * \param[in]       ref: Region to release. Set to `NULL` to only release processed data
+ */
+void
+lwespi_buff_ref_release(lwesp_buff_ref_t* ref) {
+    lwesp_buff_ref_t* r;
+    size_t pos;
+
+    if (ref != NULL) {
+        ref->freed = 1;
+    }
+
+    /* Remove all freed regions from the beginning of the list */
+    while (esp.buff_refs_cnt > 0 && esp.buff_refs[esp.buff_refs_r].freed) {
+        if (++esp.buff_refs_r >= LWESP_ARRAYSIZE(esp.buff_refs)) {
+            esp.buff_refs_r = 0;
+        }
+        --esp.buff_refs_cnt;
+    }
+
+    /* Release memory up to first referenced region, but never more than processed */
+    pos = esp.buff_proc_pos;
+    if (esp.buff_refs_cnt > 0) {
+        r = &esp.buff_refs[esp.buff_refs_r];
+        if ((r->pos - esp.buff_rel_pos) < (pos - esp.buff_rel_pos)) {
+            pos = r->pos;
+        }
+    }
+    if (pos != esp.buff_rel_pos) {
+        lwesp_buff_skip(&esp.buff, pos - esp.buff_rel_pos);
+        esp.buff_rel_pos = pos;
+    }
+}
+
+/**
+ * \brief           Reserve input buffer region and create packet buffer for it
+ * \param[in]       pos: Absolute input stream position of region
+ * \param[in]       idx: Index of region in input buffer memory
+ * \param[in]       len: Length of region in units of bytes
+ * \return          Packet buffer on success, `NULL` otherwise
+ */
+static lwesp_pbuf_p
+lwespi_buff_ref_pbuf_new(size_t pos, size_t idx, size_t len) {
+    lwesp_buff_ref_t* ref;
+    lwesp_pbuf_p p;
+    size_t i;
+
+    i = esp.buff_refs_r + esp.buff_refs_cnt;
+    if (i >= LWESP_ARRAYSIZE(esp.buff_refs)) {
+        i -= LWESP_ARRAYSIZE(esp.buff_refs);
+    }
+    ref = &esp.buff_refs[i];
+    ref->payload = &esp.buff.buff[idx];
+    ref->pos = pos;
+    ref->len = len;
+    ref->freed = 0;
+    if ((p = lwespi_pbuf_new_ref(ref)) != NULL) {
+        ++esp.buff_refs_cnt;
+    }
+    return p;
+}
+
+/**
+ * \brief           Create packet buffer referencing +IPD data in input buffer
+ * \param[in]       pos: Absolute input stream position of first data byte
+ * \param[in]       len: Length of data in units of bytes
+ * \return          Packet buffer on success, `NULL` when data must be copied
+ */
+static lwesp_pbuf_p
+lwespi_ipd_buff_new_ref(size_t pos, size_t len) {
+    lwesp_pbuf_p p, p_wrap;
+    size_t idx, seg_len;
+
+    /*
+     * Reference data only when:
+     *
+     *  - Zero-copy is not turned off and
+     *  - There are free regions for both segments and
+     *  - At least half of input buffer stays available for new data
      */
-    if (is_ok || is_error || is_ready) {
-        lwespr_t res = lwespOK;
-        if (esp.msg != NULL) {                  /* Do we have active message? */
-            res = lwespi_process_sub_cmd(esp.msg, &is_ok, &is_error, &is_ready);
-            if (res != lwespCONT) {             /* Shall we continue with next subcommand under this one? */
-                if (is_ok || is_ready) {        /* Check ready or ok status */
-                    res = esp.msg->res = lwespOK;
-                } else {                        /* Or error status */
-                    res = esp.msg->res = res;   /* Set the error status */
-                }
-            } else {
-                ++esp.msg->i;                   /* Number of continue calls */
-            }
+    if (esp.buff_refs_off || esp.buff_refs_cnt + 2 > LWESP_ARRAYSIZE(esp.buff_refs)
+        || (pos - esp.buff_rel_pos) + len > esp.buff.size / 2) {
+        return NULL;
+    }
 
-            /*
-             * When the command is finished,
-             * release synchronization semaphore
-             * from user thread and start with next command
-             */
-            if (res != lwespCONT) {             /* Do we have to continue to wait for command? */
-                lwesp_sys_sem_release(&esp.sem_sync);   /* Release semaphore */
-            }
+    /* Get index of first data byte in input buffer memory */
+    idx = esp.buff.r + (pos - esp.buff_rel_pos);
+    if (idx >= esp.buff.size) {
+        idx -= esp.buff.size;
+    }
+
+    /* Data may wrap around the end of input buffer, use chain of 2 pbufs */
+    seg_len = LWESP_MIN(len, esp.buff.size - idx);
+    p = lwespi_buff_ref_pbuf_new(pos, idx, seg_len);
+    if (p != NULL && seg_len < len) {
+        p_wrap = lwespi_buff_ref_pbuf_new(pos + seg_len, 0, len - seg_len);
+        if (p_wrap != NULL) {
+            lwesp_pbuf_cat(p, p_wrap);
+        } else {
+            lwesp_pbuf_free(p);
+            p = NULL;
         }
     }
+    return p;
 }
 
-#if !LWESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__
+#endif /* LWESP_CFG_IPD_ZERO_COPY || __DOXYGEN__ */
+
 /**
- * \brief           Process data from input buffer
- * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ * \brief           Create new packet buffer for incoming +IPD data
+ * \param[in]       data: Pointer to beginning of data currently being processed
+ * \param[in]       d: Pointer to first data byte for new packet buffer
+ * \param[in]       len: Length of data in units of bytes
+ * \return          Packet buffer on success, `NULL` otherwise
  */
-lwespr_t
-lwespi_process_buffer(void) {
-    void* data;
-    size_t len;
+static lwesp_pbuf_p
+lwespi_ipd_buff_new(const void* data, const uint8_t* d, size_t len) {
+    lwesp_pbuf_p p = NULL;
+
+#if LWESP_CFG_IPD_ZERO_COPY
+    p = lwespi_ipd_buff_new_ref(esp.buff_proc_pos + (size_t)(d - (const uint8_t*)data), len);
+    esp.m.ipd.zc = p != NULL;
+#else /* LWESP_CFG_IPD_ZERO_COPY */
+    LWESP_UNUSED(data);
+    LWESP_UNUSED(d);
+#endif /* !LWESP_CFG_IPD_ZERO_COPY */
+    if (p == NULL) {
+        p = lwesp_pbuf_new(len);                /* Allocate new packet buffer */
+    }
+    if (p != NULL) {
+        lwesp_pbuf_set_ip(p, &esp.m.ipd.ip, esp.m.ipd.port);/* Set IP and port for received data */
+    }
+    return p;
+}
 
-    do {
-        /*
-         * Get length of linear memory in buffer
-         * we can process directly as memory
-         */
-        len = lwesp_buff_get_linear_block_read_length(&esp.buff);
-        if (len > 0) {
-            /*
-             * Get memory address of first element
-             * in linear block of data to process
-             */
-            data = lwesp_buff_get_linear_block_read_address(&esp.buff);
+#if LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__
+
+/**
+ * \brief           Create new packet buffer for connection data or pause processing
+ *
+ * Processing pauses when connection holds more than \ref LWESP_CFG_CONN_RECV_BUDGET bytes
+ * or when packet buffer cannot be allocated. Data stay in input buffer and function
+ * is called again for the same data, until it succeeds or \ref LWESP_CFG_INPUT_FLOW_STALL_TIMEOUT elapses
+ *
+ * \param[in]       conn: Connection to receive data
+ * \param[in]       data: Pointer to beginning of data currently being processed
+ * \param[in]       d: Pointer to first data byte for new packet buffer
+ * \param[in]       len: Length of data in units of bytes
+ * \return          Packet buffer on success, `NULL` when processing pauses (`stalled` flag is set)
+ *                      or when data must be dropped
+ */
+static lwesp_pbuf_p
+lwespi_flow_buff_new(lwesp_conn_p conn, const void* data, const uint8_t* d, size_t len) {
+    lwesp_pbuf_p p = NULL;
+    uint32_t time;
+
+    /* Connection may always receive at least one packet buffer */
+    if (LWESP_CFG_CONN_RECV_BUDGET == 0 || conn->recv_held == 0
+        || conn->recv_held + len <= LWESP_CFG_CONN_RECV_BUDGET) {
+        p = lwespi_ipd_buff_new(data, d, len);
+    }
+    time = lwesp_sys_now();
+    if (p == NULL && !esp.m.ipd.stalled) {
+        esp.m.ipd.stalled = 1;
+        esp.m.ipd.stall_time = time;
+        ++esp.flow_stats.stalls;
+        lwespi_flow_rts(1);
+    } else if (esp.m.ipd.stalled) {
+        time -= esp.m.ipd.stall_time;
+        if (time > esp.flow_stats.stall_time_max) {
+            esp.flow_stats.stall_time_max = time;
+        }
+        if (p != NULL) {
+            esp.flow_stats.stalled_bytes += len;
+            esp.m.ipd.stalled = 0;
+        } else if (time >= LWESP_CFG_INPUT_FLOW_STALL_TIMEOUT) {
+            esp.m.ipd.stalled = 0;              /* Give up, data are dropped */
+        }
+    }
+    return p;
+}
 
-            /* Process actual received data */
-            lwespi_process(data, len);
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL || __DOXYGEN__ */
 
-            /*
-             * Once data is processed, simply skip
-             * the buffer memory and start over
-             */
-            lwesp_buff_skip(&esp.buff, len);
+/**
+ * \brief           Get number of plain characters at the beginning of data
+ *
+ * Data is checked one word at a time. Word with at least one
+ * special character is checked byte by byte
+ *
+ * \param[in]       d: Data to scan
+ * \param[in]       len: Length of data in units of bytes
+ * \return          Number of characters until first non-plain character
+ */
+size_t
+lwespi_scan_plain(const uint8_t* d, size_t len) {
+    size_t i = 0, end, w;
+
+    while (i < len) {
+        if (len - i >= sizeof(w)) {
+            LWESP_MEMCPY(&w, &d[i], sizeof(w)); /* Copy to avoid unaligned access */
+            if (!SCAN_HAS_SPECIAL(w)) {
+                i += sizeof(w);
+                continue;
+            }
+            end = i + sizeof(w);
+        } else {
+            end = len;
         }
-    } while (len);
-    return lwespOK;
+        for (; i < end; ++i) {
+            if (!RECV_IS_PLAIN(d[i])) {
+                return i;
+            }
+        }
+    }
+    return i;
 }
-#endif /* !LWESP_CFG_INPUT_USE_PROCESS || __DOXYGEN__ */
+
+#if LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__
+
+/**
+ * \brief           Send data received in passthrough mode to connection
+ * \param[in]       data: Pointer to beginning of data currently being processed
+ * \param[in]       d: Pointer to first received data byte
+ * \param[in]       len: Length of received data in units of bytes
+ * \return          Number of processed bytes, less than `len` when processing pauses
+ */
+static size_t
+lwespi_passthrough_recv(const void* data, const uint8_t* d, size_t len) {
+    lwesp_conn_t* conn = esp.m.passthrough.conn;
+    lwesp_pbuf_p p;
+    size_t l, len_all = len;
+
+    if (conn == NULL || !conn->status.f.active || conn->status.f.in_closing) {
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+        esp.flow_stats.dropped_bytes += len;
+        esp.m.ipd.stalled = 0;
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL */
+        return len_all;                         /* Ignore data on closed connection */
+    }
+    conn->status.f.data_received = 1;
+    for (; len > 0; d += l, len -= l) {
+        l = LWESP_MIN(len, LWESP_CFG_CONN_MAX_RECV_BUFF_SIZE);
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+        if ((p = lwespi_flow_buff_new(conn, data, d, l)) == NULL) {
+            if (esp.m.ipd.stalled) {
+                return len_all - len;           /* Keep data in input buffer */
+            }
+            esp.flow_stats.dropped_bytes += len;
+            return len_all;
+        }
+#else /* LWESP_CFG_INPUT_FLOW_CONTROL */
+        if ((p = lwespi_ipd_buff_new(data, d, l)) == NULL) {
+            return len_all;
+        }
+#endif /* !LWESP_CFG_INPUT_FLOW_CONTROL */
+        if (!IPD_IS_ZERO_COPY()) {
+            LWESP_MEMCPY(p->payload, d, l);
+        }
+        lwesp_pbuf_set_ip(p, &conn->remote_ip, conn->remote_port);
+        conn->total_recved += l;
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+        conn->recv_held += l;                   /* Before callback, application may confirm data in it */
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL */
+
+        /* Send data buffer to upper layer, user is responsible for packet buffer from now on */
+        esp.evt.type = LWESP_EVT_CONN_RECV;
+        esp.evt.evt.conn_data_recv.buff = p;
+        esp.evt.evt.conn_data_recv.conn = conn;
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+        if (lwespi_send_conn_cb(conn, NULL) == lwespOKIGNOREMORE) {
+            conn->recv_held -= LWESP_MIN(conn->recv_held, l);   /* Application did not keep data */
+        }
+#else /* LWESP_CFG_INPUT_FLOW_CONTROL */
+        lwespi_send_conn_cb(conn, NULL);
+#endif /* !LWESP_CFG_INPUT_FLOW_CONTROL */
+#if LWESP_CFG_CONN_POLL_ADAPTIVE
+        lwespi_conn_activity(conn);
+#endif /* LWESP_CFG_CONN_POLL_ADAPTIVE */
+        lwesp_pbuf_free(p);
+    }
+    return len_all;
+}
+
+#endif /* LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__ */
 
 /**
  * \brief           Process input data received from ESP device
+ *
+ * With \ref LWESP_CFG_INPUT_FLOW_CONTROL, processing may pause before the end of data,
+ * unprocessed data must be passed to function again later
+ *
  * \param[in]       data: Pointer to data to process
  * \param[in]       data_len: Length of data to process in units of bytes
+ * \param[out]      processed: Pointer to output variable to save number of processed bytes.
+ *                      Can be set to `NULL` if not used
  * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
  */
 lwespr_t
-lwespi_process(const void* data, size_t data_len) {
+lwespi_process(const void* data, size_t data_len, size_t* processed) {
     uint8_t ch;
     const uint8_t* d = data;
     size_t d_len = data_len;
     static uint8_t ch_prev1, ch_prev2;
     static lwesp_unicode_t unicode;
 
+    if (processed != NULL) {
+        *processed = data_len;                  /* Data are ignored when device is not available */
+    }
+
     /* Check status if device is available */
     if (!esp.status.f.dev_present) {
         return lwespERRNODEVICE;
     }
 
     while (d_len > 0) {                         /* Read entire set of characters from buffer */
+#if LWESP_CFG_CONN_PASSTHROUGH
+        if (esp.m.passthrough.active) {         /* Data without +IPD header in transparent transmission */
+            size_t len = lwespi_passthrough_recv(data, d, d_len);
+
+            d += len;
+            d_len -= len;
+            break;
+        }
+#endif /* LWESP_CFG_CONN_PASSTHROUGH */
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+        if (esp.m.ipd.buff_pending) {           /* Packet buffer for next +IPD data is not allocated yet */
+            if (esp.m.ipd.conn->status.f.active && !esp.m.ipd.conn->status.f.in_closing) {
+                esp.m.ipd.buff = lwespi_flow_buff_new(esp.m.ipd.conn, data, d,
+                                                      LWESP_MIN(esp.m.ipd.rem_len, LWESP_CFG_CONN_MAX_RECV_BUFF_SIZE));
+                if (esp.m.ipd.buff == NULL && esp.m.ipd.stalled) {
+                    break;                      /* Keep data in input buffer and try again later */
+                }
+            } else {
+                esp.m.ipd.stalled = 0;          /* Connection was closed meanwhile, ignore its data */
+            }
+            esp.m.ipd.buff_pending = 0;
+        }
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL */
         ch = *d;                                /* Get next character */
         ++d;                                    /* Go to next character, must be here as it is used later on */
         --d_len;                                /* Decrease remaining length, must be here as it is decreased later too */
@@ -1070,28 +2192,33 @@ lwespi_process(const void* data, size_t data_len) {
         if (esp.m.ipd.read) {                   /* Do we have to read incoming IPD data? */
             size_t len;
 
-            if (esp.m.ipd.buff != NULL) {       /* Do we have active buffer? */
+            if (esp.m.ipd.buff != NULL && !IPD_IS_ZERO_COPY()) {/* Do we have active buffer? */
                 esp.m.ipd.buff->payload[esp.m.ipd.buff_ptr] = ch;   /* Save data character */
             }
             ++esp.m.ipd.buff_ptr;
             --esp.m.ipd.rem_len;
 
             /* Try to read more data directly from buffer */
-            len = LWESP_MIN(d_len, LWESP_MIN(esp.m.ipd.rem_len, esp.m.ipd.buff != NULL ? (esp.m.ipd.buff->len - esp.m.ipd.buff_ptr) : esp.m.ipd.rem_len));
+            len = LWESP_MIN(d_len, LWESP_MIN(esp.m.ipd.rem_len, esp.m.ipd.buff != NULL ? (esp.m.ipd.buff->tot_len - esp.m.ipd.buff_ptr) : esp.m.ipd.rem_len));
             if (len > 0) {
-                if (esp.m.ipd.buff != NULL) {   /* Is buffer valid? */
+                if (esp.m.ipd.buff != NULL && !IPD_IS_ZERO_COPY()) {/* Is buffer valid? */
                     LWESP_MEMCPY(&esp.m.ipd.buff->payload[esp.m.ipd.buff_ptr], d, len);
                 } else {
-                    /* Simply skip the data in buffer */
+                    /* Simply skip the data in buffer, or data is already in referenced buffer */
                 }
                 d_len -= len;                   /* Decrease effective length */
                 d += len;                       /* Skip remaining length */
                 esp.m.ipd.buff_ptr += len;      /* Forward buffer pointer */
                 esp.m.ipd.rem_len -= len;       /* Decrease remaining length */
             }
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+            if (esp.m.ipd.buff == NULL) {
+                esp.flow_stats.dropped_bytes += 1 + len;
+            }
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL */
 
             /* Did we reach end of buffer or no more data? */
-            if (esp.m.ipd.rem_len == 0 || (esp.m.ipd.buff != NULL && esp.m.ipd.buff_ptr == esp.m.ipd.buff->len)) {
+            if (esp.m.ipd.rem_len == 0 || (esp.m.ipd.buff != NULL && esp.m.ipd.buff_ptr == esp.m.ipd.buff->tot_len)) {
                 lwespr_t res = lwespOK;
 
                 /* Call user callback function with received data */
@@ -1107,7 +2234,18 @@ lwespi_process(const void* data, size_t data_len) {
                     esp.evt.type = LWESP_EVT_CONN_RECV;
                     esp.evt.evt.conn_data_recv.buff = esp.m.ipd.buff;
                     esp.evt.evt.conn_data_recv.conn = esp.m.ipd.conn;
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+                    esp.m.ipd.conn->recv_held += esp.m.ipd.buff->tot_len;   /* Before callback, application may confirm data in it */
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL */
                     res = lwespi_send_conn_cb(esp.m.ipd.conn, NULL);
+#if LWESP_CFG_CONN_POLL_ADAPTIVE
+                    lwespi_conn_activity(esp.m.ipd.conn);
+#endif /* LWESP_CFG_CONN_POLL_ADAPTIVE */
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+                    if (res == lwespOKIGNOREMORE) { /* Application did not keep data */
+                        esp.m.ipd.conn->recv_held -= LWESP_MIN(esp.m.ipd.conn->recv_held, esp.m.ipd.buff->tot_len);
+                    }
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL */
 
                     lwesp_pbuf_free(esp.m.ipd.buff);/* Free packet buffer at this point */
                     if (res == lwespOKIGNOREMORE) { /* We should ignore more data */
@@ -1121,11 +2259,13 @@ lwespi_process(const void* data, size_t data_len) {
                      *  - Connection is not in closing state
                      */
                     if (esp.m.ipd.buff != NULL && esp.m.ipd.rem_len > 0 && !esp.m.ipd.conn->status.f.in_closing) {
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+                        esp.m.ipd.buff = NULL;
+                        esp.m.ipd.buff_pending = 1; /* Allocate new packet buffer before next data byte */
+#else /* LWESP_CFG_INPUT_FLOW_CONTROL */
                         size_t new_len = LWESP_MIN(esp.m.ipd.rem_len, LWESP_CFG_CONN_MAX_RECV_BUFF_SIZE);   /* Calculate new buffer length */
-                        esp.m.ipd.buff = lwesp_pbuf_new(new_len);   /* Allocate new packet buffer */
-                        if (esp.m.ipd.buff != NULL) {
-                            lwesp_pbuf_set_ip(esp.m.ipd.buff, &esp.m.ipd.ip, esp.m.ipd.port);   /* Set IP and port for received data */
-                        }
+                        esp.m.ipd.buff = lwespi_ipd_buff_new(data, d, new_len); /* Allocate new packet buffer */
+#endif /* !LWESP_CFG_INPUT_FLOW_CONTROL */
                     } else {
                         esp.m.ipd.buff = NULL;  /* Reset it */
                     }
@@ -1138,6 +2278,25 @@ lwespi_process(const void* data, size_t data_len) {
                 RECV_RESET();                   /* Reset receive data */
             }
 
+            /*
+             * We are in command mode and character has no special meaning.
+             * Find all plain characters following it and add them to receive buffer at once
+             */
+        } else if (RECV_IS_PLAIN(ch)) {
+            size_t len;
+
+            unicode.t = 1;                      /* Manually set total to 1 */
+            unicode.r = 0;                      /* Reset remaining bytes */
+            RECV_ADD(ch);
+            len = lwespi_scan_plain(d, d_len);
+            if (len > 0) {
+                RECV_ADD_BLOCK(d, len);
+                ch_prev1 = len > 1 ? d[len - 2] : ch;   /* Set as previous characters, saved below */
+                ch = d[len - 1];
+                d += len;
+                d_len -= len;
+            }
+
             /*
              * We are in command mode where we have to process byte by byte
              * Simply check for ASCII and unicode format and process data accordingly
@@ -1174,9 +2333,19 @@ lwespi_process(const void* data, size_t data_len) {
                             RECV_RESET();       /* Reset received object */
 
                             /* Now actually send the data prepared before */
-                            AT_PORT_SEND_WITH_FLUSH(&esp.msg->msg.conn_send.data[esp.msg->msg.conn_send.ptr], esp.msg->msg.conn_send.sent);
+                            lwespi_tcpip_send_data();
                             esp.msg->msg.conn_send.wait_send_ok_err = 1;/* Now we are waiting for "SEND OK" or "SEND ERROR" */
                         }
+#if LWESP_CFG_CONN_PASSTHROUGH
+                    } else if (CMD_IS_CUR(LWESP_CMD_TCPIP_CIPSEND_PASSTHROUGH)) {
+                        if (ch_prev2 == '\r' && ch_prev1 == '\n' && ch == '>') {
+                            RECV_RESET();       /* Reset received object */
+
+                            /* Everything after prompt is connection data */
+                            esp.m.passthrough.active = 1;
+                            lwespi_process_cmd_result(1, 0, 0);
+                        }
+#endif /* LWESP_CFG_CONN_PASSTHROUGH */
                     }
                         /*
                          * Check if "+IPD" statement is in array and now we received colon,
@@ -1185,10 +2354,6 @@ lwespi_process(const void* data, size_t data_len) {
                         if (ch == ':' && RECV_LEN() > 4 && RECV_IDX(0) == '+' && !strncmp(recv_buff.data, "+IPD", 4)) {
                             lwespi_parse_received(&recv_buff);  /* Parse received string */
                             if (esp.m.ipd.read) {   /* Shall we start read procedure? */
-                                size_t len;
-
-                                len = LWESP_MIN(esp.m.ipd.rem_len, LWESP_CFG_CONN_MAX_RECV_BUFF_SIZE);
-
                                 /*
                                  * Read received data in case of:
                                  *
@@ -1196,10 +2361,14 @@ lwespi_process(const void* data, size_t data_len) {
                                  *  - Connection is not in closing mode
                                  */
                                 if (esp.m.ipd.conn->status.f.active && !esp.m.ipd.conn->status.f.in_closing) {
-                                    esp.m.ipd.buff = lwesp_pbuf_new(len);   /* Allocate new packet buffer */
-                                    if (esp.m.ipd.buff != NULL) {
-                                        lwesp_pbuf_set_ip(esp.m.ipd.buff, &esp.m.ipd.ip, esp.m.ipd.port);   /* Set IP and port for received data */
-                                    }
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+                                    esp.m.ipd.buff = NULL;
+                                    esp.m.ipd.buff_pending = 1; /* Allocate packet buffer before first data byte */
+#else /* LWESP_CFG_INPUT_FLOW_CONTROL */
+                                    size_t len = LWESP_MIN(esp.m.ipd.rem_len, LWESP_CFG_CONN_MAX_RECV_BUFF_SIZE);
+
+                                    esp.m.ipd.buff = lwespi_ipd_buff_new(data, d, len); /* Allocate new packet buffer */
+#endif /* !LWESP_CFG_INPUT_FLOW_CONTROL */
                                 } else {
                                     esp.m.ipd.buff = NULL;  /* Ignore reading on closed connection */
                                 }
@@ -1226,6 +2395,9 @@ lwespi_process(const void* data, size_t data_len) {
         ch_prev2 = ch_prev1;                    /* Save previous character as previous previous */
         ch_prev1 = ch;                          /* Set current as previous */
     }
+    if (processed != NULL) {
+        *processed = data_len - d_len;
+    }
     return lwespOK;
 }
 
@@ -1249,6 +2421,149 @@ lwespi_process(const void* data, size_t data_len) {
         }                                     \
     } while (0)
 
+#if LWESP_CFG_AT_PORT_BAUDRATE_AUTO || __DOXYGEN__
+
+/**
+ * \brief           Send AT port baudrate event
+ * \param[in]       res: \ref lwespOK when baudrate from list is used, \ref lwespERR otherwise
+ */
+static void
+lwespi_send_at_baudrate_evt(lwespr_t res) {
+    esp.evt.evt.at_baudrate.baudrate = esp.ll.uart.baudrate;
+    esp.evt.evt.at_baudrate.res = res;
+    lwespi_send_cb(LWESP_EVT_AT_BAUDRATE);
+}
+
+/**
+ * \brief           Get first command of baudrate negotiation in reset sequence
+ * \param[in]       msg: Pointer to current message
+ * \return          Next command to execute
+ */
+static lwesp_cmd_t
+lwespi_get_at_baudrate_first_cmd(lwesp_msg_t* msg) {
+    if (msg->msg.reset.baudrate_idx < LWESP_ARRAYSIZE(at_baudrates)) {
+        msg->msg.reset.baudrate = at_baudrates[msg->msg.reset.baudrate_idx];
+        return LWESP_CMD_UART;
+    }
+
+    /* Device was reset to default baudrate after the last one from list did not work */
+    lwespi_send_at_baudrate_evt(lwespERR);
+    return LWESP_CMD_GMR;
+}
+
+/**
+ * \brief           Get next sub command of baudrate negotiation in reset sequence
+ *
+ * Every baudrate is set with `AT+UART_CUR` and verified with `AT` command.
+ * When verification fails, link may not work in any direction.
+ * Device is reset to default baudrate when reset function is available,
+ * otherwise next baudrate is set at current baudrate and default baudrate is the last one to try
+ *
+ * \param[in]       msg: Pointer to current message
+ * \param[in]       is_ok: Status whether last command result was OK
+ * \return          Next command to execute
+ */
+static lwesp_cmd_t
+lwespi_get_at_baudrate_sub_cmd(lwesp_msg_t* msg, uint8_t is_ok) {
+    uint8_t is_timeout = msg->msg.reset.is_timeout;
+
+    msg->msg.reset.is_timeout = 0;
+    lwesp_timeout_stop(&reset_timeout);         /* Response received or timeout expired */
+    if (CMD_IS_CUR(LWESP_CMD_UART)) {
+        if (is_timeout) {
+            /*
+             * Device changes baudrate after "OK" is sent,
+             * response may be lost when link does not work at new baudrate.
+             * Verification decides if device uses new baudrate
+             */
+            esp.ll.uart.baudrate = msg->msg.reset.baudrate;
+            lwesp_ll_init(&esp.ll);
+        }
+        if (is_ok || is_timeout) {
+            return LWESP_CMD_AT;
+        }
+        /* Device rejected baudrate, link works at current baudrate */
+    } else if (is_ok) {                         /* Link works at new baudrate */
+        lwespi_send_at_baudrate_evt(msg->msg.reset.baudrate_idx < LWESP_ARRAYSIZE(at_baudrates) ? lwespOK : lwespERR);
+        return LWESP_CMD_GMR;
+    } else if (esp.ll.reset_fn != NULL) {
+        ++msg->msg.reset.baudrate_idx;
+        return LWESP_CMD_RESET;                 /* Hardware reset sets default baudrate */
+    }
+
+    /* Try next baudrate */
+    ++msg->msg.reset.baudrate_idx;
+    if (msg->msg.reset.baudrate_idx < LWESP_ARRAYSIZE(at_baudrates)) {
+        msg->msg.reset.baudrate = at_baudrates[msg->msg.reset.baudrate_idx];
+    } else if (msg->msg.reset.baudrate_idx == LWESP_ARRAYSIZE(at_baudrates)) {
+        msg->msg.reset.baudrate = LWESP_CFG_AT_PORT_BAUDRATE;
+    } else {
+        /* Default baudrate does not work either, continue and let reset sequence report the error */
+        esp.ll.uart.baudrate = LWESP_CFG_AT_PORT_BAUDRATE;
+        lwesp_ll_init(&esp.ll);
+        lwespi_send_at_baudrate_evt(lwespERR);
+        return LWESP_CMD_GMR;
+    }
+    return LWESP_CMD_UART;
+}
+
+#endif /* LWESP_CFG_AT_PORT_BAUDRATE_AUTO || __DOXYGEN__ */
+
+#if LWESP_CFG_RESET_WARM || __DOXYGEN__
+
+/**
+ * \brief           Get next sub command of warm start
+ *
+ * When device responds to `AT` command, device information is taken from snapshot
+ * and only connection status is read. Otherwise full reset sequence starts
+ *
+ * \param[in]       msg: Pointer to current message
+ * \param[in]       is_ok: Status whether last command result was OK
+ * \return          Next command to execute
+ */
+static lwesp_cmd_t
+lwespi_get_warm_sub_cmd(lwesp_msg_t* msg, uint8_t is_ok) {
+    const lwesp_warm_snapshot_t* snap = msg->msg.reset.warm;
+
+    if (CMD_IS_CUR(LWESP_CMD_AT)) {
+        msg->msg.reset.is_timeout = 0;
+        lwesp_timeout_stop(&reset_timeout);     /* Response received or timeout expired */
+        if (!is_ok) {
+            msg->msg.reset.warm = NULL;         /* Device is not running, continue with full reset sequence */
+            return LWESP_CMD_RESET;
+        }
+        esp.m.device = snap->device;
+        esp.m.version_at = snap->version_at;
+        esp.m.version_sdk = snap->version_sdk;
+#if LWESP_CFG_MODE_STATION
+        esp.m.sta.ip = snap->sta_ip;
+        esp.m.sta.gw = snap->sta_gw;
+        esp.m.sta.nm = snap->sta_nm;
+        esp.m.sta.mac = snap->sta_mac;
+        esp.m.sta.dhcp = snap->sta_dhcp;
+#endif /* LWESP_CFG_MODE_STATION */
+#if LWESP_CFG_MODE_ACCESS_POINT
+        esp.m.ap.ip = snap->ap_ip;
+        esp.m.ap.gw = snap->ap_gw;
+        esp.m.ap.nm = snap->ap_nm;
+        esp.m.ap.mac = snap->ap_mac;
+        esp.m.ap.dhcp = snap->ap_dhcp;
+#endif /* LWESP_CFG_MODE_ACCESS_POINT */
+        return LWESP_CMD_TCPIP_CIPSTATUS;       /* Read station and connection status */
+    }
+#if LWESP_CFG_MODE_STATION
+    if (esp.m.sta.has_ip) {
+        /* Events are not sent by device again, notify the same way as in case of auto connection */
+        lwespi_send_cb(LWESP_EVT_WIFI_CONNECTED);
+        lwespi_send_cb(LWESP_EVT_WIFI_GOT_IP);
+        lwesp_sta_getip(NULL, NULL, NULL, NULL, NULL, 0);
+    }
+#endif /* LWESP_CFG_MODE_STATION */
+    return LWESP_CMD_IDLE;
+}
+
+#endif /* LWESP_CFG_RESET_WARM || __DOXYGEN__ */
+
 /**
  * \brief           Get next sub command for reset or restore sequence
  * \param[in]       msg: Pointer to current message
@@ -1260,6 +2575,11 @@ lwespi_process(const void* data, size_t data_len) {
 static lwesp_cmd_t
 lwespi_get_reset_sub_cmd(lwesp_msg_t* msg, uint8_t* is_ok, uint8_t* is_error, uint8_t* is_ready) {
     lwesp_cmd_t n_cmd = LWESP_CMD_IDLE;
+#if LWESP_CFG_RESET_WARM
+    if (CMD_IS_DEF(LWESP_CMD_RESET) && msg->msg.reset.warm != NULL) {
+        return lwespi_get_warm_sub_cmd(msg, *is_ok);
+    }
+#endif /* LWESP_CFG_RESET_WARM */
     switch (CMD_GET_CUR()) {
         case LWESP_CMD_RESET:
         case LWESP_CMD_RESTORE:
@@ -1271,8 +2591,17 @@ lwespi_get_reset_sub_cmd(lwesp_msg_t* msg, uint8_t* is_ok, uint8_t* is_error, ui
             break;
         case LWESP_CMD_ATE0:
         case LWESP_CMD_ATE1:
+#if LWESP_CFG_AT_PORT_BAUDRATE_AUTO
+            SET_NEW_CMD(lwespi_get_at_baudrate_first_cmd(msg));
+            break;                              /* Negotiate higher baudrate */
+        case LWESP_CMD_UART:
+        case LWESP_CMD_AT:
+            SET_NEW_CMD(lwespi_get_at_baudrate_sub_cmd(msg, *is_ok));
+            break;
+#else /* LWESP_CFG_AT_PORT_BAUDRATE_AUTO */
             SET_NEW_CMD(LWESP_CMD_GMR);
             break;
+#endif /* !LWESP_CFG_AT_PORT_BAUDRATE_AUTO */
         case LWESP_CMD_GMR:
             SET_NEW_CMD(LWESP_CMD_WIFI_CWMODE);
             break;
@@ -1311,6 +2640,91 @@ lwespi_get_reset_sub_cmd(lwesp_msg_t* msg, uint8_t* is_ok, uint8_t* is_error, ui
     return n_cmd;
 }
 
+#if LWESP_CFG_CMD_PIPELINE || __DOXYGEN__
+
+/**
+ * \brief           Check if sub command of reset or restore sequence can be sent
+ *                  before response of previous sub command is received
+ *
+ * Steps after echo and baudrate setup do not depend on responses of previous steps.
+ * Sequence has single `AT+CIPSTATUS` step, so connection status it clears is not cleared again
+ * before its response is parsed
+ *
+ * \param[in]       cmd: Sub command to check
+ * \return          `1` if sub command can be pipelined, `0` otherwise
+ */
+static uint8_t
+lwespi_reset_is_pipelined(lwesp_cmd_t cmd) {
+    switch (cmd) {
+        case LWESP_CMD_GMR:
+        case LWESP_CMD_WIFI_CWMODE:
+        case LWESP_CMD_WIFI_CWDHCP_GET:
+        case LWESP_CMD_TCPIP_CIPMUX:
+#if LWESP_CFG_MODE_STATION
+        case LWESP_CMD_WIFI_CWLAPOPT:
+        case LWESP_CMD_TCPIP_CIPSTATUS:
+#endif /* LWESP_CFG_MODE_STATION */
+#if LWESP_CFG_MODE_ACCESS_POINT
+        case LWESP_CMD_WIFI_CIPAP_GET:
+        case LWESP_CMD_WIFI_CIPAPMAC_GET:
+#endif /* LWESP_CFG_MODE_ACCESS_POINT */
+        case LWESP_CMD_TCPIP_CIPDINFO:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * \brief           Start current sub command of reset or restore sequence
+ *                  and send following sub commands without waiting for responses
+ *
+ * Up to \ref LWESP_CFG_CMD_PIPELINE_DEPTH sub commands are sent to device at the same time.
+ * Responses come in the same order, sub command that was sent ahead
+ * is not sent again when sequence moves to it
+ *
+ * \param[in]       msg: Reset or restore message, current sub command is set
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+static lwespr_t
+lwespi_reset_start_cmd(lwesp_msg_t* msg) {
+    lwesp_cmd_t cmd = msg->cmd, next;
+    uint8_t is_ok = 1, is_error = 0, is_ready = 0;
+    lwespr_t res = lwespOK;
+
+    if (msg->msg.reset.sent_ahead > 0) {
+        --msg->msg.reset.sent_ahead;            /* Already sent, wait for its response */
+    } else if ((res = msg->fn(msg)) != lwespOK) {
+        return res;
+    }
+#if LWESP_CFG_RESET_WARM
+    if (msg->msg.reset.warm != NULL) {
+        return res;                             /* Warm start depends on response of each step */
+    }
+#endif /* LWESP_CFG_RESET_WARM */
+
+    /* Move to last sub command already sent */
+    for (size_t i = 0; i < msg->msg.reset.sent_ahead; ++i) {
+        msg->cmd = lwespi_get_reset_sub_cmd(msg, &is_ok, &is_error, &is_ready);
+    }
+    while (msg->msg.reset.sent_ahead + 1 < LWESP_CFG_CMD_PIPELINE_DEPTH
+           && lwespi_reset_is_pipelined(msg->cmd)) {
+        next = lwespi_get_reset_sub_cmd(msg, &is_ok, &is_error, &is_ready);
+        if (!lwespi_reset_is_pipelined(next)) {
+            break;
+        }
+        msg->cmd = next;
+        if (msg->fn(msg) != lwespOK) {
+            break;                              /* Send it again when sequence moves to it */
+        }
+        ++msg->msg.reset.sent_ahead;
+    }
+    msg->cmd = cmd;                             /* Responses belong to current sub command first */
+    return res;
+}
+
+#endif /* LWESP_CFG_CMD_PIPELINE || __DOXYGEN__ */
+
 /**
  * \brief           Process current command with known execution status and start another if necessary
  * \param[in]       msg: Pointer to current message
@@ -1447,6 +2861,54 @@ lwespi_process_sub_cmd(lwesp_msg_t* msg, uint8_t* is_ok, uint8_t* is_error, uint
         if (CMD_IS_CUR(LWESP_CMD_WIFI_CWDHCP_SET)) {
             SET_NEW_CMD(LWESP_CMD_WIFI_CWDHCP_GET);
         }
+#if LWESP_CFG_CONN_PASSTHROUGH
+    } else if (CMD_IS_DEF(LWESP_CMD_TCPIP_CIPSEND_PASSTHROUGH)) {
+        /*
+         * Start sequence: CIPMUX=0, CIPSTART, CIPMODE=1, CIPSEND.
+         * On failure, device is restored with CIPMODE=0, CIPCLOSE and CIPMUX=1
+         */
+        if (!msg->msg.conn_start.failed) {
+            if (CMD_IS_CUR(LWESP_CMD_TCPIP_CIPMUX)) {
+                SET_NEW_CMD_COND(LWESP_CMD_TCPIP_CIPSTART, *is_ok);
+            } else if (CMD_IS_CUR(LWESP_CMD_TCPIP_CIPSTART)) {
+                if (*is_ok && msg->msg.conn_start.success) {
+                    esp.m.active_conns |= 1U << msg->msg.conn_start.num;
+                    esp.m.passthrough.conn = &esp.m.conns[msg->msg.conn_start.num];
+                    SET_NEW_CMD(LWESP_CMD_TCPIP_CIPMODE);
+                } else {
+                    msg->msg.conn_start.failed = 1;
+                    SET_NEW_CMD(LWESP_CMD_TCPIP_CIPMUX);
+                }
+            } else if (CMD_IS_CUR(LWESP_CMD_TCPIP_CIPMODE)) {
+                msg->msg.conn_start.failed = !*is_ok;
+                SET_NEW_CMD(*is_ok ? LWESP_CMD_TCPIP_CIPSEND_PASSTHROUGH : LWESP_CMD_TCPIP_CIPCLOSE);
+            } else if (CMD_IS_CUR(LWESP_CMD_TCPIP_CIPSEND_PASSTHROUGH) && !*is_ok) {
+                msg->msg.conn_start.failed = 1;
+                SET_NEW_CMD(LWESP_CMD_TCPIP_CIPMODE);
+            }
+        } else {
+            if (CMD_IS_CUR(LWESP_CMD_TCPIP_CIPMODE)) {
+                SET_NEW_CMD(LWESP_CMD_TCPIP_CIPCLOSE);
+            } else if (CMD_IS_CUR(LWESP_CMD_TCPIP_CIPCLOSE)) {
+                SET_NEW_CMD(LWESP_CMD_TCPIP_CIPMUX);
+            } else {
+                lwespi_passthrough_close();
+                *is_ok = 0;                     /* Start failed even if device is restored */
+                *is_error = 1;
+            }
+        }
+    } else if (CMD_IS_DEF(LWESP_CMD_TCPIP_PASSTHROUGH_EXIT)) {
+        /* Stop sequence: +++, CIPMODE=0, CIPCLOSE, CIPMUX=1. Result is set by last command */
+        if (CMD_IS_CUR(LWESP_CMD_TCPIP_PASSTHROUGH_EXIT)) {
+            SET_NEW_CMD(LWESP_CMD_TCPIP_CIPMODE);
+        } else if (CMD_IS_CUR(LWESP_CMD_TCPIP_CIPMODE)) {
+            SET_NEW_CMD(LWESP_CMD_TCPIP_CIPCLOSE);
+        } else if (CMD_IS_CUR(LWESP_CMD_TCPIP_CIPCLOSE)) {
+            SET_NEW_CMD(LWESP_CMD_TCPIP_CIPMUX);
+        } else if (CMD_IS_CUR(LWESP_CMD_TCPIP_CIPMUX)) {
+            lwespi_passthrough_close();
+        }
+#endif /* LWESP_CFG_CONN_PASSTHROUGH */
     }
 
     /* Are we enabling server mode for some reason? */
@@ -1476,7 +2938,16 @@ lwespi_process_sub_cmd(lwesp_msg_t* msg, uint8_t* is_ok, uint8_t* is_error, uint
     if (n_cmd != LWESP_CMD_IDLE) {
         lwespr_t res;
         msg->cmd = n_cmd;
+#if LWESP_CFG_CMD_PIPELINE
+        if (CMD_IS_DEF(LWESP_CMD_RESET) || CMD_IS_DEF(LWESP_CMD_RESTORE)) {
+            res = lwespi_reset_start_cmd(msg);  /* Sub command may be already sent */
+        } else {
+            res = msg->fn(msg);
+        }
+        if (res == lwespOK) {
+#else /* LWESP_CFG_CMD_PIPELINE */
         if ((res = msg->fn(msg)) == lwespOK) {
+#endif /* !LWESP_CFG_CMD_PIPELINE */
             return lwespCONT;
         } else {
             *is_ok = 0;
@@ -1497,6 +2968,13 @@ lwespi_process_sub_cmd(lwesp_msg_t* msg, uint8_t* is_ok, uint8_t* is_error, uint
  */
 lwespr_t
 lwespi_initiate_cmd(lwesp_msg_t* msg) {
+#if LWESP_CFG_CONN_PASSTHROUGH
+    /* Device accepts only data and exit sequence in transparent transmission */
+    if (esp.m.passthrough.active && !CMD_IS_CUR(LWESP_CMD_TCPIP_CIPSEND)
+        && !CMD_IS_CUR(LWESP_CMD_TCPIP_PASSTHROUGH_EXIT)) {
+        return lwespERR;
+    }
+#endif /* LWESP_CFG_CONN_PASSTHROUGH */
     switch (CMD_GET_CUR()) {                    /* Check current message we want to send over AT */
         case LWESP_CMD_RESET: {                 /* Reset MCU with AT commands */
             /* Try hardware reset first */
@@ -1530,11 +3008,41 @@ lwespi_initiate_cmd(lwesp_msg_t* msg) {
             AT_PORT_SEND_COMMAND("+GMR");
             break;
         }
+#if LWESP_CFG_AT_PORT_BAUDRATE_AUTO || LWESP_CFG_RESET_WARM
+        case LWESP_CMD_AT: {                    /* Verify AT port after baudrate change or in warm start */
+            uint32_t timeout = 0;
+#if LWESP_CFG_RESET_WARM
+            if (msg->msg.reset.warm != NULL) {
+                esp.ll.uart.baudrate = msg->msg.reset.warm->baudrate;   /* Device still uses baudrate from snapshot */
+                lwesp_ll_init(&esp.ll);
+                timeout = LWESP_CFG_RESET_WARM_TIMEOUT;
+            }
+#endif /* LWESP_CFG_RESET_WARM */
+#if LWESP_CFG_AT_PORT_BAUDRATE_AUTO
+            if (timeout == 0) {
+                timeout = LWESP_CFG_AT_PORT_BAUDRATE_TIMEOUT;
+            }
+#endif /* LWESP_CFG_AT_PORT_BAUDRATE_AUTO */
+            lwesp_timeout_start(&reset_timeout, timeout, lwespi_reset_timeout_fn, msg);
+            AT_PORT_SEND_COMMAND("");
+            break;
+        }
+#endif /* LWESP_CFG_AT_PORT_BAUDRATE_AUTO || LWESP_CFG_RESET_WARM */
         case LWESP_CMD_UART: {                  /* Change UART parameters for AT port */
+#if LWESP_CFG_AT_PORT_BAUDRATE_AUTO
+            if (CMD_IS_DEF(LWESP_CMD_RESET) || CMD_IS_DEF(LWESP_CMD_RESTORE)) {
+                lwesp_timeout_start(&reset_timeout, LWESP_CFG_AT_PORT_BAUDRATE_TIMEOUT, lwespi_reset_timeout_fn, msg);
+            }
+#endif /* LWESP_CFG_AT_PORT_BAUDRATE_AUTO */
             AT_PORT_SEND_BEGIN_AT();
             AT_PORT_SEND_CONST_STR("+UART_CUR=");
-            lwespi_send_number(LWESP_U32(msg->msg.uart.baudrate), 0, 0);
+            lwespi_send_number(LWESP_U32(lwespi_get_uart_baudrate(msg)), 0, 0);
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+            /* Device stops sending on its CTS pin, driven by RTS function */
+            AT_PORT_SEND_CONST_STR(esp.ll.rts_fn != NULL ? ",8,1,0,2" : ",8,1,0,0");
+#else /* LWESP_CFG_INPUT_FLOW_CONTROL */
             AT_PORT_SEND_CONST_STR(",8,1,0,0");
+#endif /* !LWESP_CFG_INPUT_FLOW_CONTROL */
             AT_PORT_SEND_END_AT();
             break;
         }
@@ -1843,6 +3351,7 @@ lwespi_initiate_cmd(lwesp_msg_t* msg) {
 #if LWESP_CFG_MODE_STATION
         case LWESP_CMD_TCPIP_CIPSTART: {        /* Start a new connection */
             lwesp_conn_t* c = NULL;
+            uint8_t single = 0;
 
             /* Do we have wifi connection? */
             if (!lwesp_sta_has_ip()) {
@@ -1860,6 +3369,14 @@ lwespi_initiate_cmd(lwesp_msg_t* msg) {
                     break;
                 }
             }
+#if LWESP_CFG_CONN_PASSTHROUGH
+            if (CMD_IS_DEF(LWESP_CMD_TCPIP_CIPSEND_PASSTHROUGH)) {
+                single = 1;                     /* Single connection mode always uses first connection */
+                c = &esp.m.conns[0];
+                c->num = 0;
+                msg->msg.conn_start.num = 0;
+            }
+#endif /* LWESP_CFG_CONN_PASSTHROUGH */
             if (c == NULL) {
                 lwespi_send_conn_error_cb(msg, lwespERRNOFREECONN);
                 return lwespERRNOFREECONN;      /* We don't have available connection */
@@ -1871,13 +3388,15 @@ lwespi_initiate_cmd(lwesp_msg_t* msg) {
 
             AT_PORT_SEND_BEGIN_AT();
             AT_PORT_SEND_CONST_STR("+CIPSTART=");
-            lwespi_send_number(LWESP_U32(c->num), 0, 0);
+            if (!single) {                      /* Link ID is not used in single connection mode */
+                lwespi_send_number(LWESP_U32(c->num), 0, 0);
+            }
             if (msg->msg.conn_start.type == LWESP_CONN_TYPE_SSL) {
-                lwespi_send_string("SSL", 0, 1, 1);
+                lwespi_send_string("SSL", 0, 1, !single);
             } else if (msg->msg.conn_start.type == LWESP_CONN_TYPE_TCP) {
-                lwespi_send_string("TCP", 0, 1, 1);
+                lwespi_send_string("TCP", 0, 1, !single);
             } else if (msg->msg.conn_start.type == LWESP_CONN_TYPE_UDP) {
-                lwespi_send_string("UDP", 0, 1, 1);
+                lwespi_send_string("UDP", 0, 1, !single);
             }
             lwespi_send_string(msg->msg.conn_start.remote_host, 0, 1, 1);
             lwespi_send_port(msg->msg.conn_start.remote_port, 0, 1);
@@ -1902,7 +3421,14 @@ lwespi_initiate_cmd(lwesp_msg_t* msg) {
 #endif /* LWESP_CFG_MODE_STATION */
 
         case LWESP_CMD_TCPIP_CIPCLOSE: {        /* Close the connection */
-            lwesp_conn_p c = msg->msg.conn_close.conn;
+            lwesp_conn_p c;
+#if LWESP_CFG_CONN_PASSTHROUGH
+            if (CMD_IS_DEF(LWESP_CMD_TCPIP_CIPSEND_PASSTHROUGH) || CMD_IS_DEF(LWESP_CMD_TCPIP_PASSTHROUGH_EXIT)) {
+                AT_PORT_SEND_COMMAND("+CIPCLOSE");  /* Single connection mode */
+                break;
+            }
+#endif /* LWESP_CFG_CONN_PASSTHROUGH */
+            c = msg->msg.conn_close.conn;
             if (c != NULL &&
                 /*
                  * Is connection already closed or command
@@ -1918,6 +3444,11 @@ lwespi_initiate_cmd(lwesp_msg_t* msg) {
             break;
         }
         case LWESP_CMD_TCPIP_CIPSEND: {         /* Send data to connection */
+#if LWESP_CFG_CONN_PASSTHROUGH
+            if (esp.m.passthrough.active) {
+                return lwespi_passthrough_send_data();
+            }
+#endif /* LWESP_CFG_CONN_PASSTHROUGH */
             return lwespi_tcpip_process_send_data();/* Process send data */
         }
         case LWESP_CMD_TCPIP_CIPSTATUS: {       /* Get status of device and all connections */
@@ -1931,9 +3462,43 @@ lwespi_initiate_cmd(lwesp_msg_t* msg) {
             break;
         }
         case LWESP_CMD_TCPIP_CIPMUX: {          /* Set multiple connections */
+#if LWESP_CFG_CONN_PASSTHROUGH
+            if (CMD_IS_DEF(LWESP_CMD_TCPIP_CIPSEND_PASSTHROUGH) && !msg->msg.conn_start.failed) {
+                /* Single connection mode is allowed only when no connection is active */
+                for (size_t i = 0; i < LWESP_CFG_MAX_CONNS; ++i) {
+                    if (esp.m.conns[i].status.f.active) {
+                        return lwespERR;
+                    }
+                }
+                AT_PORT_SEND_COMMAND("+CIPMUX=0");
+                break;
+            }
+#endif /* LWESP_CFG_CONN_PASSTHROUGH */
             AT_PORT_SEND_COMMAND("+CIPMUX=1");
             break;
         }
+#if LWESP_CFG_CONN_PASSTHROUGH
+        case LWESP_CMD_TCPIP_CIPMODE: {         /* Set transparent or normal transmission */
+            if (CMD_IS_DEF(LWESP_CMD_TCPIP_CIPSEND_PASSTHROUGH) && !msg->msg.conn_start.failed) {
+                AT_PORT_SEND_COMMAND("+CIPMODE=1");
+            } else {
+                AT_PORT_SEND_COMMAND("+CIPMODE=0");
+            }
+            break;
+        }
+        case LWESP_CMD_TCPIP_CIPSEND_PASSTHROUGH: { /* Start transparent transmission */
+            AT_PORT_SEND_COMMAND("+CIPSEND");
+            break;
+        }
+        case LWESP_CMD_TCPIP_PASSTHROUGH_EXIT: {/* Exit transparent transmission */
+            if (esp.m.passthrough.conn == NULL) {
+                return lwespERR;                /* Session is not started */
+            }
+            msg->msg.passthrough_stop.exit_sent = 0;
+            lwesp_timeout_start(&passthrough_timeout, LWESP_CFG_CONN_PASSTHROUGH_GUARD_TIME, lwespi_passthrough_exit_fn, msg);
+            break;
+        }
+#endif /* LWESP_CFG_CONN_PASSTHROUGH */
         case LWESP_CMD_TCPIP_CIPSSLSIZE: {      /* Set SSL size */
             AT_PORT_SEND_BEGIN_AT();
             AT_PORT_SEND_CONST_STR("+CIPSSLSIZE=");
@@ -2064,6 +3629,10 @@ lwespi_send_msg_to_producer_mbox(lwesp_msg_t* msg, lwespr_t (*process_fn)(lwesp_
     }
     msg->block_time = max_block_time;           /* Set blocking status if necessary */
     msg->fn = process_fn;                       /* Save processing function to be called as callback */
+#if LWESP_CFG_STATS
+    msg->stats_time = lwesp_sys_now();          /* Start of time in producer queue */
+    msg->stats_queued_us = lwesp_sys_now_us();
+#endif /* LWESP_CFG_STATS */
     if (msg->is_blocking) {
         lwesp_sys_mbox_put(&esp.mbox_producer, msg);/* Write message to producer queue and wait forever */
     } else {
@@ -2163,3 +3732,109 @@ lwespi_process_events_for_timeout_or_error(lwesp_msg_t* msg, lwespr_t err) {
             break;
     }
 }
+
+#if LWESP_CFG_STATS || LWESP_CFG_TRACE
+
+/**
+ * \brief           Names of commands, indexed by command type
+ */
+static const char* const
+cmd_names[LWESP_CMD_END] = {
+    [LWESP_CMD_IDLE] = "IDLE",
+    [LWESP_CMD_RESET] = "RESET",
+    [LWESP_CMD_ATE0] = "ATE0",
+    [LWESP_CMD_ATE1] = "ATE1",
+#if LWESP_CFG_AT_PORT_BAUDRATE_AUTO || LWESP_CFG_RESET_WARM
+    [LWESP_CMD_AT] = "AT",
+#endif /* LWESP_CFG_AT_PORT_BAUDRATE_AUTO || LWESP_CFG_RESET_WARM */
+    [LWESP_CMD_GMR] = "GMR",
+    [LWESP_CMD_GSLP] = "GSLP",
+    [LWESP_CMD_RESTORE] = "RESTORE",
+    [LWESP_CMD_UART] = "UART",
+    [LWESP_CMD_SLEEP] = "SLEEP",
+    [LWESP_CMD_WAKEUPGPIO] = "WAKEUPGPIO",
+    [LWESP_CMD_RFPOWER] = "RFPOWER",
+    [LWESP_CMD_RFVDD] = "RFVDD",
+    [LWESP_CMD_RFAUTOTRACE] = "RFAUTOTRACE",
+    [LWESP_CMD_SYSRAM] = "SYSRAM",
+    [LWESP_CMD_SYSADC] = "SYSADC",
+    [LWESP_CMD_WIFI_CWMODE] = "CWMODE",
+    [LWESP_CMD_WIFI_CWMODE_GET] = "CWMODE_GET",
+    [LWESP_CMD_WIFI_CWLAPOPT] = "CWLAPOPT",
+#if LWESP_CFG_MODE_STATION || __DOXYGEN__
+    [LWESP_CMD_WIFI_CWJAP] = "CWJAP",
+    [LWESP_CMD_WIFI_CWJAP_GET] = "CWJAP_GET",
+    [LWESP_CMD_WIFI_CWQAP] = "CWQAP",
+    [LWESP_CMD_WIFI_CWLAP] = "CWLAP",
+    [LWESP_CMD_WIFI_CIPSTAMAC_GET] = "CIPSTAMAC_GET",
+    [LWESP_CMD_WIFI_CIPSTAMAC_SET] = "CIPSTAMAC_SET",
+    [LWESP_CMD_WIFI_CIPSTA_GET] = "CIPSTA_GET",
+    [LWESP_CMD_WIFI_CIPSTA_SET] = "CIPSTA_SET",
+    [LWESP_CMD_WIFI_CWAUTOCONN] = "CWAUTOCONN",
+#endif /* LWESP_CFG_MODE_STATION || __DOXYGEN__ */
+    [LWESP_CMD_WIFI_CWDHCP_SET] = "CWDHCP_SET",
+    [LWESP_CMD_WIFI_CWDHCP_GET] = "CWDHCP_GET",
+    [LWESP_CMD_WIFI_CWDHCPS_SET] = "CWDHCPS_SET",
+    [LWESP_CMD_WIFI_CWDHCPS_GET] = "CWDHCPS_GET",
+#if LWESP_CFG_MODE_ACCESS_POINT || __DOXYGEN__
+    [LWESP_CMD_WIFI_CWSAP_GET] = "CWSAP_GET",
+    [LWESP_CMD_WIFI_CWSAP_SET] = "CWSAP_SET",
+    [LWESP_CMD_WIFI_CIPAPMAC_GET] = "CIPAPMAC_GET",
+    [LWESP_CMD_WIFI_CIPAPMAC_SET] = "CIPAPMAC_SET",
+    [LWESP_CMD_WIFI_CIPAP_GET] = "CIPAP_GET",
+    [LWESP_CMD_WIFI_CIPAP_SET] = "CIPAP_SET",
+    [LWESP_CMD_WIFI_CWLIF] = "CWLIF",
+    [LWESP_CMD_WIFI_CWQIF] = "CWQIF",
+#endif /* LWESP_CFG_MODE_ACCESS_POINT || __DOXYGEN__ */
+#if LWESP_CFG_WPS || __DOXYGEN__
+    [LWESP_CMD_WIFI_WPS] = "WPS",
+#endif /* LWESP_CFG_WPS || __DOXYGEN__ */
+#if LWESP_CFG_MDNS || __DOXYGEN__
+    [LWESP_CMD_WIFI_MDNS] = "MDNS",
+#endif /* LWESP_CFG_MDNS || __DOXYGEN__ */
+#if LWESP_CFG_HOSTNAME || __DOXYGEN__
+    [LWESP_CMD_WIFI_CWHOSTNAME_SET] = "CWHOSTNAME_SET",
+    [LWESP_CMD_WIFI_CWHOSTNAME_GET] = "CWHOSTNAME_GET",
+#endif /* LWESP_CFG_HOSTNAME || __DOXYGEN__ */
+#if LWESP_CFG_DNS || __DOXYGEN__
+    [LWESP_CMD_TCPIP_CIPDOMAIN] = "CIPDOMAIN",
+    [LWESP_CMD_TCPIP_CIPDNS_SET] = "CIPDNS_SET",
+    [LWESP_CMD_TCPIP_CIPDNS_GET] = "CIPDNS_GET",
+#endif /* LWESP_CFG_DNS || __DOXYGEN__ */
+    [LWESP_CMD_TCPIP_CIPSTATUS] = "CIPSTATUS",
+    [LWESP_CMD_TCPIP_CIPSTART] = "CIPSTART",
+    [LWESP_CMD_TCPIP_CIPSEND] = "CIPSEND",
+    [LWESP_CMD_TCPIP_CIPCLOSE] = "CIPCLOSE",
+    [LWESP_CMD_TCPIP_CIPSSLSIZE] = "CIPSSLSIZE",
+    [LWESP_CMD_TCPIP_CIPSSLCCONF] = "CIPSSLCCONF",
+    [LWESP_CMD_TCPIP_CIFSR] = "CIFSR",
+    [LWESP_CMD_TCPIP_CIPMUX] = "CIPMUX",
+    [LWESP_CMD_TCPIP_CIPSERVER] = "CIPSERVER",
+    [LWESP_CMD_TCPIP_CIPSERVERMAXCONN] = "CIPSERVERMAXCONN",
+    [LWESP_CMD_TCPIP_CIPMODE] = "CIPMODE",
+#if LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__
+    [LWESP_CMD_TCPIP_CIPSEND_PASSTHROUGH] = "CIPSEND_PASSTHROUGH",
+    [LWESP_CMD_TCPIP_PASSTHROUGH_EXIT] = "PASSTHROUGH_EXIT",
+#endif /* LWESP_CFG_CONN_PASSTHROUGH || __DOXYGEN__ */
+    [LWESP_CMD_TCPIP_CIPSTO] = "CIPSTO",
+    [LWESP_CMD_TCPIP_CIUPDATE] = "CIUPDATE",
+    [LWESP_CMD_TCPIP_CIPDINFO] = "CIPDINFO",
+#if LWESP_CFG_PING || __DOXYGEN__
+    [LWESP_CMD_TCPIP_PING] = "PING",
+#endif /* LWESP_CFG_PING || __DOXYGEN__ */
+};
+
+/**
+ * \brief           Get name of command
+ * \param[in]       cmd: Command type
+ * \return          Name of command without `AT+` prefix, `NULL` if command type is not valid
+ */
+const char*
+lwespi_cmd_name(size_t cmd) {
+    if (cmd >= LWESP_ARRAYSIZE(cmd_names)) {
+        return NULL;
+    }
+    return cmd_names[cmd];
+}
+
+#endif /* LWESP_CFG_STATS || LWESP_CFG_TRACE */
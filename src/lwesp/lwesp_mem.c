@@ -37,17 +37,365 @@
  *
  *   - Remove debug message
  *   - Add lwesp_mem_free_unchecked function
+ *   - Add two-level segregated fit allocator
+ *   - Add memory statistics and allocation tags
+ *   - Fix available bytes when allocated block is not split
  */
 #include <limits.h>
+#include <stddef.h>
 #include "lwesp/lwesp_private.h"
 #include "lwesp/lwesp_mem.h"
 
 #if !LWESP_CFG_MEM_CUSTOM || __DOXYGEN__
 
+#if LWESP_CFG_MEM_TLSF
+
+/*
+ * Two-level segregated fit allocator
+ *
+ * Free blocks are kept in lists, one list per size class.
+ * First level splits sizes by power of 2, second level splits each
+ * first level range to `MEM_SL_COUNT` linear ranges. Bitmaps of non-empty lists
+ * allow to find suitable free block without walking the lists.
+ */
+
+#if !__DOXYGEN__
+typedef struct mem_block {
+    struct mem_block* prev_phys;                /*!< Previous block in memory, `NULL` for first block in region */
+    size_t size;                                /*!< Size of block including metadata, lower bits are flags */
+#if LWESP_CFG_MEM_STATS
+    uint8_t tag;                                /*!< Tag of allocated block */
+#endif /* LWESP_CFG_MEM_STATS */
+    struct mem_block* next_free;                /*!< Next free block in the same list, valid only for free blocks */
+    struct mem_block* prev_free;                /*!< Previous free block in the same list, valid only for free blocks */
+} mem_block_t;
+#endif /* !__DOXYGEN__ */
+
+/**
+ * \brief           Memory alignment bits and absolute number
+ */
+#define MEM_ALIGN_BITS              LWESP_SZ(LWESP_CFG_MEM_ALIGNMENT - 1)
+#define MEM_ALIGN_NUM               LWESP_SZ(LWESP_CFG_MEM_ALIGNMENT)
+#define MEM_ALIGN(x)                LWESP_MEM_ALIGN(x)
+#define MEM_ALIGN_LOG2              (LWESP_CFG_MEM_ALIGNMENT >= 16 ? 4 : LWESP_CFG_MEM_ALIGNMENT >= 8 ? 3 : LWESP_CFG_MEM_ALIGNMENT >= 4 ? 2 : LWESP_CFG_MEM_ALIGNMENT >= 2 ? 1 : 0)
+
+/* Only previous block and size are used in allocated block, free list pointers overlap user memory */
+#define MEMBLOCK_METASIZE           MEM_ALIGN(offsetof(mem_block_t, next_free))
+#define MEMBLOCK_MINSIZE            MEM_ALIGN(sizeof(mem_block_t))
+
+#define MEM_BLOCK_FREE_BIT          ((size_t)0x01)
+#define MEM_BLOCK_SIZE(b)           ((b)->size & ~MEM_ALIGN_BITS)
+#define MEM_BLOCK_IS_FREE(b)        ((b)->size & MEM_BLOCK_FREE_BIT)
+#define MEM_BLOCK_NEXT_PHYS(b)      ((mem_block_t *)((uint8_t *)(b) + MEM_BLOCK_SIZE(b)))
+#define MEM_BLOCK_FROM_PTR(ptr)     ((mem_block_t *)(((uint8_t *)(ptr)) - MEMBLOCK_METASIZE))
+#define MEM_BLOCK_USER_SIZE(ptr)    (MEM_BLOCK_SIZE(MEM_BLOCK_FROM_PTR(ptr)) - MEMBLOCK_METASIZE)
+
+/* Size class configuration */
+#define MEM_SL_LOG2                 4
+#define MEM_SL_COUNT                (1 << MEM_SL_LOG2)
+#define MEM_FL_SHIFT                (MEM_SL_LOG2 + MEM_ALIGN_LOG2)
+#define MEM_FL_MAX_LOG2             (sizeof(size_t) >= 4 ? 30 : 15)
+#define MEM_FL_COUNT                (MEM_FL_MAX_LOG2 - MEM_FL_SHIFT + 2)
+#define MEM_SMALL_BLOCK             ((size_t)1 << MEM_FL_SHIFT)
+#define MEM_MAX_BLOCK               ((size_t)1 << MEM_FL_MAX_LOG2)
+
+static mem_block_t* free_lists[MEM_FL_COUNT][MEM_SL_COUNT]; /*!< Lists of free blocks for each size class */
+static uint32_t fl_bitmap;                      /*!< Bitmap of first level classes with free blocks */
+static uint32_t sl_bitmap[MEM_FL_COUNT];        /*!< Bitmaps of second level classes with free blocks */
+static uint8_t mem_initialized;                 /*!< Set to `1` when regions are assigned */
+static size_t mem_available_bytes;              /*!< Number of available bytes for allocations */
+
+/**
+ * \brief           Get position of most significant set bit
+ * \param[in]       x: Value to check, must not be `0`
+ * \return          Bit position
+ */
+static uint8_t
+mem_fls(size_t x) {
+#if defined(__GNUC__)
+    return (uint8_t)(sizeof(unsigned long) * CHAR_BIT - 1 - __builtin_clzl((unsigned long)x));
+#else /* defined(__GNUC__) */
+    uint8_t i = 0;
+    while (x >>= 1) {
+        ++i;
+    }
+    return i;
+#endif /* !defined(__GNUC__) */
+}
+
+/**
+ * \brief           Get position of least significant set bit
+ * \param[in]       x: Value to check, must not be `0`
+ * \return          Bit position
+ */
+static uint8_t
+mem_ffs(uint32_t x) {
+#if defined(__GNUC__)
+    return (uint8_t)__builtin_ctzl((unsigned long)x);
+#else /* defined(__GNUC__) */
+    uint8_t i = 0;
+    for (; !(x & 0x01); x >>= 1) {
+        ++i;
+    }
+    return i;
+#endif /* !defined(__GNUC__) */
+}
+
+/**
+ * \brief           Get size class of block size
+ * \param[in]       size: Block size in units of bytes
+ * \param[out]      fl: First level index
+ * \param[out]      sl: Second level index
+ */
+static void
+mem_mapping(size_t size, uint8_t* fl, uint8_t* sl) {
+    uint8_t f;
+
+    if (size < MEM_SMALL_BLOCK) {
+        *fl = 0;
+        *sl = (uint8_t)(size / (MEM_SMALL_BLOCK / MEM_SL_COUNT));
+    } else {
+        f = mem_fls(size);
+        *sl = (uint8_t)((size >> (f - MEM_SL_LOG2)) ^ MEM_SL_COUNT);
+        *fl = (uint8_t)(f - (MEM_FL_SHIFT - 1));
+    }
+}
+
+/**
+ * \brief           Insert free block to list of its size class
+ * \param[in]       b: Block to insert
+ */
+static void
+mem_insertfreeblock(mem_block_t* b) {
+    uint8_t fl, sl;
+
+    mem_mapping(MEM_BLOCK_SIZE(b), &fl, &sl);
+    b->prev_free = NULL;
+    b->next_free = free_lists[fl][sl];
+    if (b->next_free != NULL) {
+        b->next_free->prev_free = b;
+    }
+    free_lists[fl][sl] = b;
+    fl_bitmap |= (uint32_t)1 << fl;
+    sl_bitmap[fl] |= (uint32_t)1 << sl;
+}
+
+/**
+ * \brief           Remove free block from list of its size class
+ * \param[in]       b: Block to remove
+ */
+static void
+mem_removefreeblock(mem_block_t* b) {
+    uint8_t fl, sl;
+
+    mem_mapping(MEM_BLOCK_SIZE(b), &fl, &sl);
+    if (b->next_free != NULL) {
+        b->next_free->prev_free = b->prev_free;
+    }
+    if (b->prev_free != NULL) {
+        b->prev_free->next_free = b->next_free;
+    } else {
+        free_lists[fl][sl] = b->next_free;
+        if (free_lists[fl][sl] == NULL) {       /* List is now empty */
+            sl_bitmap[fl] &= ~((uint32_t)1 << sl);
+            if (sl_bitmap[fl] == 0) {
+                fl_bitmap &= ~((uint32_t)1 << fl);
+            }
+        }
+    }
+}
+
+/**
+ * \brief           Assign memory for HEAP allocations
+ * \param[in]       regions: Pointer to list of regions.
+ *                  Set regions in ascending order by address
+ * \param[in]       len: Number of regions to assign
+ */
+static uint8_t
+mem_assignmem(const lwesp_mem_region_t* regions, size_t len) {
+    uint8_t* mem_start_addr;
+    size_t mem_size;
+    mem_block_t* first_block, *last_block;
+
+    if (mem_initialized) {                      /* Regions already defined */
+        return 0;
+    }
+
+    /* Check if region address are linear and rising */
+    mem_start_addr = (uint8_t*)0;
+    for (size_t i = 0; i < len; ++i) {
+        if (mem_start_addr >= (uint8_t*)regions[i].start_addr) {/* Check if previous greater than current */
+            return 0;                           /* Return as invalid and failed */
+        }
+        mem_start_addr = (uint8_t*)regions[i].start_addr;   /* Save as previous address */
+    }
+
+    for (; len > 0; --len, ++regions) {
+        /* Get aligned start address and size */
+        mem_size = regions->size;
+        mem_start_addr = (uint8_t*)regions->start_addr;
+        if (LWESP_SZ(mem_start_addr) & MEM_ALIGN_BITS) {
+            if (mem_size < MEM_ALIGN_NUM) {
+                continue;
+            }
+            mem_start_addr += MEM_ALIGN_NUM - (LWESP_SZ(mem_start_addr) & MEM_ALIGN_BITS);
+            mem_size -= mem_start_addr - (uint8_t*)regions->start_addr;
+        }
+        mem_size &= ~MEM_ALIGN_BITS;
+
+        /* Check minimum region size, for free block and last empty block */
+        if (mem_size < (MEMBLOCK_MINSIZE + MEMBLOCK_METASIZE)) {
+            continue;
+        }
+
+        /* Block size must fit to size classes */
+        mem_size = LWESP_MIN(mem_size, MEM_MAX_BLOCK);
+
+        /*
+         * Region consists of one free block and
+         * last empty block, marked as allocated to stop merging
+         */
+        first_block = (mem_block_t*)mem_start_addr;
+        first_block->prev_phys = NULL;
+        first_block->size = (mem_size - MEMBLOCK_METASIZE) | MEM_BLOCK_FREE_BIT;
+
+        last_block = MEM_BLOCK_NEXT_PHYS(first_block);
+        last_block->prev_phys = first_block;
+        last_block->size = 0;
+
+        mem_insertfreeblock(first_block);
+        mem_available_bytes += MEM_BLOCK_SIZE(first_block);
+        mem_initialized = 1;
+    }
+
+    return mem_initialized;                     /* Regions set as expected */
+}
+
+/**
+ * \brief           Allocate memory of specific size
+ * \param[in]       size: Number of bytes to allocate
+ * \return          Memory address on success, `NULL` otherwise
+ */
+static void*
+mem_alloc(size_t size) {
+    mem_block_t* curr, *next;
+    uint32_t map;
+    uint8_t fl, sl;
+
+    if (!mem_initialized || size == 0 || size > (MEM_MAX_BLOCK / 2)) {
+        return NULL;
+    }
+
+    size = MEM_ALIGN(size) + MEMBLOCK_METASIZE; /* Increase size for metadata */
+    size = LWESP_MAX(size, MEMBLOCK_MINSIZE);
+    if (size > mem_available_bytes) {           /* Check if we have enough memory available */
+        return NULL;
+    }
+
+    /*
+     * Round size up to next class boundary,
+     * so that any block in found class is big enough
+     */
+    if (size >= MEM_SMALL_BLOCK) {
+        mem_mapping(size + ((size_t)1 << (mem_fls(size) - MEM_SL_LOG2)) - 1, &fl, &sl);
+    } else {
+        mem_mapping(size, &fl, &sl);
+    }
+
+    /* Find first non-empty class, starting with class of requested size */
+    map = sl_bitmap[fl] & (~(uint32_t)0 << sl);
+    if (map == 0) {
+        map = fl_bitmap & (~(uint32_t)0 << (fl + 1));
+        if (map == 0) {
+            return NULL;                        /* Allocation failed, no free blocks of required size */
+        }
+        fl = mem_ffs(map);
+        map = sl_bitmap[fl];
+    }
+    sl = mem_ffs(map);
+    curr = free_lists[fl][sl];
+    mem_removefreeblock(curr);
+
+    /* Split block if remaining part is big enough for new free block */
+    if ((MEM_BLOCK_SIZE(curr) - size) >= MEMBLOCK_MINSIZE) {
+        next = (mem_block_t*)((uint8_t*)curr + size);
+        next->prev_phys = curr;
+        next->size = (MEM_BLOCK_SIZE(curr) - size) | MEM_BLOCK_FREE_BIT;
+        MEM_BLOCK_NEXT_PHYS(next)->prev_phys = next;
+        curr->size = size;
+        mem_insertfreeblock(next);
+    }
+    curr->size &= ~MEM_BLOCK_FREE_BIT;          /* Block is allocated */
+    mem_available_bytes -= MEM_BLOCK_SIZE(curr);/* Decrease available memory */
+    return (uint8_t*)curr + MEMBLOCK_METASIZE;
+}
+
+/**
+ * \brief           Free memory
+ * \param[in]       ptr: Pointer to memory previously returned using \ref lwesp_mem_malloc,
+ *                      \ref lwesp_mem_calloc or \ref lwesp_mem_realloc functions
+ * \return          `1` if block was allocated and is now freed, `0` otherwise
+ */
+static uint8_t
+mem_free(void* ptr) {
+    mem_block_t* block, *b;
+
+    block = MEM_BLOCK_FROM_PTR(ptr);            /* Get block data pointer from input pointer */
+    if (MEM_BLOCK_IS_FREE(block) || MEM_BLOCK_SIZE(block) == 0) {
+        return 0;                               /* Block is not allocated */
+    }
+    mem_available_bytes += MEM_BLOCK_SIZE(block);
+
+    /* Merge with previous block in memory if it is free */
+    b = block->prev_phys;
+    if (b != NULL && MEM_BLOCK_IS_FREE(b)) {
+        mem_removefreeblock(b);
+        b->size += MEM_BLOCK_SIZE(block);
+        block = b;
+    }
+
+    /* Merge with next block in memory if it is free */
+    b = MEM_BLOCK_NEXT_PHYS(block);
+    if (MEM_BLOCK_IS_FREE(b)) {
+        mem_removefreeblock(b);
+        block->size += MEM_BLOCK_SIZE(b);
+    }
+    MEM_BLOCK_NEXT_PHYS(block)->prev_phys = block;
+
+    block->size |= MEM_BLOCK_FREE_BIT;
+    mem_insertfreeblock(block);
+    return 1;
+}
+
+#if LWESP_CFG_MEM_STATS || __DOXYGEN__
+
+/**
+ * \brief           Get number of free blocks and size of the largest one
+ * \param[out]      stats: Statistics to fill
+ */
+static void
+mem_get_free_blocks(lwesp_mem_stats_t* stats) {
+    for (size_t fl = 0; fl < MEM_FL_COUNT; ++fl) {
+        for (size_t sl = 0; sl < MEM_SL_COUNT; ++sl) {
+            for (mem_block_t* b = free_lists[fl][sl]; b != NULL; b = b->next_free) {
+                ++stats->free_blocks;
+                stats->largest_free_block = LWESP_MAX(stats->largest_free_block, MEM_BLOCK_SIZE(b) - MEMBLOCK_METASIZE);
+            }
+        }
+    }
+}
+
+#endif /* LWESP_CFG_MEM_STATS || __DOXYGEN__ */
+
+#else /* LWESP_CFG_MEM_TLSF */
+
 #if !__DOXYGEN__
 typedef struct mem_block {
     struct mem_block* next;                     /*!< Pointer to next free block */
     size_t size;                                /*!< Size of block */
+#if LWESP_CFG_MEM_STATS
+    uint8_t tag;                                /*!< Tag of allocated block */
+#endif /* LWESP_CFG_MEM_STATS */
 } mem_block_t;
 #endif /* !__DOXYGEN__ */
 
@@ -273,10 +621,9 @@ mem_alloc(size_t size) {
              */
             mem_insertfreeblock(next);          /* Insert free memory block to list of free memory blocks (linked list chain) */
         }
+        mem_available_bytes -= curr->size;      /* Decrease available memory, block may be bigger than requested */
         curr->size |= MEM_ALLOC_BIT;            /* Set allocated bit = memory is allocated */
         curr->next = NULL;                      /* Clear next free block pointer as there is no one */
-
-        mem_available_bytes -= size;            /* Decrease available memory */
     } else {
         /* Allocation failed, no free blocks of required size */
     }
@@ -287,8 +634,9 @@ mem_alloc(size_t size) {
  * \brief           Free memory
  * \param[in]       ptr: Pointer to memory previously returned using \ref lwesp_mem_malloc,
  *                      \ref lwesp_mem_calloc or \ref lwesp_mem_realloc functions
+ * \return          `1` if block was allocated and is now freed, `0` otherwise
  */
-static void
+static uint8_t
 mem_free(void* ptr) {
     mem_block_t* block;
 
@@ -306,9 +654,92 @@ mem_free(void* ptr) {
         block->size &= ~MEM_ALLOC_BIT;          /* Clear allocated bit */
         mem_available_bytes += block->size;     /* Increase available bytes back */
         mem_insertfreeblock(block);             /* Insert block to list of free blocks */
+        return 1;
+    }
+    return 0;
+}
+
+#if LWESP_CFG_MEM_STATS || __DOXYGEN__
+
+/**
+ * \brief           Get number of free blocks and size of the largest one
+ * \param[out]      stats: Statistics to fill
+ */
+static void
+mem_get_free_blocks(lwesp_mem_stats_t* stats) {
+    /* End blocks of regions have zero size and link to next region */
+    for (mem_block_t* b = start_block.next; b != NULL; b = b->next) {
+        if (b->size > 0) {
+            ++stats->free_blocks;
+            stats->largest_free_block = LWESP_MAX(stats->largest_free_block, b->size - MEMBLOCK_METASIZE);
+        }
     }
 }
 
+#endif /* LWESP_CFG_MEM_STATS || __DOXYGEN__ */
+
+#endif /* !LWESP_CFG_MEM_TLSF */
+
+#if LWESP_CFG_MEM_STATS || __DOXYGEN__
+
+static lwesp_mem_stats_t mem_stats;             /*!< Counters of memory manager, free memory is set when read */
+
+#endif /* LWESP_CFG_MEM_STATS || __DOXYGEN__ */
+
+/**
+ * \brief           Allocate memory and account it to subsystem
+ * \param[in]       size: Number of bytes to allocate
+ * \param[in]       tag: Subsystem tag
+ * \return          Memory address on success, `NULL` otherwise
+ */
+static void*
+mem_alloc_tag(size_t size, uint8_t tag) {
+    void* ptr = mem_alloc(size);
+
+#if LWESP_CFG_MEM_STATS
+    if (ptr != NULL) {
+        lwesp_mem_tag_stats_t* t = &mem_stats.tags[tag];
+
+        MEM_BLOCK_FROM_PTR(ptr)->tag = tag;
+        t->bytes += MEM_BLOCK_USER_SIZE(ptr) + MEMBLOCK_METASIZE;
+        t->bytes_max = LWESP_MAX(t->bytes_max, t->bytes);
+        ++t->blocks;
+        ++mem_stats.alloc_count;
+        mem_stats.min_free_bytes = LWESP_MIN(mem_stats.min_free_bytes, mem_available_bytes);
+    } else if (size > 0) {
+        ++mem_stats.alloc_failed;
+    }
+#else /* LWESP_CFG_MEM_STATS */
+    LWESP_UNUSED(tag);
+#endif /* !LWESP_CFG_MEM_STATS */
+    return ptr;
+}
+
+/**
+ * \brief           Free memory and remove it from subsystem accounting
+ * \param[in]       ptr: Pointer to allocated memory
+ */
+static void
+mem_free_tag(void* ptr) {
+#if LWESP_CFG_MEM_STATS
+    size_t size;
+    uint8_t tag;
+
+    /* Block is released by free, read its accounting data first */
+    tag = MEM_BLOCK_FROM_PTR(ptr)->tag;
+    size = MEM_BLOCK_USER_SIZE(ptr) + MEMBLOCK_METASIZE;
+    if (mem_free(ptr)) {                        /* Account only blocks that were actually allocated */
+        lwesp_mem_tag_stats_t* t = &mem_stats.tags[tag];
+
+        t->bytes -= size;
+        --t->blocks;
+        ++mem_stats.free_count;
+    }
+#else /* LWESP_CFG_MEM_STATS */
+    mem_free(ptr);
+#endif /* !LWESP_CFG_MEM_STATS */
+}
+
 /**
  * \brief           Free memory with lock, but do not check if ptr is NULL
  * \param[in]       ptr: Pointer to memory previously returned using \ref lwesp_mem_malloc,
@@ -318,7 +749,7 @@ static void
 lwesp_mem_free_unchecked(void *ptr)
 {
     lwesp_core_lock();
-    mem_free(ptr);
+    mem_free_tag(ptr);
     lwesp_core_unlock();
 }
 
@@ -326,14 +757,15 @@ lwesp_mem_free_unchecked(void *ptr)
  * \brief           Allocate memory of specific size
  * \param[in]       num: Number of elements to allocate
  * \param[in]       size: Size of element in units of bytes
+ * \param[in]       tag: Subsystem tag
  * \return          Memory address on success, `NULL` otherwise
  */
 static void*
-mem_calloc(size_t num, size_t size) {
+mem_calloc(size_t num, size_t size, uint8_t tag) {
     void* ptr;
     size_t tot_len = num * size;
 
-    if ((ptr = mem_alloc(tot_len)) != NULL) {   /* Try to allocate memory */
+    if ((ptr = mem_alloc_tag(tot_len, tag)) != NULL) {  /* Try to allocate memory */
         LWESP_MEMSET(ptr, 0x00, tot_len);       /* Reset entire memory */
     }
     return ptr;
@@ -351,16 +783,20 @@ static void*
 mem_realloc(void* ptr, size_t size) {
     void* new_ptr;
     size_t old_size;
+    uint8_t tag = LWESP_MEM_TAG_OTHER;
 
     if (ptr == NULL) {                          /* If pointer is not valid */
-        return mem_alloc(size);                 /* Only allocate memory */
+        return mem_alloc_tag(size, tag);        /* Only allocate memory */
     }
 
+#if LWESP_CFG_MEM_STATS
+    tag = MEM_BLOCK_FROM_PTR(ptr)->tag;         /* New memory belongs to the same subsystem */
+#endif /* LWESP_CFG_MEM_STATS */
     old_size = MEM_BLOCK_USER_SIZE(ptr);        /* Get size of old pointer */
-    new_ptr = mem_alloc(size);                  /* Try to allocate new memory block */
+    new_ptr = mem_alloc_tag(size, tag);         /* Try to allocate new memory block */
     if (new_ptr != NULL) {
         LWESP_MEMCPY(new_ptr, ptr, LWESP_MIN(size, old_size));  /* Copy old data to new array */
-        mem_free(ptr);                          /* Free old pointer */
+        mem_free_tag(ptr);                      /* Free old pointer */
     }
     return new_ptr;
 }
@@ -375,7 +811,7 @@ void*
 lwesp_mem_malloc(size_t size) {
     void* ptr;
     lwesp_core_lock();
-    ptr = mem_calloc(1, size);                  /* Allocate memory and return pointer */
+    ptr = mem_calloc(1, size, LWESP_MEM_TAG_OTHER); /* Allocate memory and return pointer */
     lwesp_core_unlock();
     return ptr;
 }
@@ -408,7 +844,7 @@ void*
 lwesp_mem_calloc(size_t num, size_t size) {
     void* ptr;
     lwesp_core_lock();
-    ptr = mem_calloc(num, size);                /* Allocate memory and clear it to 0. Then return pointer */
+    ptr = mem_calloc(num, size, LWESP_MEM_TAG_OTHER);   /* Allocate memory and clear it to 0. Then return pointer */
     lwesp_core_unlock();
     return ptr;
 }
@@ -437,9 +873,81 @@ lwesp_mem_free(void* ptr) {
  */
 uint8_t
 lwesp_mem_assignmemory(const lwesp_mem_region_t* regions, size_t len) {
-    return mem_assignmem(regions, len);         /* Assign memory */
+    uint8_t res = mem_assignmem(regions, len);  /* Assign memory */
+
+#if LWESP_CFG_MEM_STATS
+    if (res) {
+        mem_stats.total_bytes = mem_available_bytes;
+        mem_stats.min_free_bytes = mem_available_bytes;
+    }
+#endif /* LWESP_CFG_MEM_STATS */
+    return res;
+}
+
+#if LWESP_CFG_MEM_STATS || __DOXYGEN__
+
+/**
+ * \brief           Allocate memory of specific size and account it to subsystem
+ *
+ * Use \ref LWESP_MEM_MALLOC_TAG macro, which falls back to \ref lwesp_mem_malloc
+ * when \ref LWESP_CFG_MEM_STATS is disabled
+ *
+ * \param[in]       size: Number of bytes to allocate
+ * \param[in]       tag: Subsystem, member of \ref lwesp_mem_tag_t enumeration
+ * \return          Memory address on success, `NULL` otherwise
+ */
+void*
+lwesp_mem_malloc_tag(size_t size, lwesp_mem_tag_t tag) {
+    return lwesp_mem_calloc_tag(1, size, tag);
+}
+
+/**
+ * \brief           Allocate memory of specific size, set it to zero and account it to subsystem
+ *
+ * Use \ref LWESP_MEM_CALLOC_TAG macro, which falls back to \ref lwesp_mem_calloc
+ * when \ref LWESP_CFG_MEM_STATS is disabled
+ *
+ * \param[in]       num: Number of elements to allocate
+ * \param[in]       size: Size of each element
+ * \param[in]       tag: Subsystem, member of \ref lwesp_mem_tag_t enumeration
+ * \return          Memory address on success, `NULL` otherwise
+ */
+void*
+lwesp_mem_calloc_tag(size_t num, size_t size, lwesp_mem_tag_t tag) {
+    void* ptr;
+
+    if ((size_t)tag >= LWESP_MEM_TAG_END) {
+        tag = LWESP_MEM_TAG_OTHER;
+    }
+    lwesp_core_lock();
+    ptr = mem_calloc(num, size, LWESP_U8(tag));
+    lwesp_core_unlock();
+    return ptr;
+}
+
+/**
+ * \brief           Get statistics of memory manager
+ *
+ * Free blocks are counted on every call,
+ * time of call depends on number of free blocks
+ *
+ * \param[out]      stats: Pointer to output structure to fill with statistics
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_mem_get_stats(lwesp_mem_stats_t* stats) {
+    LWESP_ASSERT("stats != NULL", stats != NULL);
+
+    lwesp_core_lock();
+    *stats = mem_stats;
+    stats->free_bytes = mem_available_bytes;
+    mem_get_free_blocks(stats);
+    lwesp_core_unlock();
+    return lwespOK;
 }
 
+#endif /* LWESP_CFG_MEM_STATS || __DOXYGEN__ */
+
 #endif /* !LWESP_CFG_MEM_CUSTOM || __DOXYGEN__ */
 
 /**
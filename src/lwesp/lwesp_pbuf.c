@@ -36,6 +36,10 @@
  * Copyright (c) 2021 niedong
  *
  *   - Remove debug message
+ *   - Add packet buffers referencing input buffer memory
+ *   - Add packet buffer pool
+ *   - Account allocations to memory statistics tag
+ *   - Add packet buffer pool class for zero-copy packet buffers
  */
 #include "lwesp/lwesp_private.h"
 #include "lwesp/lwesp_pbuf.h"
@@ -45,6 +49,128 @@
 #define SIZEOF_PBUF_STRUCT          LWESP_MEM_ALIGN(sizeof(lwesp_pbuf_t))
 #define SET_NEW_LEN(v, len)         do { if ((v) != NULL) { *(v) = (len); } } while (0)
 
+#if LWESP_CFG_PBUF_POOL
+
+/* Size of single block in pool class and memory definition for class */
+#define PBUF_POOL_BLOCK_SIZE(len)   (SIZEOF_PBUF_STRUCT + LWESP_MEM_ALIGN(len))
+#define PBUF_POOL_MEM(name, len, cnt)   static size_t name[(PBUF_POOL_BLOCK_SIZE(len) * (cnt) + sizeof(size_t) - 1) / sizeof(size_t)]
+
+/**
+ * \brief           Packet buffer pool class
+ */
+typedef struct {
+    uint8_t* mem;                               /*!< Memory of all blocks in class */
+    size_t block_size;                          /*!< Size of single block in units of bytes */
+    lwesp_pbuf_p first_free;                    /*!< List of free blocks, linked with `next` member */
+    lwesp_pbuf_pool_stats_t stats;              /*!< Class statistics */
+} pbuf_pool_t;
+
+#if LWESP_CFG_IPD_ZERO_COPY
+PBUF_POOL_MEM(pool_mem_ref, 0, LWESP_CFG_IPD_ZERO_COPY_MAX_REFS);
+#endif /* LWESP_CFG_IPD_ZERO_COPY */
+PBUF_POOL_MEM(pool_mem_small, LWESP_CFG_PBUF_POOL_SMALL_LEN, LWESP_CFG_PBUF_POOL_SMALL_CNT);
+PBUF_POOL_MEM(pool_mem_medium, LWESP_CFG_PBUF_POOL_MEDIUM_LEN, LWESP_CFG_PBUF_POOL_MEDIUM_CNT);
+PBUF_POOL_MEM(pool_mem_large, LWESP_CFG_PBUF_POOL_LARGE_LEN, LWESP_CFG_PBUF_POOL_LARGE_CNT);
+
+static pbuf_pool_t pools[LWESP_PBUF_POOL_CLASSES] = {
+#if LWESP_CFG_IPD_ZERO_COPY
+    /* Zero-copy packet buffers have no payload, they must not take blocks of small class */
+    { (uint8_t*)pool_mem_ref, PBUF_POOL_BLOCK_SIZE(0), NULL, { 0, LWESP_CFG_IPD_ZERO_COPY_MAX_REFS, 0, 0, 0, 0 } },
+#endif /* LWESP_CFG_IPD_ZERO_COPY */
+    { (uint8_t*)pool_mem_small, PBUF_POOL_BLOCK_SIZE(LWESP_CFG_PBUF_POOL_SMALL_LEN), NULL, { LWESP_CFG_PBUF_POOL_SMALL_LEN, LWESP_CFG_PBUF_POOL_SMALL_CNT, 0, 0, 0, 0 } },
+    { (uint8_t*)pool_mem_medium, PBUF_POOL_BLOCK_SIZE(LWESP_CFG_PBUF_POOL_MEDIUM_LEN), NULL, { LWESP_CFG_PBUF_POOL_MEDIUM_LEN, LWESP_CFG_PBUF_POOL_MEDIUM_CNT, 0, 0, 0, 0 } },
+    { (uint8_t*)pool_mem_large, PBUF_POOL_BLOCK_SIZE(LWESP_CFG_PBUF_POOL_LARGE_LEN), NULL, { LWESP_CFG_PBUF_POOL_LARGE_LEN, LWESP_CFG_PBUF_POOL_LARGE_CNT, 0, 0, 0, 0 } },
+};
+static uint8_t pools_initialized;
+
+/**
+ * \brief           Link all blocks of all pool classes to free lists
+ * \note            Core must be locked when calling this function
+ */
+static void
+pbuf_pool_init(void) {
+    lwesp_pbuf_p p;
+
+    for (size_t i = 0; i < LWESP_ARRAYSIZE(pools); ++i) {
+        for (size_t j = pools[i].stats.count; j > 0; --j) {
+            p = (void*)(pools[i].mem + (j - 1) * pools[i].block_size);
+            p->next = pools[i].first_free;
+            pools[i].first_free = p;
+        }
+    }
+    pools_initialized = 1;
+}
+
+#endif /* LWESP_CFG_PBUF_POOL */
+
+/**
+ * \brief           Allocate memory for pbuf structure and payload
+ * \param[in]       len: Length of payload memory in units of bytes
+ * \return          Pointer to allocated memory, `NULL` otherwise
+ */
+static lwesp_pbuf_p
+pbuf_alloc(size_t len) {
+    lwesp_pbuf_p p = NULL;
+
+#if LWESP_CFG_PBUF_POOL
+    pbuf_pool_t* pool;
+
+    lwesp_core_lock();
+    if (!pools_initialized) {
+        pbuf_pool_init();
+    }
+
+    /* Take block from smallest class with enough space */
+    for (size_t i = 0; i < LWESP_ARRAYSIZE(pools); ++i) {
+        pool = &pools[i];
+        if (len <= pool->stats.len) {
+            if (pool->first_free != NULL) {
+                p = pool->first_free;
+                pool->first_free = p->next;
+                ++pool->stats.hits;
+                if (++pool->stats.used > pool->stats.max_used) {
+                    pool->stats.max_used = pool->stats.used;
+                }
+            } else {
+                ++pool->stats.misses;           /* Class exhausted, use dynamic memory */
+            }
+            break;
+        }
+    }
+    lwesp_core_unlock();
+    if (p != NULL) {
+        return p;
+    }
+#endif /* LWESP_CFG_PBUF_POOL */
+    p = LWESP_MEM_MALLOC_TAG(SIZEOF_PBUF_STRUCT + sizeof(*p->payload) * len, LWESP_MEM_TAG_PBUF);
+    return p;
+}
+
+/**
+ * \brief           Free memory of pbuf structure, allocated with \ref pbuf_alloc
+ * \param[in]       p: Packet buffer to free
+ */
+static void
+pbuf_dealloc(lwesp_pbuf_p p) {
+#if LWESP_CFG_PBUF_POOL
+    pbuf_pool_t* pool;
+
+    /* Return block to its class */
+    for (size_t i = 0; i < LWESP_ARRAYSIZE(pools); ++i) {
+        pool = &pools[i];
+        if ((uint8_t*)p >= pool->mem && (uint8_t*)p < pool->mem + pool->block_size * pool->stats.count) {
+            lwesp_core_lock();
+            p->next = pool->first_free;
+            pool->first_free = p;
+            --pool->stats.used;
+            lwesp_core_unlock();
+            return;
+        }
+    }
+#endif /* LWESP_CFG_PBUF_POOL */
+    lwesp_mem_free_s((void**)&p);
+}
+
 /**
  * \brief           Skip pbufs for desired offset
  * \param[in]       p: Source pbuf to skip
@@ -77,17 +203,47 @@ lwesp_pbuf_p
 lwesp_pbuf_new(size_t len) {
     lwesp_pbuf_p p;
 
-    p = lwesp_mem_malloc(SIZEOF_PBUF_STRUCT + sizeof(*p->payload) * len);
+    p = pbuf_alloc(len);
     if (p != NULL) {
         p->next = NULL;                         /* No next element in chain */
         p->tot_len = len;                       /* Set total length of pbuf chain */
         p->len = len;                           /* Set payload length */
         p->payload = (void*)(((char*)p) + SIZEOF_PBUF_STRUCT);  /* Set pointer to payload data */
         p->ref = 1;                             /* Single reference is used on this pbuf */
+#if LWESP_CFG_IPD_ZERO_COPY
+        p->buff_ref = NULL;                     /* Payload is owned by pbuf */
+#endif /* LWESP_CFG_IPD_ZERO_COPY */
+    }
+    return p;
+}
+
+#if LWESP_CFG_IPD_ZERO_COPY || __DOXYGEN__
+
+/**
+ * \brief           Allocate packet buffer with payload in input buffer memory
+ * \note            Only pbuf structure is allocated, payload points to region described by `ref`.
+ *                  Region is released by \ref lwespi_buff_ref_release once pbuf is freed
+ * \param[in]       ref: Input buffer region to reference
+ * \return          Pointer to allocated memory, `NULL` otherwise
+ */
+lwesp_pbuf_p
+lwespi_pbuf_new_ref(lwesp_buff_ref_t* ref) {
+    lwesp_pbuf_p p;
+
+    p = pbuf_alloc(0);
+    if (p != NULL) {
+        p->next = NULL;                         /* No next element in chain */
+        p->tot_len = ref->len;                  /* Set total length of pbuf chain */
+        p->len = ref->len;                      /* Set payload length */
+        p->payload = ref->payload;              /* Payload is in input buffer */
+        p->ref = 1;                             /* Single reference is used on this pbuf */
+        p->buff_ref = ref;                      /* Save region for release */
     }
     return p;
 }
 
+#endif /* LWESP_CFG_IPD_ZERO_COPY || __DOXYGEN__ */
+
 /**
  * \brief           Free previously allocated packet buffer
  * \param[in]       pbuf: Packet buffer to free
@@ -111,7 +267,14 @@ lwesp_pbuf_free(lwesp_pbuf_p pbuf) {
         lwesp_core_unlock();
         if (ref == 0) {                         /* Did we reach 0 and are ready to free it? */
             pn = p->next;                       /* Save next entry */
-            lwesp_mem_free_s((void**)&p);       /* Free memory for pbuf */
+#if LWESP_CFG_IPD_ZERO_COPY
+            if (p->buff_ref != NULL) {          /* Release referenced input buffer memory */
+                lwesp_core_lock();
+                lwespi_buff_ref_release(p->buff_ref);
+                lwesp_core_unlock();
+            }
+#endif /* LWESP_CFG_IPD_ZERO_COPY */
+            pbuf_dealloc(p);                    /* Free memory for pbuf */
             p = pn;                             /* Restore with next entry */
             ++cnt;                              /* Increase number of freed pbufs */
         } else {
@@ -526,8 +689,15 @@ lwesp_pbuf_advance(lwesp_pbuf_p pbuf, int len) {
             process = 1;
         }
     } else {
-        /* Is current payload + new len still higher than pbuf structure? */
-        if (((uint8_t*)pbuf + SIZEOF_PBUF_STRUCT) < (pbuf->payload + len)) {
+        uint8_t* start = (uint8_t*)pbuf + SIZEOF_PBUF_STRUCT;
+
+#if LWESP_CFG_IPD_ZERO_COPY
+        if (pbuf->buff_ref != NULL) {           /* Payload is in input buffer */
+            start = pbuf->buff_ref->payload;
+        }
+#endif /* LWESP_CFG_IPD_ZERO_COPY */
+        /* Is current payload + new len still higher than payload start? */
+        if (start < (pbuf->payload + len)) {
             process = 1;
         }
     }
@@ -551,3 +721,24 @@ lwesp_pbuf_p
 lwesp_pbuf_skip(lwesp_pbuf_p pbuf, size_t offset, size_t* new_offset) {
     return pbuf_skip(pbuf, offset, new_offset); /* Skip pbufs with internal function */
 }
+
+#if LWESP_CFG_PBUF_POOL || __DOXYGEN__
+
+/**
+ * \brief           Get statistics of packet buffer pool class
+ * \param[in]       index: Class index, from `0` (smallest) to \ref LWESP_PBUF_POOL_CLASSES` - 1` (largest)
+ * \param[out]      stats: Pointer to output structure to fill with statistics
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_pbuf_pool_get_stats(size_t index, lwesp_pbuf_pool_stats_t* stats) {
+    LWESP_ASSERT("index < LWESP_PBUF_POOL_CLASSES", index < LWESP_PBUF_POOL_CLASSES);
+    LWESP_ASSERT("stats != NULL", stats != NULL);
+
+    lwesp_core_lock();
+    *stats = pools[index].stats;
+    lwesp_core_unlock();
+    return lwespOK;
+}
+
+#endif /* LWESP_CFG_PBUF_POOL || __DOXYGEN__ */
@@ -0,0 +1,193 @@
+/**
+ * \file            lwesp_stats.c
+ * \brief           Per-command statistics
+ */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwESP - Lightweight ESP-AT parser library.
+ */
+#include "lwesp/lwesp_private.h"
+#include "lwesp/lwesp_stats.h"
+
+#if LWESP_CFG_STATS || __DOXYGEN__
+
+/**
+ * \brief           Mark command as taken from producer queue and started
+ * \note            Function is called from producer thread with core locked
+ * \param[in]       msg: Message taken from queue
+ */
+void
+lwespi_stats_cmd_start(lwesp_msg_t* msg) {
+    uint32_t now = lwesp_sys_now();
+
+    msg->stats_queue = now - msg->stats_time;
+    msg->stats_time = now;
+    if (msg->cmd_def != LWESP_CMD_TCPIP_CIPSEND) {
+        esp.stats_send_ok_valid = 0;            /* Gap would include other command */
+    }
+}
+
+/**
+ * \brief           Record statistics of finished command
+ * \note            Function is called from producer thread with core locked
+ * \param[in]       msg: Finished message
+ * \param[in]       res: Result of command
+ */
+void
+lwespi_stats_cmd_end(lwesp_msg_t* msg, lwespr_t res) {
+    lwesp_stats_cmd_t* s;
+    uint32_t time;
+    size_t i;
+
+    if ((size_t)msg->cmd_def >= LWESP_ARRAYSIZE(esp.stats)) {
+        return;
+    }
+    s = &esp.stats[msg->cmd_def];
+    time = lwesp_sys_now() - msg->stats_time;
+
+    ++s->count;
+    if (res == lwespTIMEOUT) {
+        ++s->timeouts;
+    } else if (res != lwespOK) {
+        ++s->errors;
+    }
+    s->queue_time += msg->stats_queue;
+    if (msg->stats_queue > s->queue_time_max) {
+        s->queue_time_max = msg->stats_queue;
+    }
+    s->exec_time += time;
+    if (time > s->exec_time_max) {
+        s->exec_time_max = time;
+    }
+
+    /* Bucket is number of significant bits of time */
+    for (i = 0; time > 0 && i < LWESP_CFG_STATS_HIST_LEN - 1; time >>= 1) {
+        ++i;
+    }
+    ++s->hist[i];
+}
+
+/**
+ * \brief           Mark data chunk as confirmed by device with `SEND OK`
+ * \note            Function is called from processing thread with core locked
+ */
+void
+lwespi_stats_send_ok(void) {
+    esp.stats_send_ok = lwesp_sys_now_us();
+    esp.stats_send_ok_valid = 1;
+}
+
+/**
+ * \brief           Record gap before `AT+CIPSEND` command of send message is written to AT port
+ * \note            Function is called with core locked
+ * \param[in]       msg: Send message with next chunk
+ */
+void
+lwespi_stats_send_gap(const lwesp_msg_t* msg) {
+    lwesp_stats_gap_t* g;
+    uint32_t time;
+
+    if (!esp.stats_send_ok_valid) {
+        return;
+    }
+    esp.stats_send_ok_valid = 0;
+    if (msg->msg.conn_send.ptr > 0) {
+        g = &esp.stats_send_gap.chunk;
+    } else if ((int32_t)(esp.stats_send_ok - msg->stats_queued_us) >= 0) {
+        g = &esp.stats_send_gap.msg;            /* Message was waiting in queue before `SEND OK` */
+    } else {
+        return;
+    }
+    time = lwesp_sys_now_us() - esp.stats_send_ok;
+
+    if (g->count == 0 || time < g->time_min) {
+        g->time_min = time;
+    }
+    if (time > g->time_max) {
+        g->time_max = time;
+    }
+    g->time += time;
+    ++g->count;
+}
+
+/**
+ * \brief           Get statistics of all command types
+ * \param[out]      cmds: Array to fill with statistics, indexed by command type.
+ *                      Set to `NULL` to only get number of command types
+ * \param[in]       len: Number of entries in `cmds` array
+ * \return          Number of command types
+ */
+size_t
+lwesp_stats_get(lwesp_stats_cmd_t* cmds, size_t len) {
+    if (cmds != NULL) {
+        if (len > LWESP_ARRAYSIZE(esp.stats)) {
+            len = LWESP_ARRAYSIZE(esp.stats);
+        }
+        lwesp_core_lock();
+        LWESP_MEMCPY(cmds, esp.stats, len * sizeof(*cmds));
+        lwesp_core_unlock();
+    }
+    return LWESP_ARRAYSIZE(esp.stats);
+}
+
+/**
+ * \brief           Get statistics of gaps between data chunks of send commands
+ * \param[out]      gap: Pointer to output structure to fill with statistics
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_stats_get_send_gap(lwesp_stats_send_gap_t* gap) {
+    LWESP_ASSERT("gap != NULL", gap != NULL);
+
+    lwesp_core_lock();
+    *gap = esp.stats_send_gap;
+    lwesp_core_unlock();
+    return lwespOK;
+}
+
+/**
+ * \brief           Reset statistics of all command types and send gaps
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_stats_reset(void) {
+    lwesp_core_lock();
+    LWESP_MEMSET(esp.stats, 0x00, sizeof(esp.stats));
+    LWESP_MEMSET(&esp.stats_send_gap, 0x00, sizeof(esp.stats_send_gap));
+    lwesp_core_unlock();
+    return lwespOK;
+}
+
+/**
+ * \brief           Get name of command type
+ * \param[in]       cmd: Command type, index in statistics array
+ * \return          Name of command without `AT+` prefix, `NULL` if command type is not valid
+ */
+const char*
+lwesp_stats_cmd_name(size_t cmd) {
+    return lwespi_cmd_name(cmd);
+}
+
+#endif /* LWESP_CFG_STATS || __DOXYGEN__ */
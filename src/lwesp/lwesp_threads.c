@@ -36,6 +36,11 @@
  * Copyright (c) 2021 niedong
  *
  *   - Remove debug message
+ *   - Add pipelining of query commands
+ *   - Add coalescing of queued send commands
+ *   - Add per-command statistics
+ *   - Trace start and end of commands
+ *   - Add pipelining of send commands
  */
 #include "lwesp/lwesp_private.h"
 #include "lwesp/lwesp_threads.h"
@@ -46,6 +51,367 @@
 #include "lwesp/lwesp_mem.h"
 #include "system/lwesp_sys.h"
 
+/**
+ * \brief           Finish processing of message and notify user
+ * \param[in]       msg: Message to finish
+ * \param[in]       res: Result of message execution
+ */
+static void
+produce_finish_msg(lwesp_msg_t* msg, lwespr_t res) {
+#if LWESP_CFG_CONN_SEND_COALESCE
+    if (msg->cmd_def == LWESP_CMD_TCPIP_CIPSEND && msg->msg.conn_send.next != NULL) {
+        lwesp_msg_t* m, *next;
+
+        /* Merged messages share result of first message */
+        for (m = msg->msg.conn_send.next; m != NULL; m = next) {
+            next = m->msg.conn_send.next;
+            m->msg.conn_send.next = NULL;
+            if (res == lwespOK) {
+                m->res = msg->res;
+            }
+            produce_finish_msg(m, res);
+        }
+        msg->msg.conn_send.next = NULL;
+    }
+#endif /* LWESP_CFG_CONN_SEND_COALESCE */
+#if LWESP_CFG_STATS
+    lwespi_stats_cmd_end(msg, res != lwespOK ? res : msg->res); /* Device may answer with error */
+#endif /* LWESP_CFG_STATS */
+#if LWESP_CFG_TRACE
+    {
+        uint8_t r = LWESP_U8(res != lwespOK ? res : msg->res);
+
+        lwespi_trace(LWESP_TRACE_TYPE_CMD_END, LWESP_U8(msg->cmd_def), (uint32_t)(uintptr_t)msg, &r, 1);
+    }
+#endif /* LWESP_CFG_TRACE */
+    if (res != lwespOK) {
+        /* Process global callbacks */
+        lwespi_process_events_for_timeout_or_error(msg, res);
+
+        msg->res = res;                         /* Save response */
+    }
+
+#if LWESP_CFG_USE_API_FUNC_EVT
+    /* Send event function to user */
+    if (msg->evt_fn != NULL) {
+        msg->evt_fn(msg->res, msg->evt_arg);    /* Send event with user argument */
+    }
+#endif /* LWESP_CFG_USE_API_FUNC_EVT */
+
+    /*
+     * In case message is blocking,
+     * release semaphore and notify finished with processing
+     * otherwise directly free memory of message structure
+     */
+    if (msg->is_blocking) {
+        lwesp_sys_sem_release(&msg->sem);
+    } else {
+        LWESP_MSG_VAR_FREE(msg);
+    }
+}
+
+#if LWESP_CFG_CMD_PIPELINE || LWESP_CFG_CONN_SEND_COALESCE || LWESP_CFG_CONN_SEND_PIPELINE || __DOXYGEN__
+static lwesp_msg_t* msg_pending;                /*!< Message taken from queue ahead of time, not yet processed */
+#endif /* LWESP_CFG_CMD_PIPELINE || LWESP_CFG_CONN_SEND_COALESCE || LWESP_CFG_CONN_SEND_PIPELINE || __DOXYGEN__ */
+
+#if LWESP_CFG_CONN_SEND_COALESCE || __DOXYGEN__
+
+/**
+ * \brief           Merge send messages waiting in queue into first send message
+ *
+ * Messages for the same connection are linked to first message,
+ * as long as all their data fit into single `AT+CIPSEND` command.
+ * First message that cannot be merged is processed after current one.
+ *
+ * \note            Function is called with core locked, before first message is sent
+ * \param[in]       msg: First send message
+ */
+static void
+produce_coalesce_send(lwesp_msg_t* msg) {
+    lwesp_conn_t* c = msg->msg.conn_send.conn;
+    lwesp_msg_t* last = msg, *next;
+    size_t len = msg->msg.conn_send.btw;
+
+    msg->msg.conn_send.next = NULL;
+    if (c->type == LWESP_CONN_TYPE_UDP) {       /* Datagram boundaries must be kept */
+        return;
+    }
+    while (len < LWESP_CFG_CONN_MAX_DATA_LEN
+           && lwesp_sys_mbox_getnow(&esp.mbox_producer, (void**)&next)) {
+        if (next == NULL) {
+            continue;
+        }
+        if (next->fn != lwespi_initiate_cmd || next->cmd_def != LWESP_CMD_TCPIP_CIPSEND
+            || next->msg.conn_send.conn != c || next->msg.conn_send.val_id != msg->msg.conn_send.val_id
+            || len + next->msg.conn_send.btw > LWESP_CFG_CONN_MAX_DATA_LEN) {
+            msg_pending = next;                 /* Process it after current message */
+            break;
+        }
+#if LWESP_CFG_STATS
+        lwespi_stats_cmd_start(next);
+#endif /* LWESP_CFG_STATS */
+        next->msg.conn_send.next = NULL;
+        last->msg.conn_send.next = next;
+        last = next;
+        len += next->msg.conn_send.btw;
+        ++esp.send_coalesce.merged;
+    }
+}
+
+#endif /* LWESP_CFG_CONN_SEND_COALESCE || __DOXYGEN__ */
+
+#if LWESP_CFG_CMD_PIPELINE || __DOXYGEN__
+
+/**
+ * \brief           Check if message is single query command without side effects,
+ *                  that can be sent before previous command finishes
+ *
+ * `AT+CIPSTATUS` is not pipelined, as connection status is cleared when command is sent.
+ * Second status command in flight would clear it before response of first one is parsed
+ *
+ * \param[in]       msg: Message to check
+ * \return          `1` if message can be pipelined, `0` otherwise
+ */
+static uint8_t
+produce_is_pipelined(lwesp_msg_t* msg) {
+    if (msg->fn != lwespi_initiate_cmd || msg->cmd != msg->cmd_def) {
+        return 0;
+    }
+    switch (msg->cmd_def) {
+        case LWESP_CMD_GMR:
+        case LWESP_CMD_WIFI_CWMODE_GET:
+        case LWESP_CMD_WIFI_CWDHCP_GET:
+#if LWESP_CFG_MODE_STATION
+        case LWESP_CMD_WIFI_CWJAP_GET:
+        case LWESP_CMD_WIFI_CIPSTAMAC_GET:
+        case LWESP_CMD_WIFI_CIPSTA_GET:
+#endif /* LWESP_CFG_MODE_STATION */
+#if LWESP_CFG_MODE_ACCESS_POINT
+        case LWESP_CMD_WIFI_CWSAP_GET:
+        case LWESP_CMD_WIFI_CIPAPMAC_GET:
+        case LWESP_CMD_WIFI_CIPAP_GET:
+#endif /* LWESP_CFG_MODE_ACCESS_POINT */
+#if LWESP_CFG_HOSTNAME
+        case LWESP_CMD_WIFI_CWHOSTNAME_GET:
+#endif /* LWESP_CFG_HOSTNAME */
+#if LWESP_CFG_DNS
+        case LWESP_CMD_TCPIP_CIPDNS_GET:
+#endif /* LWESP_CFG_DNS */
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+/**
+ * \brief           Send queued query commands after first one and wait for all of them to finish
+ *
+ * Commands are linked in the order they were sent. Processing thread moves \ref lwesp_t.msg
+ * to next command in the list when current one finishes and releases synchronization semaphore.
+ *
+ * \note            Function is called with core locked, after first message has been sent
+ *                  and synchronization semaphore has been acquired
+ * \param[in]       msg: First message, already sent to device
+ */
+static void
+produce_pipelined(lwesp_msg_t* msg) {
+    lwesp_msg_t* first = msg, *last = msg, *next;
+    size_t cnt = 1;
+    lwespr_t res;
+
+    /* Send next query commands from queue without waiting for responses */
+    msg->pipe_next = NULL;
+    while (cnt < LWESP_CFG_CMD_PIPELINE_DEPTH
+           && lwesp_sys_mbox_getnow(&esp.mbox_producer, (void**)&next)) {
+        if (next == NULL) {
+            continue;
+        }
+        if (!esp.status.f.dev_present || !produce_is_pipelined(next)) {
+            msg_pending = next;                 /* Process it after pipeline is empty */
+            break;
+        }
+        next->pipe_next = NULL;
+#if LWESP_CFG_STATS
+        lwespi_stats_cmd_start(next);
+#endif /* LWESP_CFG_STATS */
+
+        /* Initiate function uses current message, set it only for the time of sending */
+        esp.msg = next;
+#if LWESP_CFG_TRACE
+        lwespi_trace(LWESP_TRACE_TYPE_CMD_START, LWESP_U8(next->cmd_def), (uint32_t)(uintptr_t)next, NULL, 0);
+#endif /* LWESP_CFG_TRACE */
+        res = next->fn(next);
+        esp.msg = first;
+        if (res != lwespOK) {
+            produce_finish_msg(next, res);
+            continue;
+        }
+        last->pipe_next = next;
+        last = next;
+        ++cnt;
+    }
+
+    /* Responses come in the same order as commands were sent */
+    while (first != NULL) {
+        uint32_t time;
+
+        lwesp_core_unlock();
+        time = lwesp_sys_sem_wait(&esp.sem_sync, first->block_time);
+        lwesp_core_lock();
+        if (time == LWESP_SYS_TIMEOUT) {
+            /* Responses cannot be matched anymore, fail all pending commands */
+            lwespi_send_cb(LWESP_EVT_CMD_TIMEOUT);
+            esp.msg = NULL;
+            for (; first != NULL; first = next) {
+                next = first->pipe_next;
+                produce_finish_msg(first, lwespTIMEOUT);
+            }
+        } else {
+            /* All commands before current one are finished */
+            for (; first != NULL && first != esp.msg; first = next) {
+                next = first->pipe_next;
+                produce_finish_msg(first, lwespOK);
+            }
+        }
+    }
+}
+
+#endif /* LWESP_CFG_CMD_PIPELINE || __DOXYGEN__ */
+
+#if LWESP_CFG_CONN_SEND_PIPELINE || __DOXYGEN__
+
+/**
+ * \brief           Check if send message waits for `SEND OK`, while next one can be prepared
+ * \param[in]       msg: Message to check
+ * \return          `1` if message is pipelined, `0` otherwise
+ */
+static uint8_t
+produce_is_send_pipelined(lwesp_msg_t* msg) {
+#if LWESP_CFG_CONN_PASSTHROUGH
+    if (esp.m.passthrough.active) {             /* Data are sent without handshake */
+        return 0;
+    }
+#endif /* LWESP_CFG_CONN_PASSTHROUGH */
+    return msg->fn == lwespi_initiate_cmd && msg->cmd_def == LWESP_CMD_TCPIP_CIPSEND;
+}
+
+/**
+ * \brief           Take next send message from queue, while current one is being sent
+ *
+ * Processing thread starts it as soon as current message finishes.
+ * First message that is not send message is processed after current one.
+ *
+ * \note            Function is called with core locked
+ * \param[in]       msg: Send message being sent
+ */
+static void
+produce_stage_send(lwesp_msg_t* msg) {
+    lwesp_msg_t* next = msg_pending;
+
+    msg_pending = NULL;
+    if (next == NULL && (!lwesp_sys_mbox_getnow(&esp.mbox_producer, (void**)&next) || next == NULL)) {
+        return;
+    }
+    if (!esp.status.f.dev_present || next->fn != lwespi_initiate_cmd
+        || next->cmd_def != LWESP_CMD_TCPIP_CIPSEND) {
+        msg_pending = next;                     /* Process it after current message */
+        return;
+    }
+#if LWESP_CFG_STATS
+    lwespi_stats_cmd_start(next);
+#endif /* LWESP_CFG_STATS */
+#if LWESP_CFG_CONN_SEND_COALESCE
+    ++esp.send_coalesce.cmds;
+    if (next->msg.conn_send.btw < LWESP_CFG_CONN_MAX_DATA_LEN) {
+        produce_coalesce_send(next);            /* Merge next queued sends on the same connection */
+    }
+#endif /* LWESP_CFG_CONN_SEND_COALESCE */
+    next->msg.conn_send.stage_next = NULL;
+    next->msg.conn_send.stage_started = 0;
+    msg->msg.conn_send.stage_next = next;
+}
+
+/**
+ * \brief           Start send message, that processing thread did not start
+ * \note            Function is called with core locked and synchronization semaphore acquired
+ * \param[in]       msg: Send message taken from queue
+ * \return          `msg` when it started, `NULL` when it failed and was finished
+ */
+static lwesp_msg_t*
+produce_start_send(lwesp_msg_t* msg) {
+    lwespr_t res;
+
+    esp.msg = msg;
+#if LWESP_CFG_STATS
+    msg->stats_time = lwesp_sys_now();          /* Execution starts now */
+#endif /* LWESP_CFG_STATS */
+#if LWESP_CFG_TRACE
+    lwespi_trace(LWESP_TRACE_TYPE_CMD_START, LWESP_U8(msg->cmd_def), (uint32_t)(uintptr_t)msg, NULL, 0);
+#endif /* LWESP_CFG_TRACE */
+    if ((res = msg->fn(msg)) != lwespOK) {
+        esp.msg = NULL;
+        produce_finish_msg(msg, res);
+        return NULL;
+    }
+    return msg;
+}
+
+/**
+ * \brief           Wait for send message and for send messages started after it
+ *
+ * While current message waits for `SEND OK`, next send message is taken from queue.
+ * Processing thread starts it when current one finishes and moves \ref lwesp_t.msg to it,
+ * or sets it to `NULL` when there is nothing to start.
+ *
+ * \note            Function is called with core locked, after first message has been sent
+ *                  and synchronization semaphore has been acquired
+ * \param[in]       msg: First send message, already sent to device
+ */
+static void
+produce_send_pipelined(lwesp_msg_t* msg) {
+    lwesp_msg_t* cur;
+    lwespr_t res;
+    uint32_t time;
+    uint8_t started;
+
+    msg->msg.conn_send.stage_next = NULL;
+    msg->msg.conn_send.stage_started = 0;
+    while (msg != NULL) {
+        if (msg->msg.conn_send.stage_next == NULL) {
+            produce_stage_send(msg);
+        }
+
+        lwesp_core_unlock();
+        time = lwesp_sys_sem_wait(&esp.sem_sync, msg->block_time);
+        lwesp_core_lock();
+        res = lwespOK;
+        if (msg == esp.msg) {                   /* Message did not finish */
+            if (time != LWESP_SYS_TIMEOUT) {
+                continue;
+            }
+            lwespi_send_cb(LWESP_EVT_CMD_TIMEOUT);
+            esp.msg = NULL;
+            esp.send_stage.msg = NULL;          /* Command may be built for this message */
+            res = lwespTIMEOUT;
+        }
+
+        /* Messages finish in the same order as they were started */
+        while (msg != NULL && msg != esp.msg) {
+            cur = msg;
+            msg = cur->msg.conn_send.stage_next;
+            started = cur->msg.conn_send.stage_started;
+            cur->msg.conn_send.stage_next = NULL;
+            produce_finish_msg(cur, res);
+            res = lwespOK;
+            if (msg != NULL && !started) {
+                msg = produce_start_send(msg);  /* Processing thread did not start it */
+            }
+        }
+    }
+}
+
+#endif /* LWESP_CFG_CONN_SEND_PIPELINE || __DOXYGEN__ */
+
 /**
  * \brief           User thread to process input packets from API functions
  * \param[in]       arg: User argument. Semaphore to release when thread starts
@@ -66,11 +432,21 @@ lwesp_thread_produce(void* const arg) {
     lwesp_core_lock();
     while (1) {
         lwesp_core_unlock();
-        do {
-            time = lwesp_sys_mbox_get(&e->mbox_producer, (void**)&msg, 0);  /* Get message from queue */
-        } while (time == LWESP_SYS_TIMEOUT || msg == NULL);
+        msg = NULL;
+#if LWESP_CFG_CMD_PIPELINE || LWESP_CFG_CONN_SEND_COALESCE || LWESP_CFG_CONN_SEND_PIPELINE
+        msg = msg_pending;                      /* Message taken from queue ahead of time goes first */
+        msg_pending = NULL;
+#endif /* LWESP_CFG_CMD_PIPELINE || LWESP_CFG_CONN_SEND_COALESCE || LWESP_CFG_CONN_SEND_PIPELINE */
+        if (msg == NULL) {
+            do {
+                time = lwesp_sys_mbox_get(&e->mbox_producer, (void**)&msg, 0);  /* Get message from queue */
+            } while (time == LWESP_SYS_TIMEOUT || msg == NULL);
+        }
         LWESP_THREAD_PRODUCER_HOOK();           /* Execute producer thread hook */
         lwesp_core_lock();
+#if LWESP_CFG_STATS
+        lwespi_stats_cmd_start(msg);
+#endif /* LWESP_CFG_STATS */
 
         res = lwespOK;                          /* Start with OK */
         e->msg = msg;                           /* Set message handle */
@@ -106,8 +482,38 @@ lwesp_thread_produce(void* const arg) {
             lwesp_core_unlock();
             lwesp_sys_sem_wait(&e->sem_sync, 0);/* First call */
             lwesp_core_lock();
+#if LWESP_CFG_STATS
+            msg->stats_time = lwesp_sys_now();  /* Execution starts now, reset may have delayed it */
+#endif /* LWESP_CFG_STATS */
+#if LWESP_CFG_CONN_SEND_COALESCE
+            if (msg->fn == lwespi_initiate_cmd && msg->cmd_def == LWESP_CMD_TCPIP_CIPSEND) {
+                ++e->send_coalesce.cmds;
+                if (msg->msg.conn_send.btw < LWESP_CFG_CONN_MAX_DATA_LEN) {
+                    produce_coalesce_send(msg); /* Merge next queued sends on the same connection */
+                }
+            }
+#endif /* LWESP_CFG_CONN_SEND_COALESCE */
+#if LWESP_CFG_TRACE
+            lwespi_trace(LWESP_TRACE_TYPE_CMD_START, LWESP_U8(msg->cmd_def), (uint32_t)(uintptr_t)msg, NULL, 0);
+#endif /* LWESP_CFG_TRACE */
             res = msg->fn(msg);                 /* Process this message, check if command started at least */
             time = ~LWESP_SYS_TIMEOUT;          /* Reset time */
+#if LWESP_CFG_CMD_PIPELINE
+            if (res == lwespOK && produce_is_pipelined(msg)) {
+                produce_pipelined(msg);         /* Send next queries and wait for all responses */
+                lwesp_sys_sem_release(&e->sem_sync);
+                e->msg = NULL;
+                continue;
+            }
+#endif /* LWESP_CFG_CMD_PIPELINE */
+#if LWESP_CFG_CONN_SEND_PIPELINE
+            if (res == lwespOK && produce_is_send_pipelined(msg)) {
+                produce_send_pipelined(msg);    /* Wait for all sends started one after another */
+                lwesp_sys_sem_release(&e->sem_sync);
+                e->msg = NULL;
+                continue;
+            }
+#endif /* LWESP_CFG_CONN_SEND_PIPELINE */
             if (res == lwespOK) {               /* We have valid data and data were sent */
                 lwesp_core_unlock();
                 time = lwesp_sys_sem_wait(&e->sem_sync, msg->block_time);   /* Second call; Wait for synchronization semaphore from processing thread or timeout */
@@ -144,30 +550,7 @@ lwesp_thread_produce(void* const arg) {
                 res = lwespERR;                 /* Simply set error message */
             }
         }
-        if (res != lwespOK) {
-            /* Process global callbacks */
-            lwespi_process_events_for_timeout_or_error(msg, res);
-
-            msg->res = res;                     /* Save response */
-        }
-
-#if LWESP_CFG_USE_API_FUNC_EVT
-        /* Send event function to user */
-        if (msg->evt_fn != NULL) {
-            msg->evt_fn(msg->res, msg->evt_arg);/* Send event with user argument */
-        }
-#endif /* LWESP_CFG_USE_API_FUNC_EVT */
-
-        /*
-         * In case message is blocking,
-         * release semaphore and notify finished with processing
-         * otherwise directly free memory of message structure
-         */
-        if (msg->is_blocking) {
-            lwesp_sys_sem_release(&msg->sem);
-        } else {
-            LWESP_MSG_VAR_FREE(msg);
-        }
+        produce_finish_msg(msg, res);           /* Notify user and release message */
         e->msg = NULL;
     }
 }
@@ -31,12 +31,148 @@
  * Author:          Tilen MAJERLE <tilen@majerle.eu>
  * Version:         v1.0.0
  */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ *   - Replace sorted list of timeouts with hierarchical timing wheel
+ *   - Add lwesp_timeout_start and lwesp_timeout_stop functions for caller-owned timeouts
+ *   - Account allocations to memory statistics tag
+ */
 #include "lwesp/lwesp_private.h"
 #include "lwesp/lwesp_timeout.h"
 #include "lwesp/lwesp_mem.h"
 
-static lwesp_timeout_t* first_timeout;
-static uint32_t last_timeout_time;
+/*
+ * Timeouts are kept in hierarchical timing wheel.
+ *
+ * Each level has `TIMEOUT_SLOTS` slots, slot on level `L` covers
+ * `TIMEOUT_SLOTS ^ L` milliseconds. Timeout is put to the lowest level
+ * that covers its remaining time and to the slot selected by its absolute expiry time.
+ * When wheel time reaches the beginning of slot on higher level,
+ * its timeouts are moved to lower levels. Slots on level `0` are expired directly.
+ *
+ * Bitmap of non-empty slots per level allows to find next event without walking the slots.
+ */
+#define TIMEOUT_SLOT_BITS           5
+#define TIMEOUT_SLOTS               (1U << TIMEOUT_SLOT_BITS)
+#define TIMEOUT_SLOT_MASK           (TIMEOUT_SLOTS - 1)
+#define TIMEOUT_LEVELS              5
+#define TIMEOUT_LEVEL_SHIFT(l)      ((l) * TIMEOUT_SLOT_BITS)
+#define TIMEOUT_SLOT(t, l)          ((uint8_t)(((t) >> TIMEOUT_LEVEL_SHIFT(l)) & TIMEOUT_SLOT_MASK))
+#define TIMEOUT_RANGE               ((uint32_t)1 << TIMEOUT_LEVEL_SHIFT(TIMEOUT_LEVELS))
+
+/* Timeout flags */
+#define TIMEOUT_FLAG_ACTIVE         0x01        /*!< Timeout is in the wheel */
+#define TIMEOUT_FLAG_ALLOCATED      0x02        /*!< Timeout memory was allocated by \ref lwesp_timeout_add */
+
+static lwesp_timeout_t* wheel[TIMEOUT_LEVELS][TIMEOUT_SLOTS];   /*!< Lists of timeouts for each slot */
+static uint32_t wheel_bitmap[TIMEOUT_LEVELS];   /*!< Bitmaps of non-empty slots for each level */
+static uint32_t wheel_time;                     /*!< Time up to which wheel has been processed */
+static size_t active_cnt;                       /*!< Number of timeouts in the wheel */
+static uint8_t wheel_processing;                /*!< Set to `1` while expired timeouts are processed */
+
+/**
+ * \brief           Get number of slots from `start` slot to first non-empty slot
+ * \param[in]       bitmap: Bitmap of non-empty slots
+ * \param[in]       start: Slot to start search from
+ * \return          Number of slots, `TIMEOUT_SLOTS` if there is no non-empty slot
+ */
+static uint32_t
+wheel_find_slot(uint32_t bitmap, uint8_t start) {
+    uint32_t m;
+
+    if (bitmap == 0) {
+        return TIMEOUT_SLOTS;
+    }
+    m = start > 0 ? ((bitmap >> start) | (bitmap << (TIMEOUT_SLOTS - start))) : bitmap;
+    m &= (uint32_t)(((uint64_t)1 << TIMEOUT_SLOTS) - 1);
+#if defined(__GNUC__)
+    return (uint32_t)__builtin_ctz(m);
+#else /* defined(__GNUC__) */
+    for (uint32_t i = 0;; ++i, m >>= 1) {
+        if (m & 0x01) {
+            return i;
+        }
+    }
+#endif /* !defined(__GNUC__) */
+}
+
+/**
+ * \brief           Insert timeout to the wheel, based on its expiry time
+ * \param[in]       to: Timeout to insert
+ */
+static void
+wheel_insert(lwesp_timeout_t* to) {
+    uint32_t diff = to->time - wheel_time;
+    uint8_t level, slot;
+
+    for (level = 0; level < TIMEOUT_LEVELS - 1; ++level) {
+        if (diff < ((uint32_t)1 << TIMEOUT_LEVEL_SHIFT(level + 1))) {
+            break;
+        }
+    }
+    if (diff >= TIMEOUT_RANGE) {                /* Out of wheel range, use farthest slot and insert again later */
+        slot = (uint8_t)((TIMEOUT_SLOT(wheel_time, level) + TIMEOUT_SLOTS - 1) & TIMEOUT_SLOT_MASK);
+    } else {
+        slot = TIMEOUT_SLOT(to->time, level);
+    }
+
+    to->level = level;
+    to->slot = slot;
+    to->prev = NULL;
+    to->next = wheel[level][slot];
+    if (to->next != NULL) {
+        to->next->prev = to;
+    }
+    wheel[level][slot] = to;
+    wheel_bitmap[level] |= (uint32_t)1 << slot;
+}
+
+/**
+ * \brief           Remove timeout from the wheel
+ * \param[in]       to: Timeout to remove
+ */
+static void
+wheel_remove(lwesp_timeout_t* to) {
+    if (to->next != NULL) {
+        to->next->prev = to->prev;
+    }
+    if (to->prev != NULL) {
+        to->prev->next = to->next;
+    } else {
+        wheel[to->level][to->slot] = to->next;
+        if (to->next == NULL) {
+            wheel_bitmap[to->level] &= ~((uint32_t)1 << to->slot);
+        }
+    }
+    to->next = to->prev = NULL;
+}
+
+/**
+ * \brief           Get time of next wheel event, expiry or move of timeouts to lower level
+ * \return          Time in units of milliseconds from current wheel time
+ */
+static uint32_t
+wheel_next_event(void) {
+    uint32_t diff = 0xFFFFFFFF, d, s;
+
+    /* Level 0 slots expire at exact time */
+    s = wheel_find_slot(wheel_bitmap[0], TIMEOUT_SLOT(wheel_time, 0));
+    if (s < TIMEOUT_SLOTS) {
+        diff = s;
+    }
+
+    /* Higher level slots are processed at the beginning of slot time */
+    for (uint8_t level = 1; level < TIMEOUT_LEVELS; ++level) {
+        s = wheel_find_slot(wheel_bitmap[level], (uint8_t)((TIMEOUT_SLOT(wheel_time, level) + 1) & TIMEOUT_SLOT_MASK));
+        if (s < TIMEOUT_SLOTS) {
+            d = (((wheel_time >> TIMEOUT_LEVEL_SHIFT(level)) + s + 1) << TIMEOUT_LEVEL_SHIFT(level)) - wheel_time;
+            diff = LWESP_MIN(diff, d);
+        }
+    }
+    return diff;
+}
 
 /**
  * \brief           Get time we have to wait before we can process next timeout
@@ -44,45 +180,73 @@ static uint32_t last_timeout_time;
  */
 static uint32_t
 get_next_timeout_diff(void) {
-    uint32_t diff;
-    if (first_timeout == NULL) {
+    uint32_t diff, passed;
+
+    if (active_cnt == 0) {
         return 0xFFFFFFFF;
     }
-    diff = lwesp_sys_now() - last_timeout_time; /* Get difference between current time and last process time */
-    if (diff >= first_timeout->time) {          /* Are we over already? */
+    diff = wheel_next_event();
+    passed = lwesp_sys_now() - wheel_time;      /* Get difference between current time and last process time */
+    if (passed >= diff) {                       /* Are we over already? */
         return 0;                               /* We have to immediately process this timeout */
     }
-    return first_timeout->time - diff;          /* Return remaining time for sleep */
+    return diff - passed;                       /* Return remaining time for sleep */
 }
 
 /**
- * \brief           Process next timeout in a linked list
+ * \brief           Process all timeouts that expired until current time
  */
 static void
-process_next_timeout(void) {
-    uint32_t time;
-
-    time = lwesp_sys_now();
+process_timeouts(void) {
+    lwesp_timeout_t* to, *to_next;
+    uint32_t now, diff;
+    uint8_t slot;
 
-    /*
-     * Before calling timeout callback, update variable
-     * to make sure we have correct timing in case
-     * callback creates timeout value again
-     */
-    last_timeout_time = time;                   /* Reset variable when we were last processed */
+    wheel_processing = 1;
+    now = lwesp_sys_now();
+    while (active_cnt > 0) {
+        diff = wheel_next_event();
+        if ((int32_t)(now - wheel_time) < 0 || diff > now - wheel_time) {   /* Next event is in the future */
+            break;
+        }
+        wheel_time += diff;
 
-    if (first_timeout != NULL) {
-        lwesp_timeout_t* to = first_timeout;
+        /* Move timeouts from higher levels, if slot time begins now */
+        for (uint8_t level = TIMEOUT_LEVELS - 1; level > 0; --level) {
+            if ((wheel_time & (((uint32_t)1 << TIMEOUT_LEVEL_SHIFT(level)) - 1)) == 0) {
+                slot = TIMEOUT_SLOT(wheel_time, level);
+                to = wheel[level][slot];
+                wheel[level][slot] = NULL;
+                wheel_bitmap[level] &= ~((uint32_t)1 << slot);
+                for (; to != NULL; to = to_next) {
+                    to_next = to->next;
+                    wheel_insert(to);
+                }
+            }
+        }
 
         /*
-         * Before calling callback remove current timeout from list
+         * Expire timeouts on level 0.
+         * Remove each timeout before calling callback function
          * to make sure we are safe in case callback function
-         * adds a new timeout entry to list
+         * adds or removes timeout entries
          */
-        first_timeout = first_timeout->next;    /* Set next timeout on a list as first timeout */
-        to->fn(to->arg);                        /* Call user callback function */
-        lwesp_mem_free_s((void**)&to);
+        slot = TIMEOUT_SLOT(wheel_time, 0);
+        while ((to = wheel[0][slot]) != NULL) {
+            wheel_remove(to);
+            to->flags &= ~TIMEOUT_FLAG_ACTIVE;
+            --active_cnt;
+            to->fn(to->arg);                    /* Call user callback function */
+            if (to->flags & TIMEOUT_FLAG_ALLOCATED && !(to->flags & TIMEOUT_FLAG_ACTIVE)) {
+                lwesp_mem_free_s((void**)&to);
+            }
+            now = lwesp_sys_now();              /* Callback may take time or start new timeouts */
+        }
+    }
+    if ((int32_t)(now - wheel_time) > 0) {
+        wheel_time = now;                       /* All events up to now are processed */
     }
+    wheel_processing = 0;
 }
 
 /**
@@ -96,13 +260,13 @@ uint32_t
 lwespi_get_from_mbox_with_timeout_checks(lwesp_sys_mbox_t* b, void** m, uint32_t timeout) {
     uint32_t wait_time;
     do {
-        if (first_timeout == NULL) {            /* We have no timeouts ready? */
+        if (active_cnt == 0) {                  /* We have no timeouts ready? */
             return lwesp_sys_mbox_get(b, m, timeout);   /* Get entry from message queue */
         }
         wait_time = get_next_timeout_diff();    /* Get time to wait for next timeout execution */
         if (wait_time == 0 || lwesp_sys_mbox_get(b, m, wait_time) == LWESP_SYS_TIMEOUT) {
             lwesp_core_lock();
-            process_next_timeout();             /* Process with next timeout */
+            process_timeouts();                 /* Process expired timeouts */
             lwesp_core_unlock();
         }
         break;
@@ -111,120 +275,118 @@ lwespi_get_from_mbox_with_timeout_checks(lwesp_sys_mbox_t* b, void** m, uint32_t
 }
 
 /**
- * \brief           Add new timeout to processing list
+ * \brief           Start caller-owned timeout
+ *
+ * Timeout memory is owned by caller and must stay valid until timeout expires
+ * or is stopped with \ref lwesp_timeout_stop. When timeout is already active,
+ * it is restarted with new parameters
+ *
+ * \param[in]       to: Timeout handle
  * \param[in]       time: Time in units of milliseconds for timeout execution
  * \param[in]       fn: Callback function to call when timeout expires
  * \param[in]       arg: Pointer to user specific argument to call when timeout callback function is executed
  * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
  */
 lwespr_t
-lwesp_timeout_add(uint32_t time, lwesp_timeout_fn fn, void* arg) {
-    lwesp_timeout_t* to;
-    uint32_t now;
-
+lwesp_timeout_start(lwesp_timeout_t* to, uint32_t time, lwesp_timeout_fn fn, void* arg) {
+    LWESP_ASSERT("to != NULL", to != NULL);
     LWESP_ASSERT("fn != NULL", fn != NULL);
 
-    to = lwesp_mem_calloc(1, sizeof(*to));      /* Allocate memory for timeout structure */
-    if (to == NULL) {
-        return lwespERR;
-    }
-
     lwesp_core_lock();
-    now = lwesp_sys_now();                      /* Get current time */
-    if (first_timeout != NULL) {
-        /*
-         * Since we want timeout value to start from NOW,
-         * we have to add time when we last processed our timeouts
-         */
-        time += now - last_timeout_time;        /* Add difference between now and last processed time */
+    if (to->flags & TIMEOUT_FLAG_ACTIVE) {      /* Restart active timeout */
+        wheel_remove(to);
+        --active_cnt;
+    }
+    if (active_cnt == 0 && !wheel_processing) {
+        wheel_time = lwesp_sys_now();           /* Wheel is empty, start from current time */
     }
-    to->time = time;
-    to->arg = arg;
-    to->fn = fn;
 
     /*
-     * Add new timeout to proper place on linked list
-     * and align times to have correct values between timeouts
+     * Since we want timeout value to start from NOW,
+     * we have to add time passed since wheel was last processed
      */
-    if (first_timeout == NULL) {
-        first_timeout = to;                     /* Set as first element */
-        last_timeout_time = now;                /* Reset last timeout time to current time */
-    } else {                                    /* Find where to place a new timeout */
-        /*
-         * First check if we have to put new timeout
-         * to beginning of linked list.
-         * In this case just align new value for current first element
-         */
-        if (first_timeout->time > to->time) {
-            first_timeout->time -= time;        /* Decrease first timeout value to match difference */
-            to->next = first_timeout;           /* Set first timeout as next of new one */
-            first_timeout = to;                 /* Set new timeout as first */
-        } else {                                /* Go somewhere in between current list */
-            for (lwesp_timeout_t* t = first_timeout; t != NULL; t = t->next) {
-                to->time -= t->time;            /* Decrease new timeout time by time in a linked list */
-                /*
-                 * Enter between 2 entries on a list in case:
-                 *
-                 * - We reached end of linked list
-                 * - Our time is less than diff between 2 entries in list
-                 */
-                if (t->next == NULL || t->next->time > to->time) {
-                    if (t->next != NULL) {      /* Check if there is next element */
-                        t->next->time -= to->time;  /* Decrease difference time to next one */
-                    } else if (to->time > time) {   /* Overflow of time check */
-                        to->time = time + first_timeout->time;
-                    }
-                    to->next = t->next;         /* Change order of elements */
-                    t->next = to;               /* Add new element to linked list */
-                    break;
-                }
-            }
-        }
-    }
+    to->time = lwesp_sys_now() + time;
+    to->arg = arg;
+    to->fn = fn;
+    to->flags |= TIMEOUT_FLAG_ACTIVE;
+    wheel_insert(to);
+    ++active_cnt;
     lwesp_core_unlock();
     lwesp_sys_mbox_putnow(&esp.mbox_process, NULL); /* Write message to process queue to wakeup process thread and to start */
     return lwespOK;
 }
 
+/**
+ * \brief           Stop caller-owned timeout before it expires
+ * \param[in]       to: Timeout handle, previously started with \ref lwesp_timeout_start
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_timeout_stop(lwesp_timeout_t* to) {
+    uint8_t success = 0;
+
+    LWESP_ASSERT("to != NULL", to != NULL);
+
+    lwesp_core_lock();
+    if (to->flags & TIMEOUT_FLAG_ACTIVE) {
+        wheel_remove(to);
+        to->flags &= ~TIMEOUT_FLAG_ACTIVE;
+        --active_cnt;
+        success = 1;
+    }
+    lwesp_core_unlock();
+    return success ? lwespOK : lwespERR;
+}
+
+/**
+ * \brief           Add new timeout to processing list
+ * \note            Timeout memory is allocated by stack and released after callback function is called.
+ *                  Use \ref lwesp_timeout_start for timeout without memory allocation
+ * \param[in]       time: Time in units of milliseconds for timeout execution
+ * \param[in]       fn: Callback function to call when timeout expires
+ * \param[in]       arg: Pointer to user specific argument to call when timeout callback function is executed
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_timeout_add(uint32_t time, lwesp_timeout_fn fn, void* arg) {
+    lwesp_timeout_t* to;
+
+    LWESP_ASSERT("fn != NULL", fn != NULL);
+
+    to = LWESP_MEM_CALLOC_TAG(1, sizeof(*to), LWESP_MEM_TAG_TIMEOUT);  /* Allocate memory for timeout structure */
+    if (to == NULL) {
+        return lwespERR;
+    }
+    to->flags = TIMEOUT_FLAG_ALLOCATED;
+    return lwesp_timeout_start(to, time, fn, arg);
+}
+
 /**
  * \brief           Remove callback from timeout list
+ * \note            Function has to check all timeouts, use \ref lwesp_timeout_stop
+ *                  to stop timeout by its handle
  * \param[in]       fn: Callback function to identify timeout to remove
  * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
  */
 lwespr_t
 lwesp_timeout_remove(lwesp_timeout_fn fn) {
-    uint8_t success = 0;
+    lwesp_timeout_t* to = NULL;
 
     lwesp_core_lock();
-    for (lwesp_timeout_t* t = first_timeout, *t_prev = NULL; t != NULL;
-         t_prev = t, t = t->next) {             /* Check all entries */
-        if (t->fn == fn) {                      /* Do we have a match from callback point of view? */
-
-            /*
-             * We have to first increase
-             * difference time between current and next one
-             * to be aligned for correct wait time
-             */
-            if (t->next != NULL) {              /* Do we have next element? */
-                t->next->time += t->time;       /* Increase timeout time for next element */
-            }
-
-            /*
-             * In case we have previous element on a list,
-             * set next element of previous to next of current one
-             * otherwise we were first element so simply set
-             * next of current as first one
-             */
-            if (t_prev != NULL) {
-                t_prev->next = t->next;
-            } else {
-                first_timeout = t->next;
-            }
-            lwesp_mem_free_s((void**)&t);
-            success = 1;
-            break;
+    for (uint8_t level = 0; to == NULL && level < TIMEOUT_LEVELS; ++level) {
+        for (uint8_t slot = 0; to == NULL && slot < TIMEOUT_SLOTS; ++slot) {
+            for (to = wheel[level][slot]; to != NULL && to->fn != fn; to = to->next) {}
         }
     }
+    if (to != NULL) {                           /* Do we have a match from callback point of view? */
+        wheel_remove(to);
+        to->flags &= ~TIMEOUT_FLAG_ACTIVE;
+        --active_cnt;
+        if (to->flags & TIMEOUT_FLAG_ALLOCATED) {
+            lwesp_mem_free_s((void**)&to);
+        }
+        to = (void*)1;                          /* Only mark success */
+    }
     lwesp_core_unlock();
-    return success ? lwespOK : lwespERR;
+    return to != NULL ? lwespOK : lwespERR;
 }
@@ -0,0 +1,214 @@
+/**
+ * \file            lwesp_trace.c
+ * \brief           Binary trace of AT port
+ */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwESP - Lightweight ESP-AT parser library.
+ */
+#include "lwesp/lwesp_private.h"
+#include "lwesp/lwesp_trace.h"
+
+#if LWESP_CFG_TRACE || __DOXYGEN__
+
+#define TRACE_HDR_LEN                   12      /*!< Length of record header in units of bytes */
+#define TRACE_MASK                      (LWESP_CFG_TRACE_BUFF_SIZE - 1)
+
+/*
+ * Ring buffer keeps records in output format.
+ * Positions are absolute and only increase, index in buffer is position masked with buffer size.
+ * Read position always points to beginning of oldest record.
+ */
+static uint8_t trace_buff[LWESP_CFG_TRACE_BUFF_SIZE];
+static size_t trace_r, trace_w;
+static lwesp_sys_mutex_t trace_mutex;           /*!< Protects ring buffer, trace is written from multiple threads */
+static uint8_t trace_ready;
+
+/**
+ * \brief           Write 16-bit value in little endian format
+ * \param[out]      p: Output memory
+ * \param[in]       v: Value to write
+ */
+static void
+trace_put_u16(uint8_t* p, uint16_t v) {
+    p[0] = LWESP_U8(v);
+    p[1] = LWESP_U8(v >> 8);
+}
+
+/**
+ * \brief           Write 32-bit value in little endian format
+ * \param[out]      p: Output memory
+ * \param[in]       v: Value to write
+ */
+static void
+trace_put_u32(uint8_t* p, uint32_t v) {
+    trace_put_u16(p, (uint16_t)v);
+    trace_put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+/**
+ * \brief           Write data to ring buffer at write position
+ * \param[in]       data: Data to write
+ * \param[in]       len: Length of data in units of bytes
+ */
+static void
+trace_write(const void* data, size_t len) {
+    size_t i = trace_w & TRACE_MASK, l = LWESP_MIN(len, LWESP_CFG_TRACE_BUFF_SIZE - i);
+
+    LWESP_MEMCPY(&trace_buff[i], data, l);
+    if (len > l) {
+        LWESP_MEMCPY(trace_buff, (const uint8_t*)data + l, len - l);
+    }
+    trace_w += len;
+}
+
+/**
+ * \brief           Initialize trace
+ * \return          `1` on success, `0` otherwise
+ */
+uint8_t
+lwespi_trace_init(void) {
+    if (!trace_ready) {
+        if (!lwesp_sys_mutex_create(&trace_mutex)) {
+            return 0;
+        }
+        trace_ready = 1;
+    }
+    return 1;
+}
+
+/**
+ * \brief           Write record to trace
+ * \param[in]       type: Record type
+ * \param[in]       cmd: Command type
+ * \param[in]       arg: Record argument
+ * \param[in]       data: Record data, may be `NULL` if `len` is `0`
+ * \param[in]       len: Length of data, only first \ref LWESP_CFG_TRACE_MAX_DATA bytes are written
+ */
+void
+lwespi_trace(lwesp_trace_type_t type, uint8_t cmd, uint32_t arg, const void* data, size_t len) {
+    uint8_t hdr[TRACE_HDR_LEN];
+
+    if (!trace_ready) {
+        return;
+    }
+    len = LWESP_MIN(len, LWESP_CFG_TRACE_MAX_DATA);
+    hdr[4] = LWESP_U8(type);
+    hdr[5] = cmd;
+    trace_put_u16(&hdr[6], (uint16_t)len);
+    trace_put_u32(&hdr[8], arg);
+
+    lwesp_sys_mutex_lock(&trace_mutex);
+    trace_put_u32(&hdr[0], lwesp_sys_now_us()); /* Time is taken with lock, to keep records in time order */
+
+    /* Drop oldest records to make space for new one */
+    while (trace_w + TRACE_HDR_LEN + len - trace_r > LWESP_CFG_TRACE_BUFF_SIZE) {
+        trace_r += TRACE_HDR_LEN + (trace_buff[(trace_r + 6) & TRACE_MASK]
+                                    | (trace_buff[(trace_r + 7) & TRACE_MASK] << 8));
+    }
+    trace_write(hdr, sizeof(hdr));
+    if (len > 0) {
+        trace_write(data, len);
+    }
+    lwesp_sys_mutex_unlock(&trace_mutex);
+}
+
+/**
+ * \brief           Send data to AT port and write them to trace
+ * \param[in]       data: Data to send, `NULL` to flush
+ * \param[in]       len: Length of data in units of bytes
+ * \return          Number of bytes sent by low-level driver
+ */
+size_t
+lwespi_trace_ll_send(const void* data, size_t len) {
+    if (data != NULL && len > 0) {
+        lwespi_trace(LWESP_TRACE_TYPE_TX, LWESP_U8(CMD_GET_DEF()), (uint32_t)len, data, len);
+    }
+    return esp.ll.send_fn(data, len);
+}
+
+/**
+ * \brief           Output trace in binary format
+ *
+ * Records are not removed from trace.
+ * Trace is locked during output, records written meanwhile wait for output to finish.
+ *
+ * \note            Output function must not call any stack function
+ * \param[in]       out_fn: Output function, called multiple times
+ * \param[in]       arg: User argument for output function
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_trace_dump(lwesp_trace_out_fn out_fn, void* arg) {
+    uint8_t hdr[TRACE_HDR_LEN] = { 'L', 'W', 'T', 'R', LWESP_TRACE_VERSION };
+    const char* name;
+    size_t r, len;
+
+    LWESP_ASSERT("out_fn != NULL", out_fn != NULL);
+    if (!trace_ready) {
+        return lwespERR;
+    }
+
+    out_fn(hdr, 8, arg);
+
+    /* Names of commands, decoder does not depend on configuration of the stack */
+    LWESP_MEMSET(hdr, 0x00, sizeof(hdr));
+    hdr[4] = LWESP_TRACE_TYPE_NAME;
+    for (size_t i = 0; i < LWESP_CMD_END; ++i) {
+        if ((name = lwespi_cmd_name(i)) != NULL) {
+            len = strlen(name);
+            hdr[5] = LWESP_U8(i);
+            trace_put_u16(&hdr[6], (uint16_t)len);
+            out_fn(hdr, sizeof(hdr), arg);
+            out_fn(name, len, arg);
+        }
+    }
+
+    /* Records, at most two linear blocks of ring buffer */
+    lwesp_sys_mutex_lock(&trace_mutex);
+    for (r = trace_r; r != trace_w; r += len) {
+        len = LWESP_MIN(trace_w - r, LWESP_CFG_TRACE_BUFF_SIZE - (r & TRACE_MASK));
+        out_fn(&trace_buff[r & TRACE_MASK], len, arg);
+    }
+    lwesp_sys_mutex_unlock(&trace_mutex);
+    return lwespOK;
+}
+
+/**
+ * \brief           Remove all records from trace
+ * \return          \ref lwespOK on success, member of \ref lwespr_t enumeration otherwise
+ */
+lwespr_t
+lwesp_trace_clear(void) {
+    if (!trace_ready) {
+        return lwespERR;
+    }
+    lwesp_sys_mutex_lock(&trace_mutex);
+    trace_r = trace_w;
+    lwesp_sys_mutex_unlock(&trace_mutex);
+    return lwespOK;
+}
+
+#endif /* LWESP_CFG_TRACE || __DOXYGEN__ */
@@ -0,0 +1,1077 @@
+/**
+ * \file            lwesp_ll_emul.c
+ * \brief           Low-level communication with emulated ESP device for POSIX systems
+ */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwESP - Lightweight ESP-AT parser library.
+ */
+
+/*
+ * Emulator of Ai-thinker ESP8266 AT firmware, used instead of lwesp_ll_posix.c
+ * to run the stack on a host without a module.
+ *
+ * Commands written by the stack are parsed in the send function,
+ * responses and received network data are fed back through input module
+ * from a separate thread, paced at the configured UART baudrate.
+ * TCP and UDP connections are bridged to host sockets, server is a host listening socket.
+ */
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE                         /* getaddrinfo and clock_nanosleep */
+#endif /* _DEFAULT_SOURCE */
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "system/lwesp_ll.h"
+#include "lwesp/lwesp.h"
+#include "lwesp/lwesp_mem.h"
+#include "lwesp/lwesp_input.h"
+
+#if !__DOXYGEN__
+
+/**
+ * \brief           Set to `1` to deliver data at speed of configured UART baudrate,
+ *                  or to `0` to deliver data as fast as possible
+ */
+#ifndef LWESP_LL_EMUL_SIMULATE_BAUDRATE
+#define LWESP_LL_EMUL_SIMULATE_BAUDRATE 1
+#endif
+
+/**
+ * \brief           SSID of emulated access point, station can join to any password
+ */
+#ifndef LWESP_LL_EMUL_SSID
+#define LWESP_LL_EMUL_SSID              "lwesp_emul"
+#endif
+
+/**
+ * \brief           Maximal baudrate at which emulated UART link works, or `0` for no limit.
+ *                  Above it, data in both directions are lost
+ */
+#ifndef LWESP_LL_EMUL_MAX_BAUDRATE
+#define LWESP_LL_EMUL_MAX_BAUDRATE      0
+#endif
+
+#define EMUL_MAX_SEND_LEN               2048    /*!< Maximal length of single `AT+CIPSEND` */
+#define EMUL_MAX_IPD_LEN                1460    /*!< Maximal length of single `+IPD` data */
+#define EMUL_BITS_PER_BYTE              10      /*!< Start bit, 8 data bits and stop bit */
+
+/**
+ * \brief           Emulated connection
+ */
+typedef struct {
+    int fd;                                     /*!< Socket descriptor or `-1` when connection is closed */
+    uint8_t is_udp;                             /*!< Set to `1` for UDP connection */
+    uint8_t is_server;                          /*!< Set to `1` when connection was accepted by server */
+    char remote_ip[INET_ADDRSTRLEN];            /*!< Remote IP address */
+    uint16_t remote_port;                       /*!< Remote port */
+    uint16_t local_port;                        /*!< Local port */
+} emul_conn_t;
+
+static uint8_t initialized = 0;
+static lwesp_sys_thread_t thread_handle;
+static lwesp_sys_mutex_t emul_mutex;            /*!< Protects connections between send function and thread */
+static int out_pipe[2] = { -1, -1 };            /*!< Command responses, read by thread */
+static uint32_t baudrate;                       /*!< Current UART baudrate, protected by mutex */
+static uint32_t dev_baudrate = LWESP_CFG_AT_PORT_BAUDRATE;  /*!< UART baudrate of emulated device, protected by mutex */
+static struct timespec rx_time, tx_time;        /*!< Time when UART line is free again */
+
+static emul_conn_t conns[LWESP_CFG_MAX_CONNS];
+static int server_fd = -1;                      /*!< Listening socket when server is enabled */
+static uint16_t server_port;
+
+/* Command parser state, used only from send function */
+static char cmd[0x200];                         /*!< Received command line */
+static size_t cmd_len;
+static uint8_t echo = 1;                        /*!< Echo mode, enabled after reset */
+static uint8_t cwmode = 1;
+static uint8_t dinfo = 0;                       /*!< Set to `1` when `+IPD` includes remote IP and port */
+static uint8_t sta_has_ip = 0;
+static uint8_t cipmux = 1;                      /*!< Multiple connections, stack enables them in reset sequence */
+static uint8_t cipmode = 0;                     /*!< Set to `1` in transparent transmission mode */
+static uint8_t passthrough = 0;                 /*!< Set to `1` after open-ended `AT+CIPSEND`, until `+++` */
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+static volatile uint8_t rts_stop = 0;           /*!< Set to `1` while stack asks device to stop sending */
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL */
+
+/* Data mode after `AT+CIPSEND` prompt */
+static uint8_t send_active = 0;
+static uint8_t send_conn;
+static size_t send_len, send_received;
+static uint8_t send_data_buff[EMUL_MAX_SEND_LEN];
+static struct sockaddr_in send_addr;
+static uint8_t send_has_addr;
+
+static void emul_thread(void* param);
+
+/**
+ * \brief           Wait until UART line is free and reserve it for transfer of `len` bytes
+ * \param[in,out]   t: Time when line becomes free
+ * \param[in]       len: Number of bytes to transfer
+ */
+static void
+line_wait(struct timespec* t, size_t len) {
+#if LWESP_LL_EMUL_SIMULATE_BAUDRATE
+    struct timespec now;
+    uint64_t ns;
+    uint32_t br;
+
+    lwesp_sys_mutex_lock(&emul_mutex);
+    br = baudrate;
+    lwesp_sys_mutex_unlock(&emul_mutex);
+    if (br == 0) {
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (now.tv_sec > t->tv_sec || (now.tv_sec == t->tv_sec && now.tv_nsec > t->tv_nsec)) {
+        *t = now;                               /* Line was idle */
+    }
+    ns = (uint64_t)len * EMUL_BITS_PER_BYTE * 1000000000ULL / br;
+    ns += (uint64_t)t->tv_nsec;
+    t->tv_sec += (time_t)(ns / 1000000000ULL);
+    t->tv_nsec = (long)(ns % 1000000000ULL);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, t, NULL) == EINTR) {}
+#else /* LWESP_LL_EMUL_SIMULATE_BAUDRATE */
+    LWESP_UNUSED(t);
+    LWESP_UNUSED(len);
+#endif /* !LWESP_LL_EMUL_SIMULATE_BAUDRATE */
+}
+
+/**
+ * \brief           Deliver data from emulated device to stack, called from emulator thread only
+ * \param[in]       data: Data to deliver
+ * \param[in]       len: Length of data in units of bytes
+ */
+static void
+rx_deliver(const void* data, size_t len) {
+    const uint8_t* d = data;
+    size_t l;
+
+    while (len > 0) {
+        l = LWESP_MIN(len, 64);                 /* Small chunks keep pacing smooth */
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+        while (rts_stop) {                      /* Device checks CTS pin before every chunk */
+            usleep(100);
+        }
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL */
+        line_wait(&rx_time, l);
+#if LWESP_CFG_INPUT_USE_PROCESS
+        lwesp_input_process(d, l);
+#else /* LWESP_CFG_INPUT_USE_PROCESS */
+        {
+            size_t done = 0, bl;
+            uint8_t* b;
+
+            /* Real device does not wait, but emulator is used to measure stack, not to lose data */
+            while (done < l) {
+                b = lwesp_input_get_write_block(&bl);
+                if (b == NULL) {
+                    usleep(100);                /* Wait processing thread to free memory */
+                    continue;
+                }
+                bl = LWESP_MIN(bl, l - done);
+                memcpy(b, &d[done], bl);
+                lwesp_input_write_advance(bl);
+                done += bl;
+            }
+        }
+#endif /* !LWESP_CFG_INPUT_USE_PROCESS */
+        d += l;
+        len -= l;
+    }
+}
+
+/**
+ * \brief           Check if UART link works at current baudrate
+ * \return          `1` when stack and device use the same baudrate and it is not above the limit, `0` otherwise
+ */
+static uint8_t
+link_is_ok(void) {
+    uint8_t ok;
+
+    lwesp_sys_mutex_lock(&emul_mutex);
+    ok = baudrate == dev_baudrate && (LWESP_LL_EMUL_MAX_BAUDRATE == 0 || baudrate <= LWESP_LL_EMUL_MAX_BAUDRATE);
+    lwesp_sys_mutex_unlock(&emul_mutex);
+    return ok;
+}
+
+/**
+ * \brief           Send formatted response to stack.
+ *
+ * Response is queued to emulator thread, to keep order with received network data
+ * and not to enter the parser from send function
+ * \param[in]       fmt: Format string
+ */
+static void
+reply(const char* fmt, ...) {
+    char buff[0x200];
+    va_list va;
+    int len;
+    ssize_t ret;
+
+    if (!link_is_ok()) {
+        return;                                 /* Response is lost on line */
+    }
+    va_start(va, fmt);
+    len = vsnprintf(buff, sizeof(buff), fmt, va);
+    va_end(va);
+    if (len <= 0) {
+        return;
+    }
+    len = LWESP_MIN(len, (int)sizeof(buff) - 1);
+    for (int written = 0; written < len; written += (int)ret) {
+        ret = write(out_pipe[1], &buff[written], (size_t)(len - written));
+        if (ret < 0) {
+            if (errno == EINTR) {
+                ret = 0;
+                continue;
+            }
+            break;
+        }
+    }
+}
+
+/**
+ * \brief           Parse unsigned number from command and skip following comma
+ * \param[in,out]   s: Pointer to pointer to string
+ * \return          Parsed number
+ */
+static uint32_t
+parse_num(const char** s) {
+    uint32_t n = 0;
+
+    while (**s >= '0' && **s <= '9') {
+        n = n * 10 + (uint32_t)(**s - '0');
+        ++*s;
+    }
+    if (**s == ',') {
+        ++*s;
+    }
+    return n;
+}
+
+/**
+ * \brief           Parse quoted string with escaped characters from command and skip following comma
+ * \param[in,out]   s: Pointer to pointer to string
+ * \param[out]      out: Output buffer
+ * \param[in]       out_len: Length of output buffer
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+parse_str(const char** s, char* out, size_t out_len) {
+    const char* p = *s;
+    size_t i = 0;
+
+    if (*p++ != '"') {
+        return 0;
+    }
+    while (*p != '\0' && *p != '"') {
+        if (*p == '\\' && p[1] != '\0') {
+            ++p;
+        }
+        if (i + 1 < out_len) {
+            out[i++] = *p;
+        }
+        ++p;
+    }
+    out[i] = '\0';
+    if (*p != '"') {
+        return 0;
+    }
+    ++p;
+    if (*p == ',') {
+        ++p;
+    }
+    *s = p;
+    return 1;
+}
+
+/**
+ * \brief           Close connection socket, mutex must be locked
+ * \param[in]       num: Connection number
+ */
+static void
+conn_close(size_t num) {
+    if (conns[num].fd >= 0) {
+        close(conns[num].fd);
+        conns[num].fd = -1;
+    }
+}
+
+/**
+ * \brief           Get duplicate of connection socket descriptor.
+ *
+ * Emulator thread may close connection at any time, duplicate stays valid until closed by caller
+ * \param[in]       num: Connection number
+ * \return          Socket descriptor or `-1` when connection is not active
+ */
+static int
+conn_fd_dup(size_t num) {
+    int fd = -1;
+
+    lwesp_sys_mutex_lock(&emul_mutex);
+    if (num < LWESP_ARRAYSIZE(conns) && conns[num].fd >= 0) {
+        fd = dup(conns[num].fd);
+    }
+    lwesp_sys_mutex_unlock(&emul_mutex);
+    return fd;
+}
+
+/**
+ * \brief           Close everything, as device does on reset
+ */
+static void
+device_reset(void) {
+    lwesp_sys_mutex_lock(&emul_mutex);
+    for (size_t i = 0; i < LWESP_ARRAYSIZE(conns); ++i) {
+        conn_close(i);
+    }
+    if (server_fd >= 0) {
+        close(server_fd);
+        server_fd = -1;
+    }
+    dev_baudrate = LWESP_CFG_AT_PORT_BAUDRATE;
+    lwesp_sys_mutex_unlock(&emul_mutex);
+    echo = 1;
+    dinfo = 0;
+    sta_has_ip = 0;
+    cipmux = 1;
+    cipmode = 0;
+    passthrough = 0;
+    send_active = 0;
+    cmd_len = 0;
+}
+
+/**
+ * \brief           Process `AT+CIPSTART` command
+ * \param[in]       s: Command parameters
+ */
+static void
+cmd_cipstart(const char* s) {
+    char type[8], host[128];
+    struct addrinfo hints = { 0 }, *ai = NULL;
+    struct sockaddr_in la;
+    socklen_t la_len = sizeof(la);
+    emul_conn_t c = { .fd = -1 };
+    uint32_t num, port;
+    char port_str[8];
+    int fd;
+
+    num = cipmux ? parse_num(&s) : 0;           /* Link ID is not used in single connection mode */
+    if (num >= LWESP_ARRAYSIZE(conns) || !parse_str(&s, type, sizeof(type))
+        || !parse_str(&s, host, sizeof(host)) || (port = parse_num(&s)) == 0 || port > 0xFFFF) {
+        reply("\r\nERROR\r\n");
+        return;
+    }
+    if ((fd = conn_fd_dup(num)) >= 0) {
+        close(fd);
+        reply("ALREADY CONNECTED\r\n\r\nERROR\r\n");
+        return;
+    }
+    c.is_udp = !strcmp(type, "UDP");
+    if (!c.is_udp && strcmp(type, "TCP")) { /* SSL is not bridged */
+        reply("\r\nERROR\r\n");
+        return;
+    }
+
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = c.is_udp ? SOCK_DGRAM : SOCK_STREAM;
+    snprintf(port_str, sizeof(port_str), "%u", (unsigned)port);
+    if (getaddrinfo(host, port_str, &hints, &ai) != 0 || ai == NULL) {
+        reply("DNS Fail\r\n\r\nERROR\r\n");
+        return;
+    }
+    c.fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+    if (c.fd < 0 || connect(c.fd, ai->ai_addr, ai->ai_addrlen) != 0) {
+        if (c.fd >= 0) {
+            close(c.fd);
+        }
+        freeaddrinfo(ai);
+        if (cipmux) {
+            reply("%u,CLOSED\r\n\r\nERROR\r\n", (unsigned)num);
+        } else {
+            reply("CLOSED\r\n\r\nERROR\r\n");
+        }
+        return;
+    }
+    inet_ntop(AF_INET, &((struct sockaddr_in*)ai->ai_addr)->sin_addr, c.remote_ip, sizeof(c.remote_ip));
+    freeaddrinfo(ai);
+    c.remote_port = (uint16_t)port;
+    if (getsockname(c.fd, (struct sockaddr*)&la, &la_len) == 0) {
+        c.local_port = ntohs(la.sin_port);
+    }
+
+    /* Response is queued before socket is visible to thread, data may not overtake "CONNECT" */
+    if (cipmux) {
+        reply("%u,CONNECT\r\n\r\nOK\r\n", (unsigned)num);
+    } else {
+        reply("CONNECT\r\n\r\nOK\r\n");
+    }
+    lwesp_sys_mutex_lock(&emul_mutex);
+    conns[num] = c;
+    lwesp_sys_mutex_unlock(&emul_mutex);
+}
+
+/**
+ * \brief           Process `AT+CIPSEND` command
+ * \param[in]       s: Command parameters
+ */
+static void
+cmd_cipsend(const char* s) {
+    char ip[INET_ADDRSTRLEN];
+    uint32_t num, len;
+    int fd;
+
+    num = parse_num(&s);
+    len = parse_num(&s);
+    if ((fd = conn_fd_dup(num)) < 0) {
+        reply("link is not valid\r\n\r\nERROR\r\n");
+        return;
+    }
+    close(fd);
+    if (len == 0 || len > EMUL_MAX_SEND_LEN) {
+        reply("\r\nERROR\r\n");
+        return;
+    }
+    send_has_addr = 0;
+    if (*s == '"') {                            /* Optional remote address of UDP connection */
+        memset(&send_addr, 0x00, sizeof(send_addr));
+        send_addr.sin_family = AF_INET;
+        if (!parse_str(&s, ip, sizeof(ip)) || inet_pton(AF_INET, ip, &send_addr.sin_addr) != 1) {
+            reply("\r\nERROR\r\n");
+            return;
+        }
+        send_addr.sin_port = htons((uint16_t)parse_num(&s));
+        send_has_addr = 1;
+    }
+    send_conn = (uint8_t)num;
+    send_len = len;
+    send_received = 0;
+    send_active = 1;
+    reply("\r\nOK\r\n> ");
+}
+
+/**
+ * \brief           Data for active `AT+CIPSEND` were received completely
+ */
+static void
+send_finish(void) {
+    ssize_t ret = -1;
+    int fd;
+
+    send_active = 0;
+    fd = conn_fd_dup(send_conn);
+    if (fd >= 0) {
+        if (send_has_addr) {
+            ret = sendto(fd, send_data_buff, send_len, MSG_NOSIGNAL, (struct sockaddr*)&send_addr, sizeof(send_addr));
+        } else {
+            size_t sent = 0;
+            while (sent < send_len) {
+                ret = send(fd, &send_data_buff[sent], send_len - sent, MSG_NOSIGNAL);
+                if (ret <= 0) {
+                    break;
+                }
+                sent += (size_t)ret;
+            }
+        }
+        close(fd);
+    }
+    reply("\r\nRecv %u bytes\r\n\r\n%s\r\n", (unsigned)send_len, ret > 0 ? "SEND OK" : "SEND FAIL");
+}
+
+/**
+ * \brief           Send data of transparent transmission to connection
+ * \param[in]       d: Data to send
+ * \param[in]       len: Number of bytes to send
+ */
+static void
+passthrough_send(const uint8_t* d, size_t len) {
+    ssize_t ret;
+    int fd;
+
+    if ((fd = conn_fd_dup(0)) < 0) {
+        return;                                 /* Data are lost when connection is closed */
+    }
+    while (len > 0 && (ret = send(fd, d, len, MSG_NOSIGNAL)) > 0) {
+        d += ret;
+        len -= (size_t)ret;
+    }
+    close(fd);
+}
+
+/**
+ * \brief           Process `AT+CIPSERVER` command
+ * \param[in]       s: Command parameters
+ */
+static void
+cmd_cipserver(const char* s) {
+    struct sockaddr_in sa = { 0 };
+    uint32_t en, port;
+    int fd, one = 1;
+
+    en = parse_num(&s);
+    port = *s != '\0' ? parse_num(&s) : 333;
+    if (!en) {
+        lwesp_sys_mutex_lock(&emul_mutex);
+        if (server_fd >= 0) {
+            close(server_fd);
+            server_fd = -1;
+        }
+        lwesp_sys_mutex_unlock(&emul_mutex);
+        reply("\r\nOK\r\n");
+        return;
+    }
+    if (server_fd >= 0) {
+        reply(port == server_port ? "no change\r\n\r\nOK\r\n" : "\r\nERROR\r\n");
+        return;
+    }
+    sa.sin_family = AF_INET;
+    sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    sa.sin_port = htons((uint16_t)port);
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        reply("\r\nERROR\r\n");
+        return;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (bind(fd, (struct sockaddr*)&sa, sizeof(sa)) != 0 || listen(fd, LWESP_CFG_MAX_CONNS) != 0) {
+        close(fd);
+        reply("\r\nERROR\r\n");
+        return;
+    }
+    server_port = (uint16_t)port;
+    lwesp_sys_mutex_lock(&emul_mutex);
+    server_fd = fd;
+    lwesp_sys_mutex_unlock(&emul_mutex);
+    reply("\r\nOK\r\n");
+}
+
+/**
+ * \brief           Process complete command line
+ * \param[in]       line: Command without line ending
+ */
+static void
+process_cmd(const char* line) {
+    const char* s;
+
+    if (echo) {
+        reply("%s\r\n", line);
+    }
+    if (strncmp(line, "AT", 2)) {
+        reply("\r\nERROR\r\n");
+        return;
+    }
+    line += 2;
+
+#define IS_CMD(name)        (!strncmp(line, (name), sizeof(name) - 1) && (s = line + sizeof(name) - 1) != NULL)
+
+    if (*line == '\0') {
+        reply("\r\nOK\r\n");
+    } else if (IS_CMD("E0") || IS_CMD("E1")) {
+        echo = line[1] == '1';
+        reply("\r\nOK\r\n");
+    } else if (IS_CMD("+RST") || IS_CMD("+RESTORE")) {
+        reply("\r\nOK\r\n");
+        device_reset();
+        reply("\r\n ets Jan  8 2013,rst cause:2, boot mode:(3,7)\r\n\r\nready\r\n");
+    } else if (IS_CMD("+GMR")) {
+        reply("AT version:2.2.0.0(s-b097cdf - ESP8266 - Jun 17 2021 12:57:45)\r\n"
+              "SDK version:v3.4-22-g967752e2\r\n"
+              "compile time(6800286):Aug  4 2021 17:20:05\r\n"
+              "Bin version:2.2.0(Cytron_ESP-01S)\r\n\r\nOK\r\n");
+    } else if (IS_CMD("+UART_CUR=")) {
+        uint32_t br = parse_num(&s);
+
+        reply("\r\nOK\r\n");                    /* Stack sets new baudrate after "OK" */
+        lwesp_sys_mutex_lock(&emul_mutex);
+        dev_baudrate = br;
+        lwesp_sys_mutex_unlock(&emul_mutex);
+    } else if (IS_CMD("+CWMODE?")) {
+        reply("+CWMODE:%u\r\n\r\nOK\r\n", (unsigned)cwmode);
+    } else if (IS_CMD("+CWMODE=")) {
+        cwmode = (uint8_t)parse_num(&s);
+        reply("\r\nOK\r\n");
+    } else if (IS_CMD("+CWDHCP?")) {
+        reply("+CWDHCP:3\r\n\r\nOK\r\n");
+    } else if (IS_CMD("+CIPSTATUS")) {
+        reply("STATUS:%u\r\n", sta_has_ip ? 2U : 5U);
+        lwesp_sys_mutex_lock(&emul_mutex);
+        for (size_t i = 0; i < LWESP_ARRAYSIZE(conns); ++i) {
+            if (conns[i].fd >= 0) {
+                reply("+CIPSTATUS:%u,\"%s\",\"%s\",%u,%u,%u\r\n", (unsigned)i, conns[i].is_udp ? "UDP" : "TCP",
+                      conns[i].remote_ip, (unsigned)conns[i].remote_port, (unsigned)conns[i].local_port,
+                      (unsigned)conns[i].is_server);
+            }
+        }
+        lwesp_sys_mutex_unlock(&emul_mutex);
+        reply("\r\nOK\r\n");
+    } else if (IS_CMD("+CIPSTA?")) {
+        if (sta_has_ip) {
+            reply("+CIPSTA:ip:\"127.0.0.1\"\r\n+CIPSTA:gateway:\"127.0.0.1\"\r\n+CIPSTA:netmask:\"255.0.0.0\"\r\n\r\nOK\r\n");
+        } else {
+            reply("+CIPSTA:ip:\"0.0.0.0\"\r\n+CIPSTA:gateway:\"0.0.0.0\"\r\n+CIPSTA:netmask:\"0.0.0.0\"\r\n\r\nOK\r\n");
+        }
+    } else if (IS_CMD("+CIPAP?")) {
+        reply("+CIPAP:ip:\"192.168.4.1\"\r\n+CIPAP:gateway:\"192.168.4.1\"\r\n+CIPAP:netmask:\"255.255.255.0\"\r\n\r\nOK\r\n");
+    } else if (IS_CMD("+CIPSTAMAC?")) {
+        reply("+CIPSTAMAC:\"18:fe:34:00:00:01\"\r\n\r\nOK\r\n");
+    } else if (IS_CMD("+CIPAPMAC?")) {
+        reply("+CIPAPMAC:\"1a:fe:34:00:00:01\"\r\n\r\nOK\r\n");
+    } else if (IS_CMD("+CIPDINFO=")) {
+        dinfo = (uint8_t)parse_num(&s);
+        reply("\r\nOK\r\n");
+    } else if (IS_CMD("+CWLAPOPT=")) {
+        reply("\r\nOK\r\n");
+    } else if (IS_CMD("+CWLAP")) {
+        reply("+CWLAP:(3,\"" LWESP_LL_EMUL_SSID "\",-45,\"24:0a:c4:00:00:01\",6)\r\n"
+              "+CWLAP:(4,\"" LWESP_LL_EMUL_SSID "_2\",-71,\"24:0a:c4:00:00:02\",11)\r\n\r\nOK\r\n");
+    } else if (IS_CMD("+CWJAP?")) {
+        if (sta_has_ip) {
+            reply("+CWJAP:\"" LWESP_LL_EMUL_SSID "\",\"24:0a:c4:00:00:01\",6,-45\r\n\r\nOK\r\n");
+        } else {
+            reply("No AP\r\n\r\nOK\r\n");
+        }
+    } else if (IS_CMD("+CWJAP=")) {
+        char ssid[LWESP_CFG_MAX_SSID_LENGTH + 1];
+
+        if (parse_str(&s, ssid, sizeof(ssid)) && !strncmp(ssid, LWESP_LL_EMUL_SSID, sizeof(ssid))) {
+            sta_has_ip = 1;
+            reply("WIFI CONNECTED\r\nWIFI GOT IP\r\n\r\nOK\r\n");
+        } else {
+            reply("+CWJAP:3\r\n\r\nFAIL\r\n");  /* Cannot find the target AP */
+        }
+    } else if (IS_CMD("+CWQAP")) {
+        if (sta_has_ip) {
+            sta_has_ip = 0;
+            reply("\r\nOK\r\nWIFI DISCONNECT\r\n");
+        } else {
+            reply("\r\nOK\r\n");
+        }
+    } else if (IS_CMD("+CIPSTART=")) {
+        if (sta_has_ip) {
+            cmd_cipstart(s);
+        } else {
+            reply("\r\nERROR\r\n");
+        }
+    } else if (IS_CMD("+CIPSEND=")) {
+        cmd_cipsend(s);
+    } else if (!strcmp(line, "+CIPSEND")) {     /* Open-ended send of transparent transmission */
+        int fd = conn_fd_dup(0);
+
+        if (fd >= 0 && cipmode) {
+            passthrough = 1;
+            reply("\r\nOK\r\n\r\n>");
+        } else {
+            reply("\r\nERROR\r\n");
+        }
+        if (fd >= 0) {
+            close(fd);
+        }
+    } else if (!strcmp(line, "+CIPCLOSE")) {    /* Close connection in single connection mode */
+        uint8_t closed = 0;
+
+        lwesp_sys_mutex_lock(&emul_mutex);
+        if (!cipmux && conns[0].fd >= 0) {
+            conn_close(0);
+            closed = 1;
+        }
+        lwesp_sys_mutex_unlock(&emul_mutex);
+        reply(closed ? "CLOSED\r\n\r\nOK\r\n" : "\r\nERROR\r\n");
+    } else if (IS_CMD("+CIPMUX=")) {
+        uint32_t mux = parse_num(&s);
+        uint8_t busy = 0;
+
+        lwesp_sys_mutex_lock(&emul_mutex);
+        for (size_t i = 0; i < LWESP_ARRAYSIZE(conns); ++i) {
+            busy |= conns[i].fd >= 0;
+        }
+        busy |= server_fd >= 0;
+        lwesp_sys_mutex_unlock(&emul_mutex);
+        if (mux > 1 || busy || cipmode) {       /* Mode can be changed only without connections */
+            reply("\r\nERROR\r\n");
+        } else {
+            cipmux = (uint8_t)mux;
+            reply("\r\nOK\r\n");
+        }
+    } else if (IS_CMD("+CIPMODE=")) {
+        uint32_t mode = parse_num(&s);
+
+        if (mode > 1 || (mode == 1 && cipmux)) {/* Transparent transmission needs single connection mode */
+            reply("\r\nERROR\r\n");
+        } else {
+            cipmode = (uint8_t)mode;
+            reply("\r\nOK\r\n");
+        }
+    } else if (IS_CMD("+CIPCLOSE=")) {
+        uint32_t num = parse_num(&s);
+        uint8_t closed = 0;
+
+        lwesp_sys_mutex_lock(&emul_mutex);
+        if (num < LWESP_ARRAYSIZE(conns) && conns[num].fd >= 0) {
+            conn_close(num);
+            closed = 1;
+        }
+        lwesp_sys_mutex_unlock(&emul_mutex);
+        if (closed) {
+            reply("%u,CLOSED\r\n\r\nOK\r\n", (unsigned)num);
+        } else {
+            reply("\r\nERROR\r\n");
+        }
+    } else if (IS_CMD("+CIPSERVER=")) {
+        cmd_cipserver(s);
+    } else if (IS_CMD("+CIPSERVERMAXCONN=")
+               || IS_CMD("+CIPSTO=") || IS_CMD("+CWDHCP=") || IS_CMD("+CWAUTOCONN=")
+               || IS_CMD("+CIPDNS=") || IS_CMD("+CWHOSTNAME=")) {
+        reply("\r\nOK\r\n");                    /* Settings without effect on emulation */
+    } else {
+        reply("\r\nERROR\r\n");
+    }
+#undef IS_CMD
+}
+
+/**
+ * \brief           Send data to ESP device, function called from ESP stack when we have data to send
+ * \param[in]       data: Pointer to data to send
+ * \param[in]       len: Number of bytes to send
+ * \return          Number of bytes sent
+ */
+static size_t
+send_data(const void* data, size_t len) {
+    const uint8_t* d = data;
+    size_t l;
+
+    if (data == NULL || len == 0) {
+        return 0;                               /* Data are processed immediately, no flush is needed */
+    }
+    line_wait(&tx_time, len);
+    if (!link_is_ok()) {
+        cmd_len = 0;                            /* Data are lost on line */
+        return len;
+    }
+    if (passthrough) {                          /* Transparent transmission until single "+++" packet */
+        if (len == 3 && !memcmp(d, "+++", 3)) {
+            passthrough = 0;
+        } else {
+            passthrough_send(d, len);
+        }
+        return len;
+    }
+    for (size_t i = 0; i < len; i += l) {
+        if (send_active) {                      /* Raw data of "AT+CIPSEND" */
+            l = LWESP_MIN(len - i, send_len - send_received);
+            memcpy(&send_data_buff[send_received], &d[i], l);
+            send_received += l;
+            if (send_received == send_len) {
+                send_finish();
+            }
+            continue;
+        }
+        l = 1;
+        if (d[i] == '\n') {
+            if (cmd_len > 0 && cmd[cmd_len - 1] == '\r') {
+                --cmd_len;
+            }
+            cmd[cmd_len] = '\0';
+            if (cmd_len > 0) {
+                process_cmd(cmd);
+            }
+            cmd_len = 0;
+        } else if (cmd_len < sizeof(cmd) - 1) {
+            cmd[cmd_len++] = (char)d[i];
+        }
+    }
+    return len;
+}
+
+/**
+ * \brief           Deliver data received on connection socket
+ * \param[in]       num: Connection number
+ * \param[in]       fd: Socket descriptor from poll set
+ */
+static void
+conn_receive(size_t num, int fd) {
+    uint8_t buff[EMUL_MAX_IPD_LEN];
+    char hdr[64];
+    struct sockaddr_in sa;
+    socklen_t sa_len = sizeof(sa);
+    char ip[INET_ADDRSTRLEN];
+    ssize_t len;
+    int hdr_len;
+
+    len = recvfrom(fd, buff, sizeof(buff), MSG_DONTWAIT, (struct sockaddr*)&sa, &sa_len);
+    if (len < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)) {
+        return;
+    }
+
+    lwesp_sys_mutex_lock(&emul_mutex);
+    if (conns[num].fd != fd) {                  /* Closed by command meanwhile */
+        lwesp_sys_mutex_unlock(&emul_mutex);
+        return;
+    }
+    if (len <= 0) {                             /* Closed by remote side */
+        conn_close(num);
+        lwesp_sys_mutex_unlock(&emul_mutex);
+        if (cipmode) {
+            return;                             /* Not reported in transparent transmission */
+        }
+        hdr_len = cipmux ? snprintf(hdr, sizeof(hdr), "%u,CLOSED\r\n", (unsigned)num) : snprintf(hdr, sizeof(hdr), "CLOSED\r\n");
+        rx_deliver(hdr, (size_t)hdr_len);
+        return;
+    }
+    if (conns[num].is_udp) {
+        inet_ntop(AF_INET, &sa.sin_addr, ip, sizeof(ip));
+        sa.sin_port = ntohs(sa.sin_port);
+    } else {
+        strcpy(ip, conns[num].remote_ip);
+        sa.sin_port = conns[num].remote_port;
+    }
+    lwesp_sys_mutex_unlock(&emul_mutex);
+
+    if (cipmode) {                              /* Transparent transmission has no +IPD header */
+        rx_deliver(buff, (size_t)len);
+        return;
+    }
+    if (dinfo) {
+        hdr_len = snprintf(hdr, sizeof(hdr), "\r\n+IPD,%u,%u,%s,%u:", (unsigned)num, (unsigned)len, ip, (unsigned)sa.sin_port);
+    } else {
+        hdr_len = snprintf(hdr, sizeof(hdr), "\r\n+IPD,%u,%u:", (unsigned)num, (unsigned)len);
+    }
+    rx_deliver(hdr, (size_t)hdr_len);
+    rx_deliver(buff, (size_t)len);
+}
+
+/**
+ * \brief           Accept new connection on server socket
+ * \param[in]       fd: Server socket descriptor from poll set
+ */
+static void
+server_accept(int fd) {
+    struct sockaddr_in sa, la;
+    socklen_t sa_len = sizeof(sa), la_len = sizeof(la);
+    char hdr[32];
+    int cfd, hdr_len;
+
+    cfd = accept(fd, (struct sockaddr*)&sa, &sa_len);
+    if (cfd < 0) {
+        return;
+    }
+    lwesp_sys_mutex_lock(&emul_mutex);
+    for (size_t i = 0; i < LWESP_ARRAYSIZE(conns); ++i) {
+        if (conns[i].fd < 0) {
+            conns[i].fd = cfd;
+            conns[i].is_udp = 0;
+            conns[i].is_server = 1;
+            inet_ntop(AF_INET, &sa.sin_addr, conns[i].remote_ip, sizeof(conns[i].remote_ip));
+            conns[i].remote_port = ntohs(sa.sin_port);
+            conns[i].local_port = getsockname(cfd, (struct sockaddr*)&la, &la_len) == 0 ? ntohs(la.sin_port) : 0;
+            lwesp_sys_mutex_unlock(&emul_mutex);
+
+            hdr_len = snprintf(hdr, sizeof(hdr), "%u,CONNECT\r\n", (unsigned)i);
+            rx_deliver(hdr, (size_t)hdr_len);
+            return;
+        }
+    }
+    lwesp_sys_mutex_unlock(&emul_mutex);
+    close(cfd);                                 /* No free connection */
+}
+
+/**
+ * \brief           Emulator thread
+ *
+ * Thread sleeps in `poll` on response pipe and all sockets.
+ * Responses are always delivered before network data, to keep order of device output
+ */
+static void
+emul_thread(void* param) {
+    struct pollfd pfd[LWESP_CFG_MAX_CONNS + 2];
+    size_t pfd_conn[LWESP_CFG_MAX_CONNS + 2];
+    uint8_t buff[0x200];
+    ssize_t len;
+    nfds_t n;
+
+    LWESP_UNUSED(param);
+
+    while (1) {
+        /* Build poll set from current sockets */
+        n = 0;
+        pfd[n].fd = out_pipe[0];
+        pfd[n++].events = POLLIN;
+        lwesp_sys_mutex_lock(&emul_mutex);
+        if (server_fd >= 0) {
+            pfd[n].fd = server_fd;
+            pfd_conn[n] = LWESP_CFG_MAX_CONNS;
+            pfd[n++].events = POLLIN;
+        }
+        for (size_t i = 0; i < LWESP_ARRAYSIZE(conns); ++i) {
+            if (conns[i].fd >= 0) {
+                pfd[n].fd = conns[i].fd;
+                pfd_conn[n] = i;
+                pfd[n++].events = POLLIN;
+            }
+        }
+        lwesp_sys_mutex_unlock(&emul_mutex);
+
+        if (poll(pfd, n, -1) <= 0) {
+            continue;                           /* Interrupted, wait again */
+        }
+        if (pfd[0].revents & (POLLHUP | POLLERR | POLLNVAL)) {
+            break;                              /* Emulator was de-initialized */
+        }
+
+        /* Responses first, they were generated before any socket became visible here */
+        while ((len = read(out_pipe[0], buff, sizeof(buff))) > 0) {
+            rx_deliver(buff, (size_t)len);
+        }
+        for (nfds_t i = 1; i < n; ++i) {
+            if (!(pfd[i].revents & (POLLIN | POLLHUP | POLLERR))) {
+                continue;
+            }
+            if (pfd_conn[i] == LWESP_CFG_MAX_CONNS) {
+                lwesp_sys_mutex_lock(&emul_mutex);
+                if (server_fd == pfd[i].fd) {
+                    lwesp_sys_mutex_unlock(&emul_mutex);
+                    server_accept(pfd[i].fd);
+                } else {
+                    lwesp_sys_mutex_unlock(&emul_mutex);
+                }
+            } else {
+                conn_receive(pfd_conn[i], pfd[i].fd);
+            }
+        }
+    }
+}
+
+/**
+ * \brief           Reset device GPIO management
+ * \param[in]       state: Set to `1` to put device in reset, `0` to release it
+ * \return          `1` if reset pin was set, `0` otherwise
+ */
+static uint8_t
+reset_device(uint8_t state) {
+    if (state) {
+        device_reset();
+    } else {
+        reply("\r\n ets Jan  8 2013,rst cause:1, boot mode:(3,7)\r\n\r\nready\r\n");
+    }
+    return 1;
+}
+
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+
+/**
+ * \brief           RTS pin of host, connected to CTS pin of emulated device
+ * \param[in]       stop: Set to `1` to stop device sending data, `0` to let it send again
+ */
+static void
+rts_set(uint8_t stop) {
+    rts_stop = stop;
+}
+
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL */
+
+/**
+ * \brief           Callback function called from initialization process
+ */
+lwespr_t
+lwesp_ll_init(lwesp_ll_t* ll) {
+#if !LWESP_CFG_MEM_CUSTOM
+    /* Step 1: Configure memory for dynamic allocations */
+    static uint8_t memory[0x10000];             /* Create memory for dynamic allocations with specific size */
+
+    /*
+     * Create memory region(s) of memory.
+     * If device has internal/external memory available,
+     * multiple memories may be used
+     */
+    lwesp_mem_region_t mem_regions[] = {
+        { memory, sizeof(memory) }
+    };
+    if (!initialized) {
+        lwesp_mem_assignmemory(mem_regions, LWESP_ARRAYSIZE(mem_regions));  /* Assign memory for allocations to ESP library */
+    }
+#endif /* !LWESP_CFG_MEM_CUSTOM */
+
+    /* Step 2: Set AT port send function to use when we have data to transmit */
+    if (!initialized) {
+        ll->send_fn = send_data;                /* Set callback function to send data */
+        ll->reset_fn = reset_device;
+#if LWESP_CFG_INPUT_FLOW_CONTROL
+        ll->rts_fn = rts_set;
+#endif /* LWESP_CFG_INPUT_FLOW_CONTROL */
+    }
+
+    /* Step 3: Configure emulated device, baudrate only sets delivery speed */
+    if (initialized) {
+        lwesp_sys_mutex_lock(&emul_mutex);
+        baudrate = ll->uart.baudrate;
+        lwesp_sys_mutex_unlock(&emul_mutex);
+    } else {
+        baudrate = ll->uart.baudrate;
+        for (size_t i = 0; i < LWESP_ARRAYSIZE(conns); ++i) {
+            conns[i].fd = -1;
+        }
+        if (!lwesp_sys_mutex_create(&emul_mutex)) {
+            return lwespERR;
+        }
+        if (pipe(out_pipe) != 0) {
+            lwesp_sys_mutex_delete(&emul_mutex);
+            return lwespERR;
+        }
+        fcntl(out_pipe[0], F_SETFL, fcntl(out_pipe[0], F_GETFL) | O_NONBLOCK);
+        lwesp_sys_thread_create(&thread_handle, "lwesp_ll_emul", emul_thread, NULL, 0, 0);
+    }
+    initialized = 1;
+    return lwespOK;
+}
+
+/**
+ * \brief           Callback function to de-init low-level communication part
+ */
+lwespr_t
+lwesp_ll_deinit(lwesp_ll_t* ll) {
+    LWESP_UNUSED(ll);
+
+    if (initialized) {
+        lwesp_sys_thread_terminate(&thread_handle);
+        device_reset();
+        close(out_pipe[0]);
+        close(out_pipe[1]);
+        out_pipe[0] = out_pipe[1] = -1;
+        lwesp_sys_mutex_delete(&emul_mutex);
+    }
+    initialized = 0;                            /* Clear initialized flag */
+    return lwespOK;
+}
+
+#endif /* !__DOXYGEN__ */
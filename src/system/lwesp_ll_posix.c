@@ -0,0 +1,362 @@
+/**
+ * \file            lwesp_ll_posix.c
+ * \brief           Low-level communication with ESP device for POSIX systems
+ */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwESP - Lightweight ESP-AT parser library.
+ */
+#ifndef _DEFAULT_SOURCE
+#define _DEFAULT_SOURCE                         /* cfmakeraw and non-standard baudrates */
+#endif /* _DEFAULT_SOURCE */
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+#include "system/lwesp_ll.h"
+#include "lwesp/lwesp.h"
+#include "lwesp/lwesp_mem.h"
+#include "lwesp/lwesp_input.h"
+
+#if !__DOXYGEN__
+
+/**
+ * \brief           Serial device or pseudo terminal connected to ESP device
+ *
+ * Environment variable `LWESP_DEVICE` overrides this value at runtime
+ */
+#ifndef LWESP_LL_POSIX_DEVICE
+#define LWESP_LL_POSIX_DEVICE           "/dev/ttyUSB0"
+#endif
+
+/**
+ * \brief           Path of sysfs GPIO value file connected to ESP reset pin, such as `/sys/class/gpio/gpio17/value`.
+ *                  GPIO must be exported and configured as output. Reset pin is active low.
+ *                  libgpiod character device lines are not supported.
+ *                  Leave undefined when reset pin is not connected
+ */
+/* #define LWESP_LL_POSIX_RESET_GPIO   "/sys/class/gpio/gpio17/value" */
+
+/**
+ * \brief           Delay between attempts to open serial device again after it was lost, in units of milliseconds
+ */
+#ifndef LWESP_LL_POSIX_REOPEN_DELAY
+#define LWESP_LL_POSIX_REOPEN_DELAY     1000
+#endif
+
+static uint8_t initialized = 0;
+static lwesp_sys_thread_t thread_handle;
+static volatile int com_port = -1;              /*!< Serial device file descriptor */
+static uint32_t com_baudrate;                   /*!< Baudrate of serial device, applied again after reopen */
+static uint8_t data_buffer[0x1000];             /*!< Received data array, when input buffer cannot be used directly */
+
+static void uart_thread(void* param);
+
+/**
+ * \brief           Send data to ESP device, function called from ESP stack when we have data to send
+ * \param[in]       data: Pointer to data to send
+ * \param[in]       len: Number of bytes to send
+ * \return          Number of bytes sent
+ */
+static size_t
+send_data(const void* data, size_t len) {
+    const uint8_t* d = data;
+    size_t written = 0;
+    ssize_t ret;
+
+    if (com_port < 0 || data == NULL || len == 0) {
+        return 0;                               /* Data are written immediately, no flush is needed */
+    }
+    while (written < len) {
+        ret = write(com_port, &d[written], len - written);
+        if (ret > 0) {
+            written += (size_t)ret;
+        } else if (ret < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            struct pollfd pfd = { .fd = com_port, .events = POLLOUT };
+            poll(&pfd, 1, -1);                  /* Wait for space in output queue */
+        } else if (ret < 0 && errno == EINTR) {
+            continue;
+        } else {
+            break;
+        }
+    }
+    return written;
+}
+
+/**
+ * \brief           Get termios speed value for baudrate
+ * \param[in]       baudrate: Baudrate in units of bits per second
+ * \return          Speed value or `B0` if baudrate is not supported
+ */
+static speed_t
+baudrate_to_speed(uint32_t baudrate) {
+    switch (baudrate) {
+        case 9600:      return B9600;
+        case 19200:     return B19200;
+        case 38400:     return B38400;
+        case 57600:     return B57600;
+        case 115200:    return B115200;
+        case 230400:    return B230400;
+#ifdef B460800
+        case 460800:    return B460800;
+#endif
+#ifdef B921600
+        case 921600:    return B921600;
+#endif
+#ifdef B1000000
+        case 1000000:   return B1000000;
+#endif
+#ifdef B2000000
+        case 2000000:   return B2000000;
+#endif
+#ifdef B3000000
+        case 3000000:   return B3000000;
+#endif
+        default:        return B0;
+    }
+}
+
+/**
+ * \brief           Open serial device in non-blocking mode,
+ *                  reading thread waits for data with poll
+ * \return          File descriptor on success, negative value otherwise
+ */
+static int
+open_device(void) {
+    const char* dev = getenv("LWESP_DEVICE");
+
+    return open(dev != NULL ? dev : LWESP_LL_POSIX_DEVICE, O_RDWR | O_NOCTTY | O_NONBLOCK);
+}
+
+/**
+ * \brief           Configure raw 8N1 mode with current baudrate.
+ *                  Pseudo terminals ignore baudrate, so errors are not fatal
+ */
+static void
+setup_device(void) {
+    struct termios tio;
+    speed_t speed;
+
+    if (isatty(com_port) && tcgetattr(com_port, &tio) == 0) {
+        cfmakeraw(&tio);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cflag &= ~(CSTOPB | CRTSCTS);
+        speed = baudrate_to_speed(com_baudrate);
+        if (speed != B0) {
+            cfsetispeed(&tio, speed);
+            cfsetospeed(&tio, speed);
+        }
+        tcsetattr(com_port, TCSADRAIN, &tio);   /* Apply after pending output is sent */
+    }
+}
+
+/**
+ * \brief           Configure serial device
+ * \param[in]       baudrate: Baudrate to set
+ */
+static void
+configure_uart(uint32_t baudrate) {
+    /* On first call, open serial device */
+    if (!initialized) {
+        com_port = open_device();
+        if (com_port < 0) {
+            return;
+        }
+    }
+
+    com_baudrate = baudrate;
+    setup_device();
+
+    /* On first function call, create a thread to read data from serial device */
+    if (!initialized) {
+        lwesp_sys_thread_create(&thread_handle, "lwesp_ll_thread", uart_thread, NULL, 0, 0);
+    }
+}
+
+/**
+ * \brief           Handle loss of serial device, such as unplugged USB adapter or closed pseudo terminal
+ *
+ * Device is closed and stack is informed that ESP is not present.
+ * Device is opened again with delay between attempts, so thread does not spin
+ * while device is missing. Stack is informed again when device is back
+ */
+static void
+reopen_device(void) {
+    int fd = com_port;
+
+    com_port = -1;                              /* Stop sending to lost device */
+    close(fd);
+    lwesp_device_set_present(0, NULL, NULL, 0);
+    do {
+        lwesp_delay(LWESP_LL_POSIX_REOPEN_DELAY);
+    } while ((fd = open_device()) < 0);
+    com_port = fd;
+    setup_device();
+    lwesp_device_set_present(1, NULL, NULL, 0);
+}
+
+/**
+ * \brief           UART thread
+ *
+ * Thread sleeps in `poll` until data are available, there is no periodic wake-up.
+ * End of file or error on read and hang-up reported by `poll` mean that device was lost
+ */
+static void
+uart_thread(void* param) {
+    struct pollfd pfd;
+    ssize_t bytes_read;
+    uint8_t* buff;
+    size_t len;
+
+    LWESP_UNUSED(param);
+
+    pfd.events = POLLIN;
+    while (1) {
+        pfd.fd = com_port;
+        if (poll(&pfd, 1, -1) <= 0) {
+            continue;                           /* Interrupted, wait again */
+        }
+        if (!(pfd.revents & POLLIN)) {
+            reopen_device();                    /* Hang-up or error without data to read */
+            continue;
+        }
+
+        /*
+         * Try to read data from device
+         * and send it to upper layer for processing
+         */
+        do {
+#if !LWESP_CFG_INPUT_USE_PROCESS
+            /* Read directly to input buffer when it has free memory */
+            buff = lwesp_input_get_write_block(&len);
+            if (buff != NULL) {
+                bytes_read = read(com_port, buff, len);
+                if (bytes_read > 0) {
+                    lwesp_input_write_advance((size_t)bytes_read);
+                }
+                continue;
+            }
+#endif /* !LWESP_CFG_INPUT_USE_PROCESS */
+            buff = data_buffer;
+            len = sizeof(data_buffer);
+            bytes_read = read(com_port, buff, len);
+            if (bytes_read > 0) {
+                /* Send received data to input processing module */
+#if LWESP_CFG_INPUT_USE_PROCESS
+                lwesp_input_process(buff, (size_t)bytes_read);
+#else /* LWESP_CFG_INPUT_USE_PROCESS */
+                lwesp_input(buff, (size_t)bytes_read);
+#endif /* !LWESP_CFG_INPUT_USE_PROCESS */
+            }
+        } while (bytes_read > 0 && (size_t)bytes_read == len);
+
+        /* End of file after hang-up, or read error, device was removed or closed */
+        if (bytes_read == 0 || (bytes_read < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            reopen_device();
+        }
+    }
+}
+
+/**
+ * \brief           Reset device GPIO management
+ * \param[in]       state: Set to `1` to put device in reset, `0` to release it
+ * \return          `1` if reset pin was set, `0` otherwise
+ */
+static uint8_t
+reset_device(uint8_t state) {
+#ifdef LWESP_LL_POSIX_RESET_GPIO
+    int fd;
+    ssize_t ret;
+
+    fd = open(LWESP_LL_POSIX_RESET_GPIO, O_WRONLY);
+    if (fd < 0) {
+        return 0;
+    }
+    ret = write(fd, state ? "0" : "1", 1);      /* Reset pin is active low */
+    close(fd);
+    return ret == 1;
+#else
+    LWESP_UNUSED(state);
+    return 0;                                   /* Hardware reset was not successful */
+#endif /* LWESP_LL_POSIX_RESET_GPIO */
+}
+
+/**
+ * \brief           Callback function called from initialization process
+ */
+lwespr_t
+lwesp_ll_init(lwesp_ll_t* ll) {
+#if !LWESP_CFG_MEM_CUSTOM
+    /* Step 1: Configure memory for dynamic allocations */
+    static uint8_t memory[0x10000];             /* Create memory for dynamic allocations with specific size */
+
+    /*
+     * Create memory region(s) of memory.
+     * If device has internal/external memory available,
+     * multiple memories may be used
+     */
+    lwesp_mem_region_t mem_regions[] = {
+        { memory, sizeof(memory) }
+    };
+    if (!initialized) {
+        lwesp_mem_assignmemory(mem_regions, LWESP_ARRAYSIZE(mem_regions));  /* Assign memory for allocations to ESP library */
+    }
+#endif /* !LWESP_CFG_MEM_CUSTOM */
+
+    /* Step 2: Set AT port send function to use when we have data to transmit */
+    if (!initialized) {
+        ll->send_fn = send_data;                /* Set callback function to send data */
+        ll->reset_fn = reset_device;
+    }
+
+    /* Step 3: Configure AT port to be able to send/receive data to/from ESP device */
+    configure_uart(ll->uart.baudrate);          /* Initialize UART for communication */
+    if (com_port < 0) {
+        return lwespERR;
+    }
+    initialized = 1;
+    return lwespOK;
+}
+
+/**
+ * \brief           Callback function to de-init low-level communication part
+ */
+lwespr_t
+lwesp_ll_deinit(lwesp_ll_t* ll) {
+    LWESP_UNUSED(ll);
+
+    if (initialized) {
+        lwesp_sys_thread_terminate(&thread_handle);
+    }
+    if (com_port >= 0) {
+        close(com_port);
+        com_port = -1;
+    }
+    initialized = 0;                            /* Clear initialized flag */
+    return lwespOK;
+}
+
+#endif /* !__DOXYGEN__ */
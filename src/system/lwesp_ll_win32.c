@@ -31,6 +31,12 @@
  * Author:          Tilen MAJERLE <tilen@majerle.eu>
  * Version:         v1.0.0
  */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ *   - Skip console output of AT data when trace is enabled
+ */
 #include "system/lwesp_ll.h"
 #include "lwesp/lwesp.h"
 #include "lwesp/lwesp_mem.h"
@@ -53,7 +59,7 @@ static size_t
 send_data(const void* data, size_t len) {
     DWORD written;
     if (com_port != NULL) {
-#if !LWESP_CFG_AT_ECHO
+#if !LWESP_CFG_AT_ECHO && !LWESP_CFG_TRACE
         const uint8_t* d = data;
         HANDLE hConsole;
 
@@ -63,7 +69,7 @@ send_data(const void* data, size_t len) {
             printf("%c", d[i]);
         }
         SetConsoleTextAttribute(hConsole, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
-#endif /* !LWESP_CFG_AT_ECHO */
+#endif /* !LWESP_CFG_AT_ECHO && !LWESP_CFG_TRACE */
 
         WriteFile(com_port, data, len, &written, NULL);
         FlushFileBuffers(com_port);
@@ -154,6 +160,8 @@ uart_thread(void* param) {
         do {
             ReadFile(com_port, data_buffer, sizeof(data_buffer), &bytes_read, NULL);
             if (bytes_read > 0) {
+#if !LWESP_CFG_TRACE
+                /* Console output changes timing, trace records data instead */
                 HANDLE hConsole;
                 hConsole = GetStdHandle(STD_OUTPUT_HANDLE);
                 SetConsoleTextAttribute(hConsole, FOREGROUND_GREEN);
@@ -161,6 +169,7 @@ uart_thread(void* param) {
                     printf("%c", data_buffer[i]);
                 }
                 SetConsoleTextAttribute(hConsole, FOREGROUND_RED | FOREGROUND_GREEN | FOREGROUND_BLUE);
+#endif /* !LWESP_CFG_TRACE */
 
                 if (lwesp_ll_win32_driver_ignore_data) {
                     printf("IGNORING..\r\n");
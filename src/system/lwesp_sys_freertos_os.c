@@ -31,6 +31,14 @@
  * Author:          Adrian Carpenter (FreeRTOS port)
  */
 
+/*
+ * Copyright (c) 2021 niedong
+ *
+ *   - Skip message queue when lock-free message queue is used
+ *   - Add time in units of microseconds for trace
+ *   - Use time in units of microseconds for send gap statistics
+ */
+
 #include "system/lwesp_sys.h"
 #include "FreeRTOS.h"
 #include "task.h"
@@ -55,6 +63,13 @@ lwesp_sys_now(void) {
     return xTaskGetTickCount();
 }
 
+#if LWESP_CFG_TRACE || LWESP_CFG_STATS
+uint32_t
+lwesp_sys_now_us(void) {
+    return (uint32_t)xTaskGetTickCount() * (1000000 / configTICK_RATE_HZ); /* Kernel tick resolution */
+}
+#endif /* LWESP_CFG_TRACE || LWESP_CFG_STATS */
+
 uint8_t
 lwesp_sys_protect(void) {
     lwesp_sys_mutex_lock(&sys_mutex);
@@ -139,6 +154,7 @@ lwesp_sys_sem_invalid(lwesp_sys_sem_t* p) {
     return 1;
 }
 
+#if !LWESP_CFG_SYS_MBOX_LOCKFREE
 uint8_t
 lwesp_sys_mbox_create(lwesp_sys_mbox_t* b, size_t size) {
     *b = xQueueCreate(size, sizeof(freertos_mbox));
@@ -205,6 +221,7 @@ lwesp_sys_mbox_invalid(lwesp_sys_mbox_t* b) {
     *b = LWESP_SYS_MBOX_NULL;
     return 1;
 }
+#endif /* !LWESP_CFG_SYS_MBOX_LOCKFREE */
 
 uint8_t
 lwesp_sys_thread_create(lwesp_sys_thread_t* t, const char* name, lwesp_sys_thread_fn thread_func, void* const arg, size_t stack_size, lwesp_sys_thread_prio_t prio) {
@@ -0,0 +1,262 @@
+/**
+ * \file            lwesp_sys_mbox_lockfree.c
+ * \brief           Lock-free message queue for all system ports
+ */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwESP - Lightweight ESP-AT parser library.
+ */
+#include <stdlib.h>
+#include "system/lwesp_sys.h"
+
+/* See lwesp_sys_template.c file for function documentation on parameters and return values */
+
+#if LWESP_CFG_OS && LWESP_CFG_SYS_MBOX_LOCKFREE && !__DOXYGEN__
+
+#include <stddef.h>
+#include <stdatomic.h>
+
+/*
+ * Bounded queue with sequence number per cell (D. Vyukov).
+ *
+ * Writers claim position with compare-and-swap on write index,
+ * copy entry and publish cell by setting its sequence number.
+ * Cell at position `pos` is free when `seq == pos` and full when `seq == pos + 1`.
+ *
+ * Only waiting uses system semaphores. Reader and writers announce waiting with a flag,
+ * other side releases semaphore only when it sees the flag.
+ */
+
+/**
+ * \brief           Message queue cell
+ */
+typedef struct {
+    atomic_size_t seq;                          /*!< Sequence number of cell */
+    void* m;                                    /*!< Entry */
+} mbox_cell_t;
+
+/**
+ * \brief           Lock-free message queue
+ */
+struct lwesp_sys_mbox_lf {
+    atomic_size_t in;                           /*!< Next position to write, shared by all writers */
+    atomic_size_t out;                          /*!< Next position to read */
+    atomic_uint get_waiting;                    /*!< Set to `1` when reader waits for entry */
+    atomic_uint put_waiting;                    /*!< Number of writers waiting for free cell */
+    lwesp_sys_sem_t not_empty;                  /*!< Released when entry is written while reader waits */
+    lwesp_sys_sem_t not_full;                   /*!< Released when entry is read while writer waits */
+    size_t mask;                                /*!< Number of cells minus `1` */
+    mbox_cell_t cells[1];                       /*!< Cells, number of cells is power of `2` */
+};
+
+/**
+ * \brief           Write entry to message queue if it is not full
+ * \param[in]       mbox: Message queue
+ * \param[in]       m: Entry to write
+ * \return          `1` on success, `0` if queue is full
+ */
+static uint8_t
+mbox_write(struct lwesp_sys_mbox_lf* mbox, void* m) {
+    mbox_cell_t* cell;
+    size_t pos, seq;
+
+    pos = atomic_load_explicit(&mbox->in, memory_order_relaxed);
+    for (;;) {
+        cell = &mbox->cells[pos & mbox->mask];
+        seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        if (seq == pos) {                       /* Cell is free, claim position */
+            if (atomic_compare_exchange_weak_explicit(&mbox->in, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if ((ptrdiff_t)(seq - pos) < 0) {
+            return 0;                           /* Cell was not read yet, queue is full */
+        } else {
+            pos = atomic_load_explicit(&mbox->in, memory_order_relaxed);
+        }
+    }
+    cell->m = m;
+    atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+
+    /* Pairs with fence in lwesp_sys_mbox_get: reader sees entry or writer sees flag */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_exchange_explicit(&mbox->get_waiting, 0, memory_order_relaxed)) {
+        lwesp_sys_sem_release(&mbox->not_empty);
+    }
+    return 1;
+}
+
+/**
+ * \brief           Read entry from message queue if it is not empty
+ * \param[in]       mbox: Message queue
+ * \param[out]      m: Pointer to output variable for entry
+ * \return          `1` on success, `0` if queue is empty
+ */
+static uint8_t
+mbox_read(struct lwesp_sys_mbox_lf* mbox, void** m) {
+    mbox_cell_t* cell;
+    size_t pos, seq;
+
+    pos = atomic_load_explicit(&mbox->out, memory_order_relaxed);
+    for (;;) {
+        cell = &mbox->cells[pos & mbox->mask];
+        seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+        if (seq == pos + 1) {                   /* Cell is full, claim position */
+            if (atomic_compare_exchange_weak_explicit(&mbox->out, &pos, pos + 1,
+                    memory_order_relaxed, memory_order_relaxed)) {
+                break;
+            }
+        } else if ((ptrdiff_t)(seq - (pos + 1)) < 0) {
+            return 0;                           /* Cell was not written yet, queue is empty */
+        } else {
+            pos = atomic_load_explicit(&mbox->out, memory_order_relaxed);
+        }
+    }
+    *m = cell->m;
+    atomic_store_explicit(&cell->seq, pos + mbox->mask + 1, memory_order_release);
+
+    /* Pairs with fence in lwesp_sys_mbox_put: writer sees free cell or reader sees counter */
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(&mbox->put_waiting, memory_order_relaxed) > 0) {
+        lwesp_sys_sem_release(&mbox->not_full);
+    }
+    return 1;
+}
+
+uint8_t
+lwesp_sys_mbox_create(lwesp_sys_mbox_t* b, size_t size) {
+    struct lwesp_sys_mbox_lf* mbox;
+    size_t cnt;
+
+    *b = LWESP_SYS_MBOX_NULL;
+    for (cnt = 2; cnt < size; cnt <<= 1) {}     /* Round up to power of 2 for mask */
+
+    mbox = LWESP_SYS_MBOX_MALLOC(sizeof(*mbox) + (cnt - 1) * sizeof(mbox->cells[0]));
+    if (mbox == NULL) {
+        return 0;
+    }
+    atomic_init(&mbox->in, 0);
+    atomic_init(&mbox->out, 0);
+    atomic_init(&mbox->get_waiting, 0);
+    atomic_init(&mbox->put_waiting, 0);
+    mbox->mask = cnt - 1;
+    for (size_t i = 0; i < cnt; ++i) {
+        atomic_init(&mbox->cells[i].seq, i);
+        mbox->cells[i].m = NULL;
+    }
+    if (!lwesp_sys_sem_create(&mbox->not_empty, 0)) {
+        LWESP_SYS_MBOX_FREE(mbox);
+        return 0;
+    }
+    if (!lwesp_sys_sem_create(&mbox->not_full, 0)) {
+        lwesp_sys_sem_delete(&mbox->not_empty);
+        LWESP_SYS_MBOX_FREE(mbox);
+        return 0;
+    }
+    *b = mbox;
+    return 1;
+}
+
+uint8_t
+lwesp_sys_mbox_delete(lwesp_sys_mbox_t* b) {
+    struct lwesp_sys_mbox_lf* mbox = *b;
+
+    lwesp_sys_sem_delete(&mbox->not_full);
+    lwesp_sys_sem_delete(&mbox->not_empty);
+    LWESP_SYS_MBOX_FREE(mbox);
+    return 1;
+}
+
+uint32_t
+lwesp_sys_mbox_put(lwesp_sys_mbox_t* b, void* m) {
+    struct lwesp_sys_mbox_lf* mbox = *b;
+    uint32_t time = lwesp_sys_now();
+
+    if (!mbox_write(mbox, m)) {
+        atomic_fetch_add_explicit(&mbox->put_waiting, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+
+        /*
+         * Semaphore is binary and wakes up only one writer,
+         * other writers try again after short timeout
+         */
+        while (!mbox_write(mbox, m)) {
+            lwesp_sys_sem_wait(&mbox->not_full, 1);
+        }
+        atomic_fetch_sub_explicit(&mbox->put_waiting, 1, memory_order_relaxed);
+    }
+    return lwesp_sys_now() - time;
+}
+
+uint32_t
+lwesp_sys_mbox_get(lwesp_sys_mbox_t* b, void** m, uint32_t timeout) {
+    struct lwesp_sys_mbox_lf* mbox = *b;
+    uint32_t time = lwesp_sys_now(), elapsed, wait;
+
+    while (!mbox_read(mbox, m)) {
+        /* Announce waiting and check again, entry may have been written meanwhile */
+        atomic_store_explicit(&mbox->get_waiting, 1, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (mbox_read(mbox, m)) {
+            atomic_store_explicit(&mbox->get_waiting, 0, memory_order_relaxed);
+            break;
+        }
+
+        wait = 0;
+        if (timeout > 0) {
+            elapsed = lwesp_sys_now() - time;
+            if (elapsed >= timeout) {
+                atomic_store_explicit(&mbox->get_waiting, 0, memory_order_relaxed);
+                return LWESP_SYS_TIMEOUT;
+            }
+            wait = timeout - elapsed;
+        }
+        lwesp_sys_sem_wait(&mbox->not_empty, wait); /* Token may be stale, queue is checked again */
+    }
+    return lwesp_sys_now() - time;
+}
+
+uint8_t
+lwesp_sys_mbox_putnow(lwesp_sys_mbox_t* b, void* m) {
+    return mbox_write(*b, m);
+}
+
+uint8_t
+lwesp_sys_mbox_getnow(lwesp_sys_mbox_t* b, void** m) {
+    return mbox_read(*b, m);
+}
+
+uint8_t
+lwesp_sys_mbox_isvalid(lwesp_sys_mbox_t* b) {
+    return b != NULL && *b != NULL;
+}
+
+uint8_t
+lwesp_sys_mbox_invalid(lwesp_sys_mbox_t* b) {
+    *b = LWESP_SYS_MBOX_NULL;
+    return 1;
+}
+
+#endif /* LWESP_CFG_OS && LWESP_CFG_SYS_MBOX_LOCKFREE && !__DOXYGEN__ */
@@ -0,0 +1,521 @@
+/**
+ * \file            lwesp_sys_posix.c
+ * \brief           System dependant functions for POSIX systems
+ */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ * Permission is hereby granted, free of charge, to any person
+ * obtaining a copy of this software and associated documentation
+ * files (the "Software"), to deal in the Software without restriction,
+ * including without limitation the rights to use, copy, modify, merge,
+ * publish, distribute, sublicense, and/or sell copies of the Software,
+ * and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+ * OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+ * AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+ * HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+ * WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * This file is part of LwESP - Lightweight ESP-AT parser library.
+ */
+#ifndef _XOPEN_SOURCE
+#define _XOPEN_SOURCE 700                       /* Recursive mutexes and monotonic condition variables */
+#endif /* _XOPEN_SOURCE */
+#include <string.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <limits.h>
+#include <pthread.h>
+#include "system/lwesp_sys.h"
+
+#if !__DOXYGEN__
+
+/**
+ * \brief           Semaphore implementation with mutex and condition variable
+ */
+struct lwesp_posix_sem {
+    pthread_mutex_t mutex;                      /*!< Mutex to lock access */
+    pthread_cond_t cond;                        /*!< Condition signaled when semaphore is released */
+    uint8_t cnt;                                /*!< Semaphore count, either `0` or `1` */
+};
+
+#if !LWESP_CFG_SYS_MBOX_LOCKFREE
+/**
+ * \brief           Message queue implementation with one mutex and two condition variables
+ */
+struct lwesp_posix_mbox {
+    pthread_mutex_t mutex;                      /*!< Mutex to lock access */
+    pthread_cond_t not_empty;                   /*!< Condition signaled when entry is written */
+    pthread_cond_t not_full;                    /*!< Condition signaled when entry is read */
+    size_t in, out, cnt, size;
+    void* entries[1];
+};
+#endif /* !LWESP_CFG_SYS_MBOX_LOCKFREE */
+
+/**
+ * \brief           Thread start parameters
+ */
+typedef struct {
+    lwesp_sys_thread_fn fn;                     /*!< Thread function */
+    void* arg;                                  /*!< Thread function argument */
+} posix_thread_start_t;
+
+static struct timespec sys_start_time;
+static lwesp_sys_mutex_t sys_mutex;             /* Mutex ID for main protection */
+
+/**
+ * \brief           Get current kernel time in units of milliseconds
+ */
+static uint32_t
+osKernelSysTick(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((now.tv_sec - sys_start_time.tv_sec) * 1000
+                      + (now.tv_nsec - sys_start_time.tv_nsec) / 1000000);
+}
+
+/**
+ * \brief           Initialize condition variable to use monotonic clock for timed waits
+ * \param[in]       c: Condition variable to initialize
+ * \return          `1` on success, `0` otherwise
+ */
+static uint8_t
+cond_init(pthread_cond_t* c) {
+    pthread_condattr_t attr;
+    int ret;
+
+    if (pthread_condattr_init(&attr) != 0) {
+        return 0;
+    }
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    ret = pthread_cond_init(c, &attr);
+    pthread_condattr_destroy(&attr);
+    return ret == 0;
+}
+
+/**
+ * \brief           Calculate absolute monotonic time after timeout
+ * \param[out]      ts: Absolute time to wait until
+ * \param[in]       timeout: Timeout in units of milliseconds
+ */
+static void
+deadline_get(struct timespec* ts, uint32_t timeout) {
+    clock_gettime(CLOCK_MONOTONIC, ts);
+    ts->tv_sec += timeout / 1000;
+    ts->tv_nsec += (long)(timeout % 1000) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ++ts->tv_sec;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+/**
+ * \brief           Wait for condition variable, forever or until deadline
+ * \param[in]       c: Condition variable to wait for
+ * \param[in]       m: Locked mutex protecting condition
+ * \param[in]       ts: Absolute time to wait until or `NULL` to wait forever
+ * \return          `1` when woken up, `0` on timeout
+ */
+static uint8_t
+cond_wait(pthread_cond_t* c, pthread_mutex_t* m, const struct timespec* ts) {
+    if (ts == NULL) {
+        pthread_cond_wait(c, m);
+        return 1;
+    }
+    return pthread_cond_timedwait(c, m, ts) != ETIMEDOUT;
+}
+
+/**
+ * \brief           Thread entry, calls user thread function
+ * \param[in]       arg: Thread start parameters
+ */
+static void*
+thread_start(void* arg) {
+    posix_thread_start_t s = *(posix_thread_start_t*)arg;
+
+    free(arg);
+    s.fn(s.arg);
+    return NULL;
+}
+
+uint8_t
+lwesp_sys_init(void) {
+    clock_gettime(CLOCK_MONOTONIC, &sys_start_time);
+
+    lwesp_sys_mutex_create(&sys_mutex);
+    return 1;
+}
+
+uint32_t
+lwesp_sys_now(void) {
+    return osKernelSysTick();
+}
+
+#if LWESP_CFG_TRACE || LWESP_CFG_STATS
+uint32_t
+lwesp_sys_now_us(void) {
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint32_t)((now.tv_sec - sys_start_time.tv_sec) * 1000000
+                      + (now.tv_nsec - sys_start_time.tv_nsec) / 1000);
+}
+#endif /* LWESP_CFG_TRACE || LWESP_CFG_STATS */
+
+#if LWESP_CFG_OS
+uint8_t
+lwesp_sys_protect(void) {
+    lwesp_sys_mutex_lock(&sys_mutex);
+    return 1;
+}
+
+uint8_t
+lwesp_sys_unprotect(void) {
+    lwesp_sys_mutex_unlock(&sys_mutex);
+    return 1;
+}
+
+uint8_t
+lwesp_sys_mutex_create(lwesp_sys_mutex_t* p) {
+    pthread_mutexattr_t attr;
+    pthread_mutex_t* m;
+
+    *p = LWESP_SYS_MUTEX_NULL;
+    m = malloc(sizeof(*m));
+    if (m == NULL) {
+        return 0;
+    }
+
+    /* Core protection is locked recursively */
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    if (pthread_mutex_init(m, &attr) == 0) {
+        *p = m;
+    } else {
+        free(m);
+    }
+    pthread_mutexattr_destroy(&attr);
+    return *p != NULL;
+}
+
+uint8_t
+lwesp_sys_mutex_delete(lwesp_sys_mutex_t* p) {
+    pthread_mutex_destroy(*p);
+    free(*p);
+    return 1;
+}
+
+uint8_t
+lwesp_sys_mutex_lock(lwesp_sys_mutex_t* p) {
+    return pthread_mutex_lock(*p) == 0;
+}
+
+uint8_t
+lwesp_sys_mutex_unlock(lwesp_sys_mutex_t* p) {
+    return pthread_mutex_unlock(*p) == 0;
+}
+
+uint8_t
+lwesp_sys_mutex_isvalid(lwesp_sys_mutex_t* p) {
+    return p != NULL && *p != NULL;
+}
+
+uint8_t
+lwesp_sys_mutex_invalid(lwesp_sys_mutex_t* p) {
+    *p = LWESP_SYS_MUTEX_NULL;
+    return 1;
+}
+
+uint8_t
+lwesp_sys_sem_create(lwesp_sys_sem_t* p, uint8_t cnt) {
+    struct lwesp_posix_sem* s;
+
+    *p = LWESP_SYS_SEM_NULL;
+    s = malloc(sizeof(*s));
+    if (s == NULL) {
+        return 0;
+    }
+    if (pthread_mutex_init(&s->mutex, NULL) != 0) {
+        free(s);
+        return 0;
+    }
+    if (!cond_init(&s->cond)) {
+        pthread_mutex_destroy(&s->mutex);
+        free(s);
+        return 0;
+    }
+    s->cnt = !!cnt;
+    *p = s;
+    return 1;
+}
+
+uint8_t
+lwesp_sys_sem_delete(lwesp_sys_sem_t* p) {
+    struct lwesp_posix_sem* s = *p;
+
+    pthread_cond_destroy(&s->cond);
+    pthread_mutex_destroy(&s->mutex);
+    free(s);
+    return 1;
+}
+
+uint32_t
+lwesp_sys_sem_wait(lwesp_sys_sem_t* p, uint32_t timeout) {
+    struct lwesp_posix_sem* s = *p;
+    struct timespec ts;
+    uint32_t tick = osKernelSysTick();
+
+    if (timeout > 0) {
+        deadline_get(&ts, timeout);
+    }
+    pthread_mutex_lock(&s->mutex);
+    while (s->cnt == 0) {
+        if (!cond_wait(&s->cond, &s->mutex, timeout > 0 ? &ts : NULL) && s->cnt == 0) {
+            pthread_mutex_unlock(&s->mutex);
+            return LWESP_SYS_TIMEOUT;
+        }
+    }
+    s->cnt = 0;
+    pthread_mutex_unlock(&s->mutex);
+    return osKernelSysTick() - tick;
+}
+
+uint8_t
+lwesp_sys_sem_release(lwesp_sys_sem_t* p) {
+    struct lwesp_posix_sem* s = *p;
+    uint8_t ret = 0;
+
+    pthread_mutex_lock(&s->mutex);
+    if (s->cnt == 0) {                          /* Binary semaphore, same as other ports */
+        s->cnt = 1;
+        ret = 1;
+        pthread_cond_signal(&s->cond);
+    }
+    pthread_mutex_unlock(&s->mutex);
+    return ret;
+}
+
+uint8_t
+lwesp_sys_sem_isvalid(lwesp_sys_sem_t* p) {
+    return p != NULL && *p != NULL;
+}
+
+uint8_t
+lwesp_sys_sem_invalid(lwesp_sys_sem_t* p) {
+    *p = LWESP_SYS_SEM_NULL;
+    return 1;
+}
+
+#if !LWESP_CFG_SYS_MBOX_LOCKFREE
+uint8_t
+lwesp_sys_mbox_create(lwesp_sys_mbox_t* b, size_t size) {
+    struct lwesp_posix_mbox* mbox;
+
+    *b = LWESP_SYS_MBOX_NULL;
+    mbox = malloc(sizeof(*mbox) + size * sizeof(void*));
+    if (mbox == NULL) {
+        return 0;
+    }
+    memset(mbox, 0x00, sizeof(*mbox));
+    mbox->size = size;
+    if (pthread_mutex_init(&mbox->mutex, NULL) != 0) {
+        free(mbox);
+        return 0;
+    }
+    if (!cond_init(&mbox->not_empty)) {
+        pthread_mutex_destroy(&mbox->mutex);
+        free(mbox);
+        return 0;
+    }
+    if (!cond_init(&mbox->not_full)) {
+        pthread_cond_destroy(&mbox->not_empty);
+        pthread_mutex_destroy(&mbox->mutex);
+        free(mbox);
+        return 0;
+    }
+    *b = mbox;
+    return 1;
+}
+
+uint8_t
+lwesp_sys_mbox_delete(lwesp_sys_mbox_t* b) {
+    struct lwesp_posix_mbox* mbox = *b;
+
+    pthread_cond_destroy(&mbox->not_full);
+    pthread_cond_destroy(&mbox->not_empty);
+    pthread_mutex_destroy(&mbox->mutex);
+    free(mbox);
+    return 1;
+}
+
+/**
+ * \brief           Write entry to message queue with free space
+ * \note            Mutex must be locked when calling this function
+ * \param[in]       mbox: Message queue
+ * \param[in]       m: Entry to write
+ */
+static void
+mbox_write(struct lwesp_posix_mbox* mbox, void* m) {
+    mbox->entries[mbox->in] = m;
+    if (++mbox->in >= mbox->size) {
+        mbox->in = 0;
+    }
+    ++mbox->cnt;
+    pthread_cond_signal(&mbox->not_empty);
+}
+
+/**
+ * \brief           Read entry from non-empty message queue
+ * \note            Mutex must be locked when calling this function
+ * \param[in]       mbox: Message queue
+ * \param[out]      m: Pointer to output variable for entry
+ */
+static void
+mbox_read(struct lwesp_posix_mbox* mbox, void** m) {
+    *m = mbox->entries[mbox->out];
+    if (++mbox->out >= mbox->size) {
+        mbox->out = 0;
+    }
+    --mbox->cnt;
+    pthread_cond_signal(&mbox->not_full);       /* Every read, many writers may wait for free entry */
+}
+
+uint32_t
+lwesp_sys_mbox_put(lwesp_sys_mbox_t* b, void* m) {
+    struct lwesp_posix_mbox* mbox = *b;
+    uint32_t time = osKernelSysTick();          /* Get start time */
+
+    pthread_mutex_lock(&mbox->mutex);
+    while (mbox->cnt == mbox->size) {
+        pthread_cond_wait(&mbox->not_full, &mbox->mutex);
+    }
+    mbox_write(mbox, m);
+    pthread_mutex_unlock(&mbox->mutex);
+    return osKernelSysTick() - time;
+}
+
+uint32_t
+lwesp_sys_mbox_get(lwesp_sys_mbox_t* b, void** m, uint32_t timeout) {
+    struct lwesp_posix_mbox* mbox = *b;
+    struct timespec ts;
+    uint32_t time = osKernelSysTick();
+
+    if (timeout > 0) {
+        deadline_get(&ts, timeout);
+    }
+    pthread_mutex_lock(&mbox->mutex);
+    while (mbox->cnt == 0) {
+        if (!cond_wait(&mbox->not_empty, &mbox->mutex, timeout > 0 ? &ts : NULL) && mbox->cnt == 0) {
+            pthread_mutex_unlock(&mbox->mutex);
+            return LWESP_SYS_TIMEOUT;
+        }
+    }
+    mbox_read(mbox, m);
+    pthread_mutex_unlock(&mbox->mutex);
+    return osKernelSysTick() - time;
+}
+
+uint8_t
+lwesp_sys_mbox_putnow(lwesp_sys_mbox_t* b, void* m) {
+    struct lwesp_posix_mbox* mbox = *b;
+    uint8_t ret = 0;
+
+    pthread_mutex_lock(&mbox->mutex);
+    if (mbox->cnt < mbox->size) {
+        mbox_write(mbox, m);
+        ret = 1;
+    }
+    pthread_mutex_unlock(&mbox->mutex);
+    return ret;
+}
+
+uint8_t
+lwesp_sys_mbox_getnow(lwesp_sys_mbox_t* b, void** m) {
+    struct lwesp_posix_mbox* mbox = *b;
+    uint8_t ret = 0;
+
+    pthread_mutex_lock(&mbox->mutex);
+    if (mbox->cnt > 0) {
+        mbox_read(mbox, m);
+        ret = 1;
+    }
+    pthread_mutex_unlock(&mbox->mutex);
+    return ret;
+}
+
+uint8_t
+lwesp_sys_mbox_isvalid(lwesp_sys_mbox_t* b) {
+    return b != NULL && *b != NULL;
+}
+
+uint8_t
+lwesp_sys_mbox_invalid(lwesp_sys_mbox_t* b) {
+    *b = LWESP_SYS_MBOX_NULL;
+    return 1;
+}
+#endif /* !LWESP_CFG_SYS_MBOX_LOCKFREE */
+
+uint8_t
+lwesp_sys_thread_create(lwesp_sys_thread_t* t, const char* name, lwesp_sys_thread_fn thread_func, void* const arg, size_t stack_size, lwesp_sys_thread_prio_t prio) {
+    posix_thread_start_t* s;
+    pthread_attr_t attr;
+    pthread_t th;
+    int ret;
+
+    (void)name;
+    (void)prio;
+
+    s = malloc(sizeof(*s));
+    if (s == NULL) {
+        return 0;
+    }
+    s->fn = thread_func;
+    s->arg = arg;
+
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    if (stack_size > 0) {                       /* Use default stack size when not set */
+        pthread_attr_setstacksize(&attr, stack_size < PTHREAD_STACK_MIN ? PTHREAD_STACK_MIN : stack_size);
+    }
+    ret = pthread_create(&th, &attr, thread_start, s);
+    pthread_attr_destroy(&attr);
+    if (ret != 0) {
+        free(s);
+        return 0;
+    }
+    if (t != NULL) {
+        *t = th;
+    }
+    return 1;
+}
+
+uint8_t
+lwesp_sys_thread_terminate(lwesp_sys_thread_t* t) {
+    if (t == NULL) {                            /* Shall we terminate ourself? */
+        pthread_exit(NULL);
+    }
+    pthread_cancel(*t);
+    return 1;
+}
+
+uint8_t
+lwesp_sys_thread_yield(void) {
+    sched_yield();
+    return 1;
+}
+
+#endif /* LWESP_CFG_OS */
+#endif /* !__DOXYGEN__ */
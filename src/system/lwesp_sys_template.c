@@ -29,6 +29,14 @@
  * Author:          Tilen MAJERLE <tilen@majerle.eu>
  * Version:         v1.0.0
  */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ *   - Skip message queue when lock-free message queue is used
+ *   - Add time in units of microseconds for trace
+ *   - Use time in units of microseconds for send gap statistics
+ */
 #include "system/lwesp_sys.h"
 #include "cmsis_os.h"
 
@@ -57,6 +65,23 @@ lwesp_sys_now(void) {
     return osKernelSysTick();
 }
 
+#if LWESP_CFG_TRACE || LWESP_CFG_STATS || __DOXYGEN__
+
+/**
+ * \brief           Get current time in units of microseconds
+ *
+ * Time is used only for timestamps of trace records and send gap statistics and may overflow.
+ * Use hardware timer for best resolution, kernel tick may be used instead.
+ *
+ * \return          Current time in units of microseconds
+ */
+uint32_t
+lwesp_sys_now_us(void) {
+    return osKernelSysTick() * 1000;
+}
+
+#endif /* LWESP_CFG_TRACE || LWESP_CFG_STATS || __DOXYGEN__ */
+
 /**
  * \brief           Protect middleware core
  *
@@ -226,6 +251,7 @@ lwesp_sys_sem_invalid(lwesp_sys_sem_t* p) {
     return 1;
 }
 
+#if !LWESP_CFG_SYS_MBOX_LOCKFREE
 /**
  * \brief           Create a new message queue with entry type of `void *`
  * \param[out]      b: Pointer to message queue structure
@@ -334,6 +360,7 @@ lwesp_sys_mbox_invalid(lwesp_sys_mbox_t* b) {
     *b = LWESP_SYS_MBOX_NULL;
     return 1;
 }
+#endif /* !LWESP_CFG_SYS_MBOX_LOCKFREE */
 
 /**
  * \brief           Create a new thread
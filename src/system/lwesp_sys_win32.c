@@ -31,6 +31,14 @@
  * Author:          Tilen MAJERLE <tilen@majerle.eu>
  * Version:         v1.0.0
  */
+
+/*
+ * Copyright (c) 2021 niedong
+ *
+ *   - Skip message queue when lock-free message queue is used
+ *   - Add time in units of microseconds for trace
+ *   - Use time in units of microseconds for send gap statistics
+ */
 #include <string.h>
 #include <stdlib.h>
 #include "system/lwesp_sys.h"
@@ -38,6 +46,7 @@
 
 #if !__DOXYGEN__
 
+#if !LWESP_CFG_SYS_MBOX_LOCKFREE
 /**
  * \brief           Custom message queue implementation for WIN32
  */
@@ -48,10 +57,12 @@ typedef struct {
     size_t in, out, size;
     void* entries[1];
 } win32_mbox_t;
+#endif /* !LWESP_CFG_SYS_MBOX_LOCKFREE */
 
 static LARGE_INTEGER freq, sys_start_time;
 static lwesp_sys_mutex_t sys_mutex;             /* Mutex ID for main protection */
 
+#if !LWESP_CFG_SYS_MBOX_LOCKFREE
 /**
  * \brief           Check if message box is full
  * \param[in]       m: Message box handle
@@ -77,6 +88,7 @@ static uint8_t
 mbox_is_empty(win32_mbox_t* m) {
     return m->in == m->out;
 }
+#endif /* !LWESP_CFG_SYS_MBOX_LOCKFREE */
 
 /**
  * \brief           Get current kernel time in units of milliseconds
@@ -106,6 +118,16 @@ lwesp_sys_now(void) {
     return osKernelSysTick();
 }
 
+#if LWESP_CFG_TRACE || LWESP_CFG_STATS
+uint32_t
+lwesp_sys_now_us(void) {
+    LARGE_INTEGER now;
+
+    QueryPerformanceCounter(&now);
+    return (uint32_t)(((now.QuadPart - sys_start_time.QuadPart) * 1000000) / freq.QuadPart);
+}
+#endif /* LWESP_CFG_TRACE || LWESP_CFG_STATS */
+
 #if LWESP_CFG_OS
 uint8_t
 lwesp_sys_protect(void) {
@@ -203,6 +225,7 @@ lwesp_sys_sem_invalid(lwesp_sys_sem_t* p) {
     return 1;
 }
 
+#if !LWESP_CFG_SYS_MBOX_LOCKFREE
 uint8_t
 lwesp_sys_mbox_create(lwesp_sys_mbox_t* b, size_t size) {
     win32_mbox_t* mbox;
@@ -334,6 +357,7 @@ lwesp_sys_mbox_invalid(lwesp_sys_mbox_t* b) {
     *b = LWESP_SYS_MBOX_NULL;
     return 1;
 }
+#endif /* !LWESP_CFG_SYS_MBOX_LOCKFREE */
 
 uint8_t
 lwesp_sys_thread_create(lwesp_sys_thread_t* t, const char* name, lwesp_sys_thread_fn thread_func, void* const arg, size_t stack_size, lwesp_sys_thread_prio_t prio) {
@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+#
+# Copyright (c) 2021 niedong
+#
+# Permission is hereby granted, free of charge, to any person
+# obtaining a copy of this software and associated documentation
+# files (the "Software"), to deal in the Software without restriction,
+# including without limitation the rights to use, copy, modify, merge,
+# publish, distribute, sublicense, and/or sell copies of the Software,
+# and to permit persons to whom the Software is furnished to do so,
+# subject to the following conditions:
+#
+# The above copyright notice and this permission notice shall be
+# included in all copies or substantial portions of the Software.
+#
+# THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+# EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES
+# OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+# AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT
+# HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY,
+# WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+# FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+# OTHER DEALINGS IN THE SOFTWARE.
+#
+# This file is part of LwESP - Lightweight ESP-AT parser library.
+#
+"""
+Decode binary AT port trace written by lwesp_trace_dump().
+
+Prints timeline of data sent to and received from AT port and of commands,
+with duration of every command and idle gaps on AT port,
+followed by summary per command type.
+
+Usage: lwesp_trace_decode.py [--gap US] [--summary] trace.bin
+"""
+
+import argparse
+import struct
+import sys
+
+TRACE_VERSION = 1
+
+TYPE_TX = 1
+TYPE_RX = 2
+TYPE_CMD_START = 3
+TYPE_CMD_END = 4
+TYPE_NAME = 5
+
+RESULTS = ["OK", "OKIGNOREMORE", "ERR", "PARERR", "ERRMEM", "TIMEOUT", "CONT", "CLOSED", "INPROG",
+           "ERRNOIP", "ERRNOFREECONN", "ERRCONNTIMEOUT", "ERRPASS", "ERRNOAP", "ERRCONNFAIL",
+           "ERRWIFINOTCONNECTED", "ERRNODEVICE", "ERRBLOCKING"]
+
+
+def parse(data):
+    """Parse trace, return dictionary of command names and list of records"""
+    if len(data) < 8 or data[0:4] != b"LWTR":
+        raise ValueError("not a trace file")
+    if data[4] != TRACE_VERSION:
+        raise ValueError("unsupported trace version %d" % data[4])
+    names, records = {}, []
+    pos, base, last = 8, 0, None
+    while pos + 12 <= len(data):
+        time, typ, cmd, length, arg = struct.unpack_from("<IBBHI", data, pos)
+        payload = data[pos + 12:pos + 12 + length]
+        pos += 12 + length
+        if typ == TYPE_NAME:
+            names[cmd] = payload.decode("ascii", "replace")
+            continue
+        if last is not None and time < last:    # 32-bit microsecond counter overflow
+            base += 1 << 32
+        last = time
+        records.append((base + time, typ, cmd, arg, payload))
+    return names, records
+
+
+def text(payload, full_len):
+    """Printable form of AT data"""
+    s = payload.decode("latin-1").encode("unicode_escape").decode("ascii").replace('"', '\\"')
+    return '"%s"%s' % (s, "..." if full_len > len(payload) else "")
+
+
+def main():
+    ap = argparse.ArgumentParser(description="Decode binary AT port trace")
+    ap.add_argument("file", help="trace file written from lwesp_trace_dump output")
+    ap.add_argument("--gap", type=int, default=1000,
+                    help="report idle gaps on AT port longer than this, in microseconds (default 1000)")
+    ap.add_argument("--summary", action="store_true", help="print only summary")
+    args = ap.parse_args()
+
+    with open(args.file, "rb") as f:
+        names, records = parse(f.read())
+    if not records:
+        print("trace is empty")
+        return 0
+
+    def name(cmd):
+        return names.get(cmd, "CMD%d" % cmd)
+
+    start = records[0][0]
+    started = {}                                # Running commands by identifier
+    durations = {}                              # Command type -> list of durations
+    failed = {}                                 # Command type -> number of failed commands
+    gaps = []
+    last_io = None
+    bytes_tx = bytes_rx = 0
+
+    for time, typ, cmd, arg, payload in records:
+        line = None
+        if typ in (TYPE_TX, TYPE_RX):
+            if last_io is not None and time - last_io >= args.gap:
+                gaps.append((time - last_io, last_io))
+                if not args.summary:
+                    print("%12.3f  -- idle %.3f ms" % ((time - start) / 1000.0, (time - last_io) / 1000.0))
+            last_io = time
+            if typ == TYPE_TX:
+                bytes_tx += arg
+                line = "TX %-16s %5d %s" % (name(cmd) if cmd else "", arg, text(payload, arg))
+            else:
+                bytes_rx += arg
+                line = "RX %-16s %5d %s" % ("", arg, text(payload, arg))
+        elif typ == TYPE_CMD_START:
+            started[arg] = time
+            line = "START %s" % name(cmd)
+        elif typ == TYPE_CMD_END:
+            res = payload[0] if payload else 0
+            res_name = RESULTS[res] if res < len(RESULTS) else str(res)
+            if arg in started:
+                d = time - started.pop(arg)
+                durations.setdefault(cmd, []).append(d)
+                line = "END   %s %s in %.3f ms" % (name(cmd), res_name, d / 1000.0)
+            else:
+                line = "END   %s %s (start not in trace)" % (name(cmd), res_name)
+            if res != 0:
+                failed[cmd] = failed.get(cmd, 0) + 1
+        if line is not None and not args.summary:
+            print("%12.3f  %s" % ((time - start) / 1000.0, line))
+
+    total = records[-1][0] - start
+    print()
+    print("Trace length %.3f ms, %d records, TX %d bytes, RX %d bytes" % (total / 1000.0, len(records), bytes_tx, bytes_rx))
+    print("AT port idle gaps >= %d us: %d, total %.3f ms" % (args.gap, len(gaps), sum(g for g, _ in gaps) / 1000.0))
+    for g, at in sorted(gaps, reverse=True)[:5]:
+        print("    %.3f ms at %.3f ms" % (g / 1000.0, (at - start) / 1000.0))
+    print()
+    print("%-18s %6s %6s %10s %10s %10s" % ("command", "count", "failed", "min ms", "avg ms", "max ms"))
+    for cmd in sorted(durations, key=lambda c: -sum(durations[c])):
+        d = durations[cmd]
+        print("%-18s %6d %6d %10.3f %10.3f %10.3f" % (name(cmd), len(d), failed.get(cmd, 0),
+                                                      min(d) / 1000.0, sum(d) / len(d) / 1000.0, max(d) / 1000.0))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())